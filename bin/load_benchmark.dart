@@ -0,0 +1,380 @@
+// Load generator and latency benchmark for redis_ffi.
+//
+// Usage: dart run bin/load_benchmark.dart [--option=value ...]
+//
+//   --host=localhost
+//   --port=6379
+//   --connections=1        connections to spread commands over (a RedisPool
+//                          above 1)
+//   --concurrency=64       operations in flight at any time
+//   --requests=100000      operations per scenario (fewer for large values)
+//   --value-sizes=16,1024,65536,1048576,16777216
+//                          value sizes in bytes for the set and get scenarios
+//   --read-ratio=0.8       share of GETs in the mixed scenario
+//   --large-size=1000      elements of the HGETALL/LRANGE/ZRANGE values
+//   --publishers=8         publishing connections in the pubsub scenario
+//   --scenarios=set,get,mixed,large,pubsub
+//
+// Progress goes to stderr; the results are printed to stdout as one JSON
+// document, with throughput and p50/p99/p999 latencies in microseconds per
+// scenario.
+
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:redis_ffi/redis_ffi.dart';
+
+/// Upper bound for the bytes one scenario moves, so 16 MiB values finish.
+const _bytesPerScenario = 1 << 30;
+
+/// Upper bound for the value bytes in flight at once.
+const _bytesInFlight = 256 << 20;
+
+/// Keys the set, get and mixed scenarios cycle through.
+const _keyspace = 1000;
+
+class _Options {
+  var host = 'localhost';
+  var port = 6379;
+  var connections = 1;
+  var concurrency = 64;
+  var requests = 100000;
+  var valueSizes = [16, 1024, 64 * 1024, 1 << 20, 16 << 20];
+  var readRatio = 0.8;
+  var largeSize = 1000;
+  var publishers = 8;
+  var scenarios = {'set', 'get', 'mixed', 'large', 'pubsub'};
+
+  _Options.parse(List<String> args) {
+    for (final arg in args) {
+      final match = RegExp(r'^--([a-z-]+)=(.*)$').firstMatch(arg);
+      if (match == null) throw FormatException('Unknown argument: $arg');
+      final value = match[2]!;
+      switch (match[1]) {
+        case 'host':
+          host = value;
+        case 'port':
+          port = int.parse(value);
+        case 'connections':
+          connections = int.parse(value);
+        case 'concurrency':
+          concurrency = int.parse(value);
+        case 'requests':
+          requests = int.parse(value);
+        case 'value-sizes':
+          valueSizes = [for (final size in value.split(',')) int.parse(size)];
+        case 'read-ratio':
+          readRatio = double.parse(value);
+        case 'large-size':
+          largeSize = int.parse(value);
+        case 'publishers':
+          publishers = int.parse(value);
+        case 'scenarios':
+          scenarios = value.split(',').toSet();
+        default:
+          throw FormatException('Unknown option: --${match[1]}');
+      }
+    }
+  }
+
+  Map<String, Object> toJson() => {
+    'host': host,
+    'port': port,
+    'connections': connections,
+    'concurrency': concurrency,
+    'requests': requests,
+    'value_sizes': valueSizes,
+    'read_ratio': readRatio,
+    'large_size': largeSize,
+    'publishers': publishers,
+    'scenarios': scenarios.toList(),
+  };
+}
+
+/// The result of one scenario.
+Map<String, Object> _summarize(
+  String name,
+  Int64List latencies,
+  Duration elapsed, [
+  Map<String, Object> extra = const {},
+]) {
+  final sorted = Int64List.fromList(latencies)..sort();
+  int percentile(double p) => sorted.isEmpty
+      ? 0
+      : sorted[((p / 100 * sorted.length).ceil() - 1).clamp(
+          0,
+          sorted.length - 1,
+        )];
+  final seconds = elapsed.inMicroseconds / Duration.microsecondsPerSecond;
+  final total = sorted.fold(0, (a, b) => a + b);
+  return {
+    'name': name,
+    'operations': sorted.length,
+    'seconds': seconds,
+    'ops_per_sec': seconds > 0 ? sorted.length / seconds : 0,
+    'latency_us': {
+      'p50': percentile(50),
+      'p99': percentile(99),
+      'p999': percentile(99.9),
+      'max': sorted.isEmpty ? 0 : sorted.last,
+      'mean': sorted.isEmpty ? 0 : total / sorted.length,
+    },
+    ...extra,
+  };
+}
+
+/// Runs [operations] calls of [op] with up to [concurrency] in flight and
+/// times each one.
+Future<Map<String, Object>> _run(
+  String name,
+  int operations,
+  int concurrency,
+  Future<void> Function(int i) op, [
+  Map<String, Object> extra = const {},
+]) async {
+  stderr.writeln('$name: $operations operations, $concurrency in flight');
+  final latencies = Int64List(operations);
+  final clock = Stopwatch()..start();
+  var next = 0;
+
+  Future<void> worker() async {
+    while (true) {
+      final i = next++;
+      if (i >= operations) return;
+      final start = clock.elapsedMicroseconds;
+      await op(i);
+      latencies[i] = clock.elapsedMicroseconds - start;
+    }
+  }
+
+  await Future.wait([
+    for (var w = 0; w < min(concurrency, operations); w++) worker(),
+  ]);
+  clock.stop();
+  return _summarize(name, latencies, clock.elapsed, extra);
+}
+
+String _sizeName(int bytes) {
+  if (bytes >= 1 << 20 && bytes % (1 << 20) == 0) return '${bytes >> 20}MiB';
+  if (bytes >= 1 << 10 && bytes % (1 << 10) == 0) return '${bytes >> 10}KiB';
+  return '${bytes}B';
+}
+
+Future<void> main(List<String> args) async {
+  final options = _Options.parse(args);
+  final RedisCommands redis;
+  final Future<void> Function() close;
+  if (options.connections > 1) {
+    final pool = await RedisPool.connect(
+      options.host,
+      options.port,
+      size: options.connections,
+    );
+    redis = pool;
+    close = pool.close;
+  } else {
+    final client = await RedisClient.connect(options.host, options.port);
+    redis = client;
+    close = client.close;
+  }
+
+  final results = <Map<String, Object>>[];
+  final keys = [for (var i = 0; i < _keyspace; i++) 'bench:value:$i'];
+  try {
+    for (final size in options.valueSizes) {
+      final value = Uint8List(size)..fillRange(0, size, 0x78);
+      final operations = max(
+        10,
+        min(options.requests, _bytesPerScenario ~/ max(size, 1)),
+      );
+      final concurrency = max(
+        1,
+        min(options.concurrency, _bytesInFlight ~/ max(size, 1)),
+      );
+      final extra = {'value_bytes': size};
+      final sizeName = _sizeName(size);
+
+      if (options.scenarios.contains('set') ||
+          options.scenarios.contains('get')) {
+        final set = await _run(
+          'set/$sizeName',
+          operations,
+          concurrency,
+          (i) => redis.setBytes(keys[i % _keyspace], value),
+          extra,
+        );
+        if (options.scenarios.contains('set')) results.add(set);
+      }
+      if (options.scenarios.contains('get')) {
+        results.add(
+          await _run(
+            'get/$sizeName',
+            operations,
+            concurrency,
+            (i) => redis.getBytes(keys[i % min(_keyspace, operations)]),
+            extra,
+          ),
+        );
+      }
+      await redis.del(keys);
+    }
+
+    if (options.scenarios.contains('mixed')) {
+      final size = options.valueSizes.first;
+      final value = Uint8List(size)..fillRange(0, size, 0x78);
+      for (final key in keys) {
+        await redis.setBytes(key, value);
+      }
+      final random = Random(42);
+      results.add(
+        await _run(
+          'mixed/${_sizeName(size)}',
+          options.requests,
+          options.concurrency,
+          (i) {
+            final key = keys[random.nextInt(_keyspace)];
+            return random.nextDouble() < options.readRatio
+                ? redis.getBytes(key)
+                : redis.setBytes(key, value);
+          },
+          {'value_bytes': size, 'read_ratio': options.readRatio},
+        ),
+      );
+      await redis.del(keys);
+    }
+
+    if (options.scenarios.contains('large')) {
+      results.addAll(await _largeReplies(redis, options));
+    }
+
+    if (options.scenarios.contains('pubsub')) {
+      results.add(await _pubsubFanIn(options));
+    }
+  } finally {
+    await close();
+  }
+
+  stdout.writeln(
+    const JsonEncoder.withIndent('  ').convert({
+      'config': options.toJson(),
+      'results': results,
+    }),
+  );
+}
+
+/// HGETALL, LRANGE and ZRANGE WITHSCORES over values of `largeSize`
+/// elements.
+Future<List<Map<String, Object>>> _largeReplies(
+  RedisCommands redis,
+  _Options options,
+) async {
+  final n = options.largeSize;
+  await redis.del(['bench:hash', 'bench:list', 'bench:zset']);
+  await redis.hsetAll('bench:hash', {
+    for (var i = 0; i < n; i++) 'field:$i': 'value:$i',
+  });
+  for (var start = 0; start < n; start += 1000) {
+    await redis.rpush('bench:list', [
+      for (var i = start; i < min(start + 1000, n); i++) 'item:$i',
+    ]);
+  }
+  await redis.zadd('bench:zset', {
+    for (var i = 0; i < n; i++) 'member:$i': i.toDouble(),
+  });
+
+  final operations = max(10, options.requests ~/ 10);
+  final extra = {'elements': n};
+  try {
+    return [
+      await _run(
+        'hgetall/$n',
+        operations,
+        options.concurrency,
+        (_) => redis.hgetall('bench:hash'),
+        extra,
+      ),
+      await _run(
+        'lrange/$n',
+        operations,
+        options.concurrency,
+        (_) => redis.lrange('bench:list', 0, -1),
+        extra,
+      ),
+      await _run(
+        'zrange_withscores/$n',
+        operations,
+        options.concurrency,
+        (_) => redis.zrangeWithScores('bench:zset', 0, -1),
+        extra,
+      ),
+    ];
+  } finally {
+    await redis.del(['bench:hash', 'bench:list', 'bench:zset']);
+  }
+}
+
+/// `publishers` connections publish `requests` messages in total to one
+/// channel that a single subscriber reads. Latency is from publishing a
+/// message until the subscriber receives it.
+Future<Map<String, Object>> _pubsubFanIn(_Options options) async {
+  const channel = 'bench:fanin';
+  final client = await RedisClient.connect(options.host, options.port);
+  final publishers = [
+    for (var i = 0; i < options.publishers; i++)
+      await RedisClient.connect(options.host, options.port),
+  ];
+  final total = options.requests;
+  final latencies = Int64List(total);
+  final clock = Stopwatch()..start();
+  var received = 0;
+  final done = Completer<void>();
+
+  final subscription = client.subscribe(channels: [channel]).listen((message) {
+    final sent = int.tryParse(message.message ?? '');
+    if (sent == null || received >= total) return;
+    latencies[received++] = clock.elapsedMicroseconds - sent;
+    if (received == total) done.complete();
+  });
+
+  try {
+    // Wait until the subscription is live
+    while (await client.publish(channel, 'ready') == 0) {
+      await Future<void>.delayed(const Duration(milliseconds: 10));
+    }
+
+    stderr.writeln(
+      'pubsub_fanin: $total messages from ${publishers.length} publishers',
+    );
+    final start = clock.elapsed;
+    var next = 0;
+    final perPublisher = max(1, options.concurrency ~/ publishers.length);
+    Future<void> worker(RedisClient publisher) async {
+      while (true) {
+        final i = next++;
+        if (i >= total) return;
+        await publisher.publish(channel, '${clock.elapsedMicroseconds}');
+      }
+    }
+
+    await Future.wait([
+      for (final publisher in publishers)
+        for (var w = 0; w < perPublisher; w++) worker(publisher),
+    ]);
+    await done.future.timeout(const Duration(seconds: 60));
+    return _summarize(
+      'pubsub_fanin',
+      latencies,
+      clock.elapsed - start,
+      {'publishers': publishers.length},
+    );
+  } finally {
+    await subscription.cancel();
+    for (final publisher in publishers) {
+      await publisher.close();
+    }
+    await client.close();
+  }
+}
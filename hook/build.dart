@@ -9,6 +9,19 @@
 //
 // All target configuration (zig targets, iOS sysroot, Android NDK libc) is
 // handled by native/build.zig.
+//
+// Server deployments can opt into the performance build profile (LTO and a
+// size-class allocator for hiredis, see native/build.zig) and a CPU baseline
+// from the application's pubspec.yaml:
+//
+//   hooks:
+//     user_defines:
+//       redis_ffi:
+//         profile: performance
+//         cpu: x86-64-v3
+//
+// Both apply to Linux builds from source only; other targets, mobile ones
+// included, and the prebuilt binaries keep the defaults.
 
 import 'dart:io';
 
@@ -41,6 +54,16 @@ void main(List<String> args) async {
     // Check if we're in development mode (git checkout) or published package
     final isDevelopment = _isDevelopmentMode(packageRoot);
 
+    final tuning = targetOS == OS.linux
+        ? _serverTuning(input)
+        : const <String>[];
+    if (tuning.isNotEmpty && !isDevelopment) {
+      stderr.writeln(
+        'redis_ffi: profile/cpu need a build from source, '
+        'using the prebuilt library',
+      );
+    }
+
     if (isDevelopment) {
       // Development: always run zig build (handles its own caching)
       await _buildWithZig(
@@ -49,6 +72,7 @@ void main(List<String> args) async {
         targetArch,
         platformDir,
         isIosSimulator,
+        tuning,
       );
     }
 
@@ -111,6 +135,24 @@ String _getLibraryName(OS os, bool isIosSimulator) {
   };
 }
 
+/// The zig build options selected by the `profile` and `cpu` user defines.
+List<String> _serverTuning(BuildInput input) {
+  final profile = input.userDefines['profile'];
+  final cpu = input.userDefines['cpu'];
+  if (profile != null && profile != 'default' && profile != 'performance') {
+    throw Exception(
+      'Unknown redis_ffi profile: $profile (expected default or performance)',
+    );
+  }
+  if (cpu != null && cpu is! String) {
+    throw Exception('The redis_ffi cpu user define must be a string');
+  }
+  return [
+    if (profile != null) '-Dprofile=$profile',
+    if (cpu != null) '-Dcpu=$cpu',
+  ];
+}
+
 /// Detects if we're in development mode (source checkout) vs published package.
 ///
 /// Development mode: has native/build.zig (can build from source)
@@ -126,6 +168,7 @@ Future<void> _buildWithZig(
   Architecture targetArch,
   String platformDir,
   bool isIosSimulator,
+  List<String> tuning,
 ) async {
   // Ensure correct zig version
   await _ensureZigVersion(packageRoot);
@@ -144,6 +187,7 @@ Future<void> _buildWithZig(
   final args = [
     'build',
     '-Dplatform=$platformDir',
+    ...tuning,
     '-p',
     outputDir.toFilePath(),
   ];
@@ -23,8 +23,32 @@ library;
 
 export 'src/redis_client.dart'
     show
+        RedisCacheOptions,
         RedisClient,
+        RedisClusterClient,
+        RedisCommands,
+        RedisConnectionHandle,
+        RedisConnectionState,
         RedisException,
+        RedisPipeline,
+        RedisPool,
         RedisPubSubMessage,
-        RedisPubSubMessageType;
+        RedisPubSubMessageType,
+        RedisPubSubOverflow,
+        RedisReactor,
+        RedisReconnectOptions,
+        RedisReplayPolicy,
+        RedisScript,
+        RedisStreamConsumer,
+        RedisStreamEntry,
+        RedisTimeoutException,
+        RedisTrackingMode,
+        RedisTransaction;
 export 'src/redis_reply.dart' show RedisReply, RedisReplyType;
+export 'src/redis_stats.dart'
+    show
+        RedisCacheStats,
+        RedisClientStats,
+        RedisHistogram,
+        RedisLatencyStats,
+        RedisSubscriptionStats;
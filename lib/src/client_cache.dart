@@ -0,0 +1,275 @@
+part of 'redis_client.dart';
+
+/// How the server tracks the keys a client-side cache holds.
+///
+/// See `CLIENT TRACKING` in the Redis documentation.
+enum RedisTrackingMode {
+  /// The server remembers the keys this connection read for caching and
+  /// invalidates exactly those. Costs server memory per cached key.
+  optIn,
+
+  /// The server invalidates every key matching one of the cache's prefixes,
+  /// whoever read it. No per-key server state, but more invalidations.
+  broadcast,
+}
+
+/// Configuration of a client-side cache; see [RedisClient.connect].
+class RedisCacheOptions {
+  /// Most cached values (a `GET` result or one `HGET` field each).
+  final int maxEntries;
+
+  /// How the server tracks cached keys.
+  final RedisTrackingMode mode;
+
+  /// Only keys starting with one of these are cached (all keys if empty).
+  /// In [RedisTrackingMode.broadcast] mode these are the tracked prefixes.
+  final List<String> prefixes;
+
+  const RedisCacheOptions({
+    this.maxEntries = 10000,
+    this.mode = RedisTrackingMode.optIn,
+    this.prefixes = const [],
+  });
+
+  /// The `CLIENT TRACKING` command enabling this configuration.
+  List<Object> get _trackingCommand => [
+    'CLIENT',
+    'TRACKING',
+    'ON',
+    if (mode == RedisTrackingMode.optIn) 'OPTIN',
+    if (mode == RedisTrackingMode.broadcast) ...[
+      'BCAST',
+      for (final prefix in prefixes) ...['PREFIX', prefix],
+    ],
+  ];
+}
+
+/// The cached reads of one key: its `GET` reply and/or `HGET` fields.
+class _CacheEntry {
+  _ParsedReply? value;
+  var hasValue = false;
+  Map<String, _ParsedReply?>? fields;
+
+  int get size => (hasValue ? 1 : 0) + (fields?.length ?? 0);
+}
+
+/// A bounded LRU of `GET`/`HGET` replies, kept correct by the invalidation
+/// push frames the server sends for tracked keys.
+///
+/// Replies complete in order with the push frames, so a read is stored as
+/// its reply is dispatched. A read whose key is invalidated while it is in
+/// flight is not stored, as the server may not track it past that point.
+class _ClientCache {
+  final RedisCacheOptions options;
+
+  final _entries = <String, _CacheEntry>{};
+  var _size = 0;
+
+  /// Keys with reads in flight, and how many.
+  final _pendingReads = <String, int>{};
+
+  /// Keys invalidated while a read of them was in flight.
+  final _stalePending = <String>{};
+
+  var hits = 0;
+  var misses = 0;
+  var invalidations = 0;
+  var evictions = 0;
+
+  _ClientCache(this.options);
+
+  int get size => _size;
+
+  bool accepts(String key) {
+    final prefixes = options.prefixes;
+    if (prefixes.isEmpty) return true;
+    for (final prefix in prefixes) {
+      if (key.startsWith(prefix)) return true;
+    }
+    return false;
+  }
+
+  /// Returns the cached entry for [key] if it holds [field] (the `GET`
+  /// value if null), and marks it most recently used.
+  _CacheEntry? lookup(String key, String? field) {
+    final entry = _entries[key];
+    final cached =
+        entry != null &&
+        (field == null
+            ? entry.hasValue
+            : entry.fields?.containsKey(field) ?? false);
+    if (!cached) {
+      misses++;
+      return null;
+    }
+    hits++;
+    // Move to the most recently used end
+    _entries.remove(key);
+    _entries[key] = entry;
+    return entry;
+  }
+
+  /// Records that a read of [key] was sent.
+  void readSent(String key) {
+    _pendingReads[key] = (_pendingReads[key] ?? 0) + 1;
+  }
+
+  /// Stores the reply of a read of [key] sent with [readSent].
+  void readCompleted(String key, String? field, _ParsedReply? reply) {
+    final pending = _pendingReads[key]! - 1;
+    final stale = _stalePending.contains(key);
+    if (pending == 0) {
+      _pendingReads.remove(key);
+      _stalePending.remove(key);
+    } else {
+      _pendingReads[key] = pending;
+    }
+    if (stale) return;
+
+    // The reply's bytes are a view of the whole reply batch: copy them so
+    // the entry does not keep the batch alive
+    final bytes = reply?.bytes;
+    final value = bytes == null
+        ? reply
+        : _ParsedReply._(type: reply!.type, bytes: Uint8List.fromList(bytes));
+
+    final entry = _entries.remove(key) ?? _CacheEntry();
+    final before = entry.size;
+    if (field == null) {
+      entry.value = value;
+      entry.hasValue = true;
+    } else {
+      (entry.fields ??= {})[field] = value;
+    }
+    _entries[key] = entry;
+    _size += entry.size - before;
+    _evict();
+  }
+
+  /// A read of [key] failed; nothing is stored.
+  void readFailed(String key) {
+    final pending = _pendingReads[key]! - 1;
+    if (pending == 0) {
+      _pendingReads.remove(key);
+      _stalePending.remove(key);
+    } else {
+      _pendingReads[key] = pending;
+    }
+  }
+
+  void invalidate(String key) {
+    final entry = _entries.remove(key);
+    if (entry != null) {
+      _size -= entry.size;
+      invalidations++;
+    }
+    if (_pendingReads.containsKey(key)) _stalePending.add(key);
+  }
+
+  /// Drops everything, e.g. after the server flushed its tracking table.
+  void clear() {
+    invalidations += _entries.length;
+    _entries.clear();
+    _size = 0;
+    _stalePending.addAll(_pendingReads.keys);
+  }
+
+  void _evict() {
+    while (_size > options.maxEntries && _entries.isNotEmpty) {
+      final oldest = _entries.keys.first;
+      _size -= _entries.remove(oldest)!.size;
+      evictions++;
+    }
+  }
+
+  /// Handles a push frame: `invalidate [key, ...]`, or `invalidate nil`
+  /// when the server dropped all tracked keys.
+  void onPush(_ParsedReply? push) {
+    if (push == null || push.length < 2) return;
+    if (push.stringAt(0) != 'invalidate') return;
+    final keys = push[1];
+    if (keys == null || keys.isNil) {
+      clear();
+      return;
+    }
+    for (var i = 0; i < keys.length; i++) {
+      final name = keys.stringAt(i);
+      if (name != null) invalidate(name);
+    }
+  }
+}
+
+/// Completes a cached read, storing its reply as it is dispatched (before
+/// any push frame that follows it is handled).
+class _CachedReadCompleter implements Completer<_ParsedReply?> {
+  final _ClientCache _cache;
+  final String _key;
+  final String? _field;
+  final _inner = Completer<_ParsedReply?>();
+
+  _CachedReadCompleter(this._cache, this._key, this._field);
+
+  @override
+  Future<_ParsedReply?> get future => _inner.future;
+
+  @override
+  bool get isCompleted => _inner.isCompleted;
+
+  @override
+  void complete([FutureOr<_ParsedReply?>? value]) {
+    _cache.readCompleted(_key, _field, value as _ParsedReply?);
+    _inner.complete(value);
+  }
+
+  @override
+  void completeError(Object error, [StackTrace? stackTrace]) {
+    _cache.readFailed(_key);
+    _inner.completeError(error, stackTrace);
+  }
+}
+
+/// The keys [args] may write, which a cache drops before sending it: the
+/// first argument, or the key arguments of commands with other or several
+/// key positions. Read-only commands (see redis_reconnect.dart) and keyless
+/// commands (see redis_cluster.dart) have none.
+Iterable<Object> _writtenKeys(List<Object> args) sync* {
+  if (args.length < 2) return;
+  final name = args.first.toString().toUpperCase();
+  if (_readOnlyCommands.contains(name) ||
+      _anyNodeCommands.contains(name) ||
+      _allNodeCommands.contains(name) ||
+      _nodeCommands.contains(name)) {
+    return;
+  }
+  switch (name) {
+    case 'DEL' || 'UNLINK':
+      yield* args.skip(1);
+    case 'MSET' || 'MSETNX':
+      for (var i = 1; i < args.length; i += 2) {
+        yield args[i];
+      }
+    case 'RENAME' ||
+        'RENAMENX' ||
+        'COPY' ||
+        'SMOVE' ||
+        'LMOVE' ||
+        'BLMOVE' ||
+        'RPOPLPUSH' ||
+        'BRPOPLPUSH':
+      yield* args.skip(1).take(2);
+    case 'BLPOP' || 'BRPOP' || 'BZPOPMIN' || 'BZPOPMAX':
+      // The timeout comes last
+      yield* args.sublist(1, args.length - 1);
+    case 'EVAL' || 'EVALSHA' || 'FCALL':
+      // Script keys follow the key count
+      if (args.length < 3) return;
+      yield* args.skip(3).take(int.tryParse(args[2].toString()) ?? 0);
+    case 'LMPOP' || 'ZMPOP':
+      yield* args.skip(2).take(int.tryParse(args[1].toString()) ?? 0);
+    case 'BLMPOP' || 'BZMPOP':
+      if (args.length < 3) return;
+      yield* args.skip(3).take(int.tryParse(args[2].toString()) ?? 0);
+    default:
+      yield args[1];
+  }
+}
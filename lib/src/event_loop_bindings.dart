@@ -15,6 +15,92 @@ import 'hiredis_bindings.g.dart';
 /// Opaque handle to the native event loop state.
 final class EventLoopState extends ffi.Opaque {}
 
+/// Opaque handle to a shared native reactor (a fixed set of I/O threads).
+final class Reactor extends ffi.Opaque {}
+
+/// Event loop counters, filled by [redis_event_loop_get_stats].
+final class EventLoopStats extends ffi.Struct {
+  /// Number of times the poll thread returned from poll/select.
+  @ffi.Uint64()
+  external int poll_wakeups;
+
+  /// Wakeups that found no wakeup signal, nothing to read and nothing to write.
+  @ffi.Uint64()
+  external int spurious_wakeups;
+
+  /// Most queued commands alive at the same time.
+  @ffi.Uint64()
+  external int command_pool_high_water;
+
+  /// Command blocks currently cached for reuse.
+  @ffi.Uint64()
+  external int command_pool_cached;
+
+  /// Commands too large for any pool size class.
+  @ffi.Uint64()
+  external int command_pool_oversize;
+
+  /// Most in-flight reply callbacks at the same time.
+  @ffi.Uint64()
+  external int callback_pool_high_water;
+
+  /// Callback infos currently cached for reuse.
+  @ffi.Uint64()
+  external int callback_pool_cached;
+
+  /// Reply messages posted to Dart (each carries one or more replies).
+  @ffi.Uint64()
+  external int reply_posts;
+
+  /// Pub/sub messages waiting for Dart to acknowledge earlier ones.
+  @ffi.Uint64()
+  external int pubsub_queued;
+
+  /// Pub/sub messages discarded by the overflow policy.
+  @ffi.Uint64()
+  external int pubsub_dropped;
+
+  /// Times reading was paused because the pub/sub ring was full.
+  @ffi.Uint64()
+  external int pubsub_read_pauses;
+
+  /// 1 if the event loop is instrumented; the fields below stay 0 otherwise.
+  @ffi.Uint64()
+  external int instrumented;
+
+  /// Command bytes handed to hiredis.
+  @ffi.Uint64()
+  external int bytes_out;
+
+  /// Encoded reply bytes posted to Dart.
+  @ffi.Uint64()
+  external int bytes_in;
+
+  /// Drains of the command queue that found commands.
+  @ffi.Uint64()
+  external int drains;
+
+  /// 1 if the poll thread uses io_uring instead of poll.
+  @ffi.Uint64()
+  external int io_uring;
+
+  /// Times the connection was re-established after it was lost.
+  @ffi.Uint64()
+  external int reconnects;
+
+  /// Commands failed because their timeout passed.
+  @ffi.Uint64()
+  external int timeouts;
+
+  /// Values compressed before they were sent.
+  @ffi.Uint64()
+  external int values_compressed;
+
+  /// String replies decompressed before they were posted.
+  @ffi.Uint64()
+  external int values_decompressed;
+}
+
 /// Initialize the Dart API DL. Must be called once before using the event loop.
 /// Pass `ffi.NativeApi.initializeApiDLData` as the argument.
 @ffi.Native<ffi.IntPtr Function(ffi.Pointer<ffi.Void>)>()
@@ -47,6 +133,30 @@ external void redis_event_loop_destroy(ffi.Pointer<EventLoopState> state);
 @ffi.Native<ffi.Bool Function(ffi.Pointer<EventLoopState>)>()
 external bool redis_event_loop_start(ffi.Pointer<EventLoopState> state);
 
+/// Create a shared reactor with [numThreads] I/O threads.
+///
+/// Returns null on failure or on platforms without a reactor backend.
+@ffi.Native<ffi.Pointer<Reactor> Function(ffi.Int)>()
+external ffi.Pointer<Reactor> redis_reactor_create(int numThreads);
+
+/// Stop all reactor threads and free the reactor.
+///
+/// Event loops hosted by the reactor must be stopped first.
+@ffi.Native<ffi.Void Function(ffi.Pointer<Reactor>)>()
+external void redis_reactor_destroy(ffi.Pointer<Reactor> reactor);
+
+/// Host the event loop on one of the reactor's I/O threads instead of a
+/// dedicated poll thread.
+///
+/// Returns true on success, false if already running or on error.
+@ffi.Native<
+  ffi.Bool Function(ffi.Pointer<EventLoopState>, ffi.Pointer<Reactor>)
+>()
+external bool redis_event_loop_start_on_reactor(
+  ffi.Pointer<EventLoopState> state,
+  ffi.Pointer<Reactor> reactor,
+);
+
 /// Stop the poll loop.
 @ffi.Native<ffi.Void Function(ffi.Pointer<EventLoopState>)>()
 external void redis_event_loop_stop(ffi.Pointer<EventLoopState> state);
@@ -55,6 +165,200 @@ external void redis_event_loop_stop(ffi.Pointer<EventLoopState> state);
 @ffi.Native<ffi.Void Function(ffi.Pointer<EventLoopState>)>()
 external void redis_event_loop_wakeup(ffi.Pointer<EventLoopState> state);
 
+/// Bound the size of one reply message. Replies arriving in the same read
+/// cycle are posted together until either limit is reached; 0 keeps the
+/// current value.
+@ffi.Native<
+  ffi.Void Function(ffi.Pointer<EventLoopState>, ffi.Size, ffi.Size)
+>()
+external void redis_event_loop_set_reply_batch_limits(
+  ffi.Pointer<EventLoopState> state,
+  int maxBytes,
+  int maxReplies,
+);
+
+/// Post strings of at least [threshold] bytes without copying them, as
+/// external typed data owned by Dart. 0 disables this.
+@ffi.Native<ffi.Void Function(ffi.Pointer<EventLoopState>, ffi.Size)>()
+external void redis_event_loop_set_external_threshold(
+  ffi.Pointer<EventLoopState> state,
+  int threshold,
+);
+
+/// Bound the pub/sub messages in flight to Dart.
+///
+/// At most [capacity] messages are posted before Dart acknowledges them with
+/// [redis_pubsub_ack]; up to [capacity] more wait natively, after which
+/// [overflow] applies (0: drop oldest, 1: drop newest, 2: pause reading).
+/// 0 disables flow control. Call before starting the event loop.
+@ffi.Native<
+  ffi.Void Function(ffi.Pointer<EventLoopState>, ffi.Size, ffi.Uint8)
+>()
+external void redis_event_loop_set_pubsub_limits(
+  ffi.Pointer<EventLoopState> state,
+  int capacity,
+  int overflow,
+);
+
+/// Acknowledge [count] pub/sub messages handed to listeners, letting the
+/// event loop post that many more.
+@ffi.Native<ffi.Void Function(ffi.Pointer<EventLoopState>, ffi.Uint64)>()
+external void redis_pubsub_ack(ffi.Pointer<EventLoopState> state, int count);
+
+/// Copy the event loop counters into [out].
+///
+/// Returns 0 on success, -1 on error.
+@ffi.Native<
+  ffi.Int Function(ffi.Pointer<EventLoopState>, ffi.Pointer<EventLoopStats>)
+>()
+external int redis_event_loop_get_stats(
+  ffi.Pointer<EventLoopState> state,
+  ffi.Pointer<EventLoopStats> out,
+);
+
+/// Turn on latency histograms and byte counters. Call before starting the
+/// event loop.
+///
+/// Returns false on allocation failure.
+@ffi.Native<ffi.Bool Function(ffi.Pointer<EventLoopState>)>()
+external bool redis_event_loop_enable_instruments(
+  ffi.Pointer<EventLoopState> state,
+);
+
+/// Drive the connection's own poll thread with io_uring (Linux 5.10 or later)
+/// instead of poll. Call before starting the event loop; has no effect on a
+/// connection hosted by a reactor.
+///
+/// Returns false, keeping the poll backend, where io_uring is unavailable.
+@ffi.Native<ffi.Bool Function(ffi.Pointer<EventLoopState>)>()
+external bool redis_event_loop_enable_io_uring(
+  ffi.Pointer<EventLoopState> state,
+);
+
+/// Reconnect to [host]:[port] when the connection is lost instead of
+/// stopping, waiting between [minDelayMs] and [maxDelayMs] with jitter and
+/// giving up after [maxAttempts] failures in a row (0: never). Call before
+/// starting the event loop; a connection hosted by a reactor does not
+/// reconnect.
+///
+/// Returns false on allocation failure.
+@ffi.Native<
+  ffi.Bool Function(
+    ffi.Pointer<EventLoopState>,
+    ffi.Pointer<ffi.Char>,
+    ffi.Int,
+    ffi.Uint32,
+    ffi.Uint32,
+    ffi.Uint32,
+  )
+>()
+external bool redis_event_loop_enable_reconnect(
+  ffi.Pointer<EventLoopState> state,
+  ffi.Pointer<ffi.Char> host,
+  int port,
+  int minDelayMs,
+  int maxDelayMs,
+  int maxAttempts,
+);
+
+/// Set the commands sent first on every new connection; the event loop takes
+/// ownership of [batch] (nullptr for none).
+///
+/// Returns false, freeing the batch, without reconnect enabled.
+@ffi.Native<
+  ffi.Bool Function(ffi.Pointer<EventLoopState>, ffi.Pointer<CommandBatch>)
+>()
+external bool redis_event_loop_set_handshake(
+  ffi.Pointer<EventLoopState> state,
+  ffi.Pointer<CommandBatch> batch,
+);
+
+/// Treat the connection as lost once one of its commands times out: it is
+/// replaced with reconnect enabled, and the event loop stops as after a
+/// disconnect otherwise.
+@ffi.Native<ffi.Void Function(ffi.Pointer<EventLoopState>, ffi.Bool)>()
+external void redis_event_loop_set_close_on_timeout(
+  ffi.Pointer<EventLoopState> state,
+  bool enabled,
+);
+
+/// Compress the values of at least [threshold] bytes that commands write
+/// with LZ4, and decompress the compressed strings in replies. Call before
+/// starting the event loop.
+///
+/// Returns false on allocation failure.
+@ffi.Native<ffi.Bool Function(ffi.Pointer<EventLoopState>, ffi.Size)>()
+external bool redis_event_loop_set_compression(
+  ffi.Pointer<EventLoopState> state,
+  int threshold,
+);
+
+/// Where the connection is: 0 connecting, 1 connected, 2 reconnecting,
+/// 3 disconnected.
+@ffi.Native<ffi.Uint8 Function(ffi.Pointer<EventLoopState>)>()
+external int redis_event_loop_connection_state(
+  ffi.Pointer<EventLoopState> state,
+);
+
+/// Take a reference to the event loop for another isolate and return a token
+/// for it, or 0 on allocation failure.
+@ffi.Native<ffi.Uint64 Function(ffi.Pointer<EventLoopState>)>()
+external int redis_event_loop_share(ffi.Pointer<EventLoopState> state);
+
+/// Redeem a token from [redis_event_loop_share]: [dartPort] receives the
+/// replies of commands queued with it, and disconnect notifications.
+///
+/// Returns null if the token was already attached or released.
+@ffi.Native<ffi.Pointer<EventLoopState> Function(ffi.Uint64, ffi.Int64)>()
+external ffi.Pointer<EventLoopState> redis_event_loop_attach(
+  int token,
+  int dartPort,
+);
+
+/// Drop a token from [redis_event_loop_share] without attaching.
+@ffi.Native<ffi.Void Function(ffi.Uint64)>()
+external void redis_event_loop_unshare(int token);
+
+/// Undo [redis_event_loop_attach] for [dartPort] and drop its reference.
+@ffi.Native<ffi.Void Function(ffi.Pointer<EventLoopState>, ffi.Int64)>()
+external void redis_event_loop_detach(
+  ffi.Pointer<EventLoopState> state,
+  int dartPort,
+);
+
+/// Drop a reference to the event loop; the last one stops and destroys it,
+/// like [redis_event_loop_destroy].
+@ffi.Native<ffi.Void Function(ffi.Pointer<EventLoopState>)>()
+external void redis_event_loop_release(ffi.Pointer<EventLoopState> state);
+
+/// Copy the bucket counts of histogram [kind] into [out].
+///
+/// Returns the number of buckets copied, or -1 if the event loop is not
+/// instrumented or [kind] is unknown.
+@ffi.Native<
+  ffi.IntPtr Function(
+    ffi.Pointer<EventLoopState>,
+    ffi.Uint8,
+    ffi.Pointer<ffi.Uint64>,
+    ffi.Size,
+  )
+>()
+external int redis_event_loop_get_histogram(
+  ffi.Pointer<EventLoopState> state,
+  int kind,
+  ffi.Pointer<ffi.Uint64> out,
+  int len,
+);
+
+/// Record that a reply message posted at [postedNs] is being handled.
+@ffi.Native<ffi.Void Function(ffi.Pointer<EventLoopState>, ffi.Uint64)>(
+  isLeaf: true,
+)
+external void redis_event_loop_record_delivery(
+  ffi.Pointer<EventLoopState> state,
+  int postedNs,
+);
+
 /// Check if the context is connected.
 @ffi.Native<ffi.Bool Function(ffi.Pointer<redisAsyncContext>)>()
 external bool redis_async_is_connected(ffi.Pointer<redisAsyncContext> ctx);
@@ -82,6 +386,85 @@ external int redis_async_command_enqueue(
   ffi.Pointer<ffi.Size> argvlen,
 );
 
+/// A batch of RESP-formatted commands filled by Dart and submitted in one go.
+///
+/// Command `i` occupies `lens[i]` bytes of [data] and replies to `ids[i]`;
+/// it fails if no reply arrived within `timeouts[i]` milliseconds (0: no
+/// timeout).
+final class CommandBatch extends ffi.Struct {
+  external ffi.Pointer<ffi.Uint8> data;
+
+  @ffi.Size()
+  external int data_capacity;
+
+  @ffi.Size()
+  external int data_len;
+
+  external ffi.Pointer<ffi.Int64> ids;
+
+  external ffi.Pointer<ffi.Uint32> lens;
+
+  /// Reply shape hint of each command.
+  external ffi.Pointer<ffi.Uint8> shapes;
+
+  /// Timeout of each command in milliseconds (0: none).
+  external ffi.Pointer<ffi.Uint32> timeouts;
+
+  @ffi.Size()
+  external int cmd_capacity;
+
+  @ffi.Size()
+  external int count;
+}
+
+/// Get an empty batch with room for at least [dataCapacity] bytes and
+/// [cmdCapacity] commands, reusing the last submitted batch when possible.
+///
+/// Returns nullptr on allocation failure.
+@ffi.Native<
+  ffi.Pointer<CommandBatch> Function(
+    ffi.Pointer<EventLoopState>,
+    ffi.Size,
+    ffi.Size,
+  )
+>()
+external ffi.Pointer<CommandBatch> redis_command_batch_acquire(
+  ffi.Pointer<EventLoopState> state,
+  int dataCapacity,
+  int cmdCapacity,
+);
+
+/// Grow a batch while filling it. `data_len` and `count` must be up to date.
+///
+/// Returns false on allocation failure (the batch is left unchanged).
+@ffi.Native<ffi.Bool Function(ffi.Pointer<CommandBatch>, ffi.Size, ffi.Size)>()
+external bool redis_command_batch_reserve(
+  ffi.Pointer<CommandBatch> batch,
+  int dataCapacity,
+  int cmdCapacity,
+);
+
+/// Free a batch that was acquired but never enqueued.
+@ffi.Native<ffi.Void Function(ffi.Pointer<CommandBatch>)>()
+external void redis_command_batch_free(ffi.Pointer<CommandBatch> batch);
+
+/// Queue a batch of RESP-formatted commands without waking up the poll thread.
+///
+/// On success the event loop owns the batch; on failure it stays with the
+/// caller. Returns 0 on success, -1 on error.
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<EventLoopState>,
+    ffi.Int64,
+    ffi.Pointer<CommandBatch>,
+  )
+>()
+external int redis_async_batch_enqueue(
+  ffi.Pointer<EventLoopState> state,
+  int dartPort,
+  ffi.Pointer<CommandBatch> batch,
+);
+
 /// Send an async command and wake up the poll thread.
 /// For pipelining, use redis_async_command_enqueue + redis_event_loop_wakeup.
 ///
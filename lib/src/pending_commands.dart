@@ -0,0 +1,154 @@
+part of 'redis_client.dart';
+
+/// In-flight commands of one connection, in the order they were sent.
+///
+/// hiredis answers the commands of a connection strictly in order, so a reply
+/// almost always completes the oldest entry. Entries are still found by the
+/// command id sent along with each command: a command the event loop could
+/// not hand to hiredis fails right away, ahead of the replies still due for
+/// the commands before it.
+///
+/// On a reconnecting client, each entry can also keep what to send again if
+/// the connection is lost before the reply arrives.
+///
+/// A command that timed out, or failed out of order, leaves the queue but
+/// keeps its place without a completer until it reaches the front; [remove]
+/// skips such entries. The late reply of a timed out command is dropped
+/// natively.
+class _PendingCommands {
+  var _completers = List<Completer<_ParsedReply?>?>.filled(16, null);
+  var _ids = List<int>.filled(16, 0);
+  var _replays = List<_QueuedCommand?>.filled(16, null);
+  var _head = 0;
+  var _length = 0;
+
+  /// Entries without a completer, of commands that left out of order.
+  var _vacated = 0;
+
+  int get length => _length - _vacated;
+  bool get isEmpty => length == 0;
+
+  void add(
+    int commandId,
+    Completer<_ParsedReply?> completer, [
+    _QueuedCommand? replay,
+  ]) {
+    if (_length == _completers.length) _grow();
+    final index = (_head + _length) & (_completers.length - 1);
+    _completers[index] = completer;
+    _ids[index] = commandId;
+    _replays[index] = replay;
+    _length++;
+  }
+
+  /// What command [commandId] was added with to send again, if anything.
+  _QueuedCommand? replayOf(int commandId) {
+    final index = _indexOf(commandId);
+    return index < 0 ? null : _replays[index];
+  }
+
+  /// Removes command [commandId], normally the oldest. Returns null if it is
+  /// not pending.
+  Completer<_ParsedReply?>? remove(int commandId) {
+    _dropVacated();
+    if (_length == 0) return null;
+    if (_ids[_head] != commandId) {
+      // Failed before the replies due ahead of it
+      final index = _indexOf(commandId);
+      return index < 0 ? null : _vacate(index);
+    }
+    final completer = _completers[_head];
+    _completers[_head] = null;
+    _replays[_head] = null;
+    _head = (_head + 1) & (_completers.length - 1);
+    _length--;
+    return completer;
+  }
+
+  /// Takes the completer of the in-flight command [commandId], which timed
+  /// out, leaving its entry in place. Returns null if it is not pending.
+  Completer<_ParsedReply?>? expire(int commandId) {
+    final index = _indexOf(commandId);
+    return index < 0 ? null : _vacate(index);
+  }
+
+  /// Position of the pending command [commandId] in the ring, or -1.
+  int _indexOf(int commandId) {
+    final mask = _completers.length - 1;
+    for (var i = 0; i < _length; i++) {
+      final index = (_head + i) & mask;
+      if (_ids[index] == commandId && _completers[index] != null) return index;
+    }
+    return -1;
+  }
+
+  /// Takes the completer at [index], leaving the entry in place.
+  Completer<_ParsedReply?> _vacate(int index) {
+    final completer = _completers[index]!;
+    _completers[index] = null;
+    _replays[index] = null;
+    _vacated++;
+    return completer;
+  }
+
+  /// Drops the vacated entries at the front.
+  void _dropVacated() {
+    final mask = _completers.length - 1;
+    while (_vacated > 0 && _length > 0 && _completers[_head] == null) {
+      _head = (_head + 1) & mask;
+      _length--;
+      _vacated--;
+    }
+  }
+
+  /// Removes the [count] most recently added commands, oldest first.
+  ///
+  /// They were never handed to the event loop, so none of them is vacated.
+  List<Completer<_ParsedReply?>> removeLast(int count) {
+    assert(count <= _length);
+    final mask = _completers.length - 1;
+    final removed = <Completer<_ParsedReply?>>[];
+    for (var i = _length - count; i < _length; i++) {
+      final index = (_head + i) & mask;
+      removed.add(_completers[index]!);
+      _completers[index] = null;
+      _replays[index] = null;
+    }
+    _length -= count;
+    return removed;
+  }
+
+  /// Removes all commands, oldest first.
+  List<Completer<_ParsedReply?>> clear() {
+    final mask = _completers.length - 1;
+    final removed = <Completer<_ParsedReply?>>[];
+    for (var i = 0; i < _length; i++) {
+      final index = (_head + i) & mask;
+      final completer = _completers[index];
+      if (completer != null) removed.add(completer);
+      _completers[index] = null;
+      _replays[index] = null;
+    }
+    _head = 0;
+    _length = 0;
+    _vacated = 0;
+    return removed;
+  }
+
+  void _grow() {
+    final capacity = _completers.length * 2;
+    final completers = List<Completer<_ParsedReply?>?>.filled(capacity, null);
+    final ids = List<int>.filled(capacity, 0);
+    final replays = List<_QueuedCommand?>.filled(capacity, null);
+    final mask = _completers.length - 1;
+    for (var i = 0; i < _length; i++) {
+      completers[i] = _completers[(_head + i) & mask];
+      ids[i] = _ids[(_head + i) & mask];
+      replays[i] = _replays[(_head + i) & mask];
+    }
+    _completers = completers;
+    _ids = ids;
+    _replays = replays;
+    _head = 0;
+  }
+}
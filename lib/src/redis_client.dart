@@ -1,4 +1,5 @@
 import 'dart:async';
+import 'dart:collection';
 import 'dart:convert';
 import 'dart:ffi';
 import 'dart:isolate';
@@ -8,6 +9,22 @@ import 'package:ffi/ffi.dart';
 
 import 'event_loop_bindings.dart';
 import 'hiredis_bindings.g.dart';
+import 'redis_stats.dart';
+
+part 'client_cache.dart';
+part 'redis_reactor.dart';
+part 'redis_reconnect.dart';
+part 'pending_commands.dart';
+part 'redis_cluster.dart';
+part 'redis_commands.dart';
+part 'redis_connection_handle.dart';
+part 'redis_pipeline.dart';
+part 'redis_pool.dart';
+part 'redis_script.dart';
+part 'redis_stream_consumer.dart';
+part 'redis_subscriber.dart';
+part 'redis_timeout.dart';
+part 'resp_writer.dart';
 
 bool _dartApiInitialized = false;
 
@@ -30,63 +47,470 @@ const _redisReplyDouble = 7;
 const _redisReplyBool = 8;
 const _redisReplyMap = 9;
 const _redisReplySet = 10;
+const _redisReplyAttr = 11;
 const _redisReplyPush = 12;
+const _redisReplyBignum = 13;
+const _redisReplyVerb = 14;
+
+/// Command id of reply records that carry a RESP3 push frame.
+const _pushCommandId = -2;
+
+/// Command id of the record an instrumented event loop ends each reply
+/// message with: an integer, the native clock when it was posted.
+const _timingCommandId = -3;
+
+/// Command id of the record posted for a command whose connection was lost
+/// before its reply arrived: an integer, the command's id.
+const _lostCommandId = -4;
+
+/// Command id of the record posted for a command whose timeout passed before
+/// its reply arrived: an integer, the command's id.
+const _expiredCommandId = -5;
+
+/// Port messages of a reconnecting event loop: its connection was lost, and
+/// a new one is up.
+const _msgReconnecting = -4;
+const _msgReconnected = -5;
+
+/// Buckets of a native latency histogram.
+const _histogramBuckets = 976;
+
+/// Flat encoding tag for a missing reply or array element.
+const _replyTagNone = 0;
+
+/// Flat encoding tag for a string posted as external typed data.
+const _replyTagExternal = 0xff;
+
+/// Flat encoding tags for replies encoded by their command's shape hint.
+const _replyTagStrings = 0xfe;
+const _replyTagScored = 0xfd;
+
+/// Reply shape hints a command can carry (`ReplyShape` in async_loop.zig).
+/// The native side then encodes a reply of that shape as a [_StringTable].
+const _shapeGeneric = 0;
+
+/// An aggregate of strings: a list, a set or a flat map.
+const _shapeStrings = 1;
+
+/// (member, score) pairs, flat in RESP2 or nested in RESP3.
+const _shapeScored = 2;
+
+const _utf8Decoder = Utf8Decoder(allowMalformed: true);
 
 /// A parsed Redis reply (data copied from native, no manual free needed).
+///
+/// String-like replies keep their raw bytes; [string] decodes them as UTF-8
+/// on first access. Aggregates read from a reply batch are views over it: an
+/// element is only decoded when it is accessed, and [stringAt], [bytesAt]
+/// and [intAt] read one without creating a node for it.
 class _ParsedReply {
   final int type;
-  final String? string;
+  final Uint8List? bytes;
   final int? integer;
-  final List<_ParsedReply?>? elements;
+
+  /// The strings of a reply encoded by its shape hint.
+  final _StringTable? table;
+  String? _string;
+
+  /// The elements given up front, or materialized from the view.
+  List<_ParsedReply?>? _elements;
+
+  /// The batch an aggregate view reads its elements from.
+  final _ReplyBuffer? _buffer;
+
+  /// Offset of the first element in [_buffer].
+  final int _start;
+  final int _count;
+
+  /// Offsets of the elements, found on first access past the first one.
+  Uint32List? _offsets;
 
   _ParsedReply._({
     required this.type,
-    this.string,
+    this.bytes,
     this.integer,
-    this.elements,
-  });
+    List<_ParsedReply?>? elements,
+    this.table,
+  }) : _elements = elements,
+       _buffer = null,
+       _start = 0,
+       _count = elements?.length ?? 0;
+
+  /// An aggregate of [_count] elements encoded from [_start] in [_buffer].
+  _ParsedReply._view(this.type, this._buffer, this._start, this._count)
+    : bytes = null,
+      integer = null,
+      table = null;
 
   bool get isNil => type == _redisReplyNil;
   bool get isError => type == _redisReplyError;
-  int get length => elements?.length ?? 0;
-  _ParsedReply? operator [](int index) => elements?[index];
+  bool get isAggregate => _buffer != null || _elements != null;
+
+  /// Number of elements (or strings of a [table]).
+  int get length => table?.length ?? _count;
+
+  /// The elements, decoding all of them. Prefer [elementAt] and [stringAt]
+  /// for large replies.
+  List<_ParsedReply?>? get elements {
+    final buffer = _buffer;
+    if (buffer == null || _elements != null) return _elements;
+    return _elements = [
+      for (var i = 0; i < _count; i++) buffer.decodeAt(_offsetOf(i)),
+    ];
+  }
+
+  _ParsedReply? operator [](int index) => elementAt(index);
+
+  /// Element [index] of an aggregate, or null if this is not one.
+  _ParsedReply? elementAt(int index) {
+    final elements = _elements;
+    if (elements != null) return elements[index];
+    return _buffer?.decodeAt(_offsetOf(index));
+  }
+
+  /// Element [index] decoded as UTF-8, or null if it is not a string.
+  String? stringAt(int index) {
+    final elements = _elements;
+    if (elements != null) return elements[index]?.string;
+    final table = this.table;
+    if (table != null) return table.string(index);
+    return _buffer?.stringAt(_offsetOf(index));
+  }
+
+  /// A view of the bytes of element [index], or null if it is not a string.
+  Uint8List? bytesAt(int index) {
+    final elements = _elements;
+    if (elements != null) return elements[index]?.bytes;
+    final table = this.table;
+    if (table != null) return table.bytes(index);
+    return _buffer?.bytesAt(_offsetOf(index));
+  }
+
+  /// Element [index] as an integer, or null if it is not one.
+  int? intAt(int index) {
+    final elements = _elements;
+    if (elements != null) return elements[index]?.integer;
+    return _buffer?.intAt(_offsetOf(index));
+  }
+
+  int _offsetOf(int index) {
+    RangeError.checkValidIndex(index, this, 'index', _count);
+    if (index == 0) return _start;
+    var offsets = _offsets;
+    if (offsets == null) {
+      final buffer = _buffer!;
+      offsets = _offsets = Uint32List(_count);
+      var offset = _start;
+      for (var i = 0; i < _count; i++) {
+        offsets[i] = offset;
+        offset = buffer.skip(offset);
+      }
+    }
+    return offsets[index];
+  }
+
+  /// The reply bytes decoded as UTF-8, or null if this is not a string reply.
+  String? get string {
+    final bytes = this.bytes;
+    if (bytes == null) return null;
+    return _string ??= _utf8Decoder.convert(bytes);
+  }
+
+  /// Converts the reply to plain Dart values for [RedisCommands.sendCommand].
+  ///
+  /// Bulk strings become [Uint8List]s, status replies [String]s, integers
+  /// [int]s, aggregates [List]s and nil `null`. The RESP3 types map to
+  /// [double], [bool] and, for maps, a [Map] whose string keys are decoded
+  /// to [String].
+  Object? toValue() {
+    switch (type) {
+      case _redisReplyStatus:
+        return string;
+      case _redisReplyDouble:
+        return _parseScore(string!);
+      case _redisReplyInteger:
+        return integer;
+      case _redisReplyBool:
+        return integer != 0;
+      case _redisReplyMap:
+        final elements = this.elements!;
+        return {
+          for (var i = 0; i + 1 < elements.length; i += 2)
+            elements[i]?.string ?? elements[i]?.toValue():
+                elements[i + 1]?.toValue(),
+        };
+      case _redisReplyArray:
+      case _redisReplySet:
+      case _redisReplyAttr:
+      case _redisReplyPush:
+        return [for (final e in elements!) e?.toValue()];
+      case _redisReplyNil:
+        return null;
+      case _replyTagStrings:
+        final table = this.table!;
+        return [for (var i = 0; i < table.length; i++) table.bytes(i)];
+      case _replyTagScored:
+        final table = this.table!;
+        return [
+          for (var i = 0; i < table.length; i++)
+            [table.bytes(i), table.score(i)],
+        ];
+      default:
+        return bytes;
+    }
+  }
+}
+
+/// The strings (and scores) of a shape-encoded reply, read in place from the
+/// reply batch (see `encodeShaped` in async_loop.zig).
+class _StringTable {
+  final Uint8List _bytes;
+  final ByteData _data;
+
+  /// Number of strings.
+  final int length;
+
+  final int _scores;
+  final int _offsets;
+  final int _strings;
+
+  _StringTable._(
+    this._bytes,
+    this._data,
+    this.length,
+    this._scores,
+    this._offsets,
+    this._strings,
+  );
+
+  /// Reads the table at [start], just after the tag.
+  factory _StringTable.read(
+    Uint8List bytes,
+    ByteData data,
+    int start, {
+    required bool scored,
+  }) {
+    final length = data.getUint32(start, Endian.little);
+    final scores = start + 4;
+    final offsets = scores + (scored ? 8 * length : 0);
+    final strings = offsets + 4 * (length + 1);
+    return _StringTable._(bytes, data, length, scores, offsets, strings);
+  }
+
+  int _start(int index) =>
+      _strings + _data.getUint32(_offsets + 4 * index, Endian.little);
+
+  /// Offset just past the table.
+  int get end => _start(length);
+
+  /// A view of string [index], without copying.
+  Uint8List bytes(int index) =>
+      Uint8List.sublistView(_bytes, _start(index), _start(index + 1));
+
+  /// String [index] decoded as UTF-8.
+  String string(int index) =>
+      _utf8Decoder.convert(_bytes, _start(index), _start(index + 1));
 
-  static _ParsedReply? fromNative(dynamic data) {
-    if (data == null) return _ParsedReply._(type: _redisReplyNil);
-    if (data is! List || data.isEmpty) {
-      return _ParsedReply._(type: _redisReplyNil);
+  /// The score of member [index] of a scored reply.
+  double score(int index) =>
+      _data.getFloat64(_scores + 8 * index, Endian.little);
+}
+
+/// A received reply batch, which reply views decode from in place (see
+/// `encodeReply` in async_loop.zig).
+class _ReplyBuffer {
+  final Uint8List bytes;
+  final ByteData data;
+
+  /// Large strings sent next to the records, without copying. The message
+  /// is `[records, external_0, ...]` in that case.
+  final List<Object?> message;
+
+  _ReplyBuffer(this.bytes, this.message) : data = ByteData.sublistView(bytes);
+
+  int _length(int offset) => data.getUint32(offset, Endian.little);
+
+  /// Decodes the reply at [offset]; aggregates become views.
+  _ParsedReply? decodeAt(int offset) {
+    final type = bytes[offset++];
+    switch (type) {
+      case _replyTagNone:
+      case _redisReplyNil:
+        return _ParsedReply._(type: _redisReplyNil);
+      case _redisReplyString:
+      case _redisReplyStatus:
+      case _redisReplyError:
+      case _redisReplyDouble:
+        return _ParsedReply._(type: type, bytes: _inlineBytes(offset));
+      case _redisReplyBignum:
+      case _redisReplyVerb:
+        // Surface as plain strings
+        return _ParsedReply._(
+          type: _redisReplyString,
+          bytes: _inlineBytes(offset),
+        );
+      case _redisReplyInteger:
+        return _ParsedReply._(
+          type: type,
+          integer: data.getInt64(offset, Endian.little),
+        );
+      case _redisReplyBool:
+        return _ParsedReply._(type: type, integer: bytes[offset]);
+      case _replyTagExternal:
+        var stringType = bytes[offset];
+        if (stringType == _redisReplyBignum || stringType == _redisReplyVerb) {
+          stringType = _redisReplyString;
+        }
+        final external = _external(offset + 1);
+        // Missing if the native side ran out of memory building the message
+        if (external == null) return _ParsedReply._(type: _redisReplyNil);
+        return _ParsedReply._(type: stringType, bytes: external);
+      case _replyTagStrings:
+      case _replyTagScored:
+        final table = _StringTable.read(
+          bytes,
+          data,
+          offset,
+          scored: type == _replyTagScored,
+        );
+        return _ParsedReply._(type: type, table: table);
+      case _redisReplyArray:
+      case _redisReplyMap:
+      case _redisReplySet:
+      case _redisReplyAttr:
+      case _redisReplyPush:
+        return _ParsedReply._view(type, this, offset + 4, _length(offset));
+      default:
+        throw StateError('Unknown reply tag $type');
     }
+  }
 
-    final type = data[0] as int;
+  /// Returns the offset just past the reply at [offset].
+  int skip(int offset) {
+    final type = bytes[offset++];
     switch (type) {
+      case _replyTagNone:
       case _redisReplyNil:
-        return _ParsedReply._(type: type);
+        return offset;
       case _redisReplyString:
       case _redisReplyStatus:
       case _redisReplyError:
       case _redisReplyDouble:
-        if (data.length < 2) return _ParsedReply._(type: _redisReplyNil);
-        final bytes = data[1] as Uint8List;
-        final str = utf8.decode(bytes, allowMalformed: true);
-        return _ParsedReply._(type: type, string: str);
+      case _redisReplyBignum:
+      case _redisReplyVerb:
+        return offset + 4 + _length(offset);
       case _redisReplyInteger:
-        if (data.length < 2) return _ParsedReply._(type: _redisReplyNil);
-        return _ParsedReply._(type: type, integer: data[1] as int);
+        return offset + 8;
       case _redisReplyBool:
-        if (data.length < 2) return _ParsedReply._(type: _redisReplyNil);
-        return _ParsedReply._(type: type, integer: data[1] as int);
+        return offset + 1;
+      case _replyTagExternal:
+        return offset + 1 + 4;
+      case _replyTagStrings:
+      case _replyTagScored:
+        return _StringTable.read(
+          bytes,
+          data,
+          offset,
+          scored: type == _replyTagScored,
+        ).end;
       case _redisReplyArray:
       case _redisReplyMap:
       case _redisReplySet:
+      case _redisReplyAttr:
       case _redisReplyPush:
-        final elements = <_ParsedReply?>[];
-        for (var i = 1; i < data.length; i++) {
-          elements.add(fromNative(data[i]));
+        final count = _length(offset);
+        offset += 4;
+        for (var i = 0; i < count; i++) {
+          offset = skip(offset);
         }
-        return _ParsedReply._(type: type, elements: elements);
+        return offset;
       default:
-        return _ParsedReply._(type: _redisReplyNil);
+        throw StateError('Unknown reply tag $type');
+    }
+  }
+
+  /// A view of the length-prefixed string at [offset].
+  Uint8List _inlineBytes(int offset) {
+    final start = offset + 4;
+    return Uint8List.sublistView(bytes, start, start + _length(offset));
+  }
+
+  /// The external string whose index is at [offset], if it arrived.
+  Uint8List? _external(int offset) {
+    final index = _length(offset) + 1;
+    return index < message.length ? message[index] as Uint8List : null;
+  }
+
+  bool _isString(int type) =>
+      type == _redisReplyString ||
+      type == _redisReplyStatus ||
+      type == _redisReplyError ||
+      type == _redisReplyDouble ||
+      type == _redisReplyBignum ||
+      type == _redisReplyVerb;
+
+  /// The bytes of the string reply at [offset], or null for other types.
+  Uint8List? bytesAt(int offset) {
+    final type = bytes[offset];
+    if (_isString(type)) return _inlineBytes(offset + 1);
+    if (type == _replyTagExternal) return _external(offset + 2);
+    return null;
+  }
+
+  /// The string reply at [offset] decoded as UTF-8, or null for other types.
+  String? stringAt(int offset) {
+    final type = bytes[offset];
+    if (_isString(type)) {
+      final start = offset + 5;
+      return _utf8Decoder.convert(bytes, start, start + _length(offset + 1));
+    }
+    if (type == _replyTagExternal) {
+      final external = _external(offset + 2);
+      return external == null ? null : _utf8Decoder.convert(external);
+    }
+    return null;
+  }
+
+  /// The integer (or boolean) reply at [offset], or null for other types.
+  int? intAt(int offset) => switch (bytes[offset]) {
+    _redisReplyInteger => data.getInt64(offset + 1, Endian.little),
+    _redisReplyBool => bytes[offset + 1],
+    _ => null,
+  };
+}
+
+/// Cursor over a native reply batch: back-to-back records of a little-endian
+/// int64 command id followed by a flat-encoded reply (see `encodeReply` and
+/// `appendReply` in async_loop.zig).
+class _ReplyReader {
+  final _ReplyBuffer _buffer;
+  var _offset = 0;
+
+  _ReplyReader._(Uint8List bytes, List<Object?> message)
+    : _buffer = _ReplyBuffer(bytes, message);
+
+  /// Returns a reader for a reply message, or null if [message] is not one.
+  static _ReplyReader? forMessage(Object? message) {
+    if (message is Uint8List) return _ReplyReader._(message, const []);
+    if (message is List && message.isNotEmpty && message[0] is Uint8List) {
+      return _ReplyReader._(message[0] as Uint8List, message);
     }
+    return null;
+  }
+
+  bool get hasMore => _offset < _buffer.bytes.length;
+
+  int readCommandId() {
+    final value = _buffer.data.getInt64(_offset, Endian.little);
+    _offset += 8;
+    return value;
+  }
+
+  /// Returns the reply at the cursor, as a view, and moves past it.
+  _ParsedReply? read() {
+    final reply = _buffer.decodeAt(_offset);
+    _offset = _buffer.skip(_offset);
+    return reply;
   }
 }
 
@@ -121,6 +545,22 @@ enum RedisPubSubMessageType {
   punsubscribe,
 }
 
+/// What a client does with pub/sub messages its listeners can't keep up with.
+///
+/// See `subscriptionBufferSize` in [RedisClient.connect].
+enum RedisPubSubOverflow {
+  /// Discard the oldest buffered message to make room.
+  dropOldest,
+
+  /// Discard the incoming message.
+  dropNewest,
+
+  /// Stop reading from the socket until the listeners catch up, so TCP
+  /// pushes back on the server. Nothing is lost, but Redis disconnects
+  /// subscribers that exceed its `client-output-buffer-limit pubsub`.
+  pause,
+}
+
 /// A message received from a Redis pub/sub subscription.
 class RedisPubSubMessage {
   /// The type of message.
@@ -167,24 +607,204 @@ class RedisPubSubMessage {
 ///   await client.close();
 /// }
 /// ```
-class RedisClient {
+class RedisClient with RedisCommands {
   final String _host;
   final int _port;
   final Pointer<EventLoopState> _eventLoop;
   final ReceivePort _receivePort;
+  final RedisReactor? _reactor;
+  final _RespWriter _writer;
+  final int _subscriptionBufferSize;
+  final RedisPubSubOverflow _subscriptionOverflow;
+
+  /// Whether this client was attached to another isolate's event loop with
+  /// [RedisConnectionHandle.attach].
+  final bool _attached;
+
+  final RedisReconnectOptions? _reconnect;
+
+  /// Timeout of commands sent without one of their own, in milliseconds (0:
+  /// none).
+  final int _commandTimeoutMs;
+
+  /// Opens another connection with the options of [connect]; null for an
+  /// attached client.
+  final Future<RedisClient> Function()? _connectAgain;
+
+  /// Commands that set up the session, by [_sessionCommandKey], sent again
+  /// first on every new connection.
+  final _session = <String, List<Object>>{};
+
+  /// Whether the commands being sent are part of a `MULTI` transaction.
+  var _inTransaction = false;
 
-  final _pendingCommands = <int, Completer<_ParsedReply?>>{};
+  final _pendingCommands = _PendingCommands();
+  _RedisSubscriber? _subscriber;
+  _ClientCache? _cache;
   var _nextCommandId = 0;
   var _closed = false;
   var _flushScheduled = false;
 
-  RedisClient._(this._host, this._port, this._eventLoop, this._receivePort);
+  RedisClient._(
+    this._host,
+    this._port,
+    this._eventLoop,
+    this._receivePort,
+    this._reactor,
+    this._subscriptionBufferSize,
+    this._subscriptionOverflow, {
+    bool attached = false,
+    RedisReconnectOptions? reconnect,
+    int commandTimeoutMs = 0,
+    Future<RedisClient> Function()? connectAgain,
+  }) : _attached = attached,
+       _reconnect = reconnect,
+       _commandTimeoutMs = commandTimeoutMs,
+       _connectAgain = connectAgain,
+       _writer = _RespWriter(_eventLoop) {
+    _receivePort.listen((message) {
+      if (_closed) return;
+      if (message is int) {
+        if (message == -1) {
+          _handleDisconnect();
+        } else if (message == _msgReconnecting) {
+          // Tracking ended with the connection; reads in flight are not
+          // stored
+          _cache?.clear();
+        }
+        return;
+      }
+      final reader = _ReplyReader.forMessage(message);
+      if (reader != null) {
+        _onRepliesReceived(reader);
+      }
+    });
+  }
 
   /// Connects to a Redis server.
   ///
+  /// By default the connection gets its own native poll thread. Pass a shared
+  /// [reactor] to host it (and its [subscribe] streams) on one of the
+  /// reactor's I/O threads instead.
+  ///
+  /// Replies that arrive in the same socket read are delivered to Dart as one
+  /// message. [maxReplyBatchBytes] and [maxReplyBatchSize] bound such a
+  /// message (by default 1 MiB and 4096 replies).
+  ///
+  /// Values of at least [externalValueThreshold] bytes (64 KiB by default)
+  /// are handed to Dart without copying: the buffer hiredis read them into
+  /// becomes the reply's backing store and is freed when it is garbage
+  /// collected. Pass 0 to always copy.
+  ///
+  /// By default pub/sub messages are delivered as fast as they arrive. With
+  /// [subscriptionBufferSize], at most that many messages are in flight to
+  /// [subscribe] listeners that have not taken them yet (a paused stream,
+  /// e.g. inside a slow `await for`, or a busy isolate); up to that many more
+  /// are buffered natively, and then [subscriptionOverflow] decides what
+  /// happens. [subscriptionStats] reports how far behind the listeners are.
+  ///
+  /// [protocol] 3 switches the connection to RESP3 with `HELLO 3` (Redis 6
+  /// or later): replies carry maps, doubles and booleans natively and the
+  /// server can push frames. On top of it, [cache] enables a client-side
+  /// cache of [get] and [hget] results, kept coherent with `CLIENT TRACKING`
+  /// invalidations. Commands sent through this client drop the cached
+  /// entries named by their arguments, so it always sees its own writes.
+  ///
+  /// With [instrument], the event loop timestamps every command as it is
+  /// queued, submitted, written, answered and delivered, and [stats] reports
+  /// the resulting histograms as [RedisClientStats.latency]. Without it, no
+  /// timestamps are taken.
+  ///
+  /// With [ioUring], a client without a [reactor] drives its socket with
+  /// io_uring on Linux 5.10 or later: the socket read, the write of queued
+  /// commands and the wakeup wait share one system call per loop iteration.
+  /// Where io_uring is unavailable the client silently uses poll instead;
+  /// [RedisClientStats.ioUring] tells which one is in use.
+  ///
+  /// With [reconnect], a lost connection is replaced instead of failing the
+  /// client: after a random backoff the event loop connects again, sends
+  /// the commands that set up the session (`AUTH`, `SELECT`, `HELLO`,
+  /// `CLIENT TRACKING` and `CLIENT SETNAME`, as last sent successfully) and
+  /// then the commands queued meanwhile. Commands that were already sent are
+  /// sent again or failed by [RedisReconnectOptions.replay]; a replayed
+  /// command goes after the ones queued meanwhile, and commands of a
+  /// transaction always fail. [subscribe] streams subscribe again, and
+  /// [connectionState] tells where the connection is. Requires a client
+  /// without a [reactor].
+  ///
+  /// With [commandTimeout], a command whose reply has not arrived that long
+  /// after it was handed to the connection fails with a
+  /// [RedisTimeoutException]; [withTimeout] sets a different timeout for
+  /// some calls. Blocking commands (`BLPOP` and the like, `WAIT`, `XREAD`
+  /// with `BLOCK`) are exempt unless sent through [withTimeout]. Deadlines
+  /// are kept natively, so outstanding commands cost no [Timer] each. The
+  /// connection stays usable after a timeout: the late reply is dropped when
+  /// it arrives. With [closeOnTimeout], a timeout instead counts as a lost
+  /// connection, replaced with [reconnect] and failing the client otherwise.
+  ///
+  /// With [compressionThreshold], values of at least that many bytes written
+  /// by `SET`, `MSET`, `HSET`, `LPUSH` and their variants are compressed
+  /// with LZ4 on the native I/O thread before they are sent, behind a
+  /// header that marks them as compressed and holds a checksum of the raw
+  /// bytes. Every string reply carrying the header is decompressed there
+  /// before it reaches Dart, whatever command read it, if its body matches
+  /// the checksum; values without it are returned as they are, so data
+  /// written without compression stays readable. A binary value that is
+  /// itself such a frame is returned decompressed. The elements `LREM`,
+  /// `LPOS` and `LINSERT` look for are compressed alike, so they find the
+  /// ones stored compressed. Keys, fields and members are never compressed. Commands that work on part of a value (`APPEND`,
+  /// `GETRANGE`, `STRLEN`, ...) and clients without compression see the
+  /// compressed bytes.
+  ///
   /// Returns a [Future] that completes with the connected client.
-  static Future<RedisClient> connect(String host, int port) async {
+  static Future<RedisClient> connect(
+    String host,
+    int port, {
+    RedisReactor? reactor,
+    int? maxReplyBatchBytes,
+    int? maxReplyBatchSize,
+    int? externalValueThreshold,
+    int? subscriptionBufferSize,
+    RedisPubSubOverflow subscriptionOverflow = RedisPubSubOverflow.dropOldest,
+    int protocol = 2,
+    RedisCacheOptions? cache,
+    bool instrument = false,
+    bool ioUring = false,
+    RedisReconnectOptions? reconnect,
+    Duration? commandTimeout,
+    bool closeOnTimeout = false,
+    int? compressionThreshold,
+  }) async {
     _ensureDartApiInitialized();
+    reactor?._checkNotClosed();
+    final commandTimeoutMs = _timeoutMillis(commandTimeout, 'commandTimeout');
+    if (reconnect != null && reactor != null) {
+      throw ArgumentError.value(
+        reconnect,
+        'reconnect',
+        'requires a client without a reactor',
+      );
+    }
+    if (protocol != 2 && protocol != 3) {
+      throw ArgumentError.value(protocol, 'protocol', 'must be 2 or 3');
+    }
+    if (cache != null && protocol != 3) {
+      throw ArgumentError.value(cache, 'cache', 'requires protocol 3');
+    }
+    if (subscriptionBufferSize != null && subscriptionBufferSize < 1) {
+      throw ArgumentError.value(
+        subscriptionBufferSize,
+        'subscriptionBufferSize',
+        'must be at least 1',
+      );
+    }
+    if (compressionThreshold != null && compressionThreshold < 1) {
+      throw ArgumentError.value(
+        compressionThreshold,
+        'compressionThreshold',
+        'must be at least 1',
+      );
+    }
 
     final options = calloc<redisOptions>();
     try {
@@ -221,28 +841,88 @@ class RedisClient {
           redisAsyncFree(ctx);
           throw RedisException('Failed to create event loop');
         }
+        if (maxReplyBatchBytes != null || maxReplyBatchSize != null) {
+          redis_event_loop_set_reply_batch_limits(
+            eventLoop,
+            maxReplyBatchBytes ?? 0,
+            maxReplyBatchSize ?? 0,
+          );
+        }
+        if (externalValueThreshold != null) {
+          redis_event_loop_set_external_threshold(
+            eventLoop,
+            externalValueThreshold,
+          );
+        }
+        if (instrument && !redis_event_loop_enable_instruments(eventLoop)) {
+          receivePort.close();
+          redis_event_loop_destroy(eventLoop);
+          throw RedisException('Failed to enable instrumentation');
+        }
+        if (ioUring && reactor == null) {
+          // Falls back to poll where unsupported
+          redis_event_loop_enable_io_uring(eventLoop);
+        }
+        if (reconnect != null &&
+            !_enableReconnect(eventLoop, hostPtr, port, reconnect)) {
+          receivePort.close();
+          redis_event_loop_destroy(eventLoop);
+          throw RedisException('Failed to enable reconnect');
+        }
+        if (closeOnTimeout) {
+          redis_event_loop_set_close_on_timeout(eventLoop, true);
+        }
+        if (compressionThreshold != null &&
+            !redis_event_loop_set_compression(
+              eventLoop,
+              compressionThreshold,
+            )) {
+          receivePort.close();
+          redis_event_loop_destroy(eventLoop);
+          throw RedisException('Failed to enable compression');
+        }
+
+        final client = RedisClient._(
+          host,
+          port,
+          eventLoop,
+          receivePort,
+          reactor,
+          subscriptionBufferSize ?? 0,
+          subscriptionOverflow,
+          reconnect: reconnect,
+          commandTimeoutMs: commandTimeoutMs,
+          // For connections of its own, e.g. a stream consumer's; they
+          // need no cache or subscription buffering
+          connectAgain: () => connect(
+            host,
+            port,
+            reactor: reactor,
+            maxReplyBatchBytes: maxReplyBatchBytes,
+            maxReplyBatchSize: maxReplyBatchSize,
+            externalValueThreshold: externalValueThreshold,
+            protocol: protocol,
+            instrument: instrument,
+            ioUring: ioUring,
+            reconnect: reconnect,
+            commandTimeout: commandTimeout,
+            closeOnTimeout: closeOnTimeout,
+            compressionThreshold: compressionThreshold,
+          ),
+        );
 
-        final client = RedisClient._(host, port, eventLoop, receivePort);
-
-        receivePort.listen((message) {
-          if (client._closed) return;
-          if (message is int && message == -1) {
-            client._handleDisconnect();
-            return;
-          }
-          if (message is List && message.length == 2) {
-            final commandId = message[0] as int;
-            final replyData = message[1];
-            client._onReplyReceived(commandId, replyData);
-          }
-        });
-
-        if (!redis_event_loop_start(eventLoop)) {
+        final started = reactor != null
+            ? reactor._start(eventLoop)
+            : redis_event_loop_start(eventLoop);
+        if (!started) {
           receivePort.close();
           redis_event_loop_destroy(eventLoop);
           redisAsyncFree(ctx);
           throw RedisException('Failed to start event loop');
         }
+        reactor?._register(client, client.close);
+
+        if (protocol == 3) await client._enableResp3(cache);
 
         return client;
       } finally {
@@ -253,6 +933,34 @@ class RedisClient {
     }
   }
 
+  /// Sends `HELLO 3` and, with [cache], turns on key tracking.
+  Future<void> _enableResp3(RedisCacheOptions? cache) async {
+    try {
+      await _command(['HELLO', '3']);
+      if (cache != null) {
+        await _command(cache._trackingCommand);
+        _cache = _ClientCache(cache);
+      }
+    } catch (_) {
+      await close();
+      rethrow;
+    }
+  }
+
+  static bool _enableReconnect(
+    Pointer<EventLoopState> eventLoop,
+    Pointer<Utf8> host,
+    int port,
+    RedisReconnectOptions options,
+  ) => redis_event_loop_enable_reconnect(
+    eventLoop,
+    host.cast(),
+    port,
+    options.initialDelay.inMilliseconds,
+    options.maxDelay.inMilliseconds,
+    options.maxAttempts ?? 0,
+  );
+
   static String _extractErrorString(Pointer<Char> errstr) {
     if (errstr == nullptr) return 'Unknown error';
     return errstr.cast<Utf8>().toDartString();
@@ -264,1586 +972,364 @@ class RedisClient {
     }
   }
 
+  /// Commands sent (or queued) that have not been answered yet.
+  int get _inFlight => _pendingCommands.length;
+
   void _handleDisconnect() {
     if (_closed) return;
-    for (final completer in _pendingCommands.values) {
+    for (final completer in _pendingCommands.clear()) {
       if (!completer.isCompleted) {
         completer.completeError(RedisException('Connection lost'));
       }
     }
-    _pendingCommands.clear();
+    // Nothing is tracked for us any more
+    _cache?.clear();
+  }
+
+  /// Dispatches a batch of (commandId, reply) records from the native side.
+  /// Replies arrive in command order and complete the oldest pending command;
+  /// a command the event loop failed to send fails ahead of them.
+  void _onRepliesReceived(_ReplyReader reader) {
+    while (!_closed && reader.hasMore) {
+      final commandId = reader.readCommandId();
+      final reply = reader.read();
+      if (commandId == _pushCommandId) {
+        _cache?.onPush(reply);
+        continue;
+      }
+      if (commandId == _timingCommandId) {
+        redis_event_loop_record_delivery(_eventLoop, reply?.integer ?? 0);
+        continue;
+      }
+      if (commandId == _lostCommandId) {
+        _replayOrFail(reply?.integer ?? -1);
+        continue;
+      }
+      if (commandId == _expiredCommandId) {
+        _pendingCommands
+            .expire(reply?.integer ?? -1)
+            ?.completeError(RedisTimeoutException('Command timed out'));
+        continue;
+      }
+      final completer = _pendingCommands.remove(commandId);
+      if (completer == null) continue;
+
+      if (reply != null && reply.isError) {
+        completer.completeError(
+          RedisException(reply.string ?? 'Unknown error'),
+        );
+      } else {
+        completer.complete(reply);
+      }
+    }
   }
 
-  void _onReplyReceived(int commandId, dynamic replyData) {
-    if (_closed) return;
+  /// Sends the pending command [commandId], lost with its connection before
+  /// it was answered, again if it was sent with a replay, and fails it
+  /// otherwise.
+  void _replayOrFail(int commandId) {
+    final replay = _pendingCommands.replayOf(commandId);
     final completer = _pendingCommands.remove(commandId);
     if (completer == null) return;
-
-    final reply = _ParsedReply.fromNative(replyData);
-    if (reply != null && reply.isError) {
-      completer.completeError(RedisException(reply.string ?? 'Unknown error'));
-    } else {
-      completer.complete(reply);
+    if (replay == null) {
+      completer.completeError(RedisException('Connection lost'));
+      return;
     }
+    final id = _nextCommandId++;
+    _writer.add(
+      id,
+      replay.args,
+      replay.shape,
+      _timeoutFor(replay.args, replay.timeoutMs),
+    );
+    _pendingCommands.add(id, completer, replay);
+    _scheduleFlush();
   }
 
-  /// Sends a raw command and returns the reply.
-  /// Commands are automatically batched and flushed via microtask.
-  Future<_ParsedReply?> _command(List<String> args) async {
+  /// Commands are encoded as RESP into the current batch, which is handed to
+  /// the event loop via microtask.
+  ///
+  /// [timeoutMs] overrides the client's command timeout (0: none).
+  @override
+  Future<_ParsedReply?> _command(
+    List<Object> args, [
+    int shape = _shapeGeneric,
+    int? timeoutMs,
+  ]) async {
     _checkNotClosed();
 
-    final commandId = _nextCommandId++;
-    final completer = Completer<_ParsedReply?>();
-    _pendingCommands[commandId] = completer;
-
-    final argc = args.length;
-    final argv = calloc<Pointer<Char>>(argc);
-    final argvlen = calloc<Size>(argc);
-
-    try {
-      for (var i = 0; i < argc; i++) {
-        final arg = args[i].toNativeUtf8();
-        argv[i] = arg.cast();
-        argvlen[i] = args[i].length;
-      }
-
-      final result = redis_async_command_enqueue(
-        _eventLoop,
-        _receivePort.sendPort.nativePort,
-        commandId,
-        argc,
-        argv,
-        argvlen,
-      );
+    _invalidateArguments(args);
+    final reply = _send(args, Completer<_ParsedReply?>(), shape, timeoutMs);
+    if (_reconnect == null || _attached) return reply;
 
-      if (result != 0) {
-        _pendingCommands.remove(commandId);
-        throw RedisException('Failed to send command');
-      }
+    final key = _sessionCommandKey(args);
+    if (key == null) return reply;
+    final result = await reply;
+    _rememberSession(key, args);
+    return result;
+  }
 
-      _scheduleFlush();
-    } finally {
-      for (var i = 0; i < argc; i++) {
-        if (argv[i] != nullptr) {
-          calloc.free(argv[i].cast<Utf8>());
-        }
-      }
-      calloc.free(argv);
-      calloc.free(argvlen);
+  /// Keeps [args] in the handshake of new connections, replacing the
+  /// command kept under [key].
+  void _rememberSession(String key, List<Object> args) {
+    if (_closed) return;
+    _session[key] = args;
+    final writer = _RespWriter(_eventLoop);
+    for (final command in _session.values) {
+      writer.add(0, command);
     }
-
-    return completer.future;
+    redis_event_loop_set_handshake(_eventLoop, writer.take());
   }
 
-  /// Schedules a flush via microtask if not already scheduled.
-  /// This batches all commands issued in the current event loop turn.
-  void _scheduleFlush() {
-    if (!_flushScheduled) {
-      _flushScheduled = true;
-      scheduleMicrotask(() {
-        _flushScheduled = false;
-        if (!_closed) {
-          redis_event_loop_wakeup(_eventLoop);
-        }
-      });
+  /// Drops cached entries for every key a command may write.
+  void _invalidateArguments(List<Object> args) {
+    final cache = _cache;
+    if (cache == null) return;
+    for (final key in _writtenKeys(args)) {
+      if (key is String) cache.invalidate(key);
     }
   }
 
-  /// Pings the server.
-  Future<String> ping([String? message]) async {
-    final reply = await _command(
-      message != null ? ['PING', message] : ['PING'],
-    );
-    return reply?.string ?? 'PONG';
-  }
+  /// Serves reads of tracked keys from the client-side cache, if enabled.
+  @override
+  Future<_ParsedReply?> _cachedRead(
+    String key,
+    String? field,
+    List<Object> args, [
+    int? timeoutMs,
+  ]) async {
+    final cache = _cache;
+    if (cache == null || !cache.accepts(key)) {
+      return _command(args, _shapeGeneric, timeoutMs);
+    }
+    _checkNotClosed();
 
-  // ============ String Commands ============
+    final entry = cache.lookup(key, field);
+    if (entry != null) {
+      return field == null ? entry.value : entry.fields![field];
+    }
 
-  /// Gets the value of a key.
-  ///
-  /// Returns `null` if the key does not exist.
-  Future<String?> get(String key) async {
-    final reply = await _command(['GET', key]);
-    return reply?.string;
+    if (cache.options.mode == RedisTrackingMode.optIn) {
+      // Applies to the next command, which the writer puts right after it
+      _send(const ['CLIENT', 'CACHING', 'YES'], Completer()).ignore();
+    }
+    cache.readSent(key);
+    return _send(
+      args,
+      _CachedReadCompleter(cache, key, field),
+      _shapeGeneric,
+      timeoutMs,
+    );
   }
 
-  /// Sets a key to a value.
-  ///
-  /// Options:
-  /// - [ex]: Set expiry in seconds
-  /// - [px]: Set expiry in milliseconds
-  /// - [exat]: Set expiry at Unix timestamp in seconds
-  /// - [pxat]: Set expiry at Unix timestamp in milliseconds
-  /// - [nx]: Only set if key does not exist
-  /// - [xx]: Only set if key already exists
-  /// - [keepTtl]: Retain the existing TTL
-  /// - [get]: Return the old value stored at key
-  ///
-  /// Returns the old value if [get] is true, otherwise returns `null`.
-  Future<String?> set(
-    String key,
-    String value, {
-    int? ex,
-    int? px,
-    int? exat,
-    int? pxat,
-    bool nx = false,
-    bool xx = false,
-    bool keepTtl = false,
-    bool get = false,
-  }) async {
-    final args = ['SET', key, value];
-    if (ex != null) args.addAll(['EX', ex.toString()]);
-    if (px != null) args.addAll(['PX', px.toString()]);
-    if (exat != null) args.addAll(['EXAT', exat.toString()]);
-    if (pxat != null) args.addAll(['PXAT', pxat.toString()]);
-    if (nx) args.add('NX');
-    if (xx) args.add('XX');
-    if (keepTtl) args.add('KEEPTTL');
-    if (get) args.add('GET');
-
-    final reply = await _command(args);
-    return reply?.string;
-  }
+  /// Appends a command to the current batch; [completer] gets its reply,
+  /// encoded natively by the [shape] hint, or a [RedisTimeoutException]
+  /// after [timeoutMs] (by default the client's command timeout).
+  Future<_ParsedReply?> _send(
+    List<Object> args,
+    Completer<_ParsedReply?> completer, [
+    int shape = _shapeGeneric,
+    int? timeoutMs,
+  ]) {
+    final commandId = _nextCommandId++;
+    _writer.add(commandId, args, shape, _timeoutFor(args, timeoutMs));
+    _pendingCommands.add(
+      commandId,
+      completer,
+      _reconnect != null ? _replayFor(args, shape, completer, timeoutMs) : null,
+    );
 
-  /// Gets the values of multiple keys.
-  ///
-  /// Returns a list of values in the same order as the keys.
-  /// Non-existent keys return `null`.
-  Future<List<String?>> mget(List<String> keys) async {
-    final reply = await _command(['MGET', ...keys]);
-    try {
-      if (reply == null) return List.filled(keys.length, null);
-      final results = <String?>[];
-      for (var i = 0; i < reply.length; i++) {
-        results.add(reply[i]?.string);
-      }
-      return results;
-    } finally {}
+    _scheduleFlush();
+    return completer.future;
   }
 
-  /// Sets multiple keys to their respective values.
-  Future<void> mset(Map<String, String> keyValues) async {
-    final args = ['MSET'];
-    keyValues.forEach((key, value) {
-      args.addAll([key, value]);
-    });
-    await _command(args);
+  /// The timeout of [args] in milliseconds (0: none): [timeoutMs] if given,
+  /// else the client's command timeout unless the command blocks.
+  int _timeoutFor(List<Object> args, int? timeoutMs) {
+    if (timeoutMs != null) return timeoutMs;
+    if (_commandTimeoutMs == 0 || args.isEmpty || _isBlocking(args)) return 0;
+    return _commandTimeoutMs;
   }
 
-  /// Sets multiple keys only if none of them exist.
-  ///
-  /// Returns `true` if all keys were set, `false` if no keys were set
-  /// (because at least one key already existed).
-  Future<bool> msetnx(Map<String, String> keyValues) async {
-    final args = ['MSETNX'];
-    keyValues.forEach((key, value) {
-      args.addAll([key, value]);
-    });
-    final reply = await _command(args);
-    return (reply?.integer ?? 0) == 1;
-  }
+  /// What to send again if the connection is lost before the reply to
+  /// [args] arrived, by the replay policy; null to fail it.
+  _QueuedCommand? _replayFor(
+    List<Object> args,
+    int shape,
+    Completer<_ParsedReply?> completer,
+    int? timeoutMs,
+  ) {
+    final policy = _reconnect!.replay;
+    if (policy == RedisReplayPolicy.never || args.isEmpty) return null;
+    final name = args.first;
+    final command = name is String ? name.toUpperCase() : '';
+
+    // A command of a transaction must not run on its own
+    switch (command) {
+      case 'MULTI':
+        _inTransaction = true;
+        return null;
+      case 'EXEC' || 'DISCARD':
+        _inTransaction = false;
+        return null;
+    }
+    if (_inTransaction) return null;
 
-  /// Increments the integer value of a key by one.
-  ///
-  /// Returns the new value after incrementing.
-  Future<int> incr(String key) async {
-    final reply = await _command(['INCR', key]);
-    return reply?.integer ?? 0;
+    if (policy == RedisReplayPolicy.idempotent &&
+        !_isIdempotent(command, args)) {
+      return null;
+    }
+    return _QueuedCommand(args, shape, completer, timeoutMs);
   }
 
-  /// Increments the integer value of a key by the given amount.
-  ///
-  /// Returns the new value after incrementing.
-  Future<int> incrby(String key, int increment) async {
-    final reply = await _command(['INCRBY', key, increment.toString()]);
-    return reply?.integer ?? 0;
+  /// Writes [commands] into the current batch and submits it right away,
+  /// with one wakeup of the event loop.
+  void _submit(List<_QueuedCommand> commands) {
+    _checkNotClosed();
+    for (final command in commands) {
+      _invalidateArguments(command.args);
+      _send(command.args, command.completer, command.shape, command.timeoutMs);
+    }
+    _flush();
   }
 
-  /// Increments the floating point value of a key by the given amount.
+  /// Returns the commands of this client with [timeout] instead of the
+  /// client's `commandTimeout` (see [connect]); null sends them without a
+  /// timeout. Applies to blocking commands too.
   ///
-  /// Returns the new value after incrementing.
-  Future<double> incrbyfloat(String key, double increment) async {
-    final reply = await _command(['INCRBYFLOAT', key, increment.toString()]);
-    try {
-      final str = reply?.string;
-      return str != null ? double.parse(str) : 0.0;
-    } finally {}
-  }
-
-  /// Decrements the integer value of a key by one.
+  /// The returned object is a lightweight view; create one per call site or
+  /// keep it, as convenient.
   ///
-  /// Returns the new value after decrementing.
-  Future<int> decr(String key) async {
-    final reply = await _command(['DECR', key]);
-    return reply?.integer ?? 0;
+  /// Example:
+  /// ```dart
+  /// final value = await client
+  ///     .withTimeout(const Duration(milliseconds: 200))
+  ///     .get('key');
+  /// ```
+  RedisCommands withTimeout(Duration? timeout) {
+    _checkNotClosed();
+    return _TimeoutCommands(this, _timeoutMillis(timeout, 'timeout'));
   }
 
-  /// Decrements the integer value of a key by the given amount.
-  ///
-  /// Returns the new value after decrementing.
-  Future<int> decrby(String key, int decrement) async {
-    final reply = await _command(['DECRBY', key, decrement.toString()]);
-    return reply?.integer ?? 0;
+  /// Returns a pipeline: commands queued on it are sent together, in one
+  /// batch, when [RedisPipeline.execute] is called.
+  RedisPipeline pipeline() {
+    _checkNotClosed();
+    return RedisPipeline._(this, (commands) async => _submit(commands));
   }
 
-  /// Appends a value to a key.
-  ///
-  /// Returns the length of the string after the append.
-  Future<int> append(String key, String value) async {
-    final reply = await _command(['APPEND', key, value]);
-    return reply?.integer ?? 0;
+  /// Returns a transaction: commands queued on it are sent in one batch
+  /// between `MULTI` and `EXEC` when [RedisTransaction.execute] is called.
+  RedisTransaction transaction() {
+    _checkNotClosed();
+    return RedisTransaction._(this, (commands) async => _submit(commands));
   }
 
-  /// Returns the length of the string stored at key.
-  Future<int> strlen(String key) async {
-    final reply = await _command(['STRLEN', key]);
-    return reply?.integer ?? 0;
+  /// Schedules a flush via microtask if not already scheduled.
+  /// This batches all commands issued in the current event loop turn.
+  void _scheduleFlush() {
+    if (!_flushScheduled) {
+      _flushScheduled = true;
+      scheduleMicrotask(() {
+        _flushScheduled = false;
+        // Empty if a pipeline submitted the batch already
+        if (!_closed && !_writer.isEmpty) {
+          _flush();
+        }
+      });
+    }
   }
 
-  /// Sets or clears the bit at offset in the string value stored at key.
-  ///
-  /// Returns the original bit value at the offset.
-  Future<int> setbit(String key, int offset, int value) async {
-    final reply = await _command([
-      'SETBIT',
-      key,
-      offset.toString(),
-      value.toString(),
-    ]);
-    return reply?.integer ?? 0;
+  /// Submits the current batch and wakes up the poll thread.
+  void _flush() {
+    final failed = _writer.flush(_receivePort.sendPort.nativePort);
+    // The batch holds exactly the commands added since the last flush
+    for (final completer in _pendingCommands.removeLast(failed.length)) {
+      completer.completeError(RedisException('Failed to send command'));
+    }
+    redis_event_loop_wakeup(_eventLoop);
   }
 
-  /// Returns the bit value at offset in the string value stored at key.
-  Future<int> getbit(String key, int offset) async {
-    final reply = await _command(['GETBIT', key, offset.toString()]);
-    return reply?.integer ?? 0;
+  /// Returns a snapshot of the native event loop counters.
+  RedisClientStats stats() {
+    _checkNotClosed();
+    final out = calloc<EventLoopStats>();
+    try {
+      if (redis_event_loop_get_stats(_eventLoop, out) != 0) {
+        throw RedisException('Failed to read event loop stats');
+      }
+      return RedisClientStats(
+        pollWakeups: out.ref.poll_wakeups,
+        spuriousWakeups: out.ref.spurious_wakeups,
+        commandPoolHighWater: out.ref.command_pool_high_water,
+        commandPoolCached: out.ref.command_pool_cached,
+        commandPoolOversize: out.ref.command_pool_oversize,
+        callbackPoolHighWater: out.ref.callback_pool_high_water,
+        callbackPoolCached: out.ref.callback_pool_cached,
+        replyMessages: out.ref.reply_posts,
+        latency: out.ref.instrumented != 0 ? _latencyStats(out.ref) : null,
+        ioUring: out.ref.io_uring != 0,
+        reconnects: out.ref.reconnects,
+        timeouts: out.ref.timeouts,
+        valuesCompressed: out.ref.values_compressed,
+        valuesDecompressed: out.ref.values_decompressed,
+      );
+    } finally {
+      calloc.free(out);
+    }
   }
 
-  /// Overwrites part of the string stored at key starting at the specified offset.
-  ///
-  /// Returns the length of the string after it was modified.
-  Future<int> setrange(String key, int offset, String value) async {
-    final reply = await _command(['SETRANGE', key, offset.toString(), value]);
-    return reply?.integer ?? 0;
-  }
+  RedisLatencyStats _latencyStats(EventLoopStats counters) {
+    final buckets = calloc<Uint64>(_histogramBuckets);
+    try {
+      RedisHistogram histogram(int kind) {
+        final n = redis_event_loop_get_histogram(
+          _eventLoop,
+          kind,
+          buckets,
+          _histogramBuckets,
+        );
+        return RedisHistogram.fromBuckets(
+          n < 0 ? const [] : buckets.asTypedList(n),
+        );
+      }
 
-  /// Returns a substring of the string stored at key.
-  Future<String?> getrange(String key, int start, int end) async {
-    final reply = await _command([
-      'GETRANGE',
-      key,
-      start.toString(),
-      end.toString(),
-    ]);
-    return reply?.string;
+      // Kinds as in instruments.zig
+      return RedisLatencyStats(
+        queueWait: histogram(0),
+        write: histogram(1),
+        reply: histogram(2),
+        post: histogram(3),
+        delivery: histogram(4),
+        batchSize: histogram(5),
+        bytesOut: counters.bytes_out,
+        bytesIn: counters.bytes_in,
+        drains: counters.drains,
+      );
+    } finally {
+      calloc.free(buckets);
+    }
   }
 
-  /// Sets the value and expiration of a key in seconds.
-  Future<void> setex(String key, int seconds, String value) async {
-    await _command(['SETEX', key, seconds.toString(), value]);
-  }
-
-  /// Sets the value and expiration of a key in milliseconds.
-  Future<void> psetex(String key, int milliseconds, String value) async {
-    await _command(['PSETEX', key, milliseconds.toString(), value]);
-  }
-
-  /// Sets the value of a key only if the key does not exist.
-  ///
-  /// Returns `true` if the key was set, `false` if it already existed.
-  Future<bool> setnx(String key, String value) async {
-    final reply = await _command(['SETNX', key, value]);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Atomically sets a key to a value and returns the old value.
-  Future<String?> getset(String key, String value) async {
-    final reply = await _command(['GETSET', key, value]);
-    return reply?.string;
-  }
-
-  /// Gets the value of a key and deletes it.
-  Future<String?> getdel(String key) async {
-    final reply = await _command(['GETDEL', key]);
-    return reply?.string;
-  }
-
-  /// Gets the value of a key and optionally sets its expiration.
-  Future<String?> getex(
-    String key, {
-    int? ex,
-    int? px,
-    int? exat,
-    int? pxat,
-    bool persist = false,
-  }) async {
-    final args = ['GETEX', key];
-    if (ex != null) args.addAll(['EX', ex.toString()]);
-    if (px != null) args.addAll(['PX', px.toString()]);
-    if (exat != null) args.addAll(['EXAT', exat.toString()]);
-    if (pxat != null) args.addAll(['PXAT', pxat.toString()]);
-    if (persist) args.add('PERSIST');
-
-    final reply = await _command(args);
-    return reply?.string;
-  }
-
-  // ============ Key Commands ============
-
-  /// Deletes one or more keys.
-  ///
-  /// Returns the number of keys that were deleted.
-  Future<int> del(List<String> keys) async {
-    final reply = await _command(['DEL', ...keys]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Deletes one or more keys asynchronously (non-blocking).
-  ///
-  /// Returns the number of keys that were scheduled for deletion.
-  Future<int> unlink(List<String> keys) async {
-    final reply = await _command(['UNLINK', ...keys]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Checks if one or more keys exist.
-  ///
-  /// Returns the number of keys that exist.
-  Future<int> existsCount(List<String> keys) async {
-    final reply = await _command(['EXISTS', ...keys]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Checks if a key exists.
-  Future<bool> exists(String key) async {
-    return (await existsCount([key])) > 0;
-  }
-
-  /// Sets a timeout on a key in seconds.
-  ///
-  /// Returns `true` if the timeout was set, `false` if the key doesn't exist.
-  Future<bool> expire(String key, int seconds) async {
-    final reply = await _command(['EXPIRE', key, seconds.toString()]);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Sets a timeout on a key in milliseconds.
-  ///
-  /// Returns `true` if the timeout was set, `false` if the key doesn't exist.
-  Future<bool> pexpire(String key, int milliseconds) async {
-    final reply = await _command(['PEXPIRE', key, milliseconds.toString()]);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Sets an absolute Unix timestamp expiry on a key (in seconds).
-  ///
-  /// Returns `true` if the timeout was set, `false` if the key doesn't exist.
-  Future<bool> expireat(String key, int timestamp) async {
-    final reply = await _command(['EXPIREAT', key, timestamp.toString()]);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Sets an absolute Unix timestamp expiry on a key (in milliseconds).
-  ///
-  /// Returns `true` if the timeout was set, `false` if the key doesn't exist.
-  Future<bool> pexpireat(String key, int timestamp) async {
-    final reply = await _command(['PEXPIREAT', key, timestamp.toString()]);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Gets the remaining time to live of a key in seconds.
-  ///
-  /// Returns -2 if the key doesn't exist, -1 if the key has no expiry.
-  Future<int> ttl(String key) async {
-    final reply = await _command(['TTL', key]);
-    return reply?.integer ?? -2;
-  }
-
-  /// Gets the remaining time to live of a key in milliseconds.
-  ///
-  /// Returns -2 if the key doesn't exist, -1 if the key has no expiry.
-  Future<int> pttl(String key) async {
-    final reply = await _command(['PTTL', key]);
-    return reply?.integer ?? -2;
-  }
-
-  /// Removes the expiry from a key.
-  ///
-  /// Returns `true` if the timeout was removed, `false` if the key doesn't
-  /// exist or has no associated timeout.
-  Future<bool> persist(String key) async {
-    final reply = await _command(['PERSIST', key]);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Returns the absolute Unix timestamp (in seconds) at which the key will expire.
-  ///
-  /// Returns -2 if the key doesn't exist, -1 if the key has no expiry.
-  Future<int> expiretime(String key) async {
-    final reply = await _command(['EXPIRETIME', key]);
-    return reply?.integer ?? -2;
-  }
-
-  /// Returns the absolute Unix timestamp (in milliseconds) at which the key will expire.
-  ///
-  /// Returns -2 if the key doesn't exist, -1 if the key has no expiry.
-  Future<int> pexpiretime(String key) async {
-    final reply = await _command(['PEXPIRETIME', key]);
-    return reply?.integer ?? -2;
-  }
-
-  /// Returns the type of the value stored at key.
-  ///
-  /// Returns "none" if the key doesn't exist.
-  Future<String> type(String key) async {
-    final reply = await _command(['TYPE', key]);
-    return reply?.string ?? 'none';
-  }
-
-  /// Renames a key.
-  ///
-  /// Throws if the key doesn't exist.
-  Future<void> rename(String key, String newKey) async {
-    await _command(['RENAME', key, newKey]);
-  }
-
-  /// Renames a key only if the new key doesn't already exist.
-  ///
-  /// Returns `true` if the key was renamed, `false` if the new key already exists.
-  Future<bool> renamenx(String key, String newKey) async {
-    final reply = await _command(['RENAMENX', key, newKey]);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Returns all keys matching the given pattern.
-  ///
-  /// Warning: KEYS should not be used in production as it may block the server.
-  /// Use [scan] instead for production workloads.
-  Future<List<String>> keys(String pattern) async {
-    final reply = await _command(['KEYS', pattern]);
-    try {
-      if (reply == null) return [];
-      final results = <String>[];
-      for (var i = 0; i < reply.length; i++) {
-        final key = reply[i]?.string;
-        if (key != null) results.add(key);
-      }
-      return results;
-    } finally {}
-  }
-
-  /// Incrementally iterates over keys matching a pattern.
-  ///
-  /// Returns a tuple of (nextCursor, keys). When nextCursor is "0", iteration is complete.
-  Future<(String, List<String>)> scan(
-    String cursor, {
-    String? match,
-    int? count,
-    String? type,
-  }) async {
-    final args = ['SCAN', cursor];
-    if (match != null) args.addAll(['MATCH', match]);
-    if (count != null) args.addAll(['COUNT', count.toString()]);
-    if (type != null) args.addAll(['TYPE', type]);
-
-    final reply = await _command(args);
-    try {
-      if (reply == null || reply.length < 2) return ('0', <String>[]);
-
-      final nextCursor = reply[0]?.string ?? '0';
-      final keysReply = reply[1];
-      final keys = <String>[];
-      if (keysReply != null) {
-        for (var i = 0; i < keysReply.length; i++) {
-          final key = keysReply[i]?.string;
-          if (key != null) keys.add(key);
-        }
-      }
-      return (nextCursor, keys);
-    } finally {}
-  }
-
-  /// Returns a random key from the database.
-  Future<String?> randomkey() async {
-    final reply = await _command(['RANDOMKEY']);
-    return reply?.string;
-  }
-
-  /// Touches one or more keys (updates last access time).
-  ///
-  /// Returns the number of keys that were touched.
-  Future<int> touch(List<String> keys) async {
-    final reply = await _command(['TOUCH', ...keys]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Returns the number of bytes that a key and its value require in RAM.
-  Future<int?> memoryUsage(String key, {int? samples}) async {
-    final args = ['MEMORY', 'USAGE', key];
-    if (samples != null) args.addAll(['SAMPLES', samples.toString()]);
-
-    final reply = await _command(args);
-    return reply?.integer;
-  }
-
-  /// Copies a key to another key.
-  ///
-  /// Returns `true` if the key was copied, `false` otherwise.
-  Future<bool> copy(
-    String source,
-    String destination, {
-    int? db,
-    bool replace = false,
-  }) async {
-    final args = ['COPY', source, destination];
-    if (db != null) args.addAll(['DB', db.toString()]);
-    if (replace) args.add('REPLACE');
-
-    final reply = await _command(args);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Returns the time since the object stored at key is idle.
-  Future<int?> objectIdletime(String key) async {
-    final reply = await _command(['OBJECT', 'IDLETIME', key]);
-    return reply?.integer;
-  }
-
-  /// Returns the access frequency of the object stored at key.
-  Future<int?> objectFreq(String key) async {
-    final reply = await _command(['OBJECT', 'FREQ', key]);
-    return reply?.integer;
-  }
-
-  /// Returns the encoding of the object stored at key.
-  Future<String?> objectEncoding(String key) async {
-    final reply = await _command(['OBJECT', 'ENCODING', key]);
-    return reply?.string;
-  }
-
-  // ============ Hash Commands ============
-
-  /// Sets a field in a hash.
-  ///
-  /// Returns the number of fields that were added (0 if the field already
-  /// existed and was updated).
-  Future<int> hset(String key, String field, String value) async {
-    final reply = await _command(['HSET', key, field, value]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Sets multiple fields in a hash.
-  ///
-  /// Returns the number of fields that were added.
-  Future<int> hsetAll(String key, Map<String, String> fieldValues) async {
-    final args = ['HSET', key];
-    for (final entry in fieldValues.entries) {
-      args.addAll([entry.key, entry.value]);
-    }
-
-    final reply = await _command(args);
-    return reply?.integer ?? 0;
-  }
-
-  /// Gets the value of a field in a hash.
-  Future<String?> hget(String key, String field) async {
-    final reply = await _command(['HGET', key, field]);
-    return reply?.string;
-  }
-
-  /// Gets all fields and values in a hash.
-  Future<Map<String, String>> hgetall(String key) async {
-    final reply = await _command(['HGETALL', key]);
-    try {
-      final result = <String, String>{};
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length - 1; i += 2) {
-        final field = reply[i]?.string;
-        final value = reply[i + 1]?.string;
-        if (field != null && value != null) {
-          result[field] = value;
-        }
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Gets the values of multiple fields in a hash.
-  Future<List<String?>> hmget(String key, List<String> fields) async {
-    final reply = await _command(['HMGET', key, ...fields]);
-    try {
-      final result = <String?>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        result.add(reply[i]?.string);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Deletes one or more fields from a hash.
-  ///
-  /// Returns the number of fields that were removed.
-  Future<int> hdel(String key, List<String> fields) async {
-    final reply = await _command(['HDEL', key, ...fields]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Checks if a field exists in a hash.
-  Future<bool> hexists(String key, String field) async {
-    final reply = await _command(['HEXISTS', key, field]);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Gets all field names in a hash.
-  Future<List<String>> hkeys(String key) async {
-    final reply = await _command(['HKEYS', key]);
-    try {
-      final result = <String>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final field = reply[i]?.string;
-        if (field != null) result.add(field);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Gets all values in a hash.
-  Future<List<String>> hvals(String key) async {
-    final reply = await _command(['HVALS', key]);
-    try {
-      final result = <String>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final value = reply[i]?.string;
-        if (value != null) result.add(value);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Gets the number of fields in a hash.
-  Future<int> hlen(String key) async {
-    final reply = await _command(['HLEN', key]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Increments the integer value of a field in a hash.
-  ///
-  /// Returns the value after the increment.
-  Future<int> hincrby(String key, String field, int increment) async {
-    final reply = await _command(['HINCRBY', key, field, increment.toString()]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Increments the float value of a field in a hash.
-  ///
-  /// Returns the value after the increment.
-  Future<double> hincrbyfloat(
-    String key,
-    String field,
-    double increment,
-  ) async {
-    final reply = await _command([
-      'HINCRBYFLOAT',
-      key,
-      field,
-      increment.toString(),
-    ]);
-    try {
-      final str = reply?.string;
-      return str != null ? double.parse(str) : 0.0;
-    } finally {}
-  }
-
-  /// Sets a field in a hash only if it does not exist.
-  ///
-  /// Returns `true` if the field was set, `false` if it already existed.
-  Future<bool> hsetnx(String key, String field, String value) async {
-    final reply = await _command(['HSETNX', key, field, value]);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Gets the string length of a field value in a hash.
-  Future<int> hstrlen(String key, String field) async {
-    final reply = await _command(['HSTRLEN', key, field]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Returns a random field from a hash.
-  ///
-  /// If [count] is provided, returns that many fields (or fewer if the hash
-  /// is smaller). If [withValues] is true, returns field-value pairs.
-  Future<List<String>> hrandfield(
-    String key, {
-    int? count,
-    bool withValues = false,
-  }) async {
-    final args = ['HRANDFIELD', key];
-    if (count != null) {
-      args.add(count.toString());
-      if (withValues) args.add('WITHVALUES');
-    }
-
-    final reply = await _command(args);
-    try {
-      final result = <String>[];
-      if (reply == null) return result;
-
-      // Single field returned as string, multiple as array
-      if (reply.string != null) {
-        result.add(reply.string!);
-      } else {
-        for (var i = 0; i < reply.length; i++) {
-          final item = reply[i]?.string;
-          if (item != null) result.add(item);
-        }
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Incrementally iterates over fields in a hash.
-  ///
-  /// Returns a tuple of (nextCursor, fieldValuePairs).
-  /// When nextCursor is '0', iteration is complete.
-  Future<(String, Map<String, String>)> hscan(
-    String key,
-    String cursor, {
-    String? match,
-    int? count,
-  }) async {
-    final args = ['HSCAN', key, cursor];
-    if (match != null) args.addAll(['MATCH', match]);
-    if (count != null) args.addAll(['COUNT', count.toString()]);
-
-    final reply = await _command(args);
-    try {
-      if (reply == null || reply.length < 2) {
-        return ('0', <String, String>{});
-      }
-
-      final nextCursor = reply[0]?.string ?? '0';
-      final itemsReply = reply[1];
-      final result = <String, String>{};
-      if (itemsReply != null) {
-        for (var i = 0; i < itemsReply.length - 1; i += 2) {
-          final field = itemsReply[i]?.string;
-          final value = itemsReply[i + 1]?.string;
-          if (field != null && value != null) {
-            result[field] = value;
-          }
-        }
-      }
-      return (nextCursor, result);
-    } finally {}
-  }
-
-  // ============ List Commands ============
-
-  /// Pushes values to the left (head) of a list.
-  ///
-  /// Returns the length of the list after the push.
-  Future<int> lpush(String key, List<String> values) async {
-    final reply = await _command(['LPUSH', key, ...values]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Pushes values to the right (tail) of a list.
-  ///
-  /// Returns the length of the list after the push.
-  Future<int> rpush(String key, List<String> values) async {
-    final reply = await _command(['RPUSH', key, ...values]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Pushes a value to the left of a list only if the list exists.
-  ///
-  /// Returns the length of the list after the push, or 0 if the list doesn't
-  /// exist.
-  Future<int> lpushx(String key, List<String> values) async {
-    final reply = await _command(['LPUSHX', key, ...values]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Pushes a value to the right of a list only if the list exists.
-  ///
-  /// Returns the length of the list after the push, or 0 if the list doesn't
-  /// exist.
-  Future<int> rpushx(String key, List<String> values) async {
-    final reply = await _command(['RPUSHX', key, ...values]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Removes and returns the first element of a list.
-  Future<String?> lpop(String key) async {
-    final reply = await _command(['LPOP', key]);
-    return reply?.string;
-  }
-
-  /// Removes and returns the last element of a list.
-  Future<String?> rpop(String key) async {
-    final reply = await _command(['RPOP', key]);
-    return reply?.string;
-  }
-
-  /// Removes and returns multiple elements from the left of a list.
-  Future<List<String>> lpopCount(String key, int count) async {
-    final reply = await _command(['LPOP', key, count.toString()]);
-    try {
-      final result = <String>[];
-      if (reply == null) return result;
-
-      // Single element returned as string, multiple as array
-      if (reply.string != null) {
-        result.add(reply.string!);
-      } else {
-        for (var i = 0; i < reply.length; i++) {
-          final item = reply[i]?.string;
-          if (item != null) result.add(item);
-        }
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Removes and returns multiple elements from the right of a list.
-  Future<List<String>> rpopCount(String key, int count) async {
-    final reply = await _command(['RPOP', key, count.toString()]);
-    try {
-      final result = <String>[];
-      if (reply == null) return result;
-
-      if (reply.string != null) {
-        result.add(reply.string!);
-      } else {
-        for (var i = 0; i < reply.length; i++) {
-          final item = reply[i]?.string;
-          if (item != null) result.add(item);
-        }
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Returns a range of elements from a list.
-  ///
-  /// [start] and [stop] are zero-based indices. Negative indices count from
-  /// the end (-1 is the last element).
-  Future<List<String>> lrange(String key, int start, int stop) async {
-    final reply = await _command([
-      'LRANGE',
-      key,
-      start.toString(),
-      stop.toString(),
-    ]);
-    try {
-      final result = <String>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final item = reply[i]?.string;
-        if (item != null) result.add(item);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Returns the element at [index] in the list.
-  ///
-  /// Negative indices count from the end (-1 is the last element).
-  Future<String?> lindex(String key, int index) async {
-    final reply = await _command(['LINDEX', key, index.toString()]);
-    return reply?.string;
-  }
-
-  /// Sets the element at [index] in the list.
-  Future<void> lset(String key, int index, String value) async {
-    await _command(['LSET', key, index.toString(), value]);
-  }
-
-  /// Returns the length of a list.
-  Future<int> llen(String key) async {
-    final reply = await _command(['LLEN', key]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Inserts an element before or after a pivot element.
-  ///
-  /// Returns the length of the list after the insert, or -1 if the pivot
-  /// was not found, or 0 if the key doesn't exist.
-  Future<int> linsert(
-    String key,
-    String pivot,
-    String value, {
-    required bool before,
-  }) async {
-    final position = before ? 'BEFORE' : 'AFTER';
-    final reply = await _command(['LINSERT', key, position, pivot, value]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Removes [count] occurrences of [value] from the list.
-  ///
-  /// - count > 0: Remove from head to tail
-  /// - count < 0: Remove from tail to head
-  /// - count = 0: Remove all occurrences
-  ///
-  /// Returns the number of removed elements.
-  Future<int> lrem(String key, int count, String value) async {
-    final reply = await _command(['LREM', key, count.toString(), value]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Trims a list to the specified range.
-  Future<void> ltrim(String key, int start, int stop) async {
-    await _command(['LTRIM', key, start.toString(), stop.toString()]);
-  }
-
-  /// Atomically moves an element from one list to another.
-  ///
-  /// [srcDirection] and [dstDirection] can be 'LEFT' or 'RIGHT'.
-  Future<String?> lmove(
-    String source,
-    String destination, {
-    required String srcDirection,
-    required String dstDirection,
-  }) async {
-    final reply = await _command([
-      'LMOVE',
-      source,
-      destination,
-      srcDirection,
-      dstDirection,
-    ]);
-    return reply?.string;
-  }
-
-  /// Returns the index of the first matching element in a list.
-  ///
-  /// Returns null if the element is not found.
-  Future<int?> lpos(String key, String element) async {
-    final reply = await _command(['LPOS', key, element]);
-    try {
-      if (reply == null || reply.isNil) return null;
-      return reply.integer;
-    } finally {}
-  }
-
-  // ============ Set Commands ============
-
-  /// Adds one or more members to a set.
-  ///
-  /// Returns the number of members that were added (not already present).
-  Future<int> sadd(String key, List<String> members) async {
-    final reply = await _command(['SADD', key, ...members]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Removes one or more members from a set.
-  ///
-  /// Returns the number of members that were removed.
-  Future<int> srem(String key, List<String> members) async {
-    final reply = await _command(['SREM', key, ...members]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Returns all members of a set.
-  Future<Set<String>> smembers(String key) async {
-    final reply = await _command(['SMEMBERS', key]);
-    try {
-      final result = <String>{};
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final member = reply[i]?.string;
-        if (member != null) result.add(member);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Checks if a member is in a set.
-  Future<bool> sismember(String key, String member) async {
-    final reply = await _command(['SISMEMBER', key, member]);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Checks if multiple members are in a set.
-  ///
-  /// Returns a list of booleans indicating membership for each member.
-  Future<List<bool>> smismember(String key, List<String> members) async {
-    final reply = await _command(['SMISMEMBER', key, ...members]);
-    try {
-      final result = <bool>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        result.add((reply[i]?.integer ?? 0) == 1);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Returns the number of members in a set.
-  Future<int> scard(String key) async {
-    final reply = await _command(['SCARD', key]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Removes and returns a random member from a set.
-  Future<String?> spop(String key) async {
-    final reply = await _command(['SPOP', key]);
-    return reply?.string;
-  }
-
-  /// Removes and returns multiple random members from a set.
-  Future<Set<String>> spopCount(String key, int count) async {
-    final reply = await _command(['SPOP', key, count.toString()]);
-    try {
-      final result = <String>{};
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final member = reply[i]?.string;
-        if (member != null) result.add(member);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Returns a random member from a set without removing it.
-  Future<String?> srandmember(String key) async {
-    final reply = await _command(['SRANDMEMBER', key]);
-    return reply?.string;
-  }
-
-  /// Returns multiple random members from a set without removing them.
-  Future<List<String>> srandmemberCount(String key, int count) async {
-    final reply = await _command(['SRANDMEMBER', key, count.toString()]);
-    try {
-      final result = <String>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final member = reply[i]?.string;
-        if (member != null) result.add(member);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Moves a member from one set to another.
-  ///
-  /// Returns `true` if the member was moved, `false` if it wasn't in the source
-  /// set.
-  Future<bool> smove(String source, String destination, String member) async {
-    final reply = await _command(['SMOVE', source, destination, member]);
-    return (reply?.integer ?? 0) == 1;
-  }
-
-  /// Returns the difference between the first set and all subsequent sets.
-  Future<Set<String>> sdiff(List<String> keys) async {
-    final reply = await _command(['SDIFF', ...keys]);
-    try {
-      final result = <String>{};
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final member = reply[i]?.string;
-        if (member != null) result.add(member);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Stores the difference between sets in a destination set.
-  ///
-  /// Returns the number of members in the resulting set.
-  Future<int> sdiffstore(String destination, List<String> keys) async {
-    final reply = await _command(['SDIFFSTORE', destination, ...keys]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Returns the intersection of all given sets.
-  Future<Set<String>> sinter(List<String> keys) async {
-    final reply = await _command(['SINTER', ...keys]);
-    try {
-      final result = <String>{};
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final member = reply[i]?.string;
-        if (member != null) result.add(member);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Stores the intersection of sets in a destination set.
-  ///
-  /// Returns the number of members in the resulting set.
-  Future<int> sinterstore(String destination, List<String> keys) async {
-    final reply = await _command(['SINTERSTORE', destination, ...keys]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Returns the cardinality of the intersection of all given sets.
-  Future<int> sintercard(List<String> keys, {int? limit}) async {
-    final args = ['SINTERCARD', keys.length.toString(), ...keys];
-    if (limit != null) args.addAll(['LIMIT', limit.toString()]);
-
-    final reply = await _command(args);
-    return reply?.integer ?? 0;
-  }
-
-  /// Returns the union of all given sets.
-  Future<Set<String>> sunion(List<String> keys) async {
-    final reply = await _command(['SUNION', ...keys]);
-    try {
-      final result = <String>{};
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final member = reply[i]?.string;
-        if (member != null) result.add(member);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Stores the union of sets in a destination set.
-  ///
-  /// Returns the number of members in the resulting set.
-  Future<int> sunionstore(String destination, List<String> keys) async {
-    final reply = await _command(['SUNIONSTORE', destination, ...keys]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Incrementally iterates over members of a set.
-  ///
-  /// Returns a tuple of (nextCursor, members).
-  /// When nextCursor is '0', iteration is complete.
-  Future<(String, Set<String>)> sscan(
-    String key,
-    String cursor, {
-    String? match,
-    int? count,
-  }) async {
-    final args = ['SSCAN', key, cursor];
-    if (match != null) args.addAll(['MATCH', match]);
-    if (count != null) args.addAll(['COUNT', count.toString()]);
-
-    final reply = await _command(args);
-    try {
-      if (reply == null || reply.length < 2) {
-        return ('0', <String>{});
-      }
-
-      final nextCursor = reply[0]?.string ?? '0';
-      final itemsReply = reply[1];
-      final result = <String>{};
-      if (itemsReply != null) {
-        for (var i = 0; i < itemsReply.length; i++) {
-          final member = itemsReply[i]?.string;
-          if (member != null) result.add(member);
-        }
-      }
-      return (nextCursor, result);
-    } finally {}
-  }
-
-  // ============ Sorted Set Commands ============
-
-  /// Adds one or more members to a sorted set, or updates the score if the
-  /// member already exists.
-  ///
-  /// [members] is a map of member -> score pairs.
-  ///
-  /// Options:
-  /// - [nx]: Only add new members, don't update existing ones.
-  /// - [xx]: Only update existing members, don't add new ones.
-  /// - [gt]: Only update when the new score is greater than the current score.
-  /// - [lt]: Only update when the new score is less than the current score.
-  /// - [ch]: Return the number of changed elements (added + updated) instead
-  ///   of just added.
-  ///
-  /// Returns the number of elements added (or changed if [ch] is true).
-  Future<int> zadd(
-    String key,
-    Map<String, double> members, {
-    bool nx = false,
-    bool xx = false,
-    bool gt = false,
-    bool lt = false,
-    bool ch = false,
-  }) async {
-    final args = ['ZADD', key];
-    if (nx) args.add('NX');
-    if (xx) args.add('XX');
-    if (gt) args.add('GT');
-    if (lt) args.add('LT');
-    if (ch) args.add('CH');
-
-    for (final entry in members.entries) {
-      args.addAll([entry.value.toString(), entry.key]);
-    }
-
-    final reply = await _command(args);
-    return reply?.integer ?? 0;
-  }
-
-  /// Removes one or more members from a sorted set.
-  ///
-  /// Returns the number of members removed.
-  Future<int> zrem(String key, List<String> members) async {
-    final reply = await _command(['ZREM', key, ...members]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Returns the score of a member in a sorted set.
-  Future<double?> zscore(String key, String member) async {
-    final reply = await _command(['ZSCORE', key, member]);
-    try {
-      if (reply == null || reply.isNil) return null;
-      final str = reply.string;
-      return str != null ? double.parse(str) : null;
-    } finally {}
-  }
-
-  /// Returns the scores of multiple members in a sorted set.
-  Future<List<double?>> zmscore(String key, List<String> members) async {
-    final reply = await _command(['ZMSCORE', key, ...members]);
-    try {
-      final result = <double?>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final element = reply[i];
-        if (element == null || element.isNil) {
-          result.add(null);
-        } else {
-          final str = element.string;
-          result.add(str != null ? double.parse(str) : null);
-        }
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Returns the rank (index) of a member in a sorted set (0-based).
-  ///
-  /// Members are ordered from lowest to highest score.
-  Future<int?> zrank(String key, String member) async {
-    final reply = await _command(['ZRANK', key, member]);
-    try {
-      if (reply == null || reply.isNil) return null;
-      return reply.integer;
-    } finally {}
-  }
-
-  /// Returns the reverse rank (index) of a member in a sorted set (0-based).
-  ///
-  /// Members are ordered from highest to lowest score.
-  Future<int?> zrevrank(String key, String member) async {
-    final reply = await _command(['ZREVRANK', key, member]);
-    try {
-      if (reply == null || reply.isNil) return null;
-      return reply.integer;
-    } finally {}
-  }
-
-  /// Returns the number of members in a sorted set.
-  Future<int> zcard(String key) async {
-    final reply = await _command(['ZCARD', key]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Returns the number of members in a sorted set with scores within the
-  /// given range.
-  Future<int> zcount(String key, String min, String max) async {
-    final reply = await _command(['ZCOUNT', key, min, max]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Returns a range of members from a sorted set by index.
-  ///
-  /// If [withScores] is true, returns alternating member, score pairs.
-  Future<List<String>> zrange(
-    String key,
-    int start,
-    int stop, {
-    bool withScores = false,
-  }) async {
-    final args = ['ZRANGE', key, start.toString(), stop.toString()];
-    if (withScores) args.add('WITHSCORES');
-
-    final reply = await _command(args);
-    try {
-      final result = <String>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final item = reply[i]?.string;
-        if (item != null) result.add(item);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Returns a range of members from a sorted set by index, with scores.
-  ///
-  /// Returns a list of (member, score) pairs.
-  Future<List<(String, double)>> zrangeWithScores(
-    String key,
-    int start,
-    int stop,
-  ) async {
-    final reply = await _command([
-      'ZRANGE',
-      key,
-      start.toString(),
-      stop.toString(),
-      'WITHSCORES',
-    ]);
-    try {
-      final result = <(String, double)>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length - 1; i += 2) {
-        final member = reply[i]?.string;
-        final scoreStr = reply[i + 1]?.string;
-        if (member != null && scoreStr != null) {
-          result.add((member, double.parse(scoreStr)));
-        }
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Returns a range of members from a sorted set by score.
-  Future<List<String>> zrangebyscore(
-    String key,
-    String min,
-    String max, {
-    int? offset,
-    int? count,
-  }) async {
-    final args = ['ZRANGEBYSCORE', key, min, max];
-    if (offset != null && count != null) {
-      args.addAll(['LIMIT', offset.toString(), count.toString()]);
-    }
-
-    final reply = await _command(args);
-    try {
-      final result = <String>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final item = reply[i]?.string;
-        if (item != null) result.add(item);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Returns a range of members from a sorted set by score (highest to lowest).
-  Future<List<String>> zrevrangebyscore(
-    String key,
-    String max,
-    String min, {
-    int? offset,
-    int? count,
-  }) async {
-    final args = ['ZREVRANGEBYSCORE', key, max, min];
-    if (offset != null && count != null) {
-      args.addAll(['LIMIT', offset.toString(), count.toString()]);
-    }
-
-    final reply = await _command(args);
-    try {
-      final result = <String>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length; i++) {
-        final item = reply[i]?.string;
-        if (item != null) result.add(item);
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Increments the score of a member in a sorted set.
-  ///
-  /// Returns the new score.
-  Future<double> zincrby(String key, double increment, String member) async {
-    final reply = await _command([
-      'ZINCRBY',
-      key,
-      increment.toString(),
-      member,
-    ]);
-    try {
-      final str = reply?.string;
-      return str != null ? double.parse(str) : 0.0;
-    } finally {}
-  }
-
-  /// Removes all members in a sorted set within the given score range.
-  ///
-  /// Returns the number of members removed.
-  Future<int> zremrangebyscore(String key, String min, String max) async {
-    final reply = await _command(['ZREMRANGEBYSCORE', key, min, max]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Removes all members in a sorted set within the given rank range.
-  ///
-  /// Returns the number of members removed.
-  Future<int> zremrangebyrank(String key, int start, int stop) async {
-    final reply = await _command([
-      'ZREMRANGEBYRANK',
-      key,
-      start.toString(),
-      stop.toString(),
-    ]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Removes and returns members with the lowest scores from a sorted set.
-  Future<List<(String, double)>> zpopmin(String key, {int count = 1}) async {
-    final reply = await _command(['ZPOPMIN', key, count.toString()]);
-    try {
-      final result = <(String, double)>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length - 1; i += 2) {
-        final member = reply[i]?.string;
-        final scoreStr = reply[i + 1]?.string;
-        if (member != null && scoreStr != null) {
-          result.add((member, double.parse(scoreStr)));
-        }
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Removes and returns members with the highest scores from a sorted set.
-  Future<List<(String, double)>> zpopmax(String key, {int count = 1}) async {
-    final reply = await _command(['ZPOPMAX', key, count.toString()]);
-    try {
-      final result = <(String, double)>[];
-      if (reply == null) return result;
-
-      for (var i = 0; i < reply.length - 1; i += 2) {
-        final member = reply[i]?.string;
-        final scoreStr = reply[i + 1]?.string;
-        if (member != null && scoreStr != null) {
-          result.add((member, double.parse(scoreStr)));
-        }
-      }
-      return result;
-    } finally {}
-  }
-
-  /// Computes the union of multiple sorted sets and stores the result.
-  ///
-  /// Returns the number of members in the resulting set.
-  Future<int> zunionstore(
-    String destination,
-    List<String> keys, {
-    List<double>? weights,
-    String? aggregate,
-  }) async {
-    final args = ['ZUNIONSTORE', destination, keys.length.toString(), ...keys];
-    if (weights != null) {
-      args.add('WEIGHTS');
-      args.addAll(weights.map((w) => w.toString()));
-    }
-    if (aggregate != null) {
-      args.addAll(['AGGREGATE', aggregate]);
-    }
-
-    final reply = await _command(args);
-    return reply?.integer ?? 0;
-  }
-
-  /// Computes the intersection of multiple sorted sets and stores the result.
-  ///
-  /// Returns the number of members in the resulting set.
-  Future<int> zinterstore(
-    String destination,
-    List<String> keys, {
-    List<double>? weights,
-    String? aggregate,
-  }) async {
-    final args = ['ZINTERSTORE', destination, keys.length.toString(), ...keys];
-    if (weights != null) {
-      args.add('WEIGHTS');
-      args.addAll(weights.map((w) => w.toString()));
-    }
-    if (aggregate != null) {
-      args.addAll(['AGGREGATE', aggregate]);
-    }
-
-    final reply = await _command(args);
-    return reply?.integer ?? 0;
-  }
-
-  /// Incrementally iterates over members and scores in a sorted set.
-  ///
-  /// Returns a tuple of (nextCursor, memberScorePairs).
-  /// When nextCursor is '0', iteration is complete.
-  Future<(String, List<(String, double)>)> zscan(
-    String key,
-    String cursor, {
-    String? match,
-    int? count,
-  }) async {
-    final args = ['ZSCAN', key, cursor];
-    if (match != null) args.addAll(['MATCH', match]);
-    if (count != null) args.addAll(['COUNT', count.toString()]);
-
-    final reply = await _command(args);
-    try {
-      if (reply == null || reply.length < 2) {
-        return ('0', <(String, double)>[]);
-      }
-
-      final nextCursor = reply[0]?.string ?? '0';
-      final itemsReply = reply[1];
-      final result = <(String, double)>[];
-      if (itemsReply != null) {
-        for (var i = 0; i < itemsReply.length - 1; i += 2) {
-          final member = itemsReply[i]?.string;
-          final scoreStr = itemsReply[i + 1]?.string;
-          if (member != null && scoreStr != null) {
-            result.add((member, double.parse(scoreStr)));
-          }
-        }
-      }
-      return (nextCursor, result);
-    } finally {}
-  }
-
-  // ============ Pub/Sub API ============
+  // ============ Pub/Sub API ============
 
   /// Subscribes to channels and/or patterns and returns a stream of messages.
   ///
-  /// Each call to [subscribe] opens a dedicated Redis connection for the
-  /// subscription. The connection is opened when you call `listen()` on the
-  /// returned stream, and closed when you cancel the subscription.
+  /// All streams returned by [subscribe] share one dedicated pub/sub
+  /// connection per client. It is opened when the first stream is listened
+  /// to and closed when the last one is cancelled. If this client was
+  /// connected with a [RedisReactor], the connection is hosted on the same
+  /// reactor rather than on its own poll thread.
+  ///
+  /// Channels and patterns are reference counted across streams: SUBSCRIBE is
+  /// sent when a channel gets its first listener, UNSUBSCRIBE when its last
+  /// listener cancels. A stream that joins an already subscribed channel gets
+  /// a local `subscribe` confirmation. Unsubscribe confirmations are not
+  /// delivered.
   ///
   /// **Performance considerations:**
-  /// - Each [subscribe] call creates a new TCP connection to Redis.
-  /// - Prefer a single [subscribe] call with multiple channels over multiple
-  ///   calls, as this uses fewer connections.
+  /// - Subscribing many streams costs no extra connections or threads, and
+  ///   the changes made in one microtask turn are sent as one command.
   /// - Pattern matching ([patterns]) has a server-side cost: Redis checks
   ///   every published message against all active patterns. Use exact channel
   ///   names when possible for high-throughput scenarios.
@@ -1866,258 +1352,162 @@ class RedisClient {
     Iterable<String> patterns = const [],
   }) {
     _checkNotClosed();
-    final channelList = channels.toList();
-    final patternList = patterns.toList();
-    if (channelList.isEmpty && patternList.isEmpty) {
+    final channelSet = channels.toSet();
+    final patternSet = patterns.toSet();
+    if (channelSet.isEmpty && patternSet.isEmpty) {
       throw ArgumentError('At least one channel or pattern must be specified');
     }
-    return _RedisSubscription.create(_host, _port, channelList, patternList);
-  }
-
-  /// Publishes a message to a channel.
-  Future<int> publish(String channel, String message) async {
-    final reply = await _command(['PUBLISH', channel, message]);
-    return reply?.integer ?? 0;
-  }
-
-  /// Closes the connection.
-  Future<void> close() async {
-    if (_closed) return;
-    _closed = true;
-
-    // Complete any pending commands with errors
-    for (final completer in _pendingCommands.values) {
-      completer.completeError(RedisException('Client closed'));
-    }
-    _pendingCommands.clear();
-
-    // Stop and destroy the event loop (this also frees the async context)
-    redis_event_loop_destroy(_eventLoop);
-
-    // Close the receive port
-    _receivePort.close();
+    final subscriber = _subscriber ??= _RedisSubscriber(
+      _host,
+      _port,
+      _reactor,
+      _subscriptionBufferSize,
+      _subscriptionOverflow,
+      _reconnect,
+    );
+    return subscriber.subscribe(channelSet, patternSet);
+  }
+
+  /// Joins [group] of [stream] as [consumer]; see [RedisStreamConsumer].
+  ///
+  /// The consumer reads with `XREADGROUP` on a connection of its own,
+  /// opened with the options of this client (protocol, reactor, timeouts,
+  /// `ioUring`, `instrument`, ...) but without its cache, at most [count]
+  /// entries at a time, blocking for up to [block] on the
+  /// server when there are none. Its acknowledgements and `XAUTOCLAIM`
+  /// calls go through this client. With [createGroup], the group (and the
+  /// stream) is created if it does not exist, reading only new entries.
+  ///
+  /// With [claimMinIdle], entries that stayed unacknowledged by any
+  /// consumer of the group for that long are claimed and delivered too,
+  /// checked every [claimInterval].
+  Future<RedisStreamConsumer> streamConsumer(
+    String stream,
+    String group,
+    String consumer, {
+    int count = 100,
+    Duration block = const Duration(seconds: 5),
+    bool createGroup = true,
+    Duration? claimMinIdle,
+    Duration claimInterval = const Duration(seconds: 30),
+  }) {
+    _checkNotClosed();
+    return RedisStreamConsumer._open(
+      this,
+      _connectSibling,
+      stream: stream,
+      group: group,
+      consumer: consumer,
+      count: count,
+      block: block,
+      createGroup: createGroup,
+      claimMinIdle: claimMinIdle,
+      claimInterval: claimInterval,
+    );
   }
-}
-
-// ============ Redis Subscription ============
 
-/// A subscription that manages its own Redis connection.
-class _RedisSubscription {
-  final Pointer<EventLoopState> _eventLoop;
-  final ReceivePort _receivePort;
-  var _closed = false;
-  var _nextCommandId = 0;
-
-  _RedisSubscription._(this._eventLoop, this._receivePort);
+  /// Opens a connection of its own for this client, with the options it
+  /// was connected with (see [connect]) other than its cache and
+  /// subscription buffering. An attached client keeps those of its handle.
+  Future<RedisClient> _connectSibling() =>
+      _connectAgain?.call() ??
+      connect(
+        _host,
+        _port,
+        reactor: _reactor,
+        reconnect: _reconnect,
+        commandTimeout: _commandTimeoutMs == 0
+            ? null
+            : Duration(milliseconds: _commandTimeoutMs),
+      );
 
-  /// Creates a subscription stream that opens a dedicated connection.
-  static Stream<RedisPubSubMessage> create(
-    String host,
-    int port,
-    List<String> channels,
-    List<String> patterns,
-  ) {
-    late StreamController<RedisPubSubMessage> controller;
-    _RedisSubscription? subscription;
-
-    controller = StreamController<RedisPubSubMessage>(
-      onListen: () {
-        try {
-          final options = calloc<redisOptions>();
-          try {
-            // Zero-initialize
-            for (var i = 0; i < sizeOf<redisOptions>(); i++) {
-              options.cast<Uint8>()[i] = 0;
-            }
-
-            final hostPtr = host.toNativeUtf8();
-            try {
-              options.ref.type = redisConnectionType.REDIS_CONN_TCP.value;
-              options.ref.endpoint.tcp.ip = hostPtr.cast();
-              options.ref.endpoint.tcp.port = port;
-              options.ref.options = REDIS_OPT_NOAUTOFREE;
-
-              final ctx = redisAsyncConnectWithOptions(options);
-              if (ctx == nullptr) {
-                controller.addError(
-                  RedisException('Failed to allocate async context'),
-                );
-                return;
-              }
-
-              if (ctx.ref.err != 0) {
-                final errStr = ctx.ref.errstr.cast<Utf8>().toDartString();
-                redisAsyncFree(ctx);
-                controller.addError(
-                  RedisException('Connection failed: $errStr'),
-                );
-                return;
-              }
-
-              final receivePort = ReceivePort();
-              final eventLoop = redis_event_loop_create(
-                ctx,
-                receivePort.sendPort.nativePort,
-              );
-
-              if (eventLoop == nullptr) {
-                receivePort.close();
-                redisAsyncFree(ctx);
-                controller.addError(
-                  RedisException('Failed to create event loop'),
-                );
-                return;
-              }
-
-              subscription = _RedisSubscription._(eventLoop, receivePort);
-
-              // Listen for pub/sub messages
-              receivePort.listen((message) {
-                if (subscription?._closed ?? true) return;
-                if (controller.isClosed) return;
-                if (message is int && message == -1) {
-                  // Disconnect
-                  controller.addError(RedisException('Connection lost'));
-                  return;
-                }
-                if (message is List && message.length == 2) {
-                  final replyData = message[1];
-                  final pubsubMsg = _parsePubSubMessage(replyData);
-                  if (pubsubMsg != null) {
-                    controller.add(pubsubMsg);
-                  }
-                }
-              });
-
-              if (!redis_event_loop_start(eventLoop)) {
-                receivePort.close();
-                redis_event_loop_destroy(eventLoop);
-                redisAsyncFree(ctx);
-                controller.addError(
-                  RedisException('Failed to start event loop'),
-                );
-                return;
-              }
-
-              // Send SUBSCRIBE and PSUBSCRIBE commands
-              subscription!._sendSubscribeCommand('SUBSCRIBE', channels);
-              subscription!._sendSubscribeCommand('PSUBSCRIBE', patterns);
-            } finally {
-              calloc.free(hostPtr);
-            }
-          } finally {
-            calloc.free(options);
-          }
-        } catch (e) {
-          controller.addError(e);
-        }
-      },
-      onCancel: () async {
-        subscription?._close();
-        await controller.close();
-      },
+  /// Returns the client-side cache counters, or null without a cache.
+  RedisCacheStats? cacheStats() {
+    _checkNotClosed();
+    final cache = _cache;
+    if (cache == null) return null;
+    return RedisCacheStats(
+      size: cache.size,
+      hits: cache.hits,
+      misses: cache.misses,
+      invalidations: cache.invalidations,
+      evictions: cache.evictions,
     );
-
-    return controller.stream;
   }
 
-  /// Parses a pub/sub message from the serialized reply data.
-  static RedisPubSubMessage? _parsePubSubMessage(dynamic data) {
-    final reply = _ParsedReply.fromNative(data);
-    if (reply == null || reply.elements == null || reply.elements!.length < 3) {
-      return null;
-    }
+  /// Returns the flow control counters of the pub/sub connection (all zero
+  /// while no [subscribe] stream is listened to).
+  RedisSubscriptionStats subscriptionStats() {
+    _checkNotClosed();
+    return _subscriber?.stats() ?? const RedisSubscriptionStats();
+  }
 
-    final typeElem = reply[0];
-    if (typeElem == null ||
-        typeElem.type != _redisReplyString ||
-        typeElem.string == null) {
-      return null;
-    }
+  /// Where the connection is. Without `reconnect`, a lost connection is
+  /// [RedisConnectionState.disconnected] right away.
+  RedisConnectionState get connectionState {
+    if (_closed) return RedisConnectionState.disconnected;
+    final state = redis_event_loop_connection_state(_eventLoop);
+    return RedisConnectionState.values[state];
+  }
 
-    final typeStr = typeElem.string!;
-    final type = switch (typeStr) {
-      'message' => RedisPubSubMessageType.message,
-      'pmessage' => RedisPubSubMessageType.pmessage,
-      'subscribe' => RedisPubSubMessageType.subscribe,
-      'unsubscribe' => RedisPubSubMessageType.unsubscribe,
-      'psubscribe' => RedisPubSubMessageType.psubscribe,
-      'punsubscribe' => RedisPubSubMessageType.punsubscribe,
-      _ => null,
-    };
-
-    if (type == null) return null;
-
-    String channel = '';
-    String? message;
-    String? pattern;
-
-    if (type == RedisPubSubMessageType.pmessage &&
-        reply.elements!.length >= 4) {
-      pattern = reply[1]?.string;
-      channel = reply[2]?.string ?? '';
-      message = reply[3]?.string;
-    } else if (type == RedisPubSubMessageType.message &&
-        reply.elements!.length >= 3) {
-      channel = reply[1]?.string ?? '';
-      message = reply[2]?.string;
-    } else if (reply.elements!.length >= 2) {
-      channel = reply[1]?.string ?? '';
+  /// Returns a handle another isolate can attach to this connection with.
+  ///
+  /// The handle can be sent to another isolate, e.g. as an argument of
+  /// [Isolate.run]. [RedisConnectionHandle.attach] turns it into a client
+  /// there that submits commands to this client's event loop directly
+  /// and gets its replies on its own port, without a second connection.
+  /// The connection stays open until this client and every attached client
+  /// are closed. A handle that is never attached must be
+  /// [RedisConnectionHandle.release]d, or the connection stays open.
+  ///
+  /// Each handle attaches once; call [handle] again for every isolate. Push
+  /// frames, and with them the client-side cache, stay with this client.
+  /// Clients hosted by a [RedisReactor] cannot be shared.
+  RedisConnectionHandle handle() {
+    _checkNotClosed();
+    if (_reactor != null) {
+      throw StateError('A client hosted by a RedisReactor cannot be shared');
     }
-
-    return RedisPubSubMessage._(
-      type: type,
-      channel: channel,
-      message: message,
-      pattern: pattern,
+    final token = redis_event_loop_share(_eventLoop);
+    if (token == 0) throw RedisException('Failed to share the connection');
+    return RedisConnectionHandle._(
+      token,
+      _host,
+      _port,
+      _reconnect,
+      _commandTimeoutMs,
     );
   }
 
-  void _sendSubscribeCommand(String cmd, List<String> targets) {
-    if (targets.isEmpty) return;
+  /// Closes the connection.
+  ///
+  /// With clients attached through [handle], only this client is closed; the
+  /// connection itself closes with the last of them.
+  Future<void> close() async {
+    if (_closed) return;
+    _closed = true;
 
-    final commandId = _nextCommandId++;
-    final argc = targets.length + 1;
-    final argv = calloc<Pointer<Char>>(argc);
-    final argvlen = calloc<Size>(argc);
+    // Complete any pending commands with errors
+    for (final completer in _pendingCommands.clear()) {
+      completer.completeError(RedisException('Client closed'));
+    }
 
-    try {
-      final cmdPtr = cmd.toNativeUtf8();
-      argv[0] = cmdPtr.cast();
-      argvlen[0] = cmd.length;
-
-      for (var i = 0; i < targets.length; i++) {
-        final arg = targets[i].toNativeUtf8();
-        argv[i + 1] = arg.cast();
-        argvlen[i + 1] = targets[i].length;
-      }
+    // Drop commands that were written but not flushed yet
+    _writer.dispose();
 
-      // Use pubsub command for persistent callbacks
-      redis_async_pubsub_command(
-        _eventLoop,
-        _receivePort.sendPort.nativePort,
-        commandId,
-        argc,
-        argv,
-        argvlen,
-      );
-    } finally {
-      for (var i = 0; i < argc; i++) {
-        if (argv[i] != nullptr) {
-          calloc.free(argv[i].cast<Utf8>());
-        }
-      }
-      calloc.free(argv);
-      calloc.free(argvlen);
-    }
-  }
+    // End the subscription streams
+    await _subscriber?.close();
 
-  void _close() {
-    if (_closed) return;
-    _closed = true;
+    // Drop our reference; the last one stops and destroys the event loop
+    // (this also frees the async context)
+    if (_attached) {
+      redis_event_loop_detach(_eventLoop, _receivePort.sendPort.nativePort);
+    } else {
+      redis_event_loop_release(_eventLoop);
+    }
+    _reactor?._unregister(this);
 
-    // Destroy the event loop (this also frees the async context)
-    redis_event_loop_destroy(_eventLoop);
+    // Close the receive port
     _receivePort.close();
   }
 }
@@ -0,0 +1,525 @@
+part of 'redis_client.dart';
+
+/// The number of hash slots a Redis Cluster divides the key space into.
+const _clusterSlots = 16384;
+
+/// How often one command follows `MOVED`/`ASK`/`TRYAGAIN` before failing.
+const _maxRedirects = 5;
+
+/// Commands without a key that any node answers alike.
+const _anyNodeCommands = {
+  'CLUSTER',
+  'COMMAND',
+  'ECHO',
+  'PING',
+  'PUBLISH',
+  'RANDOMKEY',
+  'SELECT',
+  'TIME',
+};
+
+/// Commands without a key that act on the keys of every primary; see
+/// [RedisClusterClient._fanOutAll].
+const _allNodeCommands = {'DBSIZE', 'FLUSHALL', 'FLUSHDB', 'KEYS', 'SCRIPT'};
+
+/// Commands without a key whose reply or effect belongs to the one
+/// connection or node they reach; a cluster client rejects them.
+const _nodeCommands = {'AUTH', 'CLIENT', 'CONFIG', 'HELLO', 'INFO', 'SCAN'};
+
+/// CRC16-CCITT (XMODEM), the checksum Redis Cluster hashes keys with.
+final _crc16Table = () {
+  final table = Uint16List(256);
+  for (var i = 0; i < 256; i++) {
+    var crc = i << 8;
+    for (var bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) != 0 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    table[i] = crc;
+  }
+  return table;
+}();
+
+/// The hash slot of [key]: the CRC16 of the key, or of its hash tag (the
+/// part between the first `{` and the next `}`, if not empty), modulo
+/// [_clusterSlots].
+int _hashSlot(List<int> key) {
+  var start = 0;
+  var end = key.length;
+  final open = key.indexOf(0x7b); // {
+  if (open >= 0) {
+    final close = key.indexOf(0x7d, open + 1); // }
+    if (close > open + 1) {
+      start = open + 1;
+      end = close;
+    }
+  }
+  var crc = 0;
+  for (var i = start; i < end; i++) {
+    crc = ((crc << 8) & 0xffff) ^ _crc16Table[((crc >> 8) ^ key[i]) & 0xff];
+  }
+  return crc & (_clusterSlots - 1);
+}
+
+/// The UTF-8 bytes a key argument is sent as.
+List<int> _keyBytes(Object key) => switch (key) {
+  String() => utf8.encode(key),
+  List<int>() => key,
+  _ => utf8.encode(key.toString()),
+};
+
+/// A `MOVED` or `ASK` redirection parsed from an error reply.
+class _Redirect {
+  final bool ask;
+  final int slot;
+  final String address;
+
+  _Redirect(this.ask, this.slot, this.address);
+
+  /// Parses `MOVED <slot> <host>:<port>` / `ASK <slot> <host>:<port>`.
+  static _Redirect? parse(String message) {
+    final parts = message.split(' ');
+    if (parts.length != 3) return null;
+    final ask = parts[0] == 'ASK';
+    if (!ask && parts[0] != 'MOVED') return null;
+    final slot = int.tryParse(parts[1]);
+    if (slot == null) return null;
+    return _Redirect(ask, slot, parts[2]);
+  }
+}
+
+/// A client for a Redis Cluster, with the same command API as
+/// [RedisClient].
+///
+/// The client keeps the cluster's slot map and one connection (and so one
+/// native event loop) per primary. Each command goes to the primary that
+/// serves its key's hash slot; the commands issued during one microtask
+/// turn therefore form one pipeline per node. `MOVED` and `ASK` redirects
+/// are followed transparently, and a `MOVED` reloads the slot map.
+///
+/// `MGET`, `MSET`, `DEL`, `UNLINK`, `EXISTS` and `TOUCH` with keys in
+/// several slots are split into one command per slot and their replies
+/// combined, in key order for `MGET`. These are then not atomic. Other
+/// multi-key commands must keep their keys in one slot, for instance with a
+/// common hash tag: `{user:1}:name`, `{user:1}:email`.
+///
+/// `DBSIZE`, `KEYS`, `FLUSHDB`, `FLUSHALL` and `SCRIPT` go to every primary,
+/// with the counts summed and the keys concatenated. Other keyless commands
+/// that any node answers alike (`PING`, `ECHO`, `TIME`, `PUBLISH`, ...) go
+/// to one node. Those that concern a single node or connection (`INFO`,
+/// `CONFIG`, `CLIENT`, `SCAN`, `AUTH`, `HELLO`) throw an [UnsupportedError];
+/// send them with a [RedisClient] connected to that node.
+///
+/// Example:
+/// ```dart
+/// final cluster = await RedisClusterClient.connect([('localhost', 7000)]);
+/// try {
+///   await cluster.mset({'a': '1', 'b': '2'});
+///   print(await cluster.mget(['a', 'b']));
+/// } finally {
+///   await cluster.close();
+/// }
+/// ```
+class RedisClusterClient with RedisCommands {
+  final List<(String, int)> _seeds;
+  final RedisReactor? _reactor;
+  final RedisReactor? _ownedReactor;
+
+  /// The primary address serving each slot, as `host:port`.
+  final _slots = List<String?>.filled(_clusterSlots, null);
+
+  /// Open connections by address.
+  final _nodes = <String, RedisClient>{};
+
+  /// Connections being opened by address.
+  final _connecting = <String, Future<RedisClient>>{};
+
+  Future<void>? _refreshing;
+  var _closed = false;
+
+  RedisClusterClient._(this._seeds, this._reactor, this._ownedReactor);
+
+  /// Connects to a cluster through the first reachable of [seeds] (any
+  /// nodes of the cluster) and loads its slot map.
+  ///
+  /// Pass a shared [reactor] to host the node connections on it. Otherwise
+  /// the client creates its own reactor, or falls back to one poll thread
+  /// per connection on platforms without reactor support.
+  static Future<RedisClusterClient> connect(
+    Iterable<(String host, int port)> seeds, {
+    RedisReactor? reactor,
+  }) async {
+    final seedList = seeds.toList();
+    if (seedList.isEmpty) {
+      throw ArgumentError.value(seeds, 'seeds', 'must not be empty');
+    }
+
+    RedisReactor? ownedReactor;
+    if (reactor == null) {
+      try {
+        ownedReactor = RedisReactor(threads: 2);
+      } on UnsupportedError {
+        ownedReactor = null;
+      }
+    }
+
+    final cluster = RedisClusterClient._(
+      seedList,
+      reactor ?? ownedReactor,
+      ownedReactor,
+    );
+    try {
+      await cluster._refreshSlots();
+    } catch (_) {
+      await cluster.close();
+      rethrow;
+    }
+    return cluster;
+  }
+
+  /// The hash slot [key] maps to, as `CLUSTER KEYSLOT` computes it.
+  static int keySlot(Object key) => _hashSlot(_keyBytes(key));
+
+  /// Whether [close] has been called.
+  bool get isClosed => _closed;
+
+  void _checkNotClosed() {
+    if (_closed) {
+      throw StateError('RedisClusterClient has been closed');
+    }
+  }
+
+  /// Returns the connection to [address], opening it if needed.
+  Future<RedisClient> _node(String address) {
+    final client = _nodes[address];
+    if (client != null) return Future.value(client);
+    return _connecting[address] ??= _open(address);
+  }
+
+  Future<RedisClient> _open(String address) async {
+    final separator = address.lastIndexOf(':');
+    final port = int.tryParse(address.substring(separator + 1));
+    if (separator < 0 || port == null) {
+      throw RedisException('Invalid cluster node address: $address');
+    }
+    try {
+      final client = await RedisClient.connect(
+        address.substring(0, separator),
+        port,
+        reactor: _reactor,
+      );
+      if (_closed) {
+        await client.close();
+        _checkNotClosed();
+      }
+      _nodes[address] = client;
+      return client;
+    } finally {
+      _connecting.remove(address);
+    }
+  }
+
+  /// Forgets the connection to [address] after it was lost.
+  void _dropNode(String address) {
+    _nodes.remove(address)?.close();
+    _refreshSlots().ignore();
+  }
+
+  /// Reloads the slot map, once at a time.
+  Future<void> _refreshSlots() =>
+      _refreshing ??= _loadSlots().whenComplete(() => _refreshing = null);
+
+  Future<void> _loadSlots() async {
+    final candidates = [
+      ..._nodes.keys,
+      for (final (host, port) in _seeds) '$host:$port',
+    ];
+    Object? lastError;
+    for (final address in candidates) {
+      _checkNotClosed();
+      try {
+        final client = await _node(address);
+        final reply = await client._command(const ['CLUSTER', 'SLOTS']);
+        _applySlots(reply, client._host);
+        return;
+      } catch (e) {
+        // Whatever failed with this node, e.g. its connection, try the next
+        lastError = e;
+      }
+    }
+    _checkNotClosed();
+    throw RedisException('No cluster node reachable: $lastError');
+  }
+
+  /// Fills the slot map from a `CLUSTER SLOTS` reply:
+  /// `[[start, end, [host, port, id, ...], replica...], ...]`.
+  void _applySlots(_ParsedReply? reply, String queriedHost) {
+    final ranges = reply?.elements;
+    if (ranges == null || ranges.isEmpty) {
+      throw RedisException('Cluster has no slots assigned');
+    }
+    _slots.fillRange(0, _clusterSlots, null);
+    for (final range in ranges) {
+      if (range == null || range.length < 3) continue;
+      final start = range.intAt(0);
+      final end = range.intAt(1);
+      final primary = range[2];
+      final port = primary?[1]?.integer;
+      if (start == null || end == null || port == null) continue;
+      var host = primary?[0]?.string ?? '';
+      // An empty or unknown endpoint means the node that was asked
+      if (host.isEmpty || host == '?') host = queriedHost;
+      _slots.fillRange(start, end + 1, '$host:$port');
+    }
+  }
+
+  /// The slot [args] addresses, or null for a keyless command.
+  int? _commandSlot(String name, List<Object> args) {
+    if (_anyNodeCommands.contains(name)) return null;
+    switch (name) {
+      case 'EVAL' || 'EVALSHA' || 'EVAL_RO' || 'EVALSHA_RO' || 'FCALL':
+        // Script keys follow the key count
+        if (args.length < 4 || args[2].toString() == '0') return null;
+        return keySlot(args[3]);
+      case 'XREAD' || 'XREADGROUP':
+        final streams = args.indexWhere(
+          (arg) => arg is String && arg.toUpperCase() == 'STREAMS',
+        );
+        if (streams < 0 || streams + 1 >= args.length) return null;
+        return keySlot(args[streams + 1]);
+    }
+    if (args.length < 2) return null;
+    return keySlot(args[1]);
+  }
+
+  /// The address serving [slot], or any known node for null.
+  String _addressFor(int? slot) {
+    final address = slot == null ? null : _slots[slot];
+    if (address != null) return address;
+    final (host, port) = _seeds.first;
+    return _slots.firstWhere((a) => a != null, orElse: () => '$host:$port')!;
+  }
+
+  @override
+  Future<_ParsedReply?> _command(
+    List<Object> args, [
+    int shape = _shapeGeneric,
+  ]) {
+    _checkNotClosed();
+    final name = args.first.toString().toUpperCase();
+    if (_allNodeCommands.contains(name)) return _fanOutAll(name, args);
+    if (_nodeCommands.contains(name)) {
+      throw UnsupportedError(
+        '$name concerns a single node; send it with a RedisClient connected '
+        'to that node',
+      );
+    }
+    if (args.length > 2) {
+      switch (name) {
+        case 'MGET':
+          return _fanOutMget(args);
+        case 'DEL' || 'UNLINK' || 'EXISTS' || 'TOUCH':
+          return _fanOutCount(name, args);
+        case 'MSET' when args.length > 3:
+          return _fanOutMset(args);
+      }
+    }
+    return _route(args, _commandSlot(name, args), shape);
+  }
+
+  /// Sends [args] to the node serving [slot], following redirects.
+  Future<_ParsedReply?> _route(
+    List<Object> args,
+    int? slot, [
+    int shape = _shapeGeneric,
+  ]) async {
+    var address = _addressFor(slot);
+    var asking = false;
+    for (var attempt = 0; ; attempt++) {
+      final client = _nodes[address] ?? await _node(address);
+      try {
+        // ASKING must directly precede the command on the same connection
+        if (asking) client._command(const ['ASKING']).ignore();
+        return await client._command(args, shape);
+      } on RedisException catch (e) {
+        if (e.message == 'Connection lost') _dropNode(address);
+        if (attempt >= _maxRedirects) rethrow;
+
+        if (e.message.startsWith('TRYAGAIN')) {
+          // A resharding is moving the keys; retry shortly
+          await Future<void>.delayed(const Duration(milliseconds: 10));
+          asking = false;
+          address = _addressFor(slot);
+          continue;
+        }
+        final redirect = _Redirect.parse(e.message);
+        if (redirect == null) rethrow;
+        address = redirect.address;
+        asking = redirect.ask;
+        if (!redirect.ask) {
+          _slots[redirect.slot] = redirect.address;
+          _refreshSlots().ignore();
+        }
+      }
+    }
+  }
+
+  /// Groups the keys at [first], [first] + [stride], ... of [args] by slot,
+  /// as lists of argument indices.
+  Map<int, List<int>> _groupBySlot(List<Object> args, int first, int stride) {
+    final groups = <int, List<int>>{};
+    for (var i = first; i < args.length; i += stride) {
+      (groups[keySlot(args[i])] ??= []).add(i);
+    }
+    return groups;
+  }
+
+  Future<_ParsedReply?> _fanOutMget(List<Object> args) async {
+    final groups = _groupBySlot(args, 1, 1);
+    if (groups.length == 1) return _route(args, groups.keys.first);
+
+    final values = List<_ParsedReply?>.filled(args.length - 1, null);
+    await Future.wait([
+      for (final MapEntry(key: slot, value: indices) in groups.entries)
+        _route(['MGET', for (final i in indices) args[i]], slot).then((reply) {
+          for (var j = 0; j < indices.length; j++) {
+            values[indices[j] - 1] = reply?[j];
+          }
+        }),
+    ]);
+    return _ParsedReply._(type: _redisReplyArray, elements: values);
+  }
+
+  /// Splits a command replying with a count of keys and sums the counts.
+  Future<_ParsedReply?> _fanOutCount(String name, List<Object> args) async {
+    final groups = _groupBySlot(args, 1, 1);
+    if (groups.length == 1) return _route(args, groups.keys.first);
+
+    final counts = await Future.wait([
+      for (final MapEntry(key: slot, value: indices) in groups.entries)
+        _route([name, for (final i in indices) args[i]], slot),
+    ]);
+    var total = 0;
+    for (final count in counts) {
+      total += count?.integer ?? 0;
+    }
+    return _ParsedReply._(type: _redisReplyInteger, integer: total);
+  }
+
+  Future<_ParsedReply?> _fanOutMset(List<Object> args) async {
+    final groups = _groupBySlot(args, 1, 2);
+    if (groups.length == 1) return _route(args, groups.keys.first);
+
+    await Future.wait([
+      for (final MapEntry(key: slot, value: indices) in groups.entries)
+        _route([
+          'MSET',
+          for (final i in indices) ...[args[i], args[i + 1]],
+        ], slot),
+    ]);
+    return _ParsedReply._(
+      type: _redisReplyStatus,
+      bytes: Uint8List.fromList(const [0x4f, 0x4b]), // OK
+    );
+  }
+
+  /// The addresses of the primaries in the slot map.
+  Set<String> _primaries() {
+    final primaries = {
+      for (final address in _slots)
+        if (address != null) address,
+    };
+    if (primaries.isEmpty) primaries.add(_addressFor(null));
+    return primaries;
+  }
+
+  /// Sends a keyless command to every primary and combines the replies:
+  /// `DBSIZE` counts are summed, `KEYS` lists concatenated, and
+  /// `SCRIPT EXISTS` reports a script only where every primary has it. Other
+  /// commands reply as the first primary did.
+  Future<_ParsedReply?> _fanOutAll(String name, List<Object> args) async {
+    final replies = await Future.wait([
+      for (final address in _primaries())
+        _node(address).then((client) => client._command(args)),
+    ]);
+    switch (name) {
+      case 'DBSIZE':
+        var total = 0;
+        for (final reply in replies) {
+          total += reply?.integer ?? 0;
+        }
+        return _ParsedReply._(type: _redisReplyInteger, integer: total);
+      case 'KEYS':
+        return _ParsedReply._(
+          type: _redisReplyArray,
+          elements: [
+            for (final reply in replies) ...?reply?.elements,
+          ],
+        );
+      case 'SCRIPT'
+          when args.length > 2 && args[1].toString().toUpperCase() == 'EXISTS':
+        return _ParsedReply._(
+          type: _redisReplyArray,
+          elements: [
+            for (var i = 0; i < args.length - 2; i++)
+              _ParsedReply._(
+                type: _redisReplyInteger,
+                integer: replies.every((reply) => reply?.intAt(i) == 1)
+                    ? 1
+                    : 0,
+              ),
+          ],
+        );
+    }
+    return replies.first;
+  }
+
+  /// Loads a script on every primary, since `EVALSHA` may go to any of them.
+  @override
+  Future<void> _loadScript(String source) async {
+    await Future.wait([
+      for (final address in _primaries())
+        _node(address).then(
+          (client) => client._command(['SCRIPT', 'LOAD', source]),
+        ),
+    ]);
+  }
+
+  /// Subscribes to channels and/or patterns; see [RedisClient.subscribe].
+  ///
+  /// Cluster pub/sub messages reach every node, so one node's subscriber
+  /// connection serves all streams.
+  Stream<RedisPubSubMessage> subscribe({
+    Iterable<String> channels = const [],
+    Iterable<String> patterns = const [],
+  }) async* {
+    _checkNotClosed();
+    final client = await _node(_addressFor(null));
+    yield* client.subscribe(channels: channels, patterns: patterns);
+  }
+
+  /// Returns the native event loop counters of every node connection, by
+  /// `host:port`.
+  Map<String, RedisClientStats> stats() {
+    _checkNotClosed();
+    return {
+      for (final MapEntry(key: address, value: client) in _nodes.entries)
+        address: client.stats(),
+    };
+  }
+
+  /// Closes all node connections (and the client's own reactor, if any).
+  ///
+  /// Pending commands complete with an error.
+  Future<void> close() async {
+    if (_closed) return;
+    _closed = true;
+    for (final connecting in _connecting.values.toList()) {
+      await connecting.then((_) {}, onError: (_) {});
+    }
+    for (final client in _nodes.values.toList()) {
+      await client.close();
+    }
+    _nodes.clear();
+    await _ownedReactor?.close();
+  }
+}
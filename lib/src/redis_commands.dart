@@ -0,0 +1,1823 @@
+part of 'redis_client.dart';
+
+/// The Redis command API shared by [RedisClient] and [RedisPool].
+///
+/// Every command is built on a single primitive that sends one command and
+/// completes with its reply, so connections, pools and later layers only
+/// have to provide that.
+mixin RedisCommands {
+  /// Sends a raw command and returns the reply.
+  ///
+  /// A [shape] hint (`_shapeStrings`, `_shapeScored`) lets the native side
+  /// encode a reply of that shape as a [_StringTable]; read such replies
+  /// with the helpers at the end of this file.
+  Future<_ParsedReply?> _command(
+    List<Object> args, [
+    int shape = _shapeGeneric,
+  ]);
+
+  /// Sends a read of [key] (the `GET` value, or hash [field]) that a
+  /// client-side cache may answer locally.
+  Future<_ParsedReply?> _cachedRead(
+    String key,
+    String? field,
+    List<Object> args,
+  ) => _command(args);
+
+  /// Sends an arbitrary command and returns its reply as plain Dart values.
+  ///
+  /// Each argument may be a [String] (sent as UTF-8), a [Uint8List] or other
+  /// `List<int>` of bytes (sent as is), or a [num] (sent in decimal).
+  ///
+  /// The reply is binary-safe: bulk strings are returned as [Uint8List] views
+  /// without UTF-8 decoding, status replies as [String], integers as [int],
+  /// aggregates as [List] and nil as `null`. Error replies throw a
+  /// [RedisException].
+  ///
+  /// Example:
+  /// ```dart
+  /// await client.sendCommand(['SET', 'blob', Uint8List.fromList([0, 1, 2])]);
+  /// final bytes = await client.sendCommand(['GET', 'blob']) as Uint8List;
+  /// ```
+  Future<Object?> sendCommand(List<Object> args) async {
+    if (args.isEmpty) {
+      throw ArgumentError.value(args, 'args', 'must not be empty');
+    }
+    final reply = await _command(args);
+    return reply?.toValue();
+  }
+
+  /// Pings the server.
+  Future<String> ping([String? message]) async {
+    final reply = await _command(
+      message != null ? ['PING', message] : ['PING'],
+    );
+    return reply?.string ?? 'PONG';
+  }
+
+  // ============ String Commands ============
+
+  /// Gets the value of a key.
+  ///
+  /// Returns `null` if the key does not exist.
+  Future<String?> get(String key) async {
+    final reply = await _cachedRead(key, null, ['GET', key]);
+    return reply?.string;
+  }
+
+  /// Gets the raw bytes stored at a key, without UTF-8 decoding.
+  ///
+  /// Returns `null` if the key does not exist.
+  Future<Uint8List?> getBytes(String key) async {
+    final reply = await _cachedRead(key, null, ['GET', key]);
+    return reply?.bytes;
+  }
+
+  /// Sets a key to a value.
+  ///
+  /// Options:
+  /// - [ex]: Set expiry in seconds
+  /// - [px]: Set expiry in milliseconds
+  /// - [exat]: Set expiry at Unix timestamp in seconds
+  /// - [pxat]: Set expiry at Unix timestamp in milliseconds
+  /// - [nx]: Only set if key does not exist
+  /// - [xx]: Only set if key already exists
+  /// - [keepTtl]: Retain the existing TTL
+  /// - [get]: Return the old value stored at key
+  ///
+  /// Returns the old value if [get] is true, otherwise returns `null`.
+  Future<String?> set(
+    String key,
+    String value, {
+    int? ex,
+    int? px,
+    int? exat,
+    int? pxat,
+    bool nx = false,
+    bool xx = false,
+    bool keepTtl = false,
+    bool get = false,
+  }) async {
+    final args = ['SET', key, value];
+    if (ex != null) args.addAll(['EX', ex.toString()]);
+    if (px != null) args.addAll(['PX', px.toString()]);
+    if (exat != null) args.addAll(['EXAT', exat.toString()]);
+    if (pxat != null) args.addAll(['PXAT', pxat.toString()]);
+    if (nx) args.add('NX');
+    if (xx) args.add('XX');
+    if (keepTtl) args.add('KEEPTTL');
+    if (get) args.add('GET');
+
+    final reply = await _command(args);
+    return reply?.string;
+  }
+
+  /// Sets a key to a binary value.
+  ///
+  /// [ex] and [px] set an expiry in seconds or milliseconds, [nx] and [xx]
+  /// only set if the key does not / does already exist. Returns `true` if
+  /// the value was set.
+  Future<bool> setBytes(
+    String key,
+    List<int> value, {
+    int? ex,
+    int? px,
+    bool nx = false,
+    bool xx = false,
+  }) async {
+    final args = <Object>['SET', key, value];
+    if (ex != null) args.addAll(['EX', ex]);
+    if (px != null) args.addAll(['PX', px]);
+    if (nx) args.add('NX');
+    if (xx) args.add('XX');
+
+    final reply = await _command(args);
+    return reply != null && !reply.isNil;
+  }
+
+  /// Gets the values of multiple keys.
+  ///
+  /// Returns a list of values in the same order as the keys.
+  /// Non-existent keys return `null`.
+  Future<List<String?>> mget(List<String> keys) async {
+    final reply = await _command(['MGET', ...keys]);
+    try {
+      if (reply == null) return List.filled(keys.length, null);
+      final results = <String?>[];
+      for (var i = 0; i < reply.length; i++) {
+        results.add(reply.stringAt(i));
+      }
+      return results;
+    } finally {}
+  }
+
+  /// Sets multiple keys to their respective values.
+  Future<void> mset(Map<String, String> keyValues) async {
+    final args = ['MSET'];
+    keyValues.forEach((key, value) {
+      args.addAll([key, value]);
+    });
+    await _command(args);
+  }
+
+  /// Sets multiple keys only if none of them exist.
+  ///
+  /// Returns `true` if all keys were set, `false` if no keys were set
+  /// (because at least one key already existed).
+  Future<bool> msetnx(Map<String, String> keyValues) async {
+    final args = ['MSETNX'];
+    keyValues.forEach((key, value) {
+      args.addAll([key, value]);
+    });
+    final reply = await _command(args);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Increments the integer value of a key by one.
+  ///
+  /// Returns the new value after incrementing.
+  Future<int> incr(String key) async {
+    final reply = await _command(['INCR', key]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Increments the integer value of a key by the given amount.
+  ///
+  /// Returns the new value after incrementing.
+  Future<int> incrby(String key, int increment) async {
+    final reply = await _command(['INCRBY', key, increment.toString()]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Increments the floating point value of a key by the given amount.
+  ///
+  /// Returns the new value after incrementing.
+  Future<double> incrbyfloat(String key, double increment) async {
+    final reply = await _command(['INCRBYFLOAT', key, increment.toString()]);
+    try {
+      final str = reply?.string;
+      return str != null ? _parseScore(str) : 0.0;
+    } finally {}
+  }
+
+  /// Decrements the integer value of a key by one.
+  ///
+  /// Returns the new value after decrementing.
+  Future<int> decr(String key) async {
+    final reply = await _command(['DECR', key]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Decrements the integer value of a key by the given amount.
+  ///
+  /// Returns the new value after decrementing.
+  Future<int> decrby(String key, int decrement) async {
+    final reply = await _command(['DECRBY', key, decrement.toString()]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Appends a value to a key.
+  ///
+  /// Returns the length of the string after the append.
+  Future<int> append(String key, String value) async {
+    final reply = await _command(['APPEND', key, value]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns the length of the string stored at key.
+  Future<int> strlen(String key) async {
+    final reply = await _command(['STRLEN', key]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Sets or clears the bit at offset in the string value stored at key.
+  ///
+  /// Returns the original bit value at the offset.
+  Future<int> setbit(String key, int offset, int value) async {
+    final reply = await _command([
+      'SETBIT',
+      key,
+      offset.toString(),
+      value.toString(),
+    ]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns the bit value at offset in the string value stored at key.
+  Future<int> getbit(String key, int offset) async {
+    final reply = await _command(['GETBIT', key, offset.toString()]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Overwrites part of the string stored at key starting at the specified offset.
+  ///
+  /// Returns the length of the string after it was modified.
+  Future<int> setrange(String key, int offset, String value) async {
+    final reply = await _command(['SETRANGE', key, offset.toString(), value]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns a substring of the string stored at key.
+  Future<String?> getrange(String key, int start, int end) async {
+    final reply = await _command([
+      'GETRANGE',
+      key,
+      start.toString(),
+      end.toString(),
+    ]);
+    return reply?.string;
+  }
+
+  /// Sets the value and expiration of a key in seconds.
+  Future<void> setex(String key, int seconds, String value) async {
+    await _command(['SETEX', key, seconds.toString(), value]);
+  }
+
+  /// Sets the value and expiration of a key in milliseconds.
+  Future<void> psetex(String key, int milliseconds, String value) async {
+    await _command(['PSETEX', key, milliseconds.toString(), value]);
+  }
+
+  /// Sets the value of a key only if the key does not exist.
+  ///
+  /// Returns `true` if the key was set, `false` if it already existed.
+  Future<bool> setnx(String key, String value) async {
+    final reply = await _command(['SETNX', key, value]);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Atomically sets a key to a value and returns the old value.
+  Future<String?> getset(String key, String value) async {
+    final reply = await _command(['GETSET', key, value]);
+    return reply?.string;
+  }
+
+  /// Gets the value of a key and deletes it.
+  Future<String?> getdel(String key) async {
+    final reply = await _command(['GETDEL', key]);
+    return reply?.string;
+  }
+
+  /// Gets the value of a key and optionally sets its expiration.
+  Future<String?> getex(
+    String key, {
+    int? ex,
+    int? px,
+    int? exat,
+    int? pxat,
+    bool persist = false,
+  }) async {
+    final args = ['GETEX', key];
+    if (ex != null) args.addAll(['EX', ex.toString()]);
+    if (px != null) args.addAll(['PX', px.toString()]);
+    if (exat != null) args.addAll(['EXAT', exat.toString()]);
+    if (pxat != null) args.addAll(['PXAT', pxat.toString()]);
+    if (persist) args.add('PERSIST');
+
+    final reply = await _command(args);
+    return reply?.string;
+  }
+
+  // ============ Key Commands ============
+
+  /// Deletes one or more keys.
+  ///
+  /// Returns the number of keys that were deleted.
+  Future<int> del(List<String> keys) async {
+    final reply = await _command(['DEL', ...keys]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Deletes one or more keys asynchronously (non-blocking).
+  ///
+  /// Returns the number of keys that were scheduled for deletion.
+  Future<int> unlink(List<String> keys) async {
+    final reply = await _command(['UNLINK', ...keys]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Checks if one or more keys exist.
+  ///
+  /// Returns the number of keys that exist.
+  Future<int> existsCount(List<String> keys) async {
+    final reply = await _command(['EXISTS', ...keys]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Checks if a key exists.
+  Future<bool> exists(String key) async {
+    return (await existsCount([key])) > 0;
+  }
+
+  /// Sets a timeout on a key in seconds.
+  ///
+  /// Returns `true` if the timeout was set, `false` if the key doesn't exist.
+  Future<bool> expire(String key, int seconds) async {
+    final reply = await _command(['EXPIRE', key, seconds.toString()]);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Sets a timeout on a key in milliseconds.
+  ///
+  /// Returns `true` if the timeout was set, `false` if the key doesn't exist.
+  Future<bool> pexpire(String key, int milliseconds) async {
+    final reply = await _command(['PEXPIRE', key, milliseconds.toString()]);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Sets an absolute Unix timestamp expiry on a key (in seconds).
+  ///
+  /// Returns `true` if the timeout was set, `false` if the key doesn't exist.
+  Future<bool> expireat(String key, int timestamp) async {
+    final reply = await _command(['EXPIREAT', key, timestamp.toString()]);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Sets an absolute Unix timestamp expiry on a key (in milliseconds).
+  ///
+  /// Returns `true` if the timeout was set, `false` if the key doesn't exist.
+  Future<bool> pexpireat(String key, int timestamp) async {
+    final reply = await _command(['PEXPIREAT', key, timestamp.toString()]);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Gets the remaining time to live of a key in seconds.
+  ///
+  /// Returns -2 if the key doesn't exist, -1 if the key has no expiry.
+  Future<int> ttl(String key) async {
+    final reply = await _command(['TTL', key]);
+    return reply?.integer ?? -2;
+  }
+
+  /// Gets the remaining time to live of a key in milliseconds.
+  ///
+  /// Returns -2 if the key doesn't exist, -1 if the key has no expiry.
+  Future<int> pttl(String key) async {
+    final reply = await _command(['PTTL', key]);
+    return reply?.integer ?? -2;
+  }
+
+  /// Removes the expiry from a key.
+  ///
+  /// Returns `true` if the timeout was removed, `false` if the key doesn't
+  /// exist or has no associated timeout.
+  Future<bool> persist(String key) async {
+    final reply = await _command(['PERSIST', key]);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Returns the absolute Unix timestamp (in seconds) at which the key will expire.
+  ///
+  /// Returns -2 if the key doesn't exist, -1 if the key has no expiry.
+  Future<int> expiretime(String key) async {
+    final reply = await _command(['EXPIRETIME', key]);
+    return reply?.integer ?? -2;
+  }
+
+  /// Returns the absolute Unix timestamp (in milliseconds) at which the key will expire.
+  ///
+  /// Returns -2 if the key doesn't exist, -1 if the key has no expiry.
+  Future<int> pexpiretime(String key) async {
+    final reply = await _command(['PEXPIRETIME', key]);
+    return reply?.integer ?? -2;
+  }
+
+  /// Returns the type of the value stored at key.
+  ///
+  /// Returns "none" if the key doesn't exist.
+  Future<String> type(String key) async {
+    final reply = await _command(['TYPE', key]);
+    return reply?.string ?? 'none';
+  }
+
+  /// Renames a key.
+  ///
+  /// Throws if the key doesn't exist.
+  Future<void> rename(String key, String newKey) async {
+    await _command(['RENAME', key, newKey]);
+  }
+
+  /// Renames a key only if the new key doesn't already exist.
+  ///
+  /// Returns `true` if the key was renamed, `false` if the new key already exists.
+  Future<bool> renamenx(String key, String newKey) async {
+    final reply = await _command(['RENAMENX', key, newKey]);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Returns all keys matching the given pattern.
+  ///
+  /// Warning: KEYS should not be used in production as it may block the server.
+  /// Use [scan] instead for production workloads.
+  Future<List<String>> keys(String pattern) async {
+    final reply = await _command(['KEYS', pattern], _shapeStrings);
+    return _stringList(reply);
+  }
+
+  /// Incrementally iterates over keys matching a pattern.
+  ///
+  /// Returns a tuple of (nextCursor, keys). When nextCursor is "0", iteration is complete.
+  Future<(String, List<String>)> scan(
+    String cursor, {
+    String? match,
+    int? count,
+    String? type,
+  }) async {
+    final args = ['SCAN', cursor];
+    if (match != null) args.addAll(['MATCH', match]);
+    if (count != null) args.addAll(['COUNT', count.toString()]);
+    if (type != null) args.addAll(['TYPE', type]);
+
+    final reply = await _command(args);
+    try {
+      if (reply == null || reply.length < 2) return ('0', <String>[]);
+
+      final nextCursor = reply.stringAt(0) ?? '0';
+      final keysReply = reply[1];
+      final keys = <String>[];
+      if (keysReply != null) {
+        for (var i = 0; i < keysReply.length; i++) {
+          final key = keysReply.stringAt(i);
+          if (key != null) keys.add(key);
+        }
+      }
+      return (nextCursor, keys);
+    } finally {}
+  }
+
+  /// Iterates over all keys matching [match] (and of [type], if given),
+  /// driving the `SCAN` cursor for you.
+  ///
+  /// The next page is requested as soon as the previous one arrives, while
+  /// the current one is still being consumed, with up to [prefetch] pages
+  /// buffered ahead of the listener. As with [scan], a key may be reported
+  /// more than once if the keyspace changes during the iteration.
+  ///
+  /// Example:
+  /// ```dart
+  /// await for (final key in client.scanStream(match: 'session:*')) {
+  ///   if (await client.ttl(key) == -1) await client.expire(key, 3600);
+  /// }
+  /// ```
+  Stream<String> scanStream({
+    String? match,
+    int? count,
+    String? type,
+    int prefetch = 2,
+  }) => _scanStream(
+    (cursor) => scan(cursor, match: match, count: count, type: type),
+    prefetch,
+  );
+
+  /// Returns a random key from the database.
+  Future<String?> randomkey() async {
+    final reply = await _command(['RANDOMKEY']);
+    return reply?.string;
+  }
+
+  /// Touches one or more keys (updates last access time).
+  ///
+  /// Returns the number of keys that were touched.
+  Future<int> touch(List<String> keys) async {
+    final reply = await _command(['TOUCH', ...keys]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns the number of bytes that a key and its value require in RAM.
+  Future<int?> memoryUsage(String key, {int? samples}) async {
+    final args = ['MEMORY', 'USAGE', key];
+    if (samples != null) args.addAll(['SAMPLES', samples.toString()]);
+
+    final reply = await _command(args);
+    return reply?.integer;
+  }
+
+  /// Copies a key to another key.
+  ///
+  /// Returns `true` if the key was copied, `false` otherwise.
+  Future<bool> copy(
+    String source,
+    String destination, {
+    int? db,
+    bool replace = false,
+  }) async {
+    final args = ['COPY', source, destination];
+    if (db != null) args.addAll(['DB', db.toString()]);
+    if (replace) args.add('REPLACE');
+
+    final reply = await _command(args);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Returns the time since the object stored at key is idle.
+  Future<int?> objectIdletime(String key) async {
+    final reply = await _command(['OBJECT', 'IDLETIME', key]);
+    return reply?.integer;
+  }
+
+  /// Returns the access frequency of the object stored at key.
+  Future<int?> objectFreq(String key) async {
+    final reply = await _command(['OBJECT', 'FREQ', key]);
+    return reply?.integer;
+  }
+
+  /// Returns the encoding of the object stored at key.
+  Future<String?> objectEncoding(String key) async {
+    final reply = await _command(['OBJECT', 'ENCODING', key]);
+    return reply?.string;
+  }
+
+  // ============ Hash Commands ============
+
+  /// Sets a field in a hash.
+  ///
+  /// Returns the number of fields that were added (0 if the field already
+  /// existed and was updated).
+  Future<int> hset(String key, String field, String value) async {
+    final reply = await _command(['HSET', key, field, value]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Sets multiple fields in a hash.
+  ///
+  /// Returns the number of fields that were added.
+  Future<int> hsetAll(String key, Map<String, String> fieldValues) async {
+    final args = ['HSET', key];
+    for (final entry in fieldValues.entries) {
+      args.addAll([entry.key, entry.value]);
+    }
+
+    final reply = await _command(args);
+    return reply?.integer ?? 0;
+  }
+
+  /// Gets the value of a field in a hash.
+  Future<String?> hget(String key, String field) async {
+    final reply = await _cachedRead(key, field, ['HGET', key, field]);
+    return reply?.string;
+  }
+
+  /// Gets the raw bytes of a hash field, without UTF-8 decoding.
+  Future<Uint8List?> hgetBytes(String key, String field) async {
+    final reply = await _cachedRead(key, field, ['HGET', key, field]);
+    return reply?.bytes;
+  }
+
+  /// Sets a hash field to a binary value.
+  ///
+  /// Returns 1 if a new field was created, 0 if an existing one was updated.
+  Future<int> hsetBytes(String key, String field, List<int> value) async {
+    final reply = await _command(['HSET', key, field, value]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Gets all fields and values in a hash.
+  Future<Map<String, String>> hgetall(String key) async {
+    final reply = await _command(['HGETALL', key], _shapeStrings);
+    final result = <String, String>{};
+    final table = reply?.table;
+    if (table != null) {
+      for (var i = 0; i + 1 < table.length; i += 2) {
+        result[table.string(i)] = table.string(i + 1);
+      }
+      return result;
+    }
+    if (reply == null) return result;
+
+    for (var i = 0; i < reply.length - 1; i += 2) {
+      final field = reply.stringAt(i);
+      final value = reply.stringAt(i + 1);
+      if (field != null && value != null) {
+        result[field] = value;
+      }
+    }
+    return result;
+  }
+
+  /// Gets all fields of a hash with their raw values.
+  ///
+  /// Field names are decoded as UTF-8; values are returned as [Uint8List]
+  /// views without decoding.
+  Future<Map<String, Uint8List>> hgetallBytes(String key) async {
+    final reply = await _command(['HGETALL', key], _shapeStrings);
+    final result = <String, Uint8List>{};
+    final table = reply?.table;
+    if (table != null) {
+      for (var i = 0; i + 1 < table.length; i += 2) {
+        result[table.string(i)] = table.bytes(i + 1);
+      }
+      return result;
+    }
+    if (reply == null) return result;
+
+    for (var i = 0; i < reply.length - 1; i += 2) {
+      final field = reply.stringAt(i);
+      final value = reply.bytesAt(i + 1);
+      if (field != null && value != null) {
+        result[field] = value;
+      }
+    }
+    return result;
+  }
+
+  /// Gets the values of multiple fields in a hash.
+  Future<List<String?>> hmget(String key, List<String> fields) async {
+    final reply = await _command(['HMGET', key, ...fields]);
+    try {
+      final result = <String?>[];
+      if (reply == null) return result;
+
+      for (var i = 0; i < reply.length; i++) {
+        result.add(reply.stringAt(i));
+      }
+      return result;
+    } finally {}
+  }
+
+  /// Deletes one or more fields from a hash.
+  ///
+  /// Returns the number of fields that were removed.
+  Future<int> hdel(String key, List<String> fields) async {
+    final reply = await _command(['HDEL', key, ...fields]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Checks if a field exists in a hash.
+  Future<bool> hexists(String key, String field) async {
+    final reply = await _command(['HEXISTS', key, field]);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Gets all field names in a hash.
+  Future<List<String>> hkeys(String key) async {
+    final reply = await _command(['HKEYS', key], _shapeStrings);
+    return _stringList(reply);
+  }
+
+  /// Gets all values in a hash.
+  Future<List<String>> hvals(String key) async {
+    final reply = await _command(['HVALS', key], _shapeStrings);
+    return _stringList(reply);
+  }
+
+  /// Gets the number of fields in a hash.
+  Future<int> hlen(String key) async {
+    final reply = await _command(['HLEN', key]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Increments the integer value of a field in a hash.
+  ///
+  /// Returns the value after the increment.
+  Future<int> hincrby(String key, String field, int increment) async {
+    final reply = await _command(['HINCRBY', key, field, increment.toString()]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Increments the float value of a field in a hash.
+  ///
+  /// Returns the value after the increment.
+  Future<double> hincrbyfloat(
+    String key,
+    String field,
+    double increment,
+  ) async {
+    final reply = await _command([
+      'HINCRBYFLOAT',
+      key,
+      field,
+      increment.toString(),
+    ]);
+    try {
+      final str = reply?.string;
+      return str != null ? _parseScore(str) : 0.0;
+    } finally {}
+  }
+
+  /// Sets a field in a hash only if it does not exist.
+  ///
+  /// Returns `true` if the field was set, `false` if it already existed.
+  Future<bool> hsetnx(String key, String field, String value) async {
+    final reply = await _command(['HSETNX', key, field, value]);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Gets the string length of a field value in a hash.
+  Future<int> hstrlen(String key, String field) async {
+    final reply = await _command(['HSTRLEN', key, field]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns a random field from a hash.
+  ///
+  /// If [count] is provided, returns that many fields (or fewer if the hash
+  /// is smaller). If [withValues] is true, returns field-value pairs.
+  Future<List<String>> hrandfield(
+    String key, {
+    int? count,
+    bool withValues = false,
+  }) async {
+    final args = ['HRANDFIELD', key];
+    if (count != null) {
+      args.add(count.toString());
+      if (withValues) args.add('WITHVALUES');
+    }
+
+    final reply = await _command(args);
+    try {
+      final result = <String>[];
+      if (reply == null) return result;
+
+      // Single field returned as string, multiple as array
+      if (reply.string != null) {
+        result.add(reply.string!);
+      } else {
+        for (var i = 0; i < reply.length; i++) {
+          final item = reply.stringAt(i);
+          if (item != null) result.add(item);
+        }
+      }
+      return result;
+    } finally {}
+  }
+
+  /// Incrementally iterates over fields in a hash.
+  ///
+  /// Returns a tuple of (nextCursor, fieldValuePairs).
+  /// When nextCursor is '0', iteration is complete.
+  Future<(String, Map<String, String>)> hscan(
+    String key,
+    String cursor, {
+    String? match,
+    int? count,
+  }) async {
+    final args = ['HSCAN', key, cursor];
+    if (match != null) args.addAll(['MATCH', match]);
+    if (count != null) args.addAll(['COUNT', count.toString()]);
+
+    final reply = await _command(args);
+    try {
+      if (reply == null || reply.length < 2) {
+        return ('0', <String, String>{});
+      }
+
+      final nextCursor = reply.stringAt(0) ?? '0';
+      final itemsReply = reply[1];
+      final result = <String, String>{};
+      if (itemsReply != null) {
+        for (var i = 0; i < itemsReply.length - 1; i += 2) {
+          final field = itemsReply.stringAt(i);
+          final value = itemsReply.stringAt(i + 1);
+          if (field != null && value != null) {
+            result[field] = value;
+          }
+        }
+      }
+      return (nextCursor, result);
+    } finally {}
+  }
+
+  /// Iterates over the (field, value) pairs of a hash; see [scanStream].
+  Stream<(String, String)> hscanStream(
+    String key, {
+    String? match,
+    int? count,
+    int prefetch = 2,
+  }) => _scanStream((cursor) async {
+    final (next, page) = await hscan(key, cursor, match: match, count: count);
+    return (next, page.entries.map((e) => (e.key, e.value)));
+  }, prefetch);
+
+  // ============ List Commands ============
+
+  /// Pushes values to the left (head) of a list.
+  ///
+  /// Returns the length of the list after the push.
+  Future<int> lpush(String key, List<String> values) async {
+    final reply = await _command(['LPUSH', key, ...values]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Pushes values to the right (tail) of a list.
+  ///
+  /// Returns the length of the list after the push.
+  Future<int> rpush(String key, List<String> values) async {
+    final reply = await _command(['RPUSH', key, ...values]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Pushes a value to the left of a list only if the list exists.
+  ///
+  /// Returns the length of the list after the push, or 0 if the list doesn't
+  /// exist.
+  Future<int> lpushx(String key, List<String> values) async {
+    final reply = await _command(['LPUSHX', key, ...values]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Pushes a value to the right of a list only if the list exists.
+  ///
+  /// Returns the length of the list after the push, or 0 if the list doesn't
+  /// exist.
+  Future<int> rpushx(String key, List<String> values) async {
+    final reply = await _command(['RPUSHX', key, ...values]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Removes and returns the first element of a list.
+  Future<String?> lpop(String key) async {
+    final reply = await _command(['LPOP', key]);
+    return reply?.string;
+  }
+
+  /// Removes and returns the last element of a list.
+  Future<String?> rpop(String key) async {
+    final reply = await _command(['RPOP', key]);
+    return reply?.string;
+  }
+
+  /// Removes and returns multiple elements from the left of a list.
+  Future<List<String>> lpopCount(String key, int count) async {
+    final reply = await _command(['LPOP', key, count.toString()]);
+    try {
+      final result = <String>[];
+      if (reply == null) return result;
+
+      // Single element returned as string, multiple as array
+      if (reply.string != null) {
+        result.add(reply.string!);
+      } else {
+        for (var i = 0; i < reply.length; i++) {
+          final item = reply.stringAt(i);
+          if (item != null) result.add(item);
+        }
+      }
+      return result;
+    } finally {}
+  }
+
+  /// Removes and returns multiple elements from the right of a list.
+  Future<List<String>> rpopCount(String key, int count) async {
+    final reply = await _command(['RPOP', key, count.toString()]);
+    try {
+      final result = <String>[];
+      if (reply == null) return result;
+
+      if (reply.string != null) {
+        result.add(reply.string!);
+      } else {
+        for (var i = 0; i < reply.length; i++) {
+          final item = reply.stringAt(i);
+          if (item != null) result.add(item);
+        }
+      }
+      return result;
+    } finally {}
+  }
+
+  /// Returns a range of elements from a list.
+  ///
+  /// [start] and [stop] are zero-based indices. Negative indices count from
+  /// the end (-1 is the last element).
+  Future<List<String>> lrange(String key, int start, int stop) async {
+    final reply = await _command(
+      ['LRANGE', key, start.toString(), stop.toString()],
+      _shapeStrings,
+    );
+    return _stringList(reply);
+  }
+
+  /// Returns the element at [index] in the list.
+  ///
+  /// Negative indices count from the end (-1 is the last element).
+  Future<String?> lindex(String key, int index) async {
+    final reply = await _command(['LINDEX', key, index.toString()]);
+    return reply?.string;
+  }
+
+  /// Sets the element at [index] in the list.
+  Future<void> lset(String key, int index, String value) async {
+    await _command(['LSET', key, index.toString(), value]);
+  }
+
+  /// Returns the length of a list.
+  Future<int> llen(String key) async {
+    final reply = await _command(['LLEN', key]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Inserts an element before or after a pivot element.
+  ///
+  /// Returns the length of the list after the insert, or -1 if the pivot
+  /// was not found, or 0 if the key doesn't exist.
+  Future<int> linsert(
+    String key,
+    String pivot,
+    String value, {
+    required bool before,
+  }) async {
+    final position = before ? 'BEFORE' : 'AFTER';
+    final reply = await _command(['LINSERT', key, position, pivot, value]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Removes [count] occurrences of [value] from the list.
+  ///
+  /// - count > 0: Remove from head to tail
+  /// - count < 0: Remove from tail to head
+  /// - count = 0: Remove all occurrences
+  ///
+  /// Returns the number of removed elements.
+  Future<int> lrem(String key, int count, String value) async {
+    final reply = await _command(['LREM', key, count.toString(), value]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Trims a list to the specified range.
+  Future<void> ltrim(String key, int start, int stop) async {
+    await _command(['LTRIM', key, start.toString(), stop.toString()]);
+  }
+
+  /// Atomically moves an element from one list to another.
+  ///
+  /// [srcDirection] and [dstDirection] can be 'LEFT' or 'RIGHT'.
+  Future<String?> lmove(
+    String source,
+    String destination, {
+    required String srcDirection,
+    required String dstDirection,
+  }) async {
+    final reply = await _command([
+      'LMOVE',
+      source,
+      destination,
+      srcDirection,
+      dstDirection,
+    ]);
+    return reply?.string;
+  }
+
+  /// Returns the index of the first matching element in a list.
+  ///
+  /// Returns null if the element is not found.
+  Future<int?> lpos(String key, String element) async {
+    final reply = await _command(['LPOS', key, element]);
+    try {
+      if (reply == null || reply.isNil) return null;
+      return reply.integer;
+    } finally {}
+  }
+
+  // ============ Set Commands ============
+
+  /// Adds one or more members to a set.
+  ///
+  /// Returns the number of members that were added (not already present).
+  Future<int> sadd(String key, List<String> members) async {
+    final reply = await _command(['SADD', key, ...members]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Removes one or more members from a set.
+  ///
+  /// Returns the number of members that were removed.
+  Future<int> srem(String key, List<String> members) async {
+    final reply = await _command(['SREM', key, ...members]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns all members of a set.
+  Future<Set<String>> smembers(String key) async {
+    final reply = await _command(['SMEMBERS', key], _shapeStrings);
+    return _stringSet(reply);
+  }
+
+  /// Checks if a member is in a set.
+  Future<bool> sismember(String key, String member) async {
+    final reply = await _command(['SISMEMBER', key, member]);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Checks if multiple members are in a set.
+  ///
+  /// Returns a list of booleans indicating membership for each member.
+  Future<List<bool>> smismember(String key, List<String> members) async {
+    final reply = await _command(['SMISMEMBER', key, ...members]);
+    try {
+      final result = <bool>[];
+      if (reply == null) return result;
+
+      for (var i = 0; i < reply.length; i++) {
+        result.add((reply.intAt(i) ?? 0) == 1);
+      }
+      return result;
+    } finally {}
+  }
+
+  /// Returns the number of members in a set.
+  Future<int> scard(String key) async {
+    final reply = await _command(['SCARD', key]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Removes and returns a random member from a set.
+  Future<String?> spop(String key) async {
+    final reply = await _command(['SPOP', key]);
+    return reply?.string;
+  }
+
+  /// Removes and returns multiple random members from a set.
+  Future<Set<String>> spopCount(String key, int count) async {
+    final reply = await _command(
+      ['SPOP', key, count.toString()],
+      _shapeStrings,
+    );
+    return _stringSet(reply);
+  }
+
+  /// Returns a random member from a set without removing it.
+  Future<String?> srandmember(String key) async {
+    final reply = await _command(['SRANDMEMBER', key]);
+    return reply?.string;
+  }
+
+  /// Returns multiple random members from a set without removing them.
+  Future<List<String>> srandmemberCount(String key, int count) async {
+    final reply = await _command(
+      ['SRANDMEMBER', key, count.toString()],
+      _shapeStrings,
+    );
+    return _stringList(reply);
+  }
+
+  /// Moves a member from one set to another.
+  ///
+  /// Returns `true` if the member was moved, `false` if it wasn't in the source
+  /// set.
+  Future<bool> smove(String source, String destination, String member) async {
+    final reply = await _command(['SMOVE', source, destination, member]);
+    return (reply?.integer ?? 0) == 1;
+  }
+
+  /// Returns the difference between the first set and all subsequent sets.
+  Future<Set<String>> sdiff(List<String> keys) async {
+    final reply = await _command(['SDIFF', ...keys], _shapeStrings);
+    return _stringSet(reply);
+  }
+
+  /// Stores the difference between sets in a destination set.
+  ///
+  /// Returns the number of members in the resulting set.
+  Future<int> sdiffstore(String destination, List<String> keys) async {
+    final reply = await _command(['SDIFFSTORE', destination, ...keys]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns the intersection of all given sets.
+  Future<Set<String>> sinter(List<String> keys) async {
+    final reply = await _command(['SINTER', ...keys], _shapeStrings);
+    return _stringSet(reply);
+  }
+
+  /// Stores the intersection of sets in a destination set.
+  ///
+  /// Returns the number of members in the resulting set.
+  Future<int> sinterstore(String destination, List<String> keys) async {
+    final reply = await _command(['SINTERSTORE', destination, ...keys]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns the cardinality of the intersection of all given sets.
+  Future<int> sintercard(List<String> keys, {int? limit}) async {
+    final args = ['SINTERCARD', keys.length.toString(), ...keys];
+    if (limit != null) args.addAll(['LIMIT', limit.toString()]);
+
+    final reply = await _command(args);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns the union of all given sets.
+  Future<Set<String>> sunion(List<String> keys) async {
+    final reply = await _command(['SUNION', ...keys], _shapeStrings);
+    return _stringSet(reply);
+  }
+
+  /// Stores the union of sets in a destination set.
+  ///
+  /// Returns the number of members in the resulting set.
+  Future<int> sunionstore(String destination, List<String> keys) async {
+    final reply = await _command(['SUNIONSTORE', destination, ...keys]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Incrementally iterates over members of a set.
+  ///
+  /// Returns a tuple of (nextCursor, members).
+  /// When nextCursor is '0', iteration is complete.
+  Future<(String, Set<String>)> sscan(
+    String key,
+    String cursor, {
+    String? match,
+    int? count,
+  }) async {
+    final args = ['SSCAN', key, cursor];
+    if (match != null) args.addAll(['MATCH', match]);
+    if (count != null) args.addAll(['COUNT', count.toString()]);
+
+    final reply = await _command(args);
+    try {
+      if (reply == null || reply.length < 2) {
+        return ('0', <String>{});
+      }
+
+      final nextCursor = reply.stringAt(0) ?? '0';
+      final itemsReply = reply[1];
+      final result = <String>{};
+      if (itemsReply != null) {
+        for (var i = 0; i < itemsReply.length; i++) {
+          final member = itemsReply.stringAt(i);
+          if (member != null) result.add(member);
+        }
+      }
+      return (nextCursor, result);
+    } finally {}
+  }
+
+  /// Iterates over the members of a set; see [scanStream].
+  Stream<String> sscanStream(
+    String key, {
+    String? match,
+    int? count,
+    int prefetch = 2,
+  }) => _scanStream(
+    (cursor) => sscan(key, cursor, match: match, count: count),
+    prefetch,
+  );
+
+  // ============ Sorted Set Commands ============
+
+  /// Adds one or more members to a sorted set, or updates the score if the
+  /// member already exists.
+  ///
+  /// [members] is a map of member -> score pairs.
+  ///
+  /// Options:
+  /// - [nx]: Only add new members, don't update existing ones.
+  /// - [xx]: Only update existing members, don't add new ones.
+  /// - [gt]: Only update when the new score is greater than the current score.
+  /// - [lt]: Only update when the new score is less than the current score.
+  /// - [ch]: Return the number of changed elements (added + updated) instead
+  ///   of just added.
+  ///
+  /// Returns the number of elements added (or changed if [ch] is true).
+  Future<int> zadd(
+    String key,
+    Map<String, double> members, {
+    bool nx = false,
+    bool xx = false,
+    bool gt = false,
+    bool lt = false,
+    bool ch = false,
+  }) async {
+    final args = ['ZADD', key];
+    if (nx) args.add('NX');
+    if (xx) args.add('XX');
+    if (gt) args.add('GT');
+    if (lt) args.add('LT');
+    if (ch) args.add('CH');
+
+    for (final entry in members.entries) {
+      args.addAll([entry.value.toString(), entry.key]);
+    }
+
+    final reply = await _command(args);
+    return reply?.integer ?? 0;
+  }
+
+  /// Removes one or more members from a sorted set.
+  ///
+  /// Returns the number of members removed.
+  Future<int> zrem(String key, List<String> members) async {
+    final reply = await _command(['ZREM', key, ...members]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns the score of a member in a sorted set.
+  Future<double?> zscore(String key, String member) async {
+    final reply = await _command(['ZSCORE', key, member]);
+    try {
+      if (reply == null || reply.isNil) return null;
+      final str = reply.string;
+      return str != null ? _parseScore(str) : null;
+    } finally {}
+  }
+
+  /// Returns the scores of multiple members in a sorted set.
+  Future<List<double?>> zmscore(String key, List<String> members) async {
+    final reply = await _command(['ZMSCORE', key, ...members]);
+    try {
+      final result = <double?>[];
+      if (reply == null) return result;
+
+      for (var i = 0; i < reply.length; i++) {
+        final element = reply[i];
+        if (element == null || element.isNil) {
+          result.add(null);
+        } else {
+          final str = element.string;
+          result.add(str != null ? _parseScore(str) : null);
+        }
+      }
+      return result;
+    } finally {}
+  }
+
+  /// Returns the rank (index) of a member in a sorted set (0-based).
+  ///
+  /// Members are ordered from lowest to highest score.
+  Future<int?> zrank(String key, String member) async {
+    final reply = await _command(['ZRANK', key, member]);
+    try {
+      if (reply == null || reply.isNil) return null;
+      return reply.integer;
+    } finally {}
+  }
+
+  /// Returns the reverse rank (index) of a member in a sorted set (0-based).
+  ///
+  /// Members are ordered from highest to lowest score.
+  Future<int?> zrevrank(String key, String member) async {
+    final reply = await _command(['ZREVRANK', key, member]);
+    try {
+      if (reply == null || reply.isNil) return null;
+      return reply.integer;
+    } finally {}
+  }
+
+  /// Returns the number of members in a sorted set.
+  Future<int> zcard(String key) async {
+    final reply = await _command(['ZCARD', key]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns the number of members in a sorted set with scores within the
+  /// given range.
+  Future<int> zcount(String key, String min, String max) async {
+    final reply = await _command(['ZCOUNT', key, min, max]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Returns a range of members from a sorted set by index.
+  ///
+  /// If [withScores] is true, returns alternating member, score pairs.
+  Future<List<String>> zrange(
+    String key,
+    int start,
+    int stop, {
+    bool withScores = false,
+  }) async {
+    final args = ['ZRANGE', key, start.toString(), stop.toString()];
+    if (withScores) args.add('WITHSCORES');
+
+    final reply = await _command(args, _shapeStrings);
+    return _stringList(reply);
+  }
+
+  /// Returns a range of members from a sorted set by index, with scores.
+  ///
+  /// Returns a list of (member, score) pairs.
+  Future<List<(String, double)>> zrangeWithScores(
+    String key,
+    int start,
+    int stop,
+  ) async {
+    final reply = await _command(
+      ['ZRANGE', key, start.toString(), stop.toString(), 'WITHSCORES'],
+      _shapeScored,
+    );
+    return _scoredMembers(reply);
+  }
+
+  /// Returns a range of members from a sorted set by score.
+  Future<List<String>> zrangebyscore(
+    String key,
+    String min,
+    String max, {
+    int? offset,
+    int? count,
+  }) async {
+    final args = ['ZRANGEBYSCORE', key, min, max];
+    if (offset != null && count != null) {
+      args.addAll(['LIMIT', offset.toString(), count.toString()]);
+    }
+
+    final reply = await _command(args, _shapeStrings);
+    return _stringList(reply);
+  }
+
+  /// Returns a range of members from a sorted set by score (highest to lowest).
+  Future<List<String>> zrevrangebyscore(
+    String key,
+    String max,
+    String min, {
+    int? offset,
+    int? count,
+  }) async {
+    final args = ['ZREVRANGEBYSCORE', key, max, min];
+    if (offset != null && count != null) {
+      args.addAll(['LIMIT', offset.toString(), count.toString()]);
+    }
+
+    final reply = await _command(args, _shapeStrings);
+    return _stringList(reply);
+  }
+
+  /// Increments the score of a member in a sorted set.
+  ///
+  /// Returns the new score.
+  Future<double> zincrby(String key, double increment, String member) async {
+    final reply = await _command([
+      'ZINCRBY',
+      key,
+      increment.toString(),
+      member,
+    ]);
+    try {
+      final str = reply?.string;
+      return str != null ? _parseScore(str) : 0.0;
+    } finally {}
+  }
+
+  /// Removes all members in a sorted set within the given score range.
+  ///
+  /// Returns the number of members removed.
+  Future<int> zremrangebyscore(String key, String min, String max) async {
+    final reply = await _command(['ZREMRANGEBYSCORE', key, min, max]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Removes all members in a sorted set within the given rank range.
+  ///
+  /// Returns the number of members removed.
+  Future<int> zremrangebyrank(String key, int start, int stop) async {
+    final reply = await _command([
+      'ZREMRANGEBYRANK',
+      key,
+      start.toString(),
+      stop.toString(),
+    ]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Removes and returns members with the lowest scores from a sorted set.
+  Future<List<(String, double)>> zpopmin(String key, {int count = 1}) async {
+    final reply = await _command(
+      ['ZPOPMIN', key, count.toString()],
+      _shapeScored,
+    );
+    return _scoredMembers(reply);
+  }
+
+  /// Removes and returns members with the highest scores from a sorted set.
+  Future<List<(String, double)>> zpopmax(String key, {int count = 1}) async {
+    final reply = await _command(
+      ['ZPOPMAX', key, count.toString()],
+      _shapeScored,
+    );
+    return _scoredMembers(reply);
+  }
+
+  /// Computes the union of multiple sorted sets and stores the result.
+  ///
+  /// Returns the number of members in the resulting set.
+  Future<int> zunionstore(
+    String destination,
+    List<String> keys, {
+    List<double>? weights,
+    String? aggregate,
+  }) async {
+    final args = ['ZUNIONSTORE', destination, keys.length.toString(), ...keys];
+    if (weights != null) {
+      args.add('WEIGHTS');
+      args.addAll(weights.map((w) => w.toString()));
+    }
+    if (aggregate != null) {
+      args.addAll(['AGGREGATE', aggregate]);
+    }
+
+    final reply = await _command(args);
+    return reply?.integer ?? 0;
+  }
+
+  /// Computes the intersection of multiple sorted sets and stores the result.
+  ///
+  /// Returns the number of members in the resulting set.
+  Future<int> zinterstore(
+    String destination,
+    List<String> keys, {
+    List<double>? weights,
+    String? aggregate,
+  }) async {
+    final args = ['ZINTERSTORE', destination, keys.length.toString(), ...keys];
+    if (weights != null) {
+      args.add('WEIGHTS');
+      args.addAll(weights.map((w) => w.toString()));
+    }
+    if (aggregate != null) {
+      args.addAll(['AGGREGATE', aggregate]);
+    }
+
+    final reply = await _command(args);
+    return reply?.integer ?? 0;
+  }
+
+  /// Incrementally iterates over members and scores in a sorted set.
+  ///
+  /// Returns a tuple of (nextCursor, memberScorePairs).
+  /// When nextCursor is '0', iteration is complete.
+  Future<(String, List<(String, double)>)> zscan(
+    String key,
+    String cursor, {
+    String? match,
+    int? count,
+  }) async {
+    final args = ['ZSCAN', key, cursor];
+    if (match != null) args.addAll(['MATCH', match]);
+    if (count != null) args.addAll(['COUNT', count.toString()]);
+
+    final reply = await _command(args);
+    try {
+      if (reply == null || reply.length < 2) {
+        return ('0', <(String, double)>[]);
+      }
+
+      final nextCursor = reply.stringAt(0) ?? '0';
+      final itemsReply = reply[1];
+      final result = <(String, double)>[];
+      if (itemsReply != null) {
+        for (var i = 0; i < itemsReply.length - 1; i += 2) {
+          final member = itemsReply.stringAt(i);
+          final scoreStr = itemsReply.stringAt(i + 1);
+          if (member != null && scoreStr != null) {
+            result.add((member, _parseScore(scoreStr)));
+          }
+        }
+      }
+      return (nextCursor, result);
+    } finally {}
+  }
+
+  /// Iterates over the (member, score) pairs of a sorted set; see
+  /// [scanStream].
+  Stream<(String, double)> zscanStream(
+    String key, {
+    String? match,
+    int? count,
+    int prefetch = 2,
+  }) => _scanStream(
+    (cursor) => zscan(key, cursor, match: match, count: count),
+    prefetch,
+  );
+
+  // ============ Stream Commands ============
+
+  /// Appends an entry to a stream and returns its ID.
+  ///
+  /// With [maxLen], the stream is trimmed to about that many entries (to
+  /// exactly that many if [approximate] is false).
+  Future<String> xadd(
+    String key,
+    Map<String, String> fields, {
+    String id = '*',
+    int? maxLen,
+    bool approximate = true,
+  }) async {
+    final reply = await _command([
+      'XADD',
+      key,
+      if (maxLen != null) ...['MAXLEN', if (approximate) '~', maxLen],
+      id,
+      for (final MapEntry(:key, :value) in fields.entries) ...[key, value],
+    ]);
+    return reply?.string ?? '';
+  }
+
+  /// Returns the number of entries in a stream.
+  Future<int> xlen(String key) async {
+    final reply = await _command(['XLEN', key]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Removes entries from a stream and returns how many existed.
+  Future<int> xdel(String key, List<String> ids) async {
+    final reply = await _command(['XDEL', key, ...ids]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Acknowledges entries of a consumer group and returns how many were
+  /// pending.
+  Future<int> xack(String key, String group, List<String> ids) async {
+    final reply = await _command(['XACK', key, group, ...ids]);
+    return reply?.integer ?? 0;
+  }
+
+  /// Creates a consumer group that reads the entries after [id] (`$` for
+  /// only new ones).
+  ///
+  /// With [mkstream], the stream is created if it does not exist.
+  Future<void> xgroupCreate(
+    String key,
+    String group, {
+    String id = r'$',
+    bool mkstream = false,
+  }) async {
+    await _command([
+      'XGROUP',
+      'CREATE',
+      key,
+      group,
+      id,
+      if (mkstream) 'MKSTREAM',
+    ]);
+  }
+
+  // ============ Scripting Commands ============
+
+  /// Runs a Lua script, sending its whole body.
+  ///
+  /// Prefer [evalScript] for scripts that run more than once.
+  Future<Object?> eval(
+    String script, {
+    List<String> keys = const [],
+    List<Object> args = const [],
+  }) async {
+    final reply = await _command([
+      'EVAL',
+      script,
+      keys.length,
+      ...keys,
+      ...args,
+    ]);
+    return reply?.toValue();
+  }
+
+  /// Runs a cached Lua script by its SHA1 digest.
+  ///
+  /// Throws a [RedisException] starting with `NOSCRIPT` if the server does
+  /// not know the script; [evalScript] handles that.
+  Future<Object?> evalsha(
+    String sha1, {
+    List<String> keys = const [],
+    List<Object> args = const [],
+  }) async {
+    final reply = await _command([
+      'EVALSHA',
+      sha1,
+      keys.length,
+      ...keys,
+      ...args,
+    ]);
+    return reply?.toValue();
+  }
+
+  /// Runs [script] with `EVALSHA` and returns its reply as [sendCommand]
+  /// values.
+  ///
+  /// If the server does not know the script, it is loaded and the call
+  /// retried once; see [RedisScript].
+  Future<Object?> evalScript(
+    RedisScript script, {
+    List<String> keys = const [],
+    List<Object> args = const [],
+  }) async {
+    try {
+      final result = await _evalSha(script, keys, args);
+      if (!script._isLoadedOn(this)) script._markLoaded(this, true);
+      return result;
+    } on RedisException catch (e) {
+      if (!_isNoScript(e)) rethrow;
+      script._markLoaded(this, false);
+    }
+    await script._load(this);
+    return _evalSha(script, keys, args);
+  }
+
+  Future<Object?> _evalSha(
+    RedisScript script,
+    List<String> keys,
+    List<Object> args,
+  ) => evalsha(script.sha1, keys: keys, args: args);
+
+  /// Loads [source] into the script cache of the server(s) behind this
+  /// client.
+  Future<void> _loadScript(String source) async {
+    await _command(['SCRIPT', 'LOAD', source]);
+  }
+
+  /// Loads a Lua script into the script cache and returns its SHA1 digest.
+  Future<String> scriptLoad(String script) async {
+    final reply = await _command(['SCRIPT', 'LOAD', script]);
+    return reply?.string ?? '';
+  }
+
+  /// Returns whether each of [sha1s] is in the script cache.
+  Future<List<bool>> scriptExists(List<String> sha1s) async {
+    final reply = await _command(['SCRIPT', 'EXISTS', ...sha1s]);
+    if (reply == null) return [];
+    return [for (var i = 0; i < reply.length; i++) reply.intAt(i) == 1];
+  }
+
+  // ============ Transaction Commands ============
+
+  /// Marks [keys] to be watched for the next transaction on this connection;
+  /// see [RedisTransaction].
+  Future<void> watch(List<String> keys) async {
+    await _command(['WATCH', ...keys]);
+  }
+
+  /// Forgets all watched keys of this connection.
+  Future<void> unwatch() async {
+    await _command(['UNWATCH']);
+  }
+
+  // ============ Pub/Sub Commands ============
+
+  /// Publishes a message to a channel.
+  Future<int> publish(String channel, String message) async {
+    final reply = await _command(['PUBLISH', channel, message]);
+    return reply?.integer ?? 0;
+  }
+}
+
+/// Streams the elements of the pages [fetchPage] returns for successive
+/// cursors, from `0` until the server returns cursor `0` again.
+///
+/// The next page is fetched as soon as the previous one arrives, as long as
+/// fewer than [prefetch] pages wait for the listener (which pauses the
+/// stream while it is busy, e.g. in the body of an `await for`).
+Stream<T> _scanStream<T>(
+  Future<(String, Iterable<T>)> Function(String cursor) fetchPage,
+  int prefetch,
+) {
+  if (prefetch < 1) {
+    throw ArgumentError.value(prefetch, 'prefetch', 'must be at least 1');
+  }
+
+  final pages = Queue<Iterable<T>>();
+  var cursor = '0';
+  var finished = false;
+  var fetching = false;
+  var cancelled = false;
+  late final StreamController<T> controller;
+
+  void emit() {
+    while (!controller.isPaused && pages.isNotEmpty) {
+      pages.removeFirst().forEach(controller.add);
+    }
+    if (finished && !fetching && pages.isEmpty) controller.close();
+  }
+
+  void fetch() {
+    if (fetching || finished || cancelled || pages.length >= prefetch) return;
+    fetching = true;
+    fetchPage(cursor).then(
+      (page) {
+        fetching = false;
+        if (cancelled) return;
+        cursor = page.$1;
+        finished = cursor == '0';
+        pages.add(page.$2);
+        emit();
+        fetch();
+      },
+      onError: (Object error, StackTrace stackTrace) {
+        fetching = false;
+        if (cancelled) return;
+        controller.addError(error, stackTrace);
+        controller.close();
+      },
+    );
+  }
+
+  controller = StreamController<T>(
+    onListen: fetch,
+    onResume: () {
+      emit();
+      fetch();
+    },
+    onCancel: () => cancelled = true,
+  );
+  return controller.stream;
+}
+
+/// Parses a score or float reply. Redis writes infinite scores as `inf`.
+double _parseScore(String value) => switch (value) {
+  'inf' || '+inf' => double.infinity,
+  '-inf' => double.negativeInfinity,
+  'nan' => double.nan,
+  _ => double.parse(value),
+};
+
+/// Reads (member, score) pairs: a scored [_StringTable], flat `[member,
+/// score, ...]` in RESP2, or nested `[[member, score], ...]` in RESP3.
+List<(String, double)> _scoredMembers(_ParsedReply? reply) {
+  final table = reply?.table;
+  if (table != null) {
+    return List.generate(
+      table.length,
+      (i) => (table.string(i), table.score(i)),
+      growable: true,
+    );
+  }
+
+  final result = <(String, double)>[];
+  if (reply == null) return result;
+
+  void add(String? name, String? score) {
+    if (name != null && score != null) {
+      result.add((name, _parseScore(score)));
+    }
+  }
+
+  final nested = reply.length > 0 && (reply[0]?.isAggregate ?? false);
+  if (nested) {
+    for (var i = 0; i < reply.length; i++) {
+      final pair = reply[i];
+      if (pair != null && pair.length >= 2) {
+        add(pair.stringAt(0), pair.stringAt(1));
+      }
+    }
+  } else {
+    for (var i = 0; i < reply.length - 1; i += 2) {
+      add(reply.stringAt(i), reply.stringAt(i + 1));
+    }
+  }
+  return result;
+}
+
+/// Calls [add] with each string element of a list or set reply.
+void _forEachString(_ParsedReply? reply, void Function(String) add) {
+  if (reply == null) return;
+  for (var i = 0; i < reply.length; i++) {
+    final item = reply.stringAt(i);
+    if (item != null) add(item);
+  }
+}
+
+/// The string elements of a list reply (`_shapeStrings`).
+List<String> _stringList(_ParsedReply? reply) {
+  final table = reply?.table;
+  if (table != null) {
+    return List.generate(table.length, table.string, growable: true);
+  }
+  final result = <String>[];
+  _forEachString(reply, result.add);
+  return result;
+}
+
+/// The string elements of a set reply (`_shapeStrings`).
+Set<String> _stringSet(_ParsedReply? reply) {
+  final result = <String>{};
+  _forEachString(reply, result.add);
+  return result;
+}
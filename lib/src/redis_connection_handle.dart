@@ -0,0 +1,77 @@
+part of 'redis_client.dart';
+
+/// A reference to a [RedisClient]'s connection that can be sent to another
+/// isolate, returned by [RedisClient.handle].
+///
+/// [attach] turns it into a client in the receiving isolate. That client
+/// queues its commands on the same native event loop and gets their replies
+/// on its own port, so isolates share one socket (and its pipelining)
+/// without any message hop through the isolate that connected.
+///
+/// Example:
+/// ```dart
+/// final client = await RedisClient.connect('localhost', 6379);
+/// final handle = client.handle();
+/// await Isolate.run(() async {
+///   final shared = handle.attach();
+///   try {
+///     await shared.incr('counter');
+///   } finally {
+///     await shared.close();
+///   }
+/// });
+/// await client.close();
+/// ```
+final class RedisConnectionHandle {
+  final int _token;
+  final String _host;
+  final int _port;
+  final RedisReconnectOptions? _reconnect;
+  final int _commandTimeoutMs;
+
+  const RedisConnectionHandle._(
+    this._token,
+    this._host,
+    this._port,
+    this._reconnect,
+    this._commandTimeoutMs,
+  );
+
+  /// Returns a client in the current isolate that shares the connection.
+  ///
+  /// The client has the full command API; its [RedisClient.subscribe]
+  /// streams use a connection of their own, as usual. Closing it leaves the
+  /// connection open for the other clients sharing it.
+  ///
+  /// Throws a [StateError] if the handle was already attached or released.
+  RedisClient attach() {
+    _ensureDartApiInitialized();
+    final receivePort = ReceivePort();
+    final eventLoop = redis_event_loop_attach(
+      _token,
+      receivePort.sendPort.nativePort,
+    );
+    if (eventLoop == nullptr) {
+      receivePort.close();
+      throw StateError(
+        'RedisConnectionHandle was already attached or released',
+      );
+    }
+    return RedisClient._(
+      _host,
+      _port,
+      eventLoop,
+      receivePort,
+      null,
+      0,
+      RedisPubSubOverflow.dropOldest,
+      attached: true,
+      reconnect: _reconnect,
+      commandTimeoutMs: _commandTimeoutMs,
+    );
+  }
+
+  /// Gives up the handle without attaching, so it no longer keeps the
+  /// connection open. Does nothing if it was already attached or released.
+  void release() => redis_event_loop_unshare(_token);
+}
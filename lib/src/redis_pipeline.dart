@@ -0,0 +1,243 @@
+part of 'redis_client.dart';
+
+/// A command collected by a [RedisPipeline], not sent yet.
+class _QueuedCommand {
+  final List<Object> args;
+  final int shape;
+  final Completer<_ParsedReply?> completer;
+
+  /// Timeout in milliseconds, or null for the client's command timeout.
+  final int? timeoutMs;
+
+  _QueuedCommand(this.args, this.shape, this.completer, [this.timeoutMs]);
+}
+
+/// The command queue shared by [RedisPipeline] and [RedisTransaction].
+///
+/// Every command method queues its command and returns a future for its
+/// typed result, which completes once `execute` has sent the queue and the
+/// reply arrived. If that reply is an error, the future completes with a
+/// [RedisException]; await every future you keep, or [Future.ignore] it.
+abstract class _CommandQueue with RedisCommands {
+  /// The client or pool the queue sends through.
+  final RedisCommands _owner;
+
+  /// Writes commands into one batch of a connection and submits it.
+  final Future<void> Function(List<_QueuedCommand> commands) _submit;
+  final _commands = <_QueuedCommand>[];
+  final _scripts = <RedisScript>{};
+  var _executed = false;
+
+  _CommandQueue(this._owner, this._submit);
+
+  /// The number of queued commands.
+  int get length => _commands.length;
+
+  @override
+  Future<_ParsedReply?> _command(
+    List<Object> args, [
+    int shape = _shapeGeneric,
+  ]) {
+    if (_executed) {
+      throw StateError('$runtimeType has already been executed');
+    }
+    final completer = Completer<_ParsedReply?>();
+    _commands.add(_QueuedCommand(args, shape, completer));
+    return completer.future;
+  }
+
+  /// Queues `EVALSHA`; the script is loaded ahead of the batch if [_owner]
+  /// may not know it, since a queued call cannot be retried.
+  @override
+  Future<Object?> evalScript(
+    RedisScript script, {
+    List<String> keys = const [],
+    List<Object> args = const [],
+  }) {
+    _scripts.add(script);
+    return _evalSha(script, keys, args).onError<RedisException>(
+      (error, stackTrace) {
+        // The script cache was flushed: load it with the next batch again
+        script._markLoaded(_owner, false);
+        Error.throwWithStackTrace(error, stackTrace);
+      },
+      test: _isNoScript,
+    );
+  }
+
+  /// `SCRIPT LOAD` commands for the queued scripts [_owner] may not know.
+  List<_QueuedCommand> _scriptLoads() {
+    final loads = <_QueuedCommand>[];
+    for (final script in _scripts) {
+      if (script._isLoadedOn(_owner)) continue;
+      final loaded = Completer<_ParsedReply?>();
+      loaded.future.then(
+        (_) => script._markLoaded(_owner, true),
+        onError: (_) {},
+      );
+      final args = ['SCRIPT', 'LOAD', script.source];
+      loads.add(_QueuedCommand(args, _shapeGeneric, loaded));
+    }
+    return loads;
+  }
+
+  void _markExecuted() {
+    if (_executed) {
+      throw StateError('$runtimeType has already been executed');
+    }
+    _executed = true;
+  }
+
+  /// Sends [commands] in one batch; if that fails, so do all queued ones.
+  Future<void> _submitOrFail(List<_QueuedCommand> commands) async {
+    try {
+      await _submit(commands);
+    } catch (e) {
+      _failAll(e);
+      rethrow;
+    }
+  }
+
+  void _failAll(Object error) {
+    for (final command in _commands) {
+      if (!command.completer.isCompleted) {
+        command.completer.completeError(error);
+      }
+    }
+  }
+}
+
+/// Commands collected to be sent together; see [RedisClient.pipeline].
+///
+/// Every command method queues its command and returns a future for its
+/// typed result, which completes once [execute] has sent the pipeline and
+/// the reply arrived. If that reply is an error, the future completes with
+/// a [RedisException]; await every future you keep, or [Future.ignore] it.
+///
+/// Example:
+/// ```dart
+/// final pipeline = client.pipeline();
+/// final visits = pipeline.incr('visits');
+/// pipeline.expire('visits', 3600);
+/// final name = pipeline.get('name');
+/// await pipeline.execute();
+/// print('${await name}: ${await visits}');
+/// ```
+class RedisPipeline extends _CommandQueue {
+  RedisPipeline._(super.owner, super.submit);
+
+  /// Sends all queued commands in one batch, with a single wakeup of the
+  /// event loop, and waits for their replies.
+  ///
+  /// Returns the replies in command order as [RedisCommands.sendCommand]
+  /// values; an error reply appears as a [RedisException] in the list. A
+  /// pipeline can only be executed once.
+  Future<List<Object?>> execute() async {
+    _markExecuted();
+    await _submitOrFail([..._scriptLoads(), ..._commands]);
+    return [
+      for (final command in _commands)
+        await command.completer.future.then(
+          (reply) => reply?.toValue(),
+          onError: (Object error) => error,
+        ),
+    ];
+  }
+}
+
+/// Commands collected to run atomically between `MULTI` and `EXEC`; see
+/// [RedisClient.transaction].
+///
+/// For optimistic locking, [RedisCommands.watch] the keys the transaction
+/// depends on before reading them, on the same connection. If one of them
+/// changes before [execute], the server discards the transaction and
+/// [execute] returns null.
+///
+/// [execute] is the only place a transaction reports that it did not run.
+/// When it was discarded, refused with `EXECABORT` or could not be sent,
+/// the command futures complete without an error, with the result the
+/// command has for a null reply (null, 0, false or empty), so the futures of
+/// a cascade like the one below need not be awaited. A command that ran but
+/// failed inside `EXEC` completes its future with a [RedisException], as in
+/// a pipeline.
+///
+/// Example:
+/// ```dart
+/// await client.watch(['balance']);
+/// final balance = int.parse(await client.get('balance') ?? '0');
+/// final transaction = client.transaction()
+///   ..set('balance', '${balance - 10}')
+///   ..rpush('log', ['-10']);
+/// if (await transaction.execute() == null) {
+///   // Someone else changed the balance: retry
+/// }
+/// ```
+class RedisTransaction extends _CommandQueue {
+  RedisTransaction._(super.owner, super.submit);
+
+  /// Sends `MULTI`, the queued commands and `EXEC` in one batch, with a
+  /// single wakeup of the event loop.
+  ///
+  /// Returns the replies in command order as in [RedisPipeline.execute], or
+  /// null if the transaction was discarded because a watched key changed.
+  /// Throws a [RedisException] if the server refused to queue a command
+  /// (`EXECABORT`); none of the commands ran then. A transaction can only be
+  /// executed once.
+  Future<List<Object?>?> execute() async {
+    _markExecuted();
+
+    // Scripts are loaded before MULTI; until EXEC, each command is only
+    // answered with QUEUED
+    final queued = [
+      ..._scriptLoads(),
+      _QueuedCommand(const ['MULTI'], _shapeGeneric, Completer()),
+      for (final command in _commands)
+        _QueuedCommand(command.args, _shapeGeneric, Completer()),
+    ];
+    for (final command in queued) {
+      command.completer.future.ignore();
+    }
+    final exec = Completer<_ParsedReply?>();
+    await _submitOrFail([
+      ...queued,
+      _QueuedCommand(const ['EXEC'], _shapeGeneric, exec),
+    ]);
+
+    final _ParsedReply? results;
+    try {
+      results = await exec.future;
+    } on RedisException catch (e) {
+      _failAll(e);
+      rethrow;
+    }
+    if (results == null || results.isNil) {
+      // Aborted by WATCH
+      _failAll(RedisException('Transaction discarded: a watched key changed'));
+      return null;
+    }
+
+    final values = <Object?>[];
+    for (var i = 0; i < _commands.length; i++) {
+      final reply = i < results.length ? results[i] : null;
+      final completer = _commands[i].completer;
+      if (reply != null && reply.isError) {
+        final error = RedisException(reply.string ?? 'Unknown error');
+        completer.completeError(error);
+        values.add(error);
+      } else {
+        completer.complete(reply);
+        values.add(reply?.toValue());
+      }
+    }
+    return values;
+  }
+
+  /// Completes the futures of the commands that did not run with a null
+  /// reply instead of [error], which [execute] reports.
+  @override
+  void _failAll(Object error) {
+    for (final command in _commands) {
+      if (!command.completer.isCompleted) command.completer.complete(null);
+    }
+  }
+}
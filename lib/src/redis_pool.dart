@@ -0,0 +1,301 @@
+part of 'redis_client.dart';
+
+/// A fixed-size pool of Redis connections with the same command API as
+/// [RedisClient].
+///
+/// All commands issued during one microtask turn form a batch that goes to
+/// the connection with the fewest commands in flight, so a slow command (a
+/// big `KEYS` or `LRANGE 0 -1`) only delays the batch it was sent with, and
+/// several sockets share the load.
+///
+/// Commands that must run back to back on one connection (e.g. `WATCH` ...
+/// `MULTI` ... `EXEC`) go through [withConnection], which pins a connection
+/// for the duration of the callback.
+///
+/// By default the pool hosts its connections on its own [RedisReactor]
+/// (one I/O thread per four connections) where the platform supports it.
+///
+/// Example:
+/// ```dart
+/// final pool = await RedisPool.connect('localhost', 6379, size: 4);
+/// try {
+///   await pool.set('key', 'value');
+///   print(await pool.get('key'));
+/// } finally {
+///   await pool.close();
+/// }
+/// ```
+class RedisPool with RedisCommands {
+  final List<RedisClient> _clients;
+  final RedisReactor? _ownedReactor;
+
+  final _pinned = <RedisClient>{};
+  final _unpinnedWaiters = <Completer<void>>[];
+  RedisClient? _batchTarget;
+  var _closed = false;
+
+  RedisPool._(this._clients, this._ownedReactor);
+
+  /// Opens [size] connections to a Redis server.
+  ///
+  /// Pass a shared [reactor] to host the connections on it. Otherwise the
+  /// pool creates its own reactor, or falls back to one poll thread per
+  /// connection on platforms without reactor support.
+  ///
+  /// [subscriptionBufferSize] and [subscriptionOverflow] configure the pool's
+  /// pub/sub connection, and [protocol], [cache] and [instrument] every
+  /// connection, as in [RedisClient.connect]. Each connection keeps its own
+  /// cache.
+  ///
+  /// With [ioUring] and no [reactor], every connection gets its own poll
+  /// thread driven by io_uring (see [RedisClient.connect]) instead of sharing
+  /// a reactor the pool creates. The same goes for [reconnect], which
+  /// requires connections without a reactor.
+  ///
+  /// [commandTimeout] and [closeOnTimeout] apply to every connection, as in
+  /// [RedisClient.connect]; each keeps the deadlines of its own commands.
+  /// So does [compressionThreshold].
+  static Future<RedisPool> connect(
+    String host,
+    int port, {
+    int size = 4,
+    RedisReactor? reactor,
+    int? subscriptionBufferSize,
+    RedisPubSubOverflow subscriptionOverflow = RedisPubSubOverflow.dropOldest,
+    int protocol = 2,
+    RedisCacheOptions? cache,
+    bool instrument = false,
+    bool ioUring = false,
+    RedisReconnectOptions? reconnect,
+    Duration? commandTimeout,
+    bool closeOnTimeout = false,
+    int? compressionThreshold,
+  }) async {
+    if (size < 1) {
+      throw ArgumentError.value(size, 'size', 'must be at least 1');
+    }
+
+    RedisReactor? ownedReactor;
+    if (reactor == null && !ioUring && reconnect == null) {
+      try {
+        ownedReactor = RedisReactor(threads: (size + 3) ~/ 4);
+      } on UnsupportedError {
+        ownedReactor = null;
+      }
+    }
+
+    final clients = <RedisClient>[];
+    try {
+      for (var i = 0; i < size; i++) {
+        clients.add(
+          await RedisClient.connect(
+            host,
+            port,
+            reactor: reactor ?? ownedReactor,
+            subscriptionBufferSize: subscriptionBufferSize,
+            subscriptionOverflow: subscriptionOverflow,
+            protocol: protocol,
+            cache: cache,
+            instrument: instrument,
+            ioUring: ioUring,
+            reconnect: reconnect,
+            commandTimeout: commandTimeout,
+            closeOnTimeout: closeOnTimeout,
+            compressionThreshold: compressionThreshold,
+          ),
+        );
+      }
+    } catch (_) {
+      for (final client in clients) {
+        await client.close();
+      }
+      await ownedReactor?.close();
+      rethrow;
+    }
+
+    return RedisPool._(clients, ownedReactor);
+  }
+
+  /// The number of connections.
+  int get size => _clients.length;
+
+  /// Whether [close] has been called.
+  bool get isClosed => _closed;
+
+  void _checkNotClosed() {
+    if (_closed) {
+      throw StateError('RedisPool has been closed');
+    }
+  }
+
+  /// The unpinned connection with the fewest commands in flight.
+  RedisClient? _leastLoaded() {
+    RedisClient? best;
+    for (final client in _clients) {
+      if (_pinned.contains(client)) continue;
+      if (best == null || client._inFlight < best._inFlight) best = client;
+    }
+    return best;
+  }
+
+  Future<RedisClient> _acquireTarget() async {
+    while (true) {
+      _checkNotClosed();
+      final client = _leastLoaded();
+      if (client != null) return client;
+      final waiter = Completer<void>();
+      _unpinnedWaiters.add(waiter);
+      await waiter.future;
+    }
+  }
+
+  /// The connection chosen for the current microtask batch.
+  Future<RedisClient> _target() async {
+    _checkNotClosed();
+
+    var target = _batchTarget;
+    if (target == null || _pinned.contains(target)) {
+      target = _leastLoaded() ?? await _acquireTarget();
+      _batchTarget = target;
+      // Pick again for the next microtask batch
+      scheduleMicrotask(() => _batchTarget = null);
+    }
+    return target;
+  }
+
+  /// Sends the command on the connection chosen for the current batch.
+  @override
+  Future<_ParsedReply?> _command(
+    List<Object> args, [
+    int shape = _shapeGeneric,
+  ]) async {
+    final target = await _target();
+    // Writes must not leave stale entries in the other connections' caches
+    for (final client in _clients) {
+      if (client != target) client._invalidateArguments(args);
+    }
+    return target._command(args, shape);
+  }
+
+  @override
+  Future<_ParsedReply?> _cachedRead(
+    String key,
+    String? field,
+    List<Object> args,
+  ) async {
+    final target = await _target();
+    return target._cachedRead(key, field, args);
+  }
+
+  /// Returns a pipeline whose commands are sent in one batch, on one
+  /// connection; see [RedisClient.pipeline].
+  RedisPipeline pipeline() {
+    _checkNotClosed();
+    return RedisPipeline._(this, _submit);
+  }
+
+  /// Returns a transaction sent in one batch on one connection; see
+  /// [RedisClient.transaction]. Use [withConnection] to `WATCH` keys first.
+  RedisTransaction transaction() {
+    _checkNotClosed();
+    return RedisTransaction._(this, _submit);
+  }
+
+  Future<void> _submit(List<_QueuedCommand> commands) async {
+    final target = await _target();
+    for (final client in _clients) {
+      if (client == target) continue;
+      for (final command in commands) {
+        client._invalidateArguments(command.args);
+      }
+    }
+    target._submit(commands);
+  }
+
+  /// Runs [action] with a connection that no other pool command uses until
+  /// the returned future completes.
+  ///
+  /// Use this for sequences that depend on connection state, such as
+  /// `WATCH`/`MULTI`/`EXEC` or `SELECT`. Do not close the connection.
+  Future<T> withConnection<T>(
+    Future<T> Function(RedisClient client) action,
+  ) async {
+    final client = await _acquireTarget();
+    _pinned.add(client);
+    try {
+      return await action(client);
+    } finally {
+      _pinned.remove(client);
+      final waiters = List.of(_unpinnedWaiters);
+      _unpinnedWaiters.clear();
+      for (final waiter in waiters) {
+        waiter.complete();
+      }
+    }
+  }
+
+  /// Subscribes to channels and/or patterns; see [RedisClient.subscribe].
+  ///
+  /// All subscription streams of the pool share one pub/sub connection.
+  Stream<RedisPubSubMessage> subscribe({
+    Iterable<String> channels = const [],
+    Iterable<String> patterns = const [],
+  }) {
+    _checkNotClosed();
+    return _clients.first.subscribe(channels: channels, patterns: patterns);
+  }
+
+  /// Joins [group] of [stream] as [consumer]; see
+  /// [RedisClient.streamConsumer].
+  ///
+  /// Acknowledgements and `XAUTOCLAIM` calls go through the pool.
+  Future<RedisStreamConsumer> streamConsumer(
+    String stream,
+    String group,
+    String consumer, {
+    int count = 100,
+    Duration block = const Duration(seconds: 5),
+    bool createGroup = true,
+    Duration? claimMinIdle,
+    Duration claimInterval = const Duration(seconds: 30),
+  }) {
+    _checkNotClosed();
+    return RedisStreamConsumer._open(
+      this,
+      _clients.first._connectSibling,
+      stream: stream,
+      group: group,
+      consumer: consumer,
+      count: count,
+      block: block,
+      createGroup: createGroup,
+      claimMinIdle: claimMinIdle,
+      claimInterval: claimInterval,
+    );
+  }
+
+  /// Returns the native event loop counters of every connection.
+  List<RedisClientStats> stats() {
+    _checkNotClosed();
+    return [for (final client in _clients) client.stats()];
+  }
+
+  /// Closes all connections (and the pool's own reactor, if any).
+  ///
+  /// Pending commands complete with an error.
+  Future<void> close() async {
+    if (_closed) return;
+    _closed = true;
+
+    final waiters = List.of(_unpinnedWaiters);
+    _unpinnedWaiters.clear();
+    for (final waiter in waiters) {
+      waiter.complete();
+    }
+
+    for (final client in _clients) {
+      await client.close();
+    }
+    await _ownedReactor?.close();
+  }
+}
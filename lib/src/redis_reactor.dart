@@ -0,0 +1,82 @@
+part of 'redis_client.dart';
+
+/// A shared native I/O reactor that hosts many connections on a small, fixed
+/// number of threads.
+///
+/// By default every [RedisClient] and every subscription stream runs its own
+/// native poll thread. Passing a reactor to [RedisClient.connect] instead
+/// pins the connection (and its subscriptions) to one of the reactor's I/O
+/// threads, which waits on epoll (Linux/Android) or kqueue (macOS/iOS).
+/// Each connection is still driven by exactly one native thread.
+///
+/// Example:
+/// ```dart
+/// final reactor = RedisReactor(threads: 2);
+/// final clients = [
+///   for (var i = 0; i < 32; i++)
+///     await RedisClient.connect('localhost', 6379, reactor: reactor),
+/// ];
+/// // ...
+/// await reactor.close(); // also closes the clients
+/// ```
+class RedisReactor {
+  final Pointer<Reactor> _reactor;
+
+  /// The number of native I/O threads.
+  final int threads;
+
+  /// Connections hosted by this reactor, with the callback that closes them.
+  final _members = <Object, Future<void> Function()>{};
+  var _closed = false;
+
+  RedisReactor._(this._reactor, this.threads);
+
+  /// Creates a reactor with [threads] native I/O threads.
+  ///
+  /// Throws [UnsupportedError] on platforms without a reactor backend.
+  factory RedisReactor({int threads = 1}) {
+    if (threads < 1) {
+      throw ArgumentError.value(threads, 'threads', 'must be at least 1');
+    }
+    final reactor = redis_reactor_create(threads);
+    if (reactor == nullptr) {
+      throw UnsupportedError('Failed to create reactor on this platform');
+    }
+    return RedisReactor._(reactor, threads);
+  }
+
+  /// Whether [close] has been called.
+  bool get isClosed => _closed;
+
+  void _checkNotClosed() {
+    if (_closed) {
+      throw StateError('RedisReactor has been closed');
+    }
+  }
+
+  bool _start(Pointer<EventLoopState> eventLoop) {
+    _checkNotClosed();
+    return redis_event_loop_start_on_reactor(eventLoop, _reactor);
+  }
+
+  void _register(Object member, Future<void> Function() close) {
+    _members[member] = close;
+  }
+
+  void _unregister(Object member) {
+    _members.remove(member);
+  }
+
+  /// Closes every connection hosted by this reactor, then stops its threads.
+  Future<void> close() async {
+    if (_closed) return;
+    _closed = true;
+
+    for (final close in _members.values.toList()) {
+      await close();
+    }
+    _members.clear();
+
+    redis_reactor_destroy(_reactor);
+  }
+}
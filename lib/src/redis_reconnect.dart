@@ -0,0 +1,178 @@
+part of 'redis_client.dart';
+
+/// What happens to commands that were sent when the connection was lost,
+/// before their reply arrived. They may or may not have run.
+enum RedisReplayPolicy {
+  /// Fail them with a [RedisException].
+  never,
+
+  /// Send read-only commands, and writes that leave the same data and get
+  /// the same reply when they run twice (a plain `SET`, `MSET`, `EXPIRE`),
+  /// again on the new connection; fail the others.
+  idempotent,
+
+  /// Send all of them again (at least once delivery).
+  always,
+}
+
+/// Where a connection is; see [RedisClient.connectionState].
+enum RedisConnectionState {
+  /// The first connect is in progress.
+  connecting,
+
+  connected,
+
+  /// The connection was lost and a new one is being set up. Commands are
+  /// queued meanwhile.
+  reconnecting,
+
+  /// The connection is gone for good, or the client was closed.
+  disconnected,
+}
+
+/// Configuration of automatic reconnects; see [RedisClient.connect].
+class RedisReconnectOptions {
+  /// The longest wait before the first attempt. Each failed attempt doubles
+  /// it, up to [maxDelay]; the actual wait is random up to that bound, so
+  /// clients that lost a server at the same time do not all come back at
+  /// once.
+  final Duration initialDelay;
+
+  /// Upper bound for the wait between attempts.
+  final Duration maxDelay;
+
+  /// Failed attempts in a row before the client gives up and fails its
+  /// commands as without reconnect (null: never give up).
+  final int? maxAttempts;
+
+  /// What happens to commands the lost connection had sent.
+  final RedisReplayPolicy replay;
+
+  const RedisReconnectOptions({
+    this.initialDelay = const Duration(milliseconds: 100),
+    this.maxDelay = const Duration(seconds: 10),
+    this.maxAttempts,
+    this.replay = RedisReplayPolicy.idempotent,
+  });
+}
+
+/// Commands without side effects, replayed by [RedisReplayPolicy.idempotent].
+const _readOnlyCommands = {
+  'BITCOUNT',
+  'BITFIELD_RO',
+  'BITPOS',
+  'DBSIZE',
+  'DUMP',
+  'ECHO',
+  'EVALSHA_RO',
+  'EVAL_RO',
+  'EXISTS',
+  'EXPIRETIME',
+  'FCALL_RO',
+  'GEODIST',
+  'GEOHASH',
+  'GEOPOS',
+  'GET',
+  'GETBIT',
+  'GETRANGE',
+  'HEXISTS',
+  'HGET',
+  'HGETALL',
+  'HKEYS',
+  'HLEN',
+  'HMGET',
+  'HSCAN',
+  'HSTRLEN',
+  'HVALS',
+  'KEYS',
+  'LCS',
+  'LINDEX',
+  'LLEN',
+  'LPOS',
+  'LRANGE',
+  'MGET',
+  'PEXPIRETIME',
+  'PING',
+  'PTTL',
+  'SCAN',
+  'SCARD',
+  'SDIFF',
+  'SINTER',
+  'SINTERCARD',
+  'SISMEMBER',
+  'SMEMBERS',
+  'SMISMEMBER',
+  'SORT_RO',
+  'SSCAN',
+  'STRLEN',
+  'SUBSTR',
+  'SUNION',
+  'TIME',
+  'TTL',
+  'TYPE',
+  'XLEN',
+  'XRANGE',
+  'XREVRANGE',
+  'ZCARD',
+  'ZCOUNT',
+  'ZINTERCARD',
+  'ZLEXCOUNT',
+  'ZMSCORE',
+  'ZRANGE',
+  'ZRANGEBYLEX',
+  'ZRANGEBYSCORE',
+  'ZRANK',
+  'ZREVRANGE',
+  'ZREVRANGEBYLEX',
+  'ZREVRANGEBYSCORE',
+  'ZREVRANK',
+  'ZSCAN',
+  'ZSCORE',
+};
+
+/// Whether running [args] (named [command], upper case) twice leaves the
+/// same data and gets the same reply as running it once.
+bool _isIdempotent(String command, List<Object> args) {
+  if (_readOnlyCommands.contains(command)) return true;
+  switch (command) {
+    case 'MSET' || 'HMSET' || 'SETEX' || 'PSETEX':
+      return true;
+    case 'SET':
+      // NX, XX and GET make the reply depend on what was there before
+      for (var i = 3; i < args.length; i++) {
+        final option = args[i];
+        if (option is String &&
+            const {'NX', 'XX', 'GET'}.contains(option.toUpperCase())) {
+          return false;
+        }
+      }
+      return true;
+    case 'EXPIRE' || 'PEXPIRE' || 'EXPIREAT' || 'PEXPIREAT':
+      // Without NX, XX, GT or LT
+      return args.length == 3;
+    default:
+      return false;
+  }
+}
+
+/// The name under which [args] is kept in the handshake of a reconnecting
+/// client if it sets up the session (later ones with the same name replace
+/// it), or null.
+String? _sessionCommandKey(List<Object> args) {
+  final name = args.first;
+  if (name is! String) return null;
+  final command = name.toUpperCase();
+  switch (command) {
+    case 'AUTH' || 'HELLO' || 'SELECT':
+      return command;
+    case 'CLIENT' when args.length > 1:
+      final sub = args[1];
+      if (sub is! String) return null;
+      final subcommand = sub.toUpperCase();
+      return const {'TRACKING', 'SETNAME'}.contains(subcommand)
+          ? 'CLIENT $subcommand'
+          : null;
+    default:
+      return null;
+  }
+}
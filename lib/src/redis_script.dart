@@ -0,0 +1,121 @@
+part of 'redis_client.dart';
+
+/// A Lua script run with `EVALSHA`, sending its body only when the server
+/// does not know it yet.
+///
+/// Run it with [RedisCommands.evalScript]. The SHA1 digest is computed once.
+/// If the server answers `NOSCRIPT`, the script is loaded with
+/// `SCRIPT LOAD` and the call retried once; concurrent calls that hit
+/// `NOSCRIPT` share that single load.
+///
+/// In a [RedisPipeline] or [RedisTransaction], a script not yet known to be
+/// loaded is loaded in front of the batch.
+///
+/// Example:
+/// ```dart
+/// final release = RedisScript('''
+///   if redis.call('GET', KEYS[1]) == ARGV[1] then
+///     return redis.call('DEL', KEYS[1])
+///   end
+///   return 0
+/// ''');
+/// await client.evalScript(release, keys: ['lock'], args: [token]);
+/// ```
+class RedisScript {
+  /// The Lua source.
+  final String source;
+
+  /// The hex SHA1 digest of [source], as `SCRIPT LOAD` returns it.
+  final String sha1;
+
+  /// Targets (clients, pools, clusters) the script is known to be loaded on.
+  final _loaded = Expando<bool>();
+
+  /// Loads in progress per target.
+  final _loading = Expando<Future<void>>();
+
+  RedisScript(this.source) : sha1 = _sha1Hex(utf8.encode(source));
+
+  bool _isLoadedOn(Object target) => _loaded[target] ?? false;
+
+  void _markLoaded(Object target, bool loaded) {
+    _loaded[target] = loaded ? true : null;
+  }
+
+  /// Loads the script on [target], once at a time.
+  Future<void> _load(RedisCommands target) =>
+      _loading[target] ??= target
+          ._loadScript(source)
+          .then((_) => _markLoaded(target, true))
+          .whenComplete(() => _loading[target] = null);
+}
+
+bool _isNoScript(RedisException error) =>
+    error.message.startsWith('NOSCRIPT');
+
+/// The SHA1 digest of [message] as 40 lowercase hex digits.
+String _sha1Hex(List<int> message) {
+  const mask = 0xffffffff;
+  int rotl(int x, int n) => ((x << n) | (x >> (32 - n))) & mask;
+
+  final length = message.length;
+  final padded = Uint8List(((length + 8) ~/ 64 + 1) * 64);
+  padded.setRange(0, length, message);
+  padded[length] = 0x80;
+  final data = ByteData.sublistView(padded);
+  data.setUint32(padded.length - 8, (length * 8) ~/ 0x100000000);
+  data.setUint32(padded.length - 4, (length * 8) & mask);
+
+  var h0 = 0x67452301;
+  var h1 = 0xefcdab89;
+  var h2 = 0x98badcfe;
+  var h3 = 0x10325476;
+  var h4 = 0xc3d2e1f0;
+  final w = Uint32List(80);
+  for (var chunk = 0; chunk < padded.length; chunk += 64) {
+    for (var i = 0; i < 16; i++) {
+      w[i] = data.getUint32(chunk + 4 * i);
+    }
+    for (var i = 16; i < 80; i++) {
+      w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    var a = h0, b = h1, c = h2, d = h3, e = h4;
+    for (var i = 0; i < 80; i++) {
+      final int f;
+      final int k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5a827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ed9eba1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8f1bbcdc;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xca62c1d6;
+      }
+      final t = (rotl(a, 5) + (f & mask) + e + k + w[i]) & mask;
+      e = d;
+      d = c;
+      c = rotl(b, 30);
+      b = a;
+      a = t;
+    }
+    h0 = (h0 + a) & mask;
+    h1 = (h1 + b) & mask;
+    h2 = (h2 + c) & mask;
+    h3 = (h3 + d) & mask;
+    h4 = (h4 + e) & mask;
+  }
+
+  return [
+    h0,
+    h1,
+    h2,
+    h3,
+    h4,
+  ].map((h) => h.toRadixString(16).padLeft(8, '0')).join();
+}
@@ -0,0 +1,298 @@
+/// A snapshot of the native event loop counters for one connection.
+///
+/// Obtained from `RedisClient.stats()`. All counters are cumulative since the
+/// connection was created.
+class RedisClientStats {
+  /// Number of times the poll thread woke up from poll/select.
+  final int pollWakeups;
+
+  /// Wakeups that found nothing to do: no queued commands, nothing to read
+  /// and no pending output. An idle connection should not accumulate these.
+  final int spuriousWakeups;
+
+  /// Most commands that were queued for the native thread at the same time.
+  ///
+  /// Queued commands are stored in recycled blocks; this is the number of
+  /// blocks the pool had to provide at its peak.
+  final int commandPoolHighWater;
+
+  /// Command blocks currently cached for reuse.
+  final int commandPoolCached;
+
+  /// Commands too large for any pool size class, allocated directly.
+  final int commandPoolOversize;
+
+  /// Most commands that were awaiting a reply at the same time.
+  final int callbackPoolHighWater;
+
+  /// Reply callback records currently cached for reuse.
+  final int callbackPoolCached;
+
+  /// Port messages used to deliver replies. Replies read in the same cycle
+  /// share one message, so under pipelining this grows much slower than the
+  /// number of commands.
+  final int replyMessages;
+
+  /// Latency histograms and byte counters, or null unless the client was
+  /// connected with `instrument: true`.
+  final RedisLatencyStats? latency;
+
+  /// Whether the connection's poll thread uses io_uring; see the `ioUring`
+  /// option of `RedisClient.connect`.
+  final bool ioUring;
+
+  /// Times the connection was re-established after it was lost; see the
+  /// `reconnect` option of `RedisClient.connect`.
+  final int reconnects;
+
+  /// Commands that failed with a `RedisTimeoutException`; see the
+  /// `commandTimeout` option of `RedisClient.connect`.
+  final int timeouts;
+
+  /// Values compressed before they were sent; see the
+  /// `compressionThreshold` option of `RedisClient.connect`.
+  final int valuesCompressed;
+
+  /// Values in replies that were decompressed.
+  final int valuesDecompressed;
+
+  const RedisClientStats({
+    required this.pollWakeups,
+    required this.spuriousWakeups,
+    this.commandPoolHighWater = 0,
+    this.commandPoolCached = 0,
+    this.commandPoolOversize = 0,
+    this.callbackPoolHighWater = 0,
+    this.callbackPoolCached = 0,
+    this.replyMessages = 0,
+    this.latency,
+    this.ioUring = false,
+    this.reconnects = 0,
+    this.timeouts = 0,
+    this.valuesCompressed = 0,
+    this.valuesDecompressed = 0,
+  });
+
+  @override
+  String toString() =>
+      'RedisClientStats(pollWakeups: $pollWakeups, '
+      'spuriousWakeups: $spuriousWakeups, '
+      'commandPoolHighWater: $commandPoolHighWater, '
+      'commandPoolCached: $commandPoolCached, '
+      'commandPoolOversize: $commandPoolOversize, '
+      'callbackPoolHighWater: $callbackPoolHighWater, '
+      'callbackPoolCached: $callbackPoolCached, '
+      'replyMessages: $replyMessages, '
+      'ioUring: $ioUring, '
+      'reconnects: $reconnects, '
+      'timeouts: $timeouts, '
+      'valuesCompressed: $valuesCompressed, '
+      'valuesDecompressed: $valuesDecompressed'
+      '${latency != null ? ', latency: $latency' : ''})';
+}
+
+/// Where the time of an instrumented connection goes; see
+/// `RedisClient.connect(instrument: ...)`.
+///
+/// Each stage is a histogram of nanoseconds, cumulative since the
+/// connection was created:
+///
+/// 1. [queueWait]: a command waiting in the native command queue until the
+///    I/O thread picks it up.
+/// 2. [write]: hiredis' output buffer waiting to be written to the socket.
+/// 3. [reply]: from handing a command to hiredis until its reply is parsed
+///    (the network round trip plus server time, including [write]).
+/// 4. [post]: replies waiting for the rest of their batch before it is
+///    posted to Dart.
+/// 5. [delivery]: a posted batch waiting for the Dart isolate to handle it.
+class RedisLatencyStats {
+  /// Nanoseconds commands spent in the command queue.
+  final RedisHistogram queueWait;
+
+  /// Nanoseconds until buffered output was fully written to the socket.
+  final RedisHistogram write;
+
+  /// Nanoseconds from submitting a command until its reply was parsed.
+  final RedisHistogram reply;
+
+  /// Nanoseconds from the first reply of a batch until it was posted.
+  final RedisHistogram post;
+
+  /// Nanoseconds from posting a reply batch until Dart handled it.
+  final RedisHistogram delivery;
+
+  /// Commands per drain of the command queue (counts, not nanoseconds).
+  final RedisHistogram batchSize;
+
+  /// Command bytes handed to hiredis.
+  final int bytesOut;
+
+  /// Encoded reply bytes posted to Dart.
+  final int bytesIn;
+
+  /// Times the I/O thread drained queued commands.
+  final int drains;
+
+  const RedisLatencyStats({
+    required this.queueWait,
+    required this.write,
+    required this.reply,
+    required this.post,
+    required this.delivery,
+    required this.batchSize,
+    this.bytesOut = 0,
+    this.bytesIn = 0,
+    this.drains = 0,
+  });
+
+  @override
+  String toString() =>
+      'RedisLatencyStats(queueWait: $queueWait, write: $write, '
+      'reply: $reply, post: $post, delivery: $delivery, '
+      'batchSize: $batchSize, bytesOut: $bytesOut, bytesIn: $bytesIn, '
+      'drains: $drains)';
+}
+
+/// A snapshot of a log-linear histogram recorded by the native event loop.
+///
+/// Values below 16 are counted exactly; larger ones fall into 16 buckets per
+/// power of two, so reported values are within about 6% of the recorded
+/// ones.
+class RedisHistogram {
+  static const _subBuckets = 16;
+
+  final List<int> _counts;
+
+  /// The number of recorded values.
+  final int count;
+
+  const RedisHistogram._(this._counts, this.count);
+
+  /// A histogram of the bucket counts the native side reports.
+  factory RedisHistogram.fromBuckets(List<int> counts) {
+    var last = counts.length;
+    while (last > 0 && counts[last - 1] == 0) {
+      last--;
+    }
+    final trimmed = List<int>.unmodifiable(counts.take(last));
+    return RedisHistogram._(trimmed, trimmed.fold(0, (a, b) => a + b));
+  }
+
+  static int _lowest(int index) {
+    if (index < _subBuckets) return index;
+    final shift = index ~/ _subBuckets - 1;
+    return (_subBuckets + index % _subBuckets) << shift;
+  }
+
+  static int _highest(int index) {
+    if (index < _subBuckets) return index;
+    return _lowest(index) + (1 << (index ~/ _subBuckets - 1)) - 1;
+  }
+
+  /// The smallest recorded value (to bucket precision), or 0 if empty.
+  int get min {
+    for (var i = 0; i < _counts.length; i++) {
+      if (_counts[i] > 0) return _lowest(i);
+    }
+    return 0;
+  }
+
+  /// The largest recorded value (to bucket precision), or 0 if empty.
+  int get max => _counts.isEmpty ? 0 : _highest(_counts.length - 1);
+
+  /// The mean of the recorded values, taking each bucket's midpoint.
+  double get mean {
+    if (count == 0) return 0;
+    var total = 0.0;
+    for (var i = 0; i < _counts.length; i++) {
+      total += _counts[i] * (_lowest(i) + _highest(i)) / 2;
+    }
+    return total / count;
+  }
+
+  /// The value that [percentile] percent of the recorded values do not
+  /// exceed (e.g. 99 for the p99), or 0 if empty.
+  int valueAtPercentile(double percentile) {
+    if (count == 0) return 0;
+    final rank = (percentile / 100 * count).ceil().clamp(1, count);
+    var seen = 0;
+    for (var i = 0; i < _counts.length; i++) {
+      seen += _counts[i];
+      if (seen >= rank) return _highest(i);
+    }
+    return max;
+  }
+
+  /// [valueAtPercentile] of a histogram of nanoseconds, as a [Duration].
+  Duration durationAtPercentile(double percentile) =>
+      Duration(microseconds: valueAtPercentile(percentile) ~/ 1000);
+
+  @override
+  String toString() =>
+      'RedisHistogram(count: $count, p50: ${valueAtPercentile(50)}, '
+      'p99: ${valueAtPercentile(99)}, max: $max)';
+}
+
+/// Flow control counters of a client's pub/sub connection.
+///
+/// Obtained from `RedisClient.subscriptionStats()`. Only meaningful when the
+/// client was connected with a `subscriptionBufferSize`.
+class RedisSubscriptionStats {
+  /// Messages buffered natively because the listeners have not caught up.
+  final int queued;
+
+  /// Messages delivered to Dart but not yet taken by every paused listener.
+  final int pending;
+
+  /// Messages discarded by the overflow policy since the connection opened.
+  final int dropped;
+
+  /// Times reading from the socket was paused because the buffer was full.
+  final int readPauses;
+
+  const RedisSubscriptionStats({
+    this.queued = 0,
+    this.pending = 0,
+    this.dropped = 0,
+    this.readPauses = 0,
+  });
+
+  @override
+  String toString() =>
+      'RedisSubscriptionStats(queued: $queued, pending: $pending, '
+      'dropped: $dropped, readPauses: $readPauses)';
+}
+
+/// Counters of a client-side cache.
+///
+/// Obtained from `RedisClient.cacheStats()`.
+class RedisCacheStats {
+  /// Values currently cached.
+  final int size;
+
+  /// Reads answered from the cache.
+  final int hits;
+
+  /// Reads that went to the server.
+  final int misses;
+
+  /// Cached keys dropped because the server or a local write invalidated
+  /// them.
+  final int invalidations;
+
+  /// Cached keys dropped to stay within `maxEntries`.
+  final int evictions;
+
+  const RedisCacheStats({
+    this.size = 0,
+    this.hits = 0,
+    this.misses = 0,
+    this.invalidations = 0,
+    this.evictions = 0,
+  });
+
+  @override
+  String toString() =>
+      'RedisCacheStats(size: $size, hits: $hits, misses: $misses, '
+      'invalidations: $invalidations, evictions: $evictions)';
+}
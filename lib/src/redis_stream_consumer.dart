@@ -0,0 +1,333 @@
+part of 'redis_client.dart';
+
+/// An entry of a Redis stream.
+class RedisStreamEntry {
+  /// The stream key.
+  final String stream;
+
+  /// The entry ID, e.g. `1700000000000-0`.
+  final String id;
+
+  /// The field-value pairs, in the order they were added.
+  final Map<String, String> fields;
+
+  const RedisStreamEntry(this.stream, this.id, this.fields);
+
+  @override
+  String toString() => 'RedisStreamEntry($stream, $id, $fields)';
+}
+
+/// A member of a Redis stream consumer group; see
+/// [RedisClient.streamConsumer].
+///
+/// `XREADGROUP ... BLOCK` runs on a connection of its own, so it does not
+/// hold back the commands of the client it was created from. [entries]
+/// first redelivers the entries this consumer read before but never
+/// acknowledged, then waits for new ones. It only reads while it is
+/// listened to and not paused, so at most one read of `count` entries waits
+/// in its buffer.
+///
+/// [ack] calls made during one microtask turn are sent as a single `XACK`
+/// on the client the consumer was created from.
+///
+/// With a `claimMinIdle`, the consumer also takes over entries that other
+/// consumers of the group read but did not acknowledge for that long (e.g.
+/// because they crashed), using `XAUTOCLAIM` every `claimInterval`.
+///
+/// Example:
+/// ```dart
+/// final consumer = await client.streamConsumer('jobs', 'workers', 'w1');
+/// await for (final job in consumer.entries) {
+///   await handle(job.fields);
+///   await consumer.ack(job.id);
+/// }
+/// ```
+class RedisStreamConsumer {
+  final RedisCommands _commands;
+  final RedisClient _blocking;
+
+  /// The stream key.
+  final String stream;
+
+  /// The consumer group.
+  final String group;
+
+  /// The name of this consumer in [group].
+  final String consumer;
+
+  final int _count;
+  final Duration _block;
+  final Duration? _claimMinIdle;
+  final Duration _claimInterval;
+
+  late final _controller = StreamController<RedisStreamEntry>(
+    onListen: _start,
+    onResume: _resume,
+    onCancel: close,
+  );
+  Completer<void>? _resumed;
+  Completer<void>? _claimWait;
+  Timer? _claimTimer;
+
+  final _acks = <String>[];
+  Future<void>? _ackFlush;
+  var _closed = false;
+
+  RedisStreamConsumer._(
+    this._commands,
+    this._blocking,
+    this.stream,
+    this.group,
+    this.consumer,
+    this._count,
+    this._block,
+    this._claimMinIdle,
+    this._claimInterval,
+  );
+
+  /// Joins [group] through [commands], reading on a connection opened with
+  /// [connect].
+  static Future<RedisStreamConsumer> _open(
+    RedisCommands commands,
+    Future<RedisClient> Function() connect, {
+    required String stream,
+    required String group,
+    required String consumer,
+    required int count,
+    required Duration block,
+    required bool createGroup,
+    required Duration? claimMinIdle,
+    required Duration claimInterval,
+  }) async {
+    if (count < 1) {
+      throw ArgumentError.value(count, 'count', 'must be at least 1');
+    }
+    if (block.isNegative) {
+      throw ArgumentError.value(block, 'block', 'must not be negative');
+    }
+
+    if (createGroup) {
+      try {
+        await commands.xgroupCreate(stream, group, mkstream: true);
+      } on RedisException catch (e) {
+        if (!e.message.startsWith('BUSYGROUP')) rethrow;
+      }
+    }
+
+    final blocking = await connect();
+    return RedisStreamConsumer._(
+      commands,
+      blocking,
+      stream,
+      group,
+      consumer,
+      count,
+      block,
+      claimMinIdle,
+      claimInterval,
+    );
+  }
+
+  /// The entries delivered to this consumer.
+  ///
+  /// Listening starts reading; cancelling the subscription [close]s the
+  /// consumer. A failed read is reported as an error event and ends the
+  /// stream.
+  Stream<RedisStreamEntry> get entries => _controller.stream;
+
+  /// Whether [close] has been called.
+  bool get isClosed => _closed;
+
+  /// Acknowledges the entry [id].
+  ///
+  /// Acknowledgements made during one microtask turn share one `XACK`; the
+  /// returned future completes when it has been answered.
+  Future<void> ack(String id) {
+    if (_closed) {
+      throw StateError('RedisStreamConsumer has been closed');
+    }
+    _acks.add(id);
+    return _ackFlush ??= Future.microtask(_flushAcks);
+  }
+
+  Future<void> _flushAcks() async {
+    _ackFlush = null;
+    if (_acks.isEmpty) return;
+    final ids = List.of(_acks);
+    _acks.clear();
+    await _commands.xack(stream, group, ids);
+  }
+
+  void _start() {
+    _readLoop();
+    if (_claimMinIdle != null) _claimLoop(_claimMinIdle);
+  }
+
+  void _resume() {
+    _resumed?.complete();
+    _resumed = null;
+  }
+
+  /// Waits until the listener is not paused.
+  Future<void> _whilePaused() async {
+    while (!_closed && _controller.isPaused) {
+      await (_resumed ??= Completer()).future;
+    }
+  }
+
+  void _deliver(List<RedisStreamEntry> entries) {
+    if (_closed) return;
+    for (final entry in entries) {
+      _controller.add(entry);
+    }
+  }
+
+  void _fail(Object error, StackTrace stackTrace) {
+    if (_closed) return;
+    _controller.addError(error, stackTrace);
+    close();
+  }
+
+  Future<void> _readLoop() async {
+    // Entries read before but never acknowledged come first, page by page
+    String? history = '0';
+    while (true) {
+      await _whilePaused();
+      if (_closed) return;
+
+      final _ParsedReply? reply;
+      try {
+        reply = await _blocking._command([
+          'XREADGROUP',
+          'GROUP',
+          group,
+          consumer,
+          'COUNT',
+          _count,
+          'BLOCK',
+          _block.inMilliseconds,
+          'STREAMS',
+          stream,
+          history ?? '>',
+        ]);
+      } catch (e, stackTrace) {
+        _fail(e, stackTrace);
+        return;
+      }
+      if (_closed) return;
+
+      // One [stream, entries] pair, a {stream: entries} map under RESP3, or
+      // nil when BLOCK timed out
+      final page = reply?.type == _redisReplyMap
+          ? reply!.elementAt(1)
+          : reply?.elementAt(0)?.elementAt(1);
+      final deleted = <String>[];
+      final entries = _streamEntries(stream, page, deleted);
+      if (history != null) {
+        // Continue after the last entry of the page, until it is empty
+        final length = page?.length ?? 0;
+        history = length == 0 ? null : page!.elementAt(length - 1)?.stringAt(0);
+      }
+      // Deleted entries cannot be processed: acknowledge them right away
+      for (final id in deleted) {
+        ack(id).ignore();
+      }
+      _deliver(entries);
+    }
+  }
+
+  Future<void> _claimLoop(Duration minIdle) async {
+    var cursor = '0-0';
+    while (true) {
+      await _whilePaused();
+      if (_closed) return;
+
+      final _ParsedReply? reply;
+      try {
+        reply = await _commands._command([
+          'XAUTOCLAIM',
+          stream,
+          group,
+          consumer,
+          minIdle.inMilliseconds,
+          cursor,
+          'COUNT',
+          _count,
+        ]);
+      } catch (e, stackTrace) {
+        _fail(e, stackTrace);
+        return;
+      }
+      if (_closed) return;
+
+      // [next cursor, entries] plus, since Redis 7, the IDs of deleted
+      // entries it dropped from the pending list
+      cursor = reply?.stringAt(0) ?? '0-0';
+      final deleted = <String>[];
+      _deliver(_streamEntries(stream, reply?.elementAt(1), deleted));
+      for (final id in deleted) {
+        ack(id).ignore();
+      }
+
+      if (cursor == '0-0') {
+        final wait = _claimWait = Completer<void>();
+        _claimTimer = Timer(_claimInterval, wait.complete);
+        await wait.future;
+        _claimWait = null;
+      }
+    }
+  }
+
+  /// Stops reading, sends outstanding acknowledgements and closes the
+  /// consumer's connection. The [entries] stream ends.
+  Future<void> close() async {
+    if (_closed) return;
+    _closed = true;
+
+    _claimTimer?.cancel();
+    _claimWait?.complete();
+    _resumed?.complete();
+    _resumed = null;
+
+    final acks = _ackFlush;
+    if (acks != null) {
+      try {
+        await acks;
+      } catch (_) {
+        // Already reported to the caller of ack
+      }
+    }
+    // Fails a read blocked on the server
+    await _blocking.close();
+    _controller.close().ignore();
+  }
+}
+
+/// The entries of an `[[id, [field, value, ...]], ...]` reply.
+///
+/// Entries deleted from the stream while pending come with nil fields;
+/// their IDs are added to [deleted] instead.
+List<RedisStreamEntry> _streamEntries(
+  String stream,
+  _ParsedReply? reply,
+  List<String> deleted,
+) {
+  if (reply == null) return const [];
+  final entries = <RedisStreamEntry>[];
+  for (var i = 0; i < reply.length; i++) {
+    final entry = reply.elementAt(i);
+    final id = entry?.stringAt(0);
+    if (entry == null || id == null) continue;
+    final values = entry.elementAt(1);
+    if (values == null || values.isNil) {
+      deleted.add(id);
+      continue;
+    }
+    final fields = <String, String>{};
+    for (var j = 0; j + 1 < values.length; j += 2) {
+      fields[values.stringAt(j) ?? ''] = values.stringAt(j + 1) ?? '';
+    }
+    entries.add(RedisStreamEntry(stream, id, fields));
+  }
+  return entries;
+}
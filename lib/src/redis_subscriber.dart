@@ -0,0 +1,557 @@
+part of 'redis_client.dart';
+
+/// The listeners of one subscribed channel or pattern.
+class _Topic {
+  final listeners = <StreamController<RedisPubSubMessage>>{};
+
+  /// Whether Redis has confirmed the subscription.
+  var confirmed = false;
+}
+
+/// The pub/sub connection shared by all [RedisClient.subscribe] streams of
+/// one client.
+///
+/// The connection is opened when the first stream is listened to and closed
+/// when the last one is cancelled. Channels and patterns are reference
+/// counted: SUBSCRIBE is sent when a channel gets its first listener and
+/// UNSUBSCRIBE when its last listener goes away. All changes made during one
+/// microtask turn are sent as at most one command of each kind.
+///
+/// With a [_bufferSize], messages are acknowledged to the event loop once
+/// they have been handed to the listeners, and only while none of them is
+/// paused. A paused listener therefore holds back the whole connection; the
+/// event loop buffers up to [_bufferSize] messages and then applies
+/// [_overflow].
+///
+/// With [_reconnect], a lost connection is replaced by the event loop; the
+/// subscription changes made meanwhile wait, and once the new connection is
+/// up every topic is subscribed again.
+class _RedisSubscriber {
+  final String _host;
+  final int _port;
+  final RedisReactor? _reactor;
+  final int _bufferSize;
+  final RedisPubSubOverflow _overflow;
+  final RedisReconnectOptions? _reconnect;
+
+  Pointer<EventLoopState> _eventLoop = nullptr;
+  ReceivePort? _receivePort;
+
+  final _channels = <String, _Topic>{};
+  final _patterns = <String, _Topic>{};
+  final _subscribeChannels = <String>{};
+  final _unsubscribeChannels = <String>{};
+  final _subscribePatterns = <String>{};
+  final _unsubscribePatterns = <String>{};
+  final _pausedListeners = <StreamController<RedisPubSubMessage>>{};
+  var _unacknowledged = 0;
+  var _flushScheduled = false;
+  var _nextCommandId = 0;
+  var _closed = false;
+
+  /// Between losing the connection and having a new one.
+  var _reconnecting = false;
+
+  _RedisSubscriber(
+    this._host,
+    this._port,
+    this._reactor,
+    this._bufferSize,
+    this._overflow,
+    this._reconnect,
+  );
+
+  /// Returns a stream of the messages for [channels] and [patterns].
+  ///
+  /// The subscriptions are added when the stream is listened to and dropped
+  /// when it is cancelled.
+  Stream<RedisPubSubMessage> subscribe(
+    Set<String> channels,
+    Set<String> patterns,
+  ) {
+    late StreamController<RedisPubSubMessage> controller;
+
+    controller = StreamController<RedisPubSubMessage>(
+      onListen: () {
+        if (_closed) {
+          controller.addError(StateError('RedisClient has been closed'));
+          return;
+        }
+        try {
+          _open();
+        } catch (e) {
+          controller.addError(e);
+          return;
+        }
+
+        for (final channel in channels) {
+          _join(
+            _channels,
+            _subscribeChannels,
+            _unsubscribeChannels,
+            channel,
+            controller,
+            RedisPubSubMessageType.subscribe,
+          );
+        }
+        for (final pattern in patterns) {
+          _join(
+            _patterns,
+            _subscribePatterns,
+            _unsubscribePatterns,
+            pattern,
+            controller,
+            RedisPubSubMessageType.psubscribe,
+          );
+        }
+        _scheduleFlush();
+      },
+      onPause: () => _pausedListeners.add(controller),
+      onResume: () => _resumed(controller),
+      onCancel: () {
+        _resumed(controller);
+        if (_closed) return;
+        for (final channel in channels) {
+          _leave(
+            _channels,
+            _subscribeChannels,
+            _unsubscribeChannels,
+            channel,
+            controller,
+          );
+        }
+        for (final pattern in patterns) {
+          _leave(
+            _patterns,
+            _subscribePatterns,
+            _unsubscribePatterns,
+            pattern,
+            controller,
+          );
+        }
+        _scheduleFlush();
+      },
+    );
+
+    return controller.stream;
+  }
+
+  void _join(
+    Map<String, _Topic> topics,
+    Set<String> toSubscribe,
+    Set<String> toUnsubscribe,
+    String name,
+    StreamController<RedisPubSubMessage> controller,
+    RedisPubSubMessageType confirmation,
+  ) {
+    var topic = topics[name];
+    if (topic == null) {
+      topic = topics[name] = _Topic();
+      toSubscribe.add(name);
+    } else {
+      // Still subscribed on the server if its last listener just left
+      toUnsubscribe.remove(name);
+    }
+    topic.listeners.add(controller);
+
+    // Late listeners get the confirmation the server already sent
+    if (topic.confirmed) {
+      controller.add(RedisPubSubMessage._(type: confirmation, channel: name));
+    }
+  }
+
+  void _leave(
+    Map<String, _Topic> topics,
+    Set<String> toSubscribe,
+    Set<String> toUnsubscribe,
+    String name,
+    StreamController<RedisPubSubMessage> controller,
+  ) {
+    final topic = topics[name];
+    if (topic == null || !topic.listeners.remove(controller)) return;
+    if (topic.listeners.isNotEmpty) return;
+
+    if (toSubscribe.remove(name)) {
+      // Never sent, nothing to undo
+      topics.remove(name);
+    } else {
+      toUnsubscribe.add(name);
+    }
+  }
+
+  void _resumed(StreamController<RedisPubSubMessage> controller) {
+    if (_pausedListeners.remove(controller)) _acknowledge(0);
+  }
+
+  /// Tells the event loop that [count] more messages reached the listeners.
+  void _acknowledge(int count) {
+    if (_bufferSize == 0 || _eventLoop == nullptr) return;
+    _unacknowledged += count;
+    if (_unacknowledged == 0 || _pausedListeners.isNotEmpty) return;
+    redis_pubsub_ack(_eventLoop, _unacknowledged);
+    _unacknowledged = 0;
+  }
+
+  void _scheduleFlush() {
+    if (!_flushScheduled) {
+      _flushScheduled = true;
+      scheduleMicrotask(_flush);
+    }
+  }
+
+  /// Sends the subscription changes of the last microtask turn.
+  void _flush() {
+    _flushScheduled = false;
+    if (_closed || _eventLoop == nullptr) return;
+
+    // Topics without listeners are exactly the ones waiting for UNSUBSCRIBE
+    if (_channels.length == _unsubscribeChannels.length &&
+        _patterns.length == _unsubscribePatterns.length) {
+      _disconnect();
+      return;
+    }
+    // Sent by _resubscribe once connected again
+    if (_reconnecting) return;
+
+    for (final channel in _unsubscribeChannels) {
+      _channels.remove(channel);
+    }
+    for (final pattern in _unsubscribePatterns) {
+      _patterns.remove(pattern);
+    }
+
+    _send('UNSUBSCRIBE', _unsubscribeChannels, const {});
+    _send('PUNSUBSCRIBE', _unsubscribePatterns, const {});
+    _send('SUBSCRIBE', _subscribeChannels, _channels);
+    _send('PSUBSCRIBE', _subscribePatterns, _patterns);
+
+    _unsubscribeChannels.clear();
+    _unsubscribePatterns.clear();
+    _subscribeChannels.clear();
+    _subscribePatterns.clear();
+  }
+
+  /// Opens the connection unless it is already open.
+  void _open() {
+    if (_eventLoop != nullptr) return;
+
+    final options = calloc<redisOptions>();
+    try {
+      // Zero-initialize
+      for (var i = 0; i < sizeOf<redisOptions>(); i++) {
+        options.cast<Uint8>()[i] = 0;
+      }
+
+      final hostPtr = _host.toNativeUtf8();
+      try {
+        options.ref.type = redisConnectionType.REDIS_CONN_TCP.value;
+        options.ref.endpoint.tcp.ip = hostPtr.cast();
+        options.ref.endpoint.tcp.port = _port;
+        options.ref.options = REDIS_OPT_NOAUTOFREE;
+
+        final ctx = redisAsyncConnectWithOptions(options);
+        if (ctx == nullptr) {
+          throw RedisException('Failed to allocate async context');
+        }
+
+        if (ctx.ref.err != 0) {
+          final errStr = ctx.ref.errstr.cast<Utf8>().toDartString();
+          redisAsyncFree(ctx);
+          throw RedisException('Connection failed: $errStr');
+        }
+
+        final receivePort = ReceivePort();
+        final eventLoop = redis_event_loop_create(
+          ctx,
+          receivePort.sendPort.nativePort,
+        );
+
+        if (eventLoop == nullptr) {
+          receivePort.close();
+          redisAsyncFree(ctx);
+          throw RedisException('Failed to create event loop');
+        }
+        if (_bufferSize > 0) {
+          redis_event_loop_set_pubsub_limits(
+            eventLoop,
+            _bufferSize,
+            _overflow.index,
+          );
+        }
+        final reconnect = _reconnect;
+        if (reconnect != null &&
+            !RedisClient._enableReconnect(
+              eventLoop,
+              hostPtr,
+              _port,
+              reconnect,
+            )) {
+          receivePort.close();
+          redis_event_loop_destroy(eventLoop);
+          throw RedisException('Failed to enable reconnect');
+        }
+
+        receivePort.listen((message) {
+          if (receivePort != _receivePort) return;
+          if (message is int) {
+            if (message == -1) {
+              // Disconnect
+              _addErrorToAll(RedisException('Connection lost'));
+            } else if (message == _msgReconnecting) {
+              _reconnecting = true;
+            } else if (message == _msgReconnected) {
+              _resubscribe();
+            }
+            return;
+          }
+          final reader = _ReplyReader.forMessage(message);
+          var count = 0;
+          while (reader != null && reader.hasMore) {
+            reader.readCommandId();
+            count++;
+            final pubsubMsg = _parsePubSubMessage(reader.read());
+            if (pubsubMsg != null) {
+              _dispatch(pubsubMsg);
+            }
+          }
+          _acknowledge(count);
+        });
+
+        final reactor = _reactor;
+        final started = reactor != null
+            ? reactor._start(eventLoop)
+            : redis_event_loop_start(eventLoop);
+        if (!started) {
+          receivePort.close();
+          redis_event_loop_destroy(eventLoop);
+          redisAsyncFree(ctx);
+          throw RedisException('Failed to start event loop');
+        }
+        reactor?._register(this, close);
+
+        _eventLoop = eventLoop;
+        _receivePort = receivePort;
+      } finally {
+        calloc.free(hostPtr);
+      }
+    } finally {
+      calloc.free(options);
+    }
+  }
+
+  /// Subscribes to every topic that still has listeners on the new
+  /// connection. Listeners get the confirmation again.
+  void _resubscribe() {
+    _reconnecting = false;
+    if (_closed || _eventLoop == nullptr) return;
+    for (final channel in _unsubscribeChannels) {
+      _channels.remove(channel);
+    }
+    for (final pattern in _unsubscribePatterns) {
+      _patterns.remove(pattern);
+    }
+    _unsubscribeChannels.clear();
+    _unsubscribePatterns.clear();
+    for (final MapEntry(:key, :value) in _channels.entries) {
+      value.confirmed = false;
+      _subscribeChannels.add(key);
+    }
+    for (final MapEntry(:key, :value) in _patterns.entries) {
+      value.confirmed = false;
+      _subscribePatterns.add(key);
+    }
+    _flush();
+  }
+
+  /// Routes a message to the listeners of its channel or pattern.
+  void _dispatch(RedisPubSubMessage message) {
+    final _Topic? topic;
+    switch (message.type) {
+      case RedisPubSubMessageType.message:
+        topic = _channels[message.channel];
+      case RedisPubSubMessageType.pmessage:
+        topic = _patterns[message.pattern];
+      case RedisPubSubMessageType.subscribe:
+        topic = _channels[message.channel];
+        if (topic == null || topic.confirmed) return;
+        topic.confirmed = true;
+      case RedisPubSubMessageType.psubscribe:
+        topic = _patterns[message.channel];
+        if (topic == null || topic.confirmed) return;
+        topic.confirmed = true;
+      case RedisPubSubMessageType.unsubscribe:
+      case RedisPubSubMessageType.punsubscribe:
+        // Only sent once the last listener is gone
+        return;
+    }
+    if (topic == null) return;
+    for (final listener in topic.listeners) {
+      listener.add(message);
+    }
+  }
+
+  Set<StreamController<RedisPubSubMessage>> _allListeners() => {
+    for (final topic in _channels.values) ...topic.listeners,
+    for (final topic in _patterns.values) ...topic.listeners,
+  };
+
+  void _addErrorToAll(Object error) {
+    for (final listener in _allListeners()) {
+      listener.addError(error);
+    }
+  }
+
+  /// Parses a pub/sub message from a decoded reply.
+  static RedisPubSubMessage? _parsePubSubMessage(_ParsedReply? reply) {
+    if (reply == null || !reply.isAggregate || reply.length < 3) {
+      return null;
+    }
+
+    final typeElem = reply[0];
+    if (typeElem == null ||
+        typeElem.type != _redisReplyString ||
+        typeElem.string == null) {
+      return null;
+    }
+
+    final typeStr = typeElem.string!;
+    final type = switch (typeStr) {
+      'message' => RedisPubSubMessageType.message,
+      'pmessage' => RedisPubSubMessageType.pmessage,
+      'subscribe' => RedisPubSubMessageType.subscribe,
+      'unsubscribe' => RedisPubSubMessageType.unsubscribe,
+      'psubscribe' => RedisPubSubMessageType.psubscribe,
+      'punsubscribe' => RedisPubSubMessageType.punsubscribe,
+      _ => null,
+    };
+
+    if (type == null) return null;
+
+    String channel = '';
+    String? message;
+    String? pattern;
+
+    if (type == RedisPubSubMessageType.pmessage && reply.length >= 4) {
+      pattern = reply.stringAt(1);
+      channel = reply.stringAt(2) ?? '';
+      message = reply.stringAt(3);
+    } else if (type == RedisPubSubMessageType.message && reply.length >= 3) {
+      channel = reply.stringAt(1) ?? '';
+      message = reply.stringAt(2);
+    } else if (reply.length >= 2) {
+      channel = reply.stringAt(1) ?? '';
+    }
+
+    return RedisPubSubMessage._(
+      type: type,
+      channel: channel,
+      message: message,
+      pattern: pattern,
+    );
+  }
+
+  /// Sends `cmd` with [targets]; on failure their [topics] listeners get an
+  /// error.
+  void _send(String cmd, Set<String> targets, Map<String, _Topic> topics) {
+    if (targets.isEmpty) return;
+
+    final commandId = _nextCommandId++;
+    final argc = targets.length + 1;
+    final argv = calloc<Pointer<Char>>(argc);
+    final argvlen = calloc<Size>(argc);
+
+    try {
+      final cmdPtr = cmd.toNativeUtf8();
+      argv[0] = cmdPtr.cast();
+      argvlen[0] = cmdPtr.length;
+      var i = 1;
+      for (final target in targets) {
+        final arg = target.toNativeUtf8();
+        argv[i] = arg.cast();
+        argvlen[i] = arg.length;
+        i++;
+      }
+
+      // Use pubsub command for persistent callbacks
+      final result = redis_async_pubsub_command(
+        _eventLoop,
+        _receivePort!.sendPort.nativePort,
+        commandId,
+        argc,
+        argv,
+        argvlen,
+      );
+      if (result != 0) {
+        final error = RedisException('Failed to send $cmd');
+        for (final target in targets) {
+          for (final listener in topics[target]?.listeners ?? const {}) {
+            listener.addError(error);
+          }
+        }
+      }
+    } finally {
+      for (var i = 0; i < argc; i++) {
+        if (argv[i] != nullptr) {
+          calloc.free(argv[i].cast<Utf8>());
+        }
+      }
+      calloc.free(argv);
+      calloc.free(argvlen);
+    }
+  }
+
+  /// Closes the connection and forgets all subscriptions.
+  void _disconnect() {
+    if (_eventLoop == nullptr) return;
+
+    // Destroy the event loop (this also frees the async context)
+    redis_event_loop_destroy(_eventLoop);
+    _reactor?._unregister(this);
+    _receivePort?.close();
+    _eventLoop = nullptr;
+    _receivePort = null;
+    _unacknowledged = 0;
+    _reconnecting = false;
+
+    _channels.clear();
+    _patterns.clear();
+    _subscribeChannels.clear();
+    _unsubscribeChannels.clear();
+    _subscribePatterns.clear();
+    _unsubscribePatterns.clear();
+  }
+
+  /// Returns the flow control counters of the open connection.
+  RedisSubscriptionStats stats() {
+    if (_eventLoop == nullptr) {
+      return const RedisSubscriptionStats();
+    }
+    final out = calloc<EventLoopStats>();
+    try {
+      if (redis_event_loop_get_stats(_eventLoop, out) != 0) {
+        throw RedisException('Failed to read event loop stats');
+      }
+      return RedisSubscriptionStats(
+        queued: out.ref.pubsub_queued,
+        pending: _unacknowledged,
+        dropped: out.ref.pubsub_dropped,
+        readPauses: out.ref.pubsub_read_pauses,
+      );
+    } finally {
+      calloc.free(out);
+    }
+  }
+
+  /// Closes the connection and ends every subscription stream.
+  Future<void> close() async {
+    if (_closed) return;
+    _closed = true;
+
+    final listeners = _allListeners();
+    _disconnect();
+    for (final listener in listeners) {
+      // Don't wait for paused listeners to drain
+      unawaited(listener.close());
+    }
+  }
+}
@@ -0,0 +1,77 @@
+part of 'redis_client.dart';
+
+/// Thrown by a command whose reply did not arrive within its timeout; see
+/// `commandTimeout` in [RedisClient.connect] and [RedisClient.withTimeout].
+///
+/// The command may still run on the server. Its reply is dropped when it
+/// arrives, so the commands sent after it still get their own replies.
+class RedisTimeoutException extends RedisException {
+  RedisTimeoutException(super.message);
+
+  @override
+  String toString() => 'RedisTimeoutException: $message';
+}
+
+/// Commands that wait on the server by design, which a client's
+/// `commandTimeout` does not apply to.
+const _blockingCommands = {
+  'BLMOVE',
+  'BLMPOP',
+  'BLPOP',
+  'BRPOP',
+  'BRPOPLPUSH',
+  'BZMPOP',
+  'BZPOPMAX',
+  'BZPOPMIN',
+  'WAIT',
+  'WAITAOF',
+};
+
+/// Whether [args] may block on the server: a blocking pop, `WAIT`, or an
+/// `XREAD`/`XREADGROUP` with `BLOCK`.
+bool _isBlocking(List<Object> args) {
+  final name = args.first;
+  if (name is! String) return false;
+  final command = name.toUpperCase();
+  if (_blockingCommands.contains(command)) return true;
+  if (command != 'XREAD' && command != 'XREADGROUP') return false;
+  for (var i = 1; i < args.length; i++) {
+    final option = args[i];
+    if (option is String && option.toUpperCase() == 'BLOCK') return true;
+  }
+  return false;
+}
+
+/// Milliseconds of [timeout] for the native side: 0 for none, at least 1
+/// otherwise.
+int _timeoutMillis(Duration? timeout, String name) {
+  if (timeout == null) return 0;
+  if (timeout <= Duration.zero) {
+    throw ArgumentError.value(timeout, name, 'must be positive');
+  }
+  return timeout.inMilliseconds.clamp(1, 0xffffffff);
+}
+
+/// The commands of a [RedisClient] sent with their own timeout; see
+/// [RedisClient.withTimeout].
+class _TimeoutCommands with RedisCommands {
+  final RedisClient _client;
+
+  /// 0 for no timeout.
+  final int _timeoutMs;
+
+  _TimeoutCommands(this._client, this._timeoutMs);
+
+  @override
+  Future<_ParsedReply?> _command(
+    List<Object> args, [
+    int shape = _shapeGeneric,
+  ]) => _client._command(args, shape, _timeoutMs);
+
+  @override
+  Future<_ParsedReply?> _cachedRead(
+    String key,
+    String? field,
+    List<Object> args,
+  ) => _client._cachedRead(key, field, args, _timeoutMs);
+}
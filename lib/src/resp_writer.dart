@@ -0,0 +1,239 @@
+part of 'redis_client.dart';
+
+const _asciiCR = 0x0d;
+const _asciiLF = 0x0a;
+const _asciiZero = 0x30;
+const _respArray = 0x2a; // '*'
+const _respBulk = 0x24; // '$'
+
+/// Encodes commands as RESP directly into a native [CommandBatch].
+///
+/// All commands issued during one microtask turn go into the same batch,
+/// which is then handed to the event loop as a whole. The native side passes
+/// each command to hiredis pre-formatted, so an argument is copied once into
+/// the batch and once into the hiredis output buffer.
+class _RespWriter {
+  static const _initialDataCapacity = 4096;
+  static const _initialCommandCapacity = 64;
+
+  final Pointer<EventLoopState> _eventLoop;
+
+  Pointer<CommandBatch> _batch = nullptr;
+  Uint8List _data = Uint8List(0);
+  Int64List _ids = Int64List(0);
+  Uint32List _lens = Uint32List(0);
+  Uint8List _shapes = Uint8List(0);
+  Uint32List _timeouts = Uint32List(0);
+  var _length = 0;
+  var _count = 0;
+
+  _RespWriter(this._eventLoop);
+
+  /// Whether no command was added since the last flush.
+  bool get isEmpty => _count == 0;
+
+  /// Appends `args` as one RESP command replying to [commandId], whose reply
+  /// is encoded by the [shape] hint and fails natively after [timeoutMs]
+  /// milliseconds (0: never).
+  ///
+  /// Each argument is a [String] (UTF-8), a `List<int>` of bytes or a [num].
+  void add(
+    int commandId,
+    List<Object> args, [
+    int shape = _shapeGeneric,
+    int timeoutMs = 0,
+  ]) {
+    if (_batch == nullptr) _acquire();
+
+    final start = _length;
+    try {
+      if (_count == _ids.length) _reserve(0, _count + 1);
+      _writeLength(_respArray, args.length);
+      for (final arg in args) {
+        _writeArgument(arg);
+      }
+    } catch (_) {
+      _length = start;
+      rethrow;
+    }
+
+    _ids[_count] = commandId;
+    _lens[_count] = _length - start;
+    _shapes[_count] = shape;
+    _timeouts[_count] = timeoutMs;
+    _count++;
+  }
+
+  /// Hands the current batch to the event loop.
+  ///
+  /// Returns the ids of the commands that could not be queued (empty on
+  /// success). The caller still has to wake up the poll thread.
+  List<int> flush(int dartPort) {
+    if (_count == 0) return const [];
+
+    final batch = _batch;
+    batch.ref
+      ..data_len = _length
+      ..count = _count;
+
+    if (redis_async_batch_enqueue(_eventLoop, dartPort, batch) != 0) {
+      final failed = List<int>.of(_ids.take(_count));
+      _reset();
+      return failed;
+    }
+
+    // The event loop owns the batch now.
+    _detach();
+    return const [];
+  }
+
+  /// Returns the current batch, which the caller owns from then on, or
+  /// nullptr if no command was added.
+  Pointer<CommandBatch> take() {
+    if (_count == 0) return nullptr;
+
+    final batch = _batch;
+    batch.ref
+      ..data_len = _length
+      ..count = _count;
+    _detach();
+    return batch;
+  }
+
+  /// Forgets the batch after it was handed over.
+  void _detach() {
+    _batch = nullptr;
+    _data = Uint8List(0);
+    _ids = Int64List(0);
+    _lens = Uint32List(0);
+    _shapes = Uint8List(0);
+    _timeouts = Uint32List(0);
+    _length = 0;
+    _count = 0;
+  }
+
+  /// Frees the batch being filled, if any.
+  void dispose() {
+    if (_batch != nullptr) {
+      redis_command_batch_free(_batch);
+      _batch = nullptr;
+    }
+  }
+
+  void _reset() {
+    _length = 0;
+    _count = 0;
+  }
+
+  void _acquire() {
+    final batch = redis_command_batch_acquire(
+      _eventLoop,
+      _initialDataCapacity,
+      _initialCommandCapacity,
+    );
+    if (batch == nullptr) {
+      throw RedisException('Failed to allocate command buffer');
+    }
+    _batch = batch;
+    _refreshViews();
+  }
+
+  void _refreshViews() {
+    final ref = _batch.ref;
+    _data = ref.data.asTypedList(ref.data_capacity);
+    _ids = ref.ids.asTypedList(ref.cmd_capacity);
+    _lens = ref.lens.asTypedList(ref.cmd_capacity);
+    _shapes = ref.shapes.asTypedList(ref.cmd_capacity);
+    _timeouts = ref.timeouts.asTypedList(ref.cmd_capacity);
+  }
+
+  /// Grows the batch so that [extraBytes] more bytes and [commands] commands
+  /// in total fit.
+  void _reserve(int extraBytes, int commands) {
+    _batch.ref
+      ..data_len = _length
+      ..count = _count;
+    if (!redis_command_batch_reserve(_batch, _length + extraBytes, commands)) {
+      throw RedisException('Failed to grow command buffer');
+    }
+    _refreshViews();
+  }
+
+  void _ensure(int extraBytes) {
+    if (_length + extraBytes > _data.length) _reserve(extraBytes, _count);
+  }
+
+  /// Writes `<prefix><n>\r\n`.
+  void _writeLength(int prefix, int n) {
+    _ensure(24);
+    final data = _data;
+    var pos = _length;
+    data[pos++] = prefix;
+    if (n < 10) {
+      data[pos++] = _asciiZero + n;
+    } else {
+      final digitsStart = pos;
+      while (n > 0) {
+        data[pos++] = _asciiZero + n % 10;
+        n ~/= 10;
+      }
+      // Digits were written least significant first
+      for (var i = digitsStart, j = pos - 1; i < j; i++, j--) {
+        final t = data[i];
+        data[i] = data[j];
+        data[j] = t;
+      }
+    }
+    data[pos++] = _asciiCR;
+    data[pos++] = _asciiLF;
+    _length = pos;
+  }
+
+  void _writeArgument(Object arg) {
+    if (arg is String) {
+      _writeBulkString(arg);
+    } else if (arg is List<int>) {
+      _writeBulkBytes(arg);
+    } else if (arg is num) {
+      _writeBulkString(arg.toString());
+    } else {
+      throw ArgumentError.value(
+        arg,
+        'arg',
+        'must be a String, List<int> or num',
+      );
+    }
+  }
+
+  void _writeBulkString(String value) {
+    final n = value.length;
+    for (var i = 0; i < n; i++) {
+      if (value.codeUnitAt(i) > 0x7f) {
+        _writeBulkBytes(utf8.encode(value));
+        return;
+      }
+    }
+
+    // ASCII: one byte per code unit
+    _writeLength(_respBulk, n);
+    _ensure(n + 2);
+    final data = _data;
+    var pos = _length;
+    for (var i = 0; i < n; i++) {
+      data[pos++] = value.codeUnitAt(i);
+    }
+    data[pos++] = _asciiCR;
+    data[pos++] = _asciiLF;
+    _length = pos;
+  }
+
+  void _writeBulkBytes(List<int> bytes) {
+    final n = bytes.length;
+    _writeLength(_respBulk, n);
+    _ensure(n + 2);
+    _data.setRange(_length, _length + n, bytes);
+    _length += n;
+    _data[_length++] = _asciiCR;
+    _data[_length++] = _asciiLF;
+  }
+}
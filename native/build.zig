@@ -27,6 +27,31 @@ const platforms = [_]Platform{
     .{ .name = "ios-simulator-x64", .target = .{ .cpu_arch = .x86_64, .os_tag = .ios, .abi = .simulator }, .ios_sdk = "iphonesimulator" },
 };
 
+/// hiredis sources compiled into the library (and the benchmarks).
+const hiredis_source_files = &[_][]const u8{
+    "alloc.c",
+    "async.c",
+    "hiredis.c",
+    "net.c",
+    "read.c",
+    "sds.c",
+    "sockcompat.c",
+};
+
+const hiredis_cflags = &[_][]const u8{"-std=c99"};
+
+/// Build profiles (-Dprofile).
+const Profile = enum {
+    /// What the published libraries ship: ReleaseFast, hiredis on the
+    /// system allocator.
+    default,
+    /// For server deployments. On Linux targets the shared library is built
+    /// with LTO across the Zig and hiredis sources, and hiredis allocates
+    /// through the size-class allocator of src/alloc.zig. Other targets,
+    /// mobile ones included, build as with the default profile.
+    performance,
+};
+
 pub fn build(b: *std.Build) void {
     // Check if building all platforms
     const build_all = b.option(bool, "all", "Build for all platforms") orelse false;
@@ -37,17 +62,85 @@ pub fn build(b: *std.Build) void {
     // Single platform option (e.g., -Dplatform=android-arm64)
     const platform_name = b.option([]const u8, "platform", "Build for a specific platform by name");
 
+    const profile = b.option(Profile, "profile", "Build profile: default, or performance for servers") orelse .default;
+
     if (build_all) {
-        buildAllPlatforms(b, ndk_path);
+        buildAllPlatforms(b, ndk_path, profile);
     } else if (platform_name) |name| {
-        buildNamedPlatform(b, name, ndk_path);
+        buildNamedPlatform(b, name, ndk_path, profile);
     } else {
         // Single target build (default behavior, uses -Dtarget)
-        buildSingleTarget(b, ndk_path);
+        buildSingleTarget(b, ndk_path, profile);
     }
+
+    addBenchStep(b, profile);
+    addTestStep(b);
+}
+
+/// Whether `profile` tunes the library for `target` (see Profile).
+fn isTuned(profile: Profile, target: std.Build.ResolvedTarget) bool {
+    const is_android = target.result.abi == .android or target.result.abi == .androideabi;
+    return profile == .performance and target.result.os.tag == .linux and !is_android;
+}
+
+/// The build_options module of the native sources.
+fn buildOptions(b: *std.Build, profile: Profile, target: std.Build.ResolvedTarget) *std.Build.Step.Options {
+    const options = b.addOptions();
+    options.addOption(bool, "fast_alloc", isTuned(profile, target));
+    return options;
+}
+
+/// `zig build bench`: microbenchmarks of the native hot paths for the host,
+/// always optimized, without a Redis server (see src/bench.zig). With
+/// -Dprofile=performance, hiredis allocates as in that profile.
+fn addBenchStep(b: *std.Build, profile: Profile) void {
+    const hiredis_dep = b.dependency("hiredis", .{});
+    const hiredis_path = hiredis_dep.path(".");
+
+    const module = b.createModule(.{
+        .root_source_file = b.path("src/bench.zig"),
+        .target = b.graph.host,
+        .optimize = .ReleaseFast,
+        .link_libc = true,
+    });
+    module.addOptions("build_options", buildOptions(b, profile, b.graph.host));
+    const exe = b.addExecutable(.{
+        .name = "bench",
+        .root_module = module,
+    });
+    exe.addCSourceFiles(.{
+        .root = hiredis_path,
+        .files = hiredis_source_files,
+        .flags = hiredis_cflags,
+    });
+    exe.addCSourceFiles(.{
+        .files = &.{"src/dart_api/dart_api_dl.c"},
+        .flags = &.{},
+    });
+    exe.addIncludePath(hiredis_path);
+    exe.addIncludePath(b.path("src/dart_api"));
+    if (b.graph.host.result.os.tag == .windows) exe.linkSystemLibrary("ws2_32");
+
+    const run = b.addRunArtifact(exe);
+    const step = b.step("bench", "Run the native microbenchmarks");
+    step.dependOn(&run.step);
 }
 
-fn buildAllPlatforms(b: *std.Build, ndk_path: ?[]const u8) void {
+/// `zig build test`: the test blocks of the native sources that need
+/// neither hiredis nor a Redis server, for the host.
+fn addTestStep(b: *std.Build) void {
+    const tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/lz4.zig"),
+            .target = b.graph.host,
+        }),
+    });
+    const run = b.addRunArtifact(tests);
+    const step = b.step("test", "Run the native unit tests");
+    step.dependOn(&run.step);
+}
+
+fn buildAllPlatforms(b: *std.Build, ndk_path: ?[]const u8, profile: Profile) void {
     for (platforms) |platform| {
         const target = b.resolveTargetQuery(platform.target);
         // Install to <prefix>/<platform>/ - use with `zig build -Dall -p lib`
@@ -70,8 +163,8 @@ fn buildAllPlatforms(b: *std.Build, ndk_path: ?[]const u8) void {
             }
         }
 
-        const shared_lib = buildLibrary(b, target, .dynamic, sysroot, ndk_path);
-        const static_lib = buildLibrary(b, target, .static, sysroot, ndk_path);
+        const shared_lib = buildLibrary(b, target, .dynamic, sysroot, ndk_path, profile);
+        const static_lib = buildLibrary(b, target, .static, sysroot, ndk_path, profile);
 
         // Install to platform-specific directory
         const shared_install = b.addInstallArtifact(shared_lib, .{
@@ -86,7 +179,11 @@ fn buildAllPlatforms(b: *std.Build, ndk_path: ?[]const u8) void {
     }
 }
 
-fn buildNamedPlatform(b: *std.Build, name: []const u8, ndk_path: ?[]const u8) void {
+fn buildNamedPlatform(b: *std.Build, name: []const u8, ndk_path: ?[]const u8, profile: Profile) void {
+    // CPU baseline (e.g. -Dcpu=x86_64_v3 for current servers); -Dtarget
+    // builds take the standard -Dcpu instead
+    const cpu_name = b.option([]const u8, "cpu", "CPU model of a -Dplatform build (default: the architecture's baseline)");
+
     // Find the platform by name
     const platform = for (platforms) |p| {
         if (std.mem.eql(u8, p.name, name)) break p;
@@ -99,7 +196,16 @@ fn buildNamedPlatform(b: *std.Build, name: []const u8, ndk_path: ?[]const u8) vo
         return;
     };
 
-    const target = b.resolveTargetQuery(platform.target);
+    var query = platform.target;
+    if (cpu_name) |cpu| {
+        const model = parseCpuModel(b, query.cpu_arch.?, cpu) orelse {
+            std.debug.print("Unknown CPU model for {s}: {s}\n", .{ platform.name, cpu });
+            return;
+        };
+        query.cpu_model = .{ .explicit = model };
+    }
+
+    const target = b.resolveTargetQuery(query);
     const is_android = platform.target.abi == .android or platform.target.abi == .androideabi;
 
     if (is_android and ndk_path == null) {
@@ -117,8 +223,8 @@ fn buildNamedPlatform(b: *std.Build, name: []const u8, ndk_path: ?[]const u8) vo
         }
     }
 
-    const shared_lib = buildLibrary(b, target, .dynamic, sysroot, ndk_path);
-    const static_lib = buildLibrary(b, target, .static, sysroot, ndk_path);
+    const shared_lib = buildLibrary(b, target, .dynamic, sysroot, ndk_path, profile);
+    const static_lib = buildLibrary(b, target, .static, sysroot, ndk_path, profile);
 
     // Use dest_dir override to put files directly in prefix (not prefix/lib/)
     const shared_install = b.addInstallArtifact(shared_lib, .{
@@ -132,15 +238,22 @@ fn buildNamedPlatform(b: *std.Build, name: []const u8, ndk_path: ?[]const u8) vo
     b.getInstallStep().dependOn(&static_install.step);
 }
 
-fn buildSingleTarget(b: *std.Build, ndk_path: ?[]const u8) void {
+/// Look up a CPU model by name, accepting LLVM's spelling (x86-64-v3) too.
+fn parseCpuModel(b: *std.Build, arch: std.Target.Cpu.Arch, name: []const u8) ?*const std.Target.Cpu.Model {
+    const normalized = b.dupe(name);
+    std.mem.replaceScalar(u8, normalized, '-', '_');
+    return arch.parseCpuModel(normalized) catch null;
+}
+
+fn buildSingleTarget(b: *std.Build, ndk_path: ?[]const u8, profile: Profile) void {
     const target = b.standardTargetOptions(.{});
     const optimize = b.standardOptimizeOption(.{});
 
     // Check for sysroot (needed for iOS)
     const sysroot = b.sysroot;
 
-    const shared_lib = buildLibraryWithOptimize(b, target, optimize, .dynamic, sysroot, ndk_path);
-    const static_lib = buildLibraryWithOptimize(b, target, optimize, .static, sysroot, ndk_path);
+    const shared_lib = buildLibraryWithOptimize(b, target, optimize, .dynamic, sysroot, ndk_path, profile);
+    const static_lib = buildLibraryWithOptimize(b, target, optimize, .static, sysroot, ndk_path, profile);
 
     // Install headers for ffigen
     const hiredis_dep = b.dependency("hiredis", .{});
@@ -169,8 +282,9 @@ fn buildLibrary(
     linkage: std.builtin.LinkMode,
     sysroot: ?[]const u8,
     ndk_path: ?[]const u8,
+    profile: Profile,
 ) *std.Build.Step.Compile {
-    return buildLibraryWithOptimize(b, target, .ReleaseFast, linkage, sysroot, ndk_path);
+    return buildLibraryWithOptimize(b, target, .ReleaseFast, linkage, sysroot, ndk_path, profile);
 }
 
 fn buildLibraryWithOptimize(
@@ -180,22 +294,11 @@ fn buildLibraryWithOptimize(
     linkage: std.builtin.LinkMode,
     sysroot: ?[]const u8,
     ndk_path: ?[]const u8,
+    profile: Profile,
 ) *std.Build.Step.Compile {
     const hiredis_dep = b.dependency("hiredis", .{});
     const hiredis_path = hiredis_dep.path(".");
 
-    const hiredis_source_files = &[_][]const u8{
-        "alloc.c",
-        "async.c",
-        "hiredis.c",
-        "net.c",
-        "read.c",
-        "sds.c",
-        "sockcompat.c",
-    };
-
-    const cflags = &[_][]const u8{"-std=c99"};
-
     const is_ios = target.result.os.tag == .ios;
     const is_apple = target.result.os.tag == .macos or is_ios;
     const is_android = target.result.abi == .android or target.result.abi == .androideabi;
@@ -207,6 +310,7 @@ fn buildLibraryWithOptimize(
         .optimize = optimize,
         .link_libc = true,
     });
+    module.addOptions("build_options", buildOptions(b, profile, target));
 
     // Build library
     const lib = b.addLibrary(.{
@@ -219,7 +323,7 @@ fn buildLibraryWithOptimize(
     lib.addCSourceFiles(.{
         .root = hiredis_path,
         .files = hiredis_source_files,
-        .flags = cflags,
+        .flags = hiredis_cflags,
     });
 
     // Add Dart API DL sources
@@ -251,6 +355,18 @@ fn buildLibraryWithOptimize(
         }
     }
 
+    // Performance profile: optimize across the Zig and C sources at link
+    // time. Static archives stay regular objects, since whoever links them
+    // may not read Zig's LLVM bitcode.
+    if (isTuned(profile, target) and linkage == .dynamic) {
+        lib.lto = .full;
+    }
+
+    // Windows: hiredis and the event loop's WSAEventSelect wakeup use Winsock
+    if (target.result.os.tag == .windows) {
+        lib.linkSystemLibrary("ws2_32");
+    }
+
     // macOS/iOS: Add headerpad for install_name_tool compatibility (required by Dart)
     if (is_apple) {
         lib.headerpad_max_install_names = true;
@@ -0,0 +1,187 @@
+// Size-class allocator for hiredis, built with -Dprofile=performance on
+// Linux (see native/build.zig).
+//
+// It is installed with hiredisSetAllocators when the library is loaded,
+// before hiredis has allocated anything, so every hi_malloc and hi_free
+// goes through it whichever thread calls them. redis_init_dart_api, which
+// runs before the first connection, installs it as well if the loader did
+// not. Each block starts with a
+// 16-byte header naming its size class, since hi_free is not told the size.
+//
+// The threads driving connections (pollLoop, reactor I/O threads) keep a
+// thread-local cache of free blocks per class, after calling enterThread.
+// Reply objects, element arrays, reader buffers and sds strings, which
+// those threads allocate and free for every reply, are then recycled
+// without a trip to malloc and its locks. A block freed on another thread,
+// e.g. a reply string handed to Dart as external typed data, goes back to
+// malloc. exitThread returns a thread's cache to malloc before it exits.
+
+const std = @import("std");
+const build_options = @import("build_options");
+const c = @import("async_loop.zig").c;
+
+/// Whether this build installs the allocator.
+pub const enabled = build_options.fast_alloc;
+
+/// Payload sizes of the classes; larger blocks go straight to malloc.
+const class_sizes = [_]usize{ 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384 };
+const max_cached_per_class = 64;
+
+/// Class of a block too large for any, allocated to its exact size.
+const large_class = std.math.maxInt(u32);
+
+/// Keeps payloads at malloc's 16-byte alignment.
+const Header = extern struct {
+    class: u32,
+    _pad: u32 = 0,
+    /// Payload size of a large block.
+    size: u64,
+};
+
+comptime {
+    std.debug.assert(@sizeOf(Header) == 16);
+}
+
+const FreeBlock = struct { next: ?*FreeBlock };
+
+const Cache = struct {
+    lists: [class_sizes.len]?*FreeBlock = .{null} ** class_sizes.len,
+    counts: [class_sizes.len]u32 = .{0} ** class_sizes.len,
+};
+
+threadlocal var cache: Cache = .{};
+threadlocal var caching: bool = false;
+
+var funcs: c.hiredisAllocFuncs = .{
+    .mallocFn = mallocFn,
+    .callocFn = callocFn,
+    .reallocFn = reallocFn,
+    .strdupFn = strdupFn,
+    .freeFn = freeFn,
+};
+
+fn install() callconv(.c) void {
+    _ = c.hiredisSetAllocators(&funcs);
+}
+
+/// Run by the dynamic loader (an .init_array entry; see async_loop.zig).
+pub const init_entry: *const fn () callconv(.c) void = &install;
+
+/// Install the allocator unless it is in place already. Must run before
+/// hiredis allocates anything.
+pub fn ensureInstalled() void {
+    if (enabled and !installed()) install();
+}
+
+/// Whether hiredis allocates through this allocator.
+pub fn installed() bool {
+    return c.hiredisAllocFns.mallocFn == funcs.mallocFn;
+}
+
+/// Start caching free blocks on the calling thread.
+pub fn enterThread() void {
+    if (!enabled) return;
+    caching = true;
+}
+
+/// Stop caching on the calling thread and free its cached blocks.
+pub fn exitThread() void {
+    if (!enabled) return;
+    caching = false;
+    for (&cache.lists, &cache.counts) |*list, *count| {
+        while (list.*) |block| {
+            list.* = block.next;
+            std.c.free(block);
+        }
+        count.* = 0;
+    }
+}
+
+fn classFor(size: usize) ?u32 {
+    for (class_sizes, 0..) |class_size, i| {
+        if (size <= class_size) return @intCast(i);
+    }
+    return null;
+}
+
+fn headerOf(ptr: *anyopaque) *Header {
+    return @ptrFromInt(@intFromPtr(ptr) - @sizeOf(Header));
+}
+
+fn payloadOf(header: *Header) *anyopaque {
+    return @ptrFromInt(@intFromPtr(header) + @sizeOf(Header));
+}
+
+fn capacityOf(header: *const Header) usize {
+    return if (header.class == large_class) header.size else class_sizes[header.class];
+}
+
+fn mallocFn(size: usize) callconv(.c) ?*anyopaque {
+    const class = classFor(size) orelse {
+        const total = std.math.add(usize, @sizeOf(Header), size) catch return null;
+        const header: *Header = @ptrCast(@alignCast(std.c.malloc(total) orelse return null));
+        header.* = .{ .class = large_class, .size = size };
+        return payloadOf(header);
+    };
+
+    if (caching) {
+        if (cache.lists[class]) |block| {
+            cache.lists[class] = block.next;
+            cache.counts[class] -= 1;
+            const header: *Header = @ptrCast(block);
+            header.* = .{ .class = class, .size = 0 };
+            return payloadOf(header);
+        }
+    }
+    const raw = std.c.malloc(@sizeOf(Header) + class_sizes[class]) orelse return null;
+    const header: *Header = @ptrCast(@alignCast(raw));
+    header.* = .{ .class = class, .size = 0 };
+    return payloadOf(header);
+}
+
+fn callocFn(count: usize, size: usize) callconv(.c) ?*anyopaque {
+    const total = std.math.mul(usize, count, size) catch return null;
+    const ptr = mallocFn(total) orelse return null;
+    @memset(@as([*]u8, @ptrCast(ptr))[0..total], 0);
+    return ptr;
+}
+
+fn reallocFn(ptr: ?*anyopaque, size: usize) callconv(.c) ?*anyopaque {
+    const old = ptr orelse return mallocFn(size);
+    const header = headerOf(old);
+    const capacity = capacityOf(header);
+    if (header.class == large_class and classFor(size) == null) {
+        // Let malloc grow or shrink it in place where it can
+        const total = std.math.add(usize, @sizeOf(Header), size) catch return null;
+        const moved: *Header = @ptrCast(@alignCast(std.c.realloc(header, total) orelse return null));
+        moved.size = size;
+        return payloadOf(moved);
+    }
+    if (header.class != large_class and size <= capacity) return old;
+
+    const new = mallocFn(size) orelse return null;
+    const len = @min(capacity, size);
+    @memcpy(@as([*]u8, @ptrCast(new))[0..len], @as([*]const u8, @ptrCast(old))[0..len]);
+    freeFn(old);
+    return new;
+}
+
+fn strdupFn(str: [*c]const u8) callconv(.c) [*c]u8 {
+    const len = std.mem.len(str);
+    const copy: [*]u8 = @ptrCast(mallocFn(len + 1) orelse return null);
+    @memcpy(copy[0 .. len + 1], str[0 .. len + 1]);
+    return copy;
+}
+
+fn freeFn(ptr: ?*anyopaque) callconv(.c) void {
+    const header = headerOf(ptr orelse return);
+    const class = header.class;
+    if (caching and class != large_class and cache.counts[class] < max_cached_per_class) {
+        const block: *FreeBlock = @ptrCast(header);
+        block.next = cache.lists[class];
+        cache.lists[class] = block;
+        cache.counts[class] += 1;
+        return;
+    }
+    std.c.free(header);
+}
@@ -7,11 +7,24 @@
 // 4. When hiredis invokes reply callbacks, we copy the reply data and post to Dart
 // 5. Hiredis frees the original reply (no NOAUTOFREEREPLIES)
 // 6. Dart receives the copied data and processes it
+//
+// Each EventLoopState is driven either by its own poll thread (pollLoop) or by
+// one I/O thread of a shared Reactor (see reactor.zig). In both cases a given
+// hiredis context is only ever touched by a single native thread.
 
 const std = @import("std");
 const builtin = @import("builtin");
-
-const c = @cImport({
+const reactor = @import("reactor.zig");
+const pool = @import("pool.zig");
+const instruments = @import("instruments.zig");
+const uring = @import("uring.zig");
+const reconnect = @import("reconnect.zig");
+const timer_wheel = @import("timer_wheel.zig");
+const codec = @import("codec.zig");
+const alloc = @import("alloc.zig");
+const Wakeup = @import("wakeup.zig").Wakeup;
+
+pub const c = @cImport({
     @cInclude("hiredis.h");
     @cInclude("async.h");
     @cInclude("dart_api_dl.h");
@@ -19,8 +32,40 @@ const c = @cImport({
 
 const is_windows = builtin.os.tag == .windows;
 
+// The performance profile's allocator must be in place before hiredis
+// allocates anything, so the dynamic loader installs it (see alloc.zig).
+// The entry is exported with default visibility, so that LTO keeps it
+// although nothing refers to it; redis_init_dart_api checks it ran.
+comptime {
+    if (alloc.enabled) @export(&alloc.init_entry, .{
+        .name = "redis_ffi_install_allocator",
+        .section = ".init_array",
+    });
+}
+
 // Message types sent to Dart
 const MSG_DISCONNECT: i64 = -1;
+// With reconnect enabled: the connection was lost, and a new one is up
+pub const MSG_RECONNECTING: i64 = -4;
+pub const MSG_RECONNECTED: i64 = -5;
+
+// Command id of reply records carrying a RESP3 push frame (e.g. a client-side
+// cache invalidation) instead of the reply to a command
+const PUSH_COMMAND_ID: i64 = -2;
+
+// Command id of the record an instrumented event loop appends to each reply
+// message: an INTEGER reply holding the monotonicNs at which it was posted
+const TIMING_COMMAND_ID: i64 = -3;
+
+// Command id of the record posted for a command whose connection was lost
+// before it was answered (see reconnect.zig): an INTEGER reply holding the
+// command's id
+const LOST_COMMAND_ID: i64 = -4;
+
+// Command id of the record posted for a command whose timeout passed before
+// it was answered: an INTEGER reply holding the command's id. Its reply is
+// dropped when it arrives.
+const EXPIRED_COMMAND_ID: i64 = -5;
 
 // Redis reply types (from hiredis.h)
 const REDIS_REPLY_STRING = 1;
@@ -44,94 +89,245 @@ const REDIS_REPLY_VERB = 14;
 // ============================================================================
 
 /// A command node in the lock-free queue.
-const CommandNode = struct {
+///
+/// Each command lives in one contiguous block from the state's node pool:
+///
+///     [CommandNode][argvlen: argc * usize][argv: argc * ptr][argument bytes]
+///
+/// argv points into the packed bytes so the node can be handed to
+/// redisAsyncCommandArgv as is.
+///
+/// A node may instead carry a CommandBatch of commands that Dart already
+/// formatted as RESP (argc is 0 in that case).
+pub const CommandNode = struct {
     next: std.atomic.Value(?*CommandNode),
-    // Command data - owned by this node, freed when processed
     dart_port: c.Dart_Port_DL,
     command_id: i64,
     argc: c_int,
-    argv: [*c][*c]u8, // Owned copies of strings
-    argvlen: [*c]usize,
+    // Total block size, needed to return the block to its size class
+    size: usize,
+    batch: ?*CommandBatch,
+    // monotonicNs when queued, if the event loop is instrumented (else 0)
+    enqueued_ns: u64,
+
+    fn argvlen(self: *CommandNode) [*]usize {
+        return @ptrFromInt(@intFromPtr(self) + @sizeOf(CommandNode));
+    }
+
+    fn argv(self: *CommandNode) [*][*c]const u8 {
+        const argc: usize = @intCast(self.argc);
+        return @ptrFromInt(@intFromPtr(self.argvlen()) + argc * @sizeOf(usize));
+    }
+
+    /// Total length of the arguments.
+    fn argBytes(self: *CommandNode) usize {
+        var total: usize = 0;
+        for (self.argvlen()[0..@intCast(self.argc)]) |len| total += len;
+        return total;
+    }
 
-    fn create(
+    pub fn create(
+        node_pool: *pool.BlockPool,
         dart_port: c.Dart_Port_DL,
         command_id: i64,
         argc: c_int,
-        argv: [*c][*c]const u8,
-        argvlen: [*c]const usize,
+        argv_in: [*c][*c]const u8,
+        argvlen_in: [*c]const usize,
     ) ?*CommandNode {
-        const node = std.heap.c_allocator.create(CommandNode) catch return null;
+        if (argc < 0) return null;
+        const count: usize = @intCast(argc);
 
-        // Allocate arrays for argv and argvlen copies
-        const argv_copy = std.heap.c_allocator.alloc([*c]u8, @intCast(argc)) catch {
-            std.heap.c_allocator.destroy(node);
-            return null;
-        };
-        const argvlen_copy = std.heap.c_allocator.alloc(usize, @intCast(argc)) catch {
-            std.heap.c_allocator.free(argv_copy);
-            std.heap.c_allocator.destroy(node);
-            return null;
+        var size: usize = @sizeOf(CommandNode) + count * (@sizeOf(usize) + @sizeOf([*c]const u8));
+        for (0..count) |i| size += argvlen_in[i];
+
+        const block = node_pool.alloc(size) orelse return null;
+        const node: *CommandNode = @ptrCast(@alignCast(block));
+        node.* = .{
+            .next = std.atomic.Value(?*CommandNode).init(null),
+            .dart_port = dart_port,
+            .command_id = command_id,
+            .argc = argc,
+            .size = size,
+            .batch = null,
+            .enqueued_ns = 0,
         };
 
-        // Copy each argument string
-        for (0..@intCast(argc)) |i| {
-            const len = argvlen[i];
-            const str_copy = std.heap.c_allocator.alloc(u8, len) catch {
-                // Free already allocated strings
-                for (0..i) |j| {
-                    std.heap.c_allocator.free(argv_copy[j][0..argvlen_copy[j]]);
-                }
-                std.heap.c_allocator.free(argvlen_copy);
-                std.heap.c_allocator.free(argv_copy);
-                std.heap.c_allocator.destroy(node);
-                return null;
-            };
-            @memcpy(str_copy, argv[i][0..len]);
-            argv_copy[i] = str_copy.ptr;
-            argvlen_copy[i] = len;
+        const lens = node.argvlen();
+        const ptrs = node.argv();
+        var bytes: [*]u8 = @ptrFromInt(@intFromPtr(ptrs) + count * @sizeOf([*c]const u8));
+        for (0..count) |i| {
+            const len = argvlen_in[i];
+            @memcpy(bytes[0..len], argv_in[i][0..len]);
+            lens[i] = len;
+            ptrs[i] = bytes;
+            bytes += len;
         }
+        return node;
+    }
 
+    fn createForBatch(
+        node_pool: *pool.BlockPool,
+        dart_port: c.Dart_Port_DL,
+        batch: *CommandBatch,
+    ) ?*CommandNode {
+        const block = node_pool.alloc(@sizeOf(CommandNode)) orelse return null;
+        const node: *CommandNode = @ptrCast(@alignCast(block));
         node.* = .{
             .next = std.atomic.Value(?*CommandNode).init(null),
             .dart_port = dart_port,
-            .command_id = command_id,
-            .argc = argc,
-            .argv = argv_copy.ptr,
-            .argvlen = argvlen_copy.ptr,
+            .command_id = -1,
+            .argc = 0,
+            .size = @sizeOf(CommandNode),
+            .batch = batch,
+            .enqueued_ns = 0,
         };
         return node;
     }
 
-    fn destroy(self: *CommandNode) void {
-        // Free copied strings
-        for (0..@intCast(self.argc)) |i| {
-            const len = self.argvlen[i];
-            std.heap.c_allocator.free(self.argv[i][0..len]);
+    /// Frees the node. A carried batch is not freed (see recycleBatch).
+    pub fn destroy(self: *CommandNode, node_pool: *pool.BlockPool) void {
+        node_pool.free(@ptrCast(self), self.size);
+    }
+};
+
+/// Commands formatted as RESP by Dart, one after another in `data`.
+/// Command i occupies `lens[i]` bytes and replies to `ids[i]`.
+///
+/// Dart fills a batch obtained from redis_command_batch_acquire and hands it
+/// over with redis_async_batch_enqueue. After submitting it, the poll thread
+/// parks the batch in EventLoopState.spare_batch so the next acquire can reuse
+/// its buffers instead of allocating.
+pub const CommandBatch = extern struct {
+    data: [*]u8,
+    data_capacity: usize,
+    data_len: usize,
+    ids: [*]i64,
+    lens: [*]u32,
+    /// ReplyShape of each command.
+    shapes: [*]u8,
+    /// Timeout of each command in milliseconds (0: none).
+    timeouts: [*]u32,
+    cmd_capacity: usize,
+    count: usize,
+
+    fn create(data_capacity: usize, cmd_capacity: usize) ?*CommandBatch {
+        const allocator = std.heap.c_allocator;
+        const batch = allocator.create(CommandBatch) catch return null;
+        const data = allocator.alloc(u8, data_capacity) catch {
+            allocator.destroy(batch);
+            return null;
+        };
+        const ids = allocator.alloc(i64, cmd_capacity) catch {
+            allocator.free(data);
+            allocator.destroy(batch);
+            return null;
+        };
+        const lens = allocator.alloc(u32, cmd_capacity) catch {
+            allocator.free(ids);
+            allocator.free(data);
+            allocator.destroy(batch);
+            return null;
+        };
+        const shapes = allocator.alloc(u8, cmd_capacity) catch {
+            allocator.free(lens);
+            allocator.free(ids);
+            allocator.free(data);
+            allocator.destroy(batch);
+            return null;
+        };
+        const timeouts = allocator.alloc(u32, cmd_capacity) catch {
+            allocator.free(shapes);
+            allocator.free(lens);
+            allocator.free(ids);
+            allocator.free(data);
+            allocator.destroy(batch);
+            return null;
+        };
+        batch.* = .{
+            .data = data.ptr,
+            .data_capacity = data_capacity,
+            .data_len = 0,
+            .ids = ids.ptr,
+            .lens = lens.ptr,
+            .shapes = shapes.ptr,
+            .timeouts = timeouts.ptr,
+            .cmd_capacity = cmd_capacity,
+            .count = 0,
+        };
+        return batch;
+    }
+
+    /// Grow the buffers to hold at least the given sizes, keeping contents.
+    fn reserve(self: *CommandBatch, data_capacity: usize, cmd_capacity: usize) bool {
+        const allocator = std.heap.c_allocator;
+        if (data_capacity > self.data_capacity) {
+            const new_capacity = @max(data_capacity, self.data_capacity * 2);
+            const data = allocator.realloc(self.data[0..self.data_capacity], new_capacity) catch return false;
+            self.data = data.ptr;
+            self.data_capacity = new_capacity;
+        }
+        if (cmd_capacity > self.cmd_capacity) {
+            const new_capacity = @max(cmd_capacity, self.cmd_capacity * 2);
+            const ids = allocator.alloc(i64, new_capacity) catch return false;
+            const lens = allocator.alloc(u32, new_capacity) catch {
+                allocator.free(ids);
+                return false;
+            };
+            const shapes = allocator.alloc(u8, new_capacity) catch {
+                allocator.free(lens);
+                allocator.free(ids);
+                return false;
+            };
+            const timeouts = allocator.alloc(u32, new_capacity) catch {
+                allocator.free(shapes);
+                allocator.free(lens);
+                allocator.free(ids);
+                return false;
+            };
+            @memcpy(ids[0..self.cmd_capacity], self.ids[0..self.cmd_capacity]);
+            @memcpy(lens[0..self.cmd_capacity], self.lens[0..self.cmd_capacity]);
+            @memcpy(shapes[0..self.cmd_capacity], self.shapes[0..self.cmd_capacity]);
+            @memcpy(timeouts[0..self.cmd_capacity], self.timeouts[0..self.cmd_capacity]);
+            allocator.free(self.ids[0..self.cmd_capacity]);
+            allocator.free(self.lens[0..self.cmd_capacity]);
+            allocator.free(self.shapes[0..self.cmd_capacity]);
+            allocator.free(self.timeouts[0..self.cmd_capacity]);
+            self.ids = ids.ptr;
+            self.lens = lens.ptr;
+            self.shapes = shapes.ptr;
+            self.timeouts = timeouts.ptr;
+            self.cmd_capacity = new_capacity;
         }
-        // Free arrays
-        std.heap.c_allocator.free(self.argv[0..@intCast(self.argc)]);
-        std.heap.c_allocator.free(self.argvlen[0..@intCast(self.argc)]);
-        // Free node
-        std.heap.c_allocator.destroy(self);
+        return true;
+    }
+
+    pub fn destroy(self: *CommandBatch) void {
+        const allocator = std.heap.c_allocator;
+        allocator.free(self.timeouts[0..self.cmd_capacity]);
+        allocator.free(self.shapes[0..self.cmd_capacity]);
+        allocator.free(self.lens[0..self.cmd_capacity]);
+        allocator.free(self.ids[0..self.cmd_capacity]);
+        allocator.free(self.data[0..self.data_capacity]);
+        allocator.destroy(self);
     }
 };
 
 /// Simple MPSC queue using atomic swap for push.
 /// Producers atomically swap the tail, consumer drains from head.
-const CommandQueue = struct {
+pub const CommandQueue = struct {
     // Tail is atomically swapped by producers
     tail: std.atomic.Value(?*CommandNode),
     // Mutex for consumer-side operations (only held briefly during drain)
     drain_mutex: std.Thread.Mutex,
 
-    fn init(self: *CommandQueue) void {
+    pub fn init(self: *CommandQueue) void {
         self.tail = std.atomic.Value(?*CommandNode).init(null);
         self.drain_mutex = .{};
     }
 
     /// Push a node to the queue (lock-free, multiple producers safe).
     /// Uses atomic swap to build a reversed list.
-    fn push(self: *CommandQueue, node: *CommandNode) void {
+    pub fn push(self: *CommandQueue, node: *CommandNode) void {
         // Build a stack (LIFO) via atomic swap
         var old_tail = self.tail.load(.acquire);
         while (true) {
@@ -146,7 +342,7 @@ const CommandQueue = struct {
 
     /// Drain all nodes from the queue (single consumer).
     /// Returns nodes in FIFO order (reverses the internal LIFO stack).
-    fn drainAll(self: *CommandQueue) ?*CommandNode {
+    pub fn drainAll(self: *CommandQueue) ?*CommandNode {
         // Atomically take all nodes
         const stack = self.tail.swap(null, .acq_rel) orelse return null;
 
@@ -174,13 +370,164 @@ pub const EventLoopState = struct {
     ctx_mutex: std.Thread.Mutex, // For hiredis context access
     // Lock-free command queue
     command_queue: CommandQueue,
-    // Pipe for waking up the poll thread when commands are queued (POSIX only)
-    wakeup_read_fd: if (is_windows) void else std.posix.fd_t,
-    wakeup_write_fd: if (is_windows) void else std.posix.fd_t,
+    // Wakes the poll thread when commands are queued (POSIX)
+    wakeup: if (is_windows) void else Wakeup,
+    // Event objects the poll thread waits on instead (Windows)
+    win_events: if (is_windows) WindowsEvents else void,
+    // Set while hiredis has unsent output (driven by the ev.addWrite/delWrite
+    // hooks) or while the non-blocking connect is still in progress.
+    want_write: std.atomic.Value(bool),
+    // Poll counters (written by the poll thread, read by redis_event_loop_get_stats)
+    poll_wakeups: std.atomic.Value(u64),
+    spurious_wakeups: std.atomic.Value(u64),
+    // Bookkeeping when hosted by a shared reactor instead of our own thread
+    reactor_link: reactor.Link,
+    // Recycled storage for queued commands and their reply callbacks
+    node_pool: pool.BlockPool,
+    info_pool: pool.ItemPool(CallbackInfo),
+    // Persistent callback shared by every (P)SUBSCRIBE on this connection;
+    // messages are routed to listeners by channel on the Dart side
+    pubsub_info: ?*CallbackInfo,
+    // Most recently submitted batch, kept for reuse by the next acquire
+    spare_batch: std.atomic.Value(?*CommandBatch),
+    // Replies collected during one read cycle, posted to Dart as one message
+    // (driving thread only, under ctx_mutex)
+    reply_buf: std.ArrayListUnmanaged(u8),
+    reply_externals: std.ArrayListUnmanaged(ExternalString),
+    reply_count: usize,
+    reply_port: c.Dart_Port_DL,
+    collecting_replies: bool,
+    // Upper bounds for one reply batch (redis_event_loop_set_reply_batch_limits)
+    max_batch_bytes: std.atomic.Value(usize),
+    max_batch_replies: std.atomic.Value(usize),
+    // Strings at least this long are posted as external typed data (0: never)
+    external_threshold: std.atomic.Value(usize),
+    reply_posts: std.atomic.Value(u64),
+    // Flow control for pub/sub messages (redis_event_loop_set_pubsub_limits).
+    // A capacity of 0 posts every message right away.
+    pubsub_capacity: usize,
+    pubsub_overflow: PubsubOverflow,
+    // Messages Dart may still be sent before it acknowledges earlier ones
+    pubsub_credits: std.atomic.Value(u64),
+    // Messages waiting for credits (driving thread only, under ctx_mutex)
+    pubsub_ring: PubsubRing,
+    pubsub_queued: std.atomic.Value(u64),
+    pubsub_dropped: std.atomic.Value(u64),
+    pubsub_read_pauses: std.atomic.Value(u64),
+    // Set while the socket is not polled for reading (PubsubOverflow.pause)
+    read_paused: std.atomic.Value(bool),
+    // Latency histograms and byte counters (redis_event_loop_enable_instruments)
+    instruments: ?*instruments.Instruments,
+    // io_uring backend of pollLoop (redis_event_loop_enable_io_uring)
+    uring: ?*uring.Backend,
+    // The creating client plus every isolate attached or handle outstanding;
+    // the last redis_event_loop_release destroys the state
+    refs: std.atomic.Value(u32),
+    // Reply ports of attached isolates, also told about disconnects
+    // (guarded by ports_mutex)
+    ports_mutex: std.Thread.Mutex,
+    attached_ports: std.ArrayListUnmanaged(c.Dart_Port_DL),
+    // Where the connection is (redis_event_loop_connection_state)
+    connection: std.atomic.Value(ConnectionState),
+    // Automatic reconnect of pollLoop (redis_event_loop_enable_reconnect)
+    reconnect: ?*reconnect.Reconnect,
+    // Set while a lost context is freed, so its commands are posted as lost
+    // records instead of NULL replies (driving thread only, under ctx_mutex)
+    dropping_context: bool,
+    // Deadlines of the commands sent with a timeout, when driven by pollLoop
+    // (poll thread only); a reactor I/O thread keeps its own for all the
+    // states it hosts (see timerWheel)
+    timers: timer_wheel.Wheel,
+    // Treat the connection as lost once a command timed out
+    // (redis_event_loop_set_close_on_timeout)
+    close_on_timeout: std.atomic.Value(bool),
+    // Set when a command timed out with close_on_timeout; connectionClosed
+    // then reports the connection as lost
+    timed_out: std.atomic.Value(bool),
+    timeouts: std.atomic.Value(u64),
+    // Compression of large values (redis_event_loop_set_compression)
+    codec: ?*codec.Codec,
+};
+
+/// Connection state reported by redis_event_loop_connection_state.
+pub const ConnectionState = enum(u8) {
+    /// The first connect is in progress.
+    connecting = 0,
+    connected = 1,
+    /// Lost; a new connection is being set up.
+    reconnecting = 2,
+    /// Lost for good, or the event loop was stopped.
+    disconnected = 3,
+};
+
+/// What to do with a pub/sub message when the ring is full.
+pub const PubsubOverflow = enum(u8) {
+    /// Discard the oldest queued message.
+    drop_oldest = 0,
+    /// Discard the incoming message.
+    drop_newest = 1,
+    /// Stop reading from the socket until Dart catches up, so TCP pushes
+    /// back on the server. Messages already read are still queued.
+    pause = 2,
+};
+
+const default_max_batch_bytes: usize = 1 << 20;
+const default_max_batch_replies: usize = 4096;
+
+/// Snapshot of the event loop counters, filled by redis_event_loop_get_stats.
+pub const EventLoopStats = extern struct {
+    /// Number of times the poll thread returned from poll/select.
+    poll_wakeups: u64,
+    /// Wakeups that found no wakeup signal, nothing to read and nothing to write.
+    spurious_wakeups: u64,
+    /// Most queued commands alive at the same time.
+    command_pool_high_water: u64,
+    /// Command blocks currently cached for reuse.
+    command_pool_cached: u64,
+    /// Commands too large for any pool size class.
+    command_pool_oversize: u64,
+    /// Most in-flight reply callbacks at the same time.
+    callback_pool_high_water: u64,
+    /// Callback infos currently cached for reuse.
+    callback_pool_cached: u64,
+    /// Reply messages posted to Dart (each carries one or more replies).
+    reply_posts: u64,
+    /// Pub/sub messages waiting for Dart to acknowledge earlier ones.
+    pubsub_queued: u64,
+    /// Pub/sub messages discarded by the overflow policy.
+    pubsub_dropped: u64,
+    /// Times reading was paused because the pub/sub ring was full.
+    pubsub_read_pauses: u64,
+    /// 1 if the event loop is instrumented; the fields below stay 0 otherwise.
+    instrumented: u64,
+    /// Command bytes handed to hiredis.
+    bytes_out: u64,
+    /// Encoded reply bytes posted to Dart.
+    bytes_in: u64,
+    /// Drains of the command queue that found commands.
+    drains: u64,
+    /// 1 if the poll thread uses io_uring instead of poll.
+    io_uring: u64,
+    /// Times the connection was re-established after it was lost.
+    reconnects: u64,
+    /// Commands failed because their timeout passed.
+    timeouts: u64,
+    /// Values compressed before they were sent.
+    values_compressed: u64,
+    /// String replies decompressed before they were posted.
+    values_decompressed: u64,
 };
 
 /// Initialize the Dart API DL.
 export fn redis_init_dart_api(data: ?*anyopaque) callconv(.c) isize {
+    // The .init_array entry has installed the allocator unless the linker
+    // dropped it. Installing it now is only safe until hiredis allocates,
+    // so say so in every build mode.
+    if (alloc.enabled and !alloc.installed()) {
+        std.log.err("hiredis allocator not installed at load time, installing it late", .{});
+        alloc.ensureInstalled();
+    }
+    instruments.init();
     return c.Dart_InitializeApiDL(data);
 }
 
@@ -191,16 +538,15 @@ export fn redis_event_loop_create(
 ) callconv(.c) ?*EventLoopState {
     const async_ctx = ctx orelse return null;
 
-    // Create wakeup pipe
-    const pipe_fds = if (is_windows)
-        .{ .read = -1, .write = -1 } // Windows uses different mechanism
-    else
-        std.posix.pipe() catch return null;
+    // Create the wakeup eventfd or pipe (event objects on Windows)
+    const wakeup = if (is_windows) {} else (Wakeup.init() catch return null);
+    const win_events = if (is_windows) (WindowsEvents.create() orelse return null) else {};
 
     const state = std.heap.c_allocator.create(EventLoopState) catch {
-        if (!is_windows) {
-            std.posix.close(pipe_fds[0]);
-            std.posix.close(pipe_fds[1]);
+        if (is_windows) {
+            win_events.destroy();
+        } else {
+            wakeup.deinit();
         }
         return null;
     };
@@ -212,18 +558,70 @@ export fn redis_event_loop_create(
         .mutex = .{},
         .ctx_mutex = .{},
         .command_queue = undefined,
-        .wakeup_read_fd = if (is_windows) {} else pipe_fds[0],
-        .wakeup_write_fd = if (is_windows) {} else pipe_fds[1],
+        .wakeup = wakeup,
+        .win_events = win_events,
+        // hiredis clears REDIS_CONNECTED until the first write event completes
+        // the connect, so we need POLLOUT until then.
+        .want_write = std.atomic.Value(bool).init(async_ctx.c.flags & c.REDIS_CONNECTED == 0),
+        .poll_wakeups = std.atomic.Value(u64).init(0),
+        .spurious_wakeups = std.atomic.Value(u64).init(0),
+        .reactor_link = .{},
+        .node_pool = .{},
+        .info_pool = .{},
+        .pubsub_info = null,
+        .spare_batch = std.atomic.Value(?*CommandBatch).init(null),
+        .reply_buf = .{},
+        .reply_externals = .{},
+        .reply_count = 0,
+        .reply_port = dart_port,
+        .collecting_replies = false,
+        .max_batch_bytes = std.atomic.Value(usize).init(default_max_batch_bytes),
+        .max_batch_replies = std.atomic.Value(usize).init(default_max_batch_replies),
+        .external_threshold = std.atomic.Value(usize).init(default_external_threshold),
+        .reply_posts = std.atomic.Value(u64).init(0),
+        .pubsub_capacity = 0,
+        .pubsub_overflow = .drop_oldest,
+        .pubsub_credits = std.atomic.Value(u64).init(0),
+        .pubsub_ring = .{},
+        .pubsub_queued = std.atomic.Value(u64).init(0),
+        .pubsub_dropped = std.atomic.Value(u64).init(0),
+        .pubsub_read_pauses = std.atomic.Value(u64).init(0),
+        .read_paused = std.atomic.Value(bool).init(false),
+        .instruments = null,
+        .uring = null,
+        .refs = std.atomic.Value(u32).init(1),
+        .ports_mutex = .{},
+        .attached_ports = .{},
+        .connection = std.atomic.Value(ConnectionState).init(.connecting),
+        .reconnect = null,
+        .dropping_context = false,
+        .timers = .{},
+        .close_on_timeout = std.atomic.Value(bool).init(false),
+        .timed_out = std.atomic.Value(bool).init(false),
+        .timeouts = std.atomic.Value(u64).init(0),
+        .codec = null,
     };
     state.command_queue.init();
-
-    // Store state in ev.data for cleanup callback
-    async_ctx.ev.data = state;
-    async_ctx.ev.cleanup = cleanupCallback;
+    installHooks(state, async_ctx);
 
     return state;
 }
 
+/// Point a context's event hooks and callbacks at `state`.
+fn installHooks(state: *EventLoopState, ctx: *c.redisAsyncContext) void {
+    // Store state in ev.data for the event hooks and the cleanup callback
+    ctx.ev.data = state;
+    ctx.ev.addWrite = addWriteCallback;
+    ctx.ev.delWrite = delWriteCallback;
+    ctx.ev.cleanup = cleanupCallback;
+
+    _ = c.redisAsyncSetConnectCallback(ctx, connectCallback);
+
+    // Only RESP3 connections receive push frames; replaces hiredis' default
+    // of dropping them
+    _ = c.redisAsyncSetPushCallback(ctx, pushCallback);
+}
+
 /// Destroy the event loop state and free the async context.
 /// After calling this, do NOT call redisAsyncFree - this function handles it.
 export fn redis_event_loop_destroy(state: ?*EventLoopState) callconv(.c) void {
@@ -234,17 +632,32 @@ export fn redis_event_loop_destroy(state: ?*EventLoopState) callconv(.c) void {
     var node = s.command_queue.drainAll();
     while (node) |n| {
         const next = n.next.load(.acquire);
-        n.destroy();
+        if (n.batch) |b| b.destroy();
+        n.destroy(&s.node_pool);
         node = next;
     }
+    if (s.spare_batch.swap(null, .acq_rel)) |b| b.destroy();
 
-    // Free the async context - we use REDIS_OPT_NOAUTOFREE so we control when it's freed
+    // Free the async context - we use REDIS_OPT_NOAUTOFREE so we control when it's freed.
+    // This runs the pending reply callbacks, which still return their infos to the pool.
     c.redisAsyncFree(s.ctx);
-
-    // Close wakeup pipe (POSIX only)
-    if (!is_windows) {
-        std.posix.close(s.wakeup_read_fd);
-        std.posix.close(s.wakeup_write_fd);
+    if (s.pubsub_info) |info| std.heap.c_allocator.destroy(info);
+    s.pubsub_ring.deinit();
+    s.reply_buf.deinit(std.heap.c_allocator);
+    s.reply_externals.deinit(std.heap.c_allocator);
+    s.node_pool.deinit();
+    s.info_pool.deinit();
+    if (s.instruments) |inst| inst.destroy();
+    if (s.uring) |u| u.destroy();
+    if (s.reconnect) |r| r.destroy();
+    if (s.codec) |cd| cd.destroy();
+    s.attached_ports.deinit(std.heap.c_allocator);
+
+    // Close the wakeup descriptors (or event objects)
+    if (is_windows) {
+        s.win_events.destroy();
+    } else {
+        s.wakeup.deinit();
     }
     std.heap.c_allocator.destroy(s);
 }
@@ -256,21 +669,63 @@ export fn redis_event_loop_start(state: ?*EventLoopState) callconv(.c) bool {
     s.mutex.lock();
     defer s.mutex.unlock();
 
-    if (s.thread != null) return false;
+    if (s.thread != null or s.reactor_link.thread != null) return false;
     s.stop.store(false, .release);
     s.thread = std.Thread.spawn(.{}, pollLoop, .{s}) catch return false;
     return true;
 }
 
+/// Create a shared reactor with `num_threads` I/O threads (epoll/kqueue).
+/// Returns null on failure or on platforms without a reactor backend.
+export fn redis_reactor_create(num_threads: c_int) callconv(.c) ?*reactor.Reactor {
+    if (num_threads <= 0) return null;
+    return reactor.Reactor.create(@intCast(num_threads));
+}
+
+/// Stop all reactor threads and free the reactor.
+/// Connections still attached are detached and notified with MSG_DISCONNECT.
+export fn redis_reactor_destroy(r: ?*reactor.Reactor) callconv(.c) void {
+    const self = r orelse return;
+    self.destroy();
+}
+
+/// Host the event loop on one of the reactor's I/O threads instead of
+/// spawning a dedicated poll thread.
+/// Returns true on success, false if already running or on error.
+export fn redis_event_loop_start_on_reactor(
+    state: ?*EventLoopState,
+    r: ?*reactor.Reactor,
+) callconv(.c) bool {
+    const s = state orelse return false;
+    const self = r orelse return false;
+
+    s.mutex.lock();
+    defer s.mutex.unlock();
+
+    if (s.thread != null or s.reactor_link.thread != null) return false;
+    s.stop.store(false, .release);
+    return self.attach(s);
+}
+
 /// Stop the poll loop.
 export fn redis_event_loop_stop(state: ?*EventLoopState) callconv(.c) void {
     const s = state orelse return;
 
     s.mutex.lock();
     const thread = s.thread;
+    const io_thread = s.reactor_link.thread;
     s.stop.store(true, .release);
     s.mutex.unlock();
 
+    // Reactor-hosted: the I/O thread acknowledges once it no longer touches us
+    if (io_thread) |t| {
+        t.detach(s);
+        s.mutex.lock();
+        s.reactor_link.thread = null;
+        s.mutex.unlock();
+        return;
+    }
+
     // Wake up the poll thread so it can exit
     redis_event_loop_wakeup(state);
 
@@ -283,36 +738,345 @@ export fn redis_event_loop_stop(state: ?*EventLoopState) callconv(.c) void {
 }
 
 /// Notify the poll thread that there's work to do (command queued).
-/// This writes to the wakeup pipe to wake up the blocking poll.
+/// Only the first call after the poll thread last woke up makes a system
+/// call (an eventfd or pipe write, or SetEvent on Windows); later ones find
+/// the wakeup pending and return.
 export fn redis_event_loop_wakeup(state: ?*EventLoopState) callconv(.c) void {
     const s = state orelse return;
-    if (is_windows) return; // TODO: Windows wakeup mechanism
+    if (s.reactor_link.thread) |t| {
+        t.wake(s);
+        return;
+    }
+    if (is_windows) {
+        if (s.win_events.pending.swap(true, .seq_cst)) return;
+        _ = win.WSASetEvent(s.win_events.wakeup);
+        return;
+    }
+    s.wakeup.signal();
+}
+
+// ============================================================================
+// Sharing across isolates
+//
+// Replies are routed by the reply port each command was queued with, so any
+// number of isolates can submit commands to one event loop. A handle is a
+// token for one reference to the state: the owning client shares it, another
+// isolate attaches with its own reply port, and the state is destroyed when
+// the last reference is released. Tokens live in a process-wide table, so a
+// handle that was already attached or released is simply not found instead
+// of touching a state that may be gone.
+// ============================================================================
+
+var handles_mutex: std.Thread.Mutex = .{};
+var handles: std.AutoHashMapUnmanaged(u64, *EventLoopState) = .{};
+var next_handle: u64 = 1;
+
+/// Take a reference for another isolate and return its token (0 on
+/// allocation failure). Called by the owner of a reference.
+export fn redis_event_loop_share(state: ?*EventLoopState) callconv(.c) u64 {
+    const s = state orelse return 0;
+    handles_mutex.lock();
+    defer handles_mutex.unlock();
+
+    const token = next_handle;
+    handles.put(std.heap.c_allocator, token, s) catch return 0;
+    next_handle += 1;
+    _ = s.refs.fetchAdd(1, .monotonic);
+    return token;
+}
+
+fn takeHandle(token: u64) ?*EventLoopState {
+    handles_mutex.lock();
+    defer handles_mutex.unlock();
+    const entry = handles.fetchRemove(token) orelse return null;
+    return entry.value;
+}
+
+/// Redeem a token from redis_event_loop_share: replies for commands queued
+/// with `dart_port` go to it, and so does MSG_DISCONNECT. Returns null if the
+/// token was already used. Release with redis_event_loop_detach.
+export fn redis_event_loop_attach(token: u64, dart_port: c.Dart_Port_DL) callconv(.c) ?*EventLoopState {
+    const s = takeHandle(token) orelse return null;
+
+    s.ports_mutex.lock();
+    const appended = s.attached_ports.append(std.heap.c_allocator, dart_port);
+    s.ports_mutex.unlock();
+    appended catch {
+        redis_event_loop_release(s);
+        return null;
+    };
+    return s;
+}
+
+/// Drop a token from redis_event_loop_share without attaching.
+export fn redis_event_loop_unshare(token: u64) callconv(.c) void {
+    if (takeHandle(token)) |s| redis_event_loop_release(s);
+}
+
+/// Undo redis_event_loop_attach: stop telling `dart_port` about disconnects
+/// and drop its reference.
+export fn redis_event_loop_detach(state: ?*EventLoopState, dart_port: c.Dart_Port_DL) callconv(.c) void {
+    const s = state orelse return;
+    {
+        s.ports_mutex.lock();
+        defer s.ports_mutex.unlock();
+        for (s.attached_ports.items, 0..) |port, i| {
+            if (port == dart_port) {
+                _ = s.attached_ports.swapRemove(i);
+                break;
+            }
+        }
+    }
+    redis_event_loop_release(s);
+}
+
+/// Drop a reference; the last one stops and destroys the event loop (see
+/// redis_event_loop_destroy).
+export fn redis_event_loop_release(state: ?*EventLoopState) callconv(.c) void {
+    const s = state orelse return;
+    if (s.refs.fetchSub(1, .acq_rel) == 1) redis_event_loop_destroy(s);
+}
+
+/// Bound the size of one reply message. Replies arriving in the same read
+/// cycle are posted together until either limit is reached; 0 keeps the
+/// current value. A single reply larger than `max_bytes` is posted alone.
+export fn redis_event_loop_set_reply_batch_limits(
+    state: ?*EventLoopState,
+    max_bytes: usize,
+    max_replies: usize,
+) callconv(.c) void {
+    const s = state orelse return;
+    if (max_bytes > 0) s.max_batch_bytes.store(max_bytes, .monotonic);
+    if (max_replies > 0) s.max_batch_replies.store(max_replies, .monotonic);
+}
+
+/// Post strings of at least `threshold` bytes without copying them, as
+/// external typed data owned by Dart. 0 disables this.
+export fn redis_event_loop_set_external_threshold(
+    state: ?*EventLoopState,
+    threshold: usize,
+) callconv(.c) void {
+    const s = state orelse return;
+    s.external_threshold.store(threshold, .monotonic);
+}
+
+/// Bound the pub/sub messages in flight to Dart. At most `capacity` messages
+/// are posted before Dart acknowledges them with redis_pubsub_ack; up to
+/// `capacity` more wait natively, after which `overflow` (a PubsubOverflow)
+/// applies. 0 disables flow control. Call before starting the event loop.
+export fn redis_event_loop_set_pubsub_limits(
+    state: ?*EventLoopState,
+    capacity: usize,
+    overflow: u8,
+) callconv(.c) void {
+    const s = state orelse return;
+    s.pubsub_capacity = capacity;
+    s.pubsub_overflow = std.meta.intToEnum(PubsubOverflow, overflow) catch .drop_oldest;
+    s.pubsub_credits.store(capacity, .seq_cst);
+}
+
+/// Acknowledge `count` pub/sub messages that Dart has handed to its listeners,
+/// allowing that many more to be posted. Wakes the event loop if messages are
+/// waiting.
+export fn redis_pubsub_ack(state: ?*EventLoopState, count: u64) callconv(.c) void {
+    const s = state orelse return;
+    _ = s.pubsub_credits.fetchAdd(count, .seq_cst);
+    if (s.pubsub_queued.load(.seq_cst) > 0) redis_event_loop_wakeup(s);
+}
+
+/// Copy the event loop counters into `out`.
+/// Returns 0 on success, -1 on error.
+export fn redis_event_loop_get_stats(state: ?*EventLoopState, out: ?*EventLoopStats) callconv(.c) c_int {
+    const s = state orelse return -1;
+    const o = out orelse return -1;
+    const nodes = s.node_pool.stats();
+    const infos = s.info_pool.stats();
+    o.* = .{
+        .poll_wakeups = s.poll_wakeups.load(.monotonic),
+        .spurious_wakeups = s.spurious_wakeups.load(.monotonic),
+        .command_pool_high_water = nodes.high_water,
+        .command_pool_cached = nodes.cached,
+        .command_pool_oversize = nodes.oversize,
+        .callback_pool_high_water = infos.high_water,
+        .callback_pool_cached = infos.cached,
+        .reply_posts = s.reply_posts.load(.monotonic),
+        .pubsub_queued = s.pubsub_queued.load(.monotonic),
+        .pubsub_dropped = s.pubsub_dropped.load(.monotonic),
+        .pubsub_read_pauses = s.pubsub_read_pauses.load(.monotonic),
+        .instrumented = @intFromBool(s.instruments != null),
+        .bytes_out = if (s.instruments) |inst| inst.bytes_out.load(.monotonic) else 0,
+        .bytes_in = if (s.instruments) |inst| inst.bytes_in.load(.monotonic) else 0,
+        .drains = if (s.instruments) |inst| inst.drains.load(.monotonic) else 0,
+        .io_uring = @intFromBool(s.uring != null),
+        .reconnects = if (s.reconnect) |r| r.reconnects.load(.monotonic) else 0,
+        .timeouts = s.timeouts.load(.monotonic),
+        .values_compressed = if (s.codec) |cd| cd.compressed.load(.monotonic) else 0,
+        .values_decompressed = if (s.codec) |cd| cd.decompressed.load(.monotonic) else 0,
+    };
+    return 0;
+}
+
+/// Turn on latency histograms and byte counters. Call before starting the
+/// event loop. Returns false on allocation failure.
+export fn redis_event_loop_enable_instruments(state: ?*EventLoopState) callconv(.c) bool {
+    const s = state orelse return false;
+    if (s.instruments != null) return true;
+    s.instruments = instruments.Instruments.create() orelse return false;
+    return true;
+}
+
+/// Drive the connection's own poll thread with io_uring (Linux 5.10 or
+/// later) instead of poll. Call before redis_event_loop_start; has no effect
+/// on a connection hosted by a reactor. Returns false, leaving the poll
+/// backend in place, where io_uring is unsupported or unavailable.
+export fn redis_event_loop_enable_io_uring(state: ?*EventLoopState) callconv(.c) bool {
+    const s = state orelse return false;
+    if (s.uring != null) return true;
+    s.uring = uring.Backend.create() orelse return false;
+    return true;
+}
+
+/// Reconnect to `host`:`port` when the connection is lost instead of
+/// stopping (see reconnect.zig), waiting between `min_delay_ms` and
+/// `max_delay_ms` with jitter and giving up after `max_attempts` failures in
+/// a row (0: never). Call before redis_event_loop_start; a connection hosted
+/// by a reactor does not reconnect. Returns false on allocation failure.
+export fn redis_event_loop_enable_reconnect(
+    state: ?*EventLoopState,
+    host: ?[*:0]const u8,
+    port: c_int,
+    min_delay_ms: u32,
+    max_delay_ms: u32,
+    max_attempts: u32,
+) callconv(.c) bool {
+    const s = state orelse return false;
+    if (s.reconnect != null) return true;
+    s.reconnect = reconnect.Reconnect.create(host orelse return false, port, min_delay_ms, max_delay_ms, max_attempts) orelse return false;
+    return true;
+}
+
+/// Set the commands sent first on every new connection, e.g. AUTH, SELECT
+/// and CLIENT TRACKING, as a batch from redis_command_batch_acquire (null
+/// for none). The event loop takes ownership of the batch. Returns false
+/// without reconnect enabled; the batch is freed then.
+export fn redis_event_loop_set_handshake(state: ?*EventLoopState, batch: ?*CommandBatch) callconv(.c) bool {
+    const s = state orelse return false;
+    const r = s.reconnect orelse {
+        if (batch) |b| b.destroy();
+        return false;
+    };
+    s.ctx_mutex.lock();
+    defer s.ctx_mutex.unlock();
+    r.setHandshake(batch);
+    return true;
+}
+
+/// Treat the connection as lost once one of its commands times out: it is
+/// replaced with reconnect enabled, and the event loop stops as after a
+/// disconnect otherwise. Off by default, so a slow command only fails itself.
+export fn redis_event_loop_set_close_on_timeout(state: ?*EventLoopState, enabled: bool) callconv(.c) void {
+    const s = state orelse return;
+    s.close_on_timeout.store(enabled, .monotonic);
+}
 
-    // Write a single byte to wake up the poll
-    const buf = [_]u8{1};
-    _ = std.posix.write(s.wakeup_write_fd, &buf) catch {};
+/// Compress the values of at least `threshold` bytes that commands write
+/// with LZ4, and decompress the compressed strings in replies (see
+/// codec.zig). Call before starting the event loop. Returns false on
+/// allocation failure.
+export fn redis_event_loop_set_compression(state: ?*EventLoopState, threshold: usize) callconv(.c) bool {
+    const s = state orelse return false;
+    if (s.codec) |cd| {
+        cd.threshold = @max(threshold, codec.header_size + 1);
+        return true;
+    }
+    s.codec = codec.Codec.create(threshold) orelse return false;
+    return true;
+}
+
+/// Where the connection is: a ConnectionState.
+export fn redis_event_loop_connection_state(state: ?*EventLoopState) callconv(.c) u8 {
+    const s = state orelse return @intFromEnum(ConnectionState.disconnected);
+    return @intFromEnum(s.connection.load(.acquire));
+}
+
+/// Copy the bucket counts of histogram `kind` (an instruments.HistogramKind)
+/// into `out`. Returns the number of buckets copied, or -1 if the event loop
+/// is not instrumented or `kind` is unknown.
+export fn redis_event_loop_get_histogram(
+    state: ?*EventLoopState,
+    kind: u8,
+    out: [*]u64,
+    len: usize,
+) callconv(.c) isize {
+    const s = state orelse return -1;
+    const inst = s.instruments orelse return -1;
+    const k = std.meta.intToEnum(instruments.HistogramKind, kind) catch return -1;
+    return @intCast(inst.histogram(k).snapshot(out[0..len]));
+}
+
+/// Record that Dart began handling a reply message posted at `posted_ns` (the
+/// value of its timing record). Called on the Dart thread.
+export fn redis_event_loop_record_delivery(state: ?*EventLoopState, posted_ns: u64) callconv(.c) void {
+    const s = state orelse return;
+    const inst = s.instruments orelse return;
+    inst.recordSince(.delivery, posted_ns, instruments.monotonicNs());
 }
 
 fn cleanupCallback(privdata: ?*anyopaque) callconv(.c) void {
     const state: *EventLoopState = @ptrCast(@alignCast(privdata orelse return));
-    state.stop.store(true, .release);
+    // A lost context is replaced instead
+    if (state.reconnect == null) state.stop.store(true, .release);
+}
+
+/// hiredis calls this when the connect has completed or failed. A failed
+/// connect disconnects the context, which pollLoop then notices.
+fn connectCallback(ac: [*c]const c.redisAsyncContext, status: c_int) callconv(.c) void {
+    if (ac == null or status != c.REDIS_OK) return;
+    const state: *EventLoopState = @ptrCast(@alignCast(ac.*.ev.data orelse return));
+    const was = state.connection.swap(.connected, .acq_rel);
+    if (state.reconnect) |r| r.connected(state, was);
+}
+
+/// hiredis calls this when it has appended output (or wants to finish a connect).
+/// May run on the Dart thread (pub/sub commands), hence the atomic.
+fn addWriteCallback(privdata: ?*anyopaque) callconv(.c) void {
+    const state: *EventLoopState = @ptrCast(@alignCast(privdata orelse return));
+    state.want_write.store(true, .release);
+    if (state.instruments) |inst| {
+        // Keep the oldest unwritten output's timestamp
+        _ = inst.write_pending_since.cmpxchgStrong(0, instruments.monotonicNs(), .monotonic, .monotonic);
+    }
+}
+
+/// hiredis calls this once its output buffer has been fully written.
+fn delWriteCallback(privdata: ?*anyopaque) callconv(.c) void {
+    outputFlushed(@ptrCast(@alignCast(privdata orelse return)));
+}
+
+/// Record that hiredis' output buffer has been fully written.
+pub fn outputFlushed(state: *EventLoopState) void {
+    state.want_write.store(false, .release);
+    if (state.instruments) |inst| {
+        const since = inst.write_pending_since.swap(0, .monotonic);
+        if (since != 0) inst.recordSince(.write, since, instruments.monotonicNs());
+    }
 }
 
 fn pollLoop(state: *EventLoopState) void {
-    const ctx = state.ctx;
+    alloc.enterThread();
+    defer alloc.exitThread();
 
     while (true) {
         // Check stop flag (lock-free)
         if (state.stop.load(.acquire)) break;
 
         // Check connection validity (single-threaded access, no lock needed)
-        const fd_invalid = if (is_windows)
-            ctx.c.fd == ~@as(@TypeOf(ctx.c.fd), 0)
-        else
-            ctx.c.fd < 0;
-        const disconnecting = ctx.c.flags & c.REDIS_DISCONNECTING != 0;
-
-        if (fd_invalid or disconnecting) break;
+        if (connectionClosed(state)) {
+            if (state.reconnect) |r| {
+                if (r.reconnect(state)) continue;
+            }
+            break;
+        }
 
         // Drain command queue and submit to hiredis (single-threaded hiredis access)
         drainCommandQueue(state);
@@ -320,23 +1084,176 @@ fn pollLoop(state: *EventLoopState) void {
         // Poll and handle I/O
         const result = if (is_windows)
             pollAndHandleWindows(state)
+        else if (state.uring) |u|
+            u.pollAndHandle(state)
         else
             pollAndHandlePosix(state);
 
-        if (result < 0) break; // Error or disconnect
+        if (result < 0) { // Error or disconnect
+            if (state.reconnect) |r| {
+                if (r.reconnect(state)) continue;
+            }
+            break;
+        }
+
+        expireCommands(state);
     }
 
-    // Notify Dart of disconnect
+    notifyDisconnect(state);
+}
+
+/// True once hiredis has closed the socket or started disconnecting, or a
+/// command timed out with close_on_timeout.
+/// Called only from the thread driving this state.
+pub fn connectionClosed(state: *EventLoopState) bool {
+    if (state.timed_out.load(.acquire)) return true;
+    const ctx = state.ctx;
+    const fd_invalid = if (is_windows)
+        ctx.c.fd == ~@as(@TypeOf(ctx.c.fd), 0)
+    else
+        ctx.c.fd < 0;
+    const disconnecting = ctx.c.flags & c.REDIS_DISCONNECTING != 0;
+    return fd_invalid or disconnecting;
+}
+
+/// Notify Dart that the connection is gone.
+pub fn notifyDisconnect(state: *EventLoopState) void {
+    state.connection.store(.disconnected, .release);
+    notifyPorts(state, MSG_DISCONNECT);
+}
+
+/// Post `message` to the creating port and every attached one.
+pub fn notifyPorts(state: *EventLoopState, message: i64) void {
     if (c.Dart_PostInteger_DL) |postFn| {
-        _ = postFn(state.dart_port, MSG_DISCONNECT);
+        _ = postFn(state.dart_port, message);
+
+        state.ports_mutex.lock();
+        defer state.ports_mutex.unlock();
+        for (state.attached_ports.items) |port| _ = postFn(port, message);
+    }
+}
+
+/// Swap a new context in for the lost one and queue `handshake` on it.
+/// Freeing the old context posts its unanswered commands as lost records.
+/// Called from the poll thread.
+pub fn replaceContext(state: *EventLoopState, ctx: *c.redisAsyncContext, handshake: ?*CommandBatch) void {
+    state.ctx_mutex.lock();
+    defer state.ctx_mutex.unlock();
+
+    state.collecting_replies = true;
+    defer {
+        state.collecting_replies = false;
+        flushReplies(state);
+    }
+
+    state.dropping_context = true;
+    c.redisAsyncFree(state.ctx);
+    state.dropping_context = false;
+
+    state.ctx = ctx;
+    state.timed_out.store(false, .release);
+    installHooks(state, ctx);
+    // Until the connect completes
+    state.want_write.store(true, .release);
+    if (is_windows) {
+        state.win_events.selected = false;
+        state.win_events.write_blocked = false;
+        state.win_events.read_pending = true;
+    }
+
+    if (handshake) |batch| submitHandshake(state, batch);
+}
+
+/// Queue the session setup commands of a handshake batch on a new context.
+/// Their replies are dropped; a failed AUTH shows in the commands after it.
+fn submitHandshake(state: *EventLoopState, batch: *const CommandBatch) void {
+    var offset: usize = 0;
+    for (0..batch.count) |i| {
+        const len: usize = batch.lens[i];
+        _ = c.redisAsyncFormattedCommand(state.ctx, null, null, @ptrCast(batch.data + offset), len);
+        offset += len;
+    }
+}
+
+/// Wait about `ms` milliseconds, or less if stopped. Commands queued
+/// meanwhile stay queued. Returns false if stopped. Called from the poll
+/// thread.
+pub fn sleepUnlessStopped(state: *EventLoopState, ms: u32) bool {
+    const deadline = std.time.milliTimestamp() + ms;
+    while (!state.stop.load(.acquire)) {
+        const remaining = deadline - std.time.milliTimestamp();
+        if (remaining <= 0) return true;
+        if (is_windows) {
+            const events = &state.win_events;
+            const handles = [_]win.HANDLE{events.wakeup};
+            _ = win.WSAWaitForMultipleEvents(handles.len, &handles, win.FALSE, @intCast(remaining), win.FALSE);
+            _ = win.WSAResetEvent(events.wakeup);
+            events.pending.store(false, .seq_cst);
+        } else {
+            var fds = [_]std.posix.pollfd{
+                .{ .fd = state.wakeup.read_fd, .events = std.posix.POLL.IN, .revents = 0 },
+            };
+            const ready = std.posix.poll(&fds, @intCast(remaining)) catch 0;
+            if (ready > 0) state.wakeup.consume();
+        }
+    }
+    return false;
+}
+
+/// Re-arm the wakeup after a read of it may have been lost (io_uring
+/// backend torn down). Called from the poll thread.
+pub fn rearmWakeup(state: *EventLoopState) void {
+    if (!is_windows) state.wakeup.rearm();
+}
+
+/// Let hiredis write and/or read on its socket, holding the context lock.
+/// Replies produced meanwhile are posted to Dart in batches.
+pub fn handleSocketEvents(state: *EventLoopState, readable: bool, writable: bool) void {
+    state.ctx_mutex.lock();
+    defer state.ctx_mutex.unlock();
+
+    state.collecting_replies = true;
+    defer {
+        state.collecting_replies = false;
+        flushReplies(state);
+    }
+
+    if (writable) {
+        c.redisAsyncHandleWrite(state.ctx);
+    }
+    if (readable) {
+        c.redisAsyncHandleRead(state.ctx);
+    }
+}
+
+/// Hand bytes read from the socket by the io_uring backend to hiredis'
+/// reader and run the callbacks of the replies they complete.
+pub fn handleReceived(state: *EventLoopState, data: []const u8) void {
+    state.ctx_mutex.lock();
+    defer state.ctx_mutex.unlock();
+
+    state.collecting_replies = true;
+    defer {
+        state.collecting_replies = false;
+        flushReplies(state);
     }
+
+    if (c.redisReaderFeed(state.ctx.c.reader, data.ptr, data.len) != c.REDIS_OK) return;
+    redisProcessCallbacks(state.ctx);
 }
 
+// Not declared in async.h, but exported by async.c; runs the callbacks of
+// the replies the reader has parsed
+extern fn redisProcessCallbacks(ac: *c.redisAsyncContext) void;
+
 /// Drain all pending commands from the queue and submit to hiredis.
 /// Called only from the poll thread (single consumer).
-fn drainCommandQueue(state: *EventLoopState) void {
+pub fn drainCommandQueue(state: *EventLoopState) void {
     const ctx = state.ctx;
 
+    // Pub/sub messages that were waiting for an acknowledgement
+    if (state.pubsub_queued.load(.seq_cst) > 0) deliverQueuedPubsub(state);
+
     // Get all queued commands at once (lock-free)
     var node = state.command_queue.drainAll();
     if (node == null) return;
@@ -345,12 +1262,46 @@ fn drainCommandQueue(state: *EventLoopState) void {
     state.ctx_mutex.lock();
     defer state.ctx_mutex.unlock();
 
+    // Error replies for rejected commands go out in one batch
+    state.collecting_replies = true;
+    defer {
+        state.collecting_replies = false;
+        flushReplies(state);
+    }
+
+    const inst = state.instruments;
+    const now = if (inst != null) instruments.monotonicNs() else 0;
+    var submitted: u64 = 0;
+    defer {
+        if (inst) |i| {
+            _ = i.drains.fetchAdd(1, .monotonic);
+            i.histogram(.batch_size).record(submitted);
+        }
+    }
+
     while (node) |n| {
         const next = n.next.load(.acquire);
 
+        if (inst) |i| {
+            const count: u64 = if (n.batch) |b| b.count else 1;
+            const bytes: u64 = if (n.batch) |b| b.data_len else n.argBytes();
+            i.histogram(.queue_wait).recordCount(if (now > n.enqueued_ns) now - n.enqueued_ns else 0, count);
+            _ = i.bytes_out.fetchAdd(bytes, .monotonic);
+            submitted += count;
+        }
+
+        if (n.batch) |batch| {
+            submitBatch(state, n.dart_port, batch, now);
+            recycleBatch(state, batch);
+            n.destroy(&state.node_pool);
+            node = next;
+            continue;
+        }
+
         // Allocate callback info
-        const info = std.heap.c_allocator.create(CallbackInfo) catch {
-            n.destroy();
+        const info = state.info_pool.create() orelse {
+            replySendFailed(state, n.dart_port, n.command_id);
+            n.destroy(&state.node_pool);
             node = next;
             continue;
         };
@@ -358,122 +1309,374 @@ fn drainCommandQueue(state: *EventLoopState) void {
             .dart_port = n.dart_port,
             .command_id = n.command_id,
             .persistent = false,
+            .state = state,
+            .submitted_ns = now,
         };
 
-        // Submit to hiredis
+        // Submit to hiredis (it formats the command into its own buffer)
         const result = c.redisAsyncCommandArgv(
             ctx,
             nativeReplyCallback,
             info,
             n.argc,
-            @ptrCast(n.argv),
-            n.argvlen,
+            @ptrCast(n.argv()),
+            n.argvlen(),
         );
 
         if (result != c.REDIS_OK) {
-            std.heap.c_allocator.destroy(info);
+            state.info_pool.destroy(info);
+            replySendFailed(state, n.dart_port, n.command_id);
         }
 
-        // Free the node (we've copied what we need)
-        n.destroy();
+        // Recycle the node (we've copied what we need)
+        n.destroy(&state.node_pool);
         node = next;
     }
 }
 
-fn pollAndHandlePosix(state: *EventLoopState) i32 {
-    const ctx = state.ctx;
-    const wakeup_fd = state.wakeup_read_fd;
-
-    // Single-threaded access to ctx, no lock needed
-    const fd = ctx.c.fd;
+/// Hand each pre-formatted command of a batch to hiredis, which appends it to
+/// its output buffer. Called with ctx_mutex held. `now` is the drain's
+/// monotonicNs on an instrumented event loop, else 0.
+fn submitBatch(state: *EventLoopState, dart_port: c.Dart_Port_DL, batch: *CommandBatch, now: u64) void {
+    var offset: usize = 0;
+    // Taken once, for the first command with a timeout
+    var now_ms: u64 = 0;
+    for (0..batch.count) |i| {
+        const len: usize = batch.lens[i];
+        defer offset += len;
+
+        const info = state.info_pool.create() orelse {
+            replySendFailed(state, dart_port, batch.ids[i]);
+            continue;
+        };
+        info.* = .{
+            .dart_port = dart_port,
+            .command_id = batch.ids[i],
+            .persistent = false,
+            .state = state,
+            .shape = std.meta.intToEnum(ReplyShape, batch.shapes[i]) catch .generic,
+            .submitted_ns = now,
+        };
+
+        var command: []const u8 = batch.data[offset..][0..len];
+        if (state.codec) |cd| command = cd.compressCommand(command);
+        const result = c.redisAsyncFormattedCommand(
+            state.ctx,
+            nativeReplyCallback,
+            info,
+            command.ptr,
+            command.len,
+        );
+        if (result != c.REDIS_OK) {
+            state.info_pool.destroy(info);
+            replySendFailed(state, dart_port, batch.ids[i]);
+            continue;
+        }
+
+        const timeout_ms = batch.timeouts[i];
+        if (timeout_ms > 0) {
+            if (now_ms == 0) now_ms = timer_wheel.nowMs();
+            timerWheel(state).insert(&info.timer, now_ms, timeout_ms);
+        }
+    }
+}
+
+/// Answer a command hiredis did not accept with an error reply, so every
+/// queued command gets one. It is posted before the replies still due for
+/// earlier commands; Dart completes the command by its id.
+fn replySendFailed(state: *EventLoopState, dart_port: c.Dart_Port_DL, command_id: i64) void {
+    const message = "ERR failed to send command";
+    var reply = std.mem.zeroes(c.redisReply);
+    reply.type = REDIS_REPLY_ERROR;
+    reply.str = @constCast(message.ptr);
+    reply.len = message.len;
+    appendReply(state, dart_port, command_id, &reply, .generic);
+}
+
+// ============================================================================
+// Command timeouts
+//
+// A command sent with a timeout has its CallbackInfo linked into the timer
+// wheel of the thread driving the connection (see timer_wheel.zig), which
+// also bounds how long that thread blocks. If the deadline passes first, the
+// command is failed with an EXPIRED_COMMAND_ID record and its info is marked
+// expired but stays with hiredis: the reply still arrives in order and is
+// dropped then, so the replies after it keep matching their commands.
+// ============================================================================
+
+/// The wheel of the thread driving `state`.
+pub fn timerWheel(state: *EventLoopState) *timer_wheel.Wheel {
+    if (state.reactor_link.thread) |t| return &t.timers;
+    return &state.timers;
+}
+
+/// The connection a scheduled deadline belongs to.
+pub fn timerOwner(node: *timer_wheel.Node) ?*EventLoopState {
+    const info: *CallbackInfo = @fieldParentPtr("timer", node);
+    return info.state;
+}
+
+/// Fail the commands whose deadline has passed, in one reply message.
+/// Called from the poll thread.
+fn expireCommands(state: *EventLoopState) void {
+    if (state.timers.count == 0) return;
+
+    state.ctx_mutex.lock();
+    defer state.ctx_mutex.unlock();
+
+    state.collecting_replies = true;
+    defer {
+        state.collecting_replies = false;
+        flushReplies(state);
+    }
+
+    state.timers.advance(timer_wheel.nowMs(), state, expireLocked);
+}
+
+/// Fail the command of a deadline the wheel of a reactor I/O thread has just
+/// unscheduled. Returns its connection.
+pub fn expireCommand(node: *timer_wheel.Node) ?*EventLoopState {
+    const state = timerOwner(node) orelse return null;
+    state.ctx_mutex.lock();
+    defer state.ctx_mutex.unlock();
+    expireLocked(state, node);
+    return state;
+}
+
+/// Called with ctx_mutex held.
+fn expireLocked(state: *EventLoopState, node: *timer_wheel.Node) void {
+    const info: *CallbackInfo = @fieldParentPtr("timer", node);
+    info.expired = true;
+    _ = state.timeouts.fetchAdd(1, .monotonic);
+    appendCommandRecord(state, info.dart_port, EXPIRED_COMMAND_ID, info.command_id);
+    if (state.close_on_timeout.load(.monotonic)) state.timed_out.store(true, .release);
+}
+
+/// Park a consumed batch for reuse, freeing whichever batch was parked before.
+fn recycleBatch(state: *EventLoopState, batch: *CommandBatch) void {
+    batch.data_len = 0;
+    batch.count = 0;
+    if (state.spare_batch.swap(batch, .acq_rel)) |old| old.destroy();
+}
+
+fn pollAndHandlePosix(state: *EventLoopState) i32 {
+    const ctx = state.ctx;
+    const wakeup_fd = state.wakeup.read_fd;
+
+    // Single-threaded access to ctx, no lock needed
+    const fd = ctx.c.fd;
     if (fd < 0) return -1;
 
-    // Poll redis socket for read/write and wakeup pipe for commands
+    // Only ask for POLLOUT while hiredis has unsent output. A connected socket
+    // is almost always writable, so always polling for it makes poll() return
+    // immediately and the thread spins.
+    const want_write = state.want_write.load(.acquire);
+    const want_read = !state.read_paused.load(.acquire);
+    var socket_events: i16 = 0;
+    if (want_read) socket_events |= std.posix.POLL.IN;
+    if (want_write) socket_events |= std.posix.POLL.OUT;
+
+    // Poll redis socket and wakeup descriptor for commands
     var fds = [_]std.posix.pollfd{
-        .{ .fd = fd, .events = std.posix.POLL.IN | std.posix.POLL.OUT, .revents = 0 },
+        .{ .fd = fd, .events = socket_events, .revents = 0 },
         .{ .fd = wakeup_fd, .events = std.posix.POLL.IN, .revents = 0 },
     };
 
-    // Block until events occur - wakeup pipe signals when commands are queued
-    const poll_result = std.posix.poll(&fds, -1) catch return -1;
+    // Block until events occur - the wakeup signals when commands are queued -
+    // or the next command deadline
+    const timeout = state.timers.timeoutMs(timer_wheel.nowMs());
+    const poll_result = std.posix.poll(&fds, timeout) catch return -1;
 
-    if (poll_result == 0) return 0; // Timeout (shouldn't happen with -1)
+    if (poll_result == 0) return 0; // A deadline is due
+    _ = state.poll_wakeups.fetchAdd(1, .monotonic);
 
-    // Drain wakeup pipe if signaled
-    if (fds[1].revents & std.posix.POLL.IN != 0) {
-        var buf: [64]u8 = undefined;
-        _ = std.posix.read(wakeup_fd, &buf) catch {};
-    }
+    // Consume the wakeup; commands queued from here on signal again
+    const woken = fds[1].revents & std.posix.POLL.IN != 0;
+    if (woken) state.wakeup.consume();
 
     const revents = fds[0].revents;
 
-    // Only treat socket errors as fatal, not wakeup pipe issues
+    // Only treat socket errors as fatal, not wakeup descriptor issues
     if (revents & std.posix.POLL.ERR != 0 or revents & std.posix.POLL.HUP != 0) {
         return -1;
     }
 
-    // Handle I/O with lock
-    state.ctx_mutex.lock();
-    defer state.ctx_mutex.unlock();
-
-    if (revents & std.posix.POLL.OUT != 0) {
-        c.redisAsyncHandleWrite(ctx);
-    }
-    if (revents & std.posix.POLL.IN != 0) {
-        c.redisAsyncHandleRead(ctx);
+    const readable = revents & std.posix.POLL.IN != 0;
+    const writable = revents & std.posix.POLL.OUT != 0;
+    if (!woken and !readable and !writable) {
+        _ = state.spurious_wakeups.fetchAdd(1, .monotonic);
+        return 0;
     }
 
+    handleSocketEvents(state, readable, writable);
     return 0;
 }
 
 fn pollAndHandleWindows(state: *EventLoopState) i32 {
     const ctx = state.ctx;
+    const events = &state.win_events;
 
     // Single-threaded access to ctx, no lock needed
     const socket_raw = ctx.c.fd;
-
     if (socket_raw == ~@as(@TypeOf(socket_raw), 0)) return -1;
+    const socket: win.SOCKET = @ptrFromInt(socket_raw);
 
-    const ws2 = std.os.windows.ws2_32;
-    const socket: ws2.SOCKET = @ptrFromInt(socket_raw);
-
-    var read_fds: ws2.fd_set = .{ .fd_count = 0, .fd_array = undefined };
-    var write_fds: ws2.fd_set = .{ .fd_count = 0, .fd_array = undefined };
-    var except_fds: ws2.fd_set = .{ .fd_count = 0, .fd_array = undefined };
-
-    read_fds.fd_array[0] = socket;
-    read_fds.fd_count = 1;
-
-    write_fds.fd_array[0] = socket;
-    write_fds.fd_count = 1;
+    if (!events.selected) {
+        const mask = win.FD_READ | win.FD_WRITE | win.FD_CONNECT | win.FD_CLOSE;
+        if (win.WSAEventSelect(socket, events.socket, mask) != 0) return -1;
+        events.selected = true;
+    }
 
-    except_fds.fd_array[0] = socket;
-    except_fds.fd_count = 1;
+    // Don't block while there is output to try or input left unread
+    const ready = (state.want_write.load(.acquire) and !events.write_blocked) or
+        (!state.read_paused.load(.acquire) and events.read_pending);
+
+    // Block until the socket or the wakeup event is signalled, or the next
+    // command deadline
+    const handles = [_]win.HANDLE{ events.wakeup, events.socket };
+    const deadline = state.timers.timeoutMs(timer_wheel.nowMs());
+    const result = win.WSAWaitForMultipleEvents(
+        handles.len,
+        &handles,
+        win.FALSE,
+        if (ready) 0 else if (deadline < 0) win.WSA_INFINITE else @intCast(deadline),
+        win.FALSE,
+    );
+    if (result == win.WSA_WAIT_FAILED) return -1;
+    const woken = result == win.WSA_WAIT_EVENT_0;
+    if (result != win.WSA_WAIT_TIMEOUT) {
+        _ = state.poll_wakeups.fetchAdd(1, .monotonic);
+        // Manual-reset; commands queued before this are drained next, and
+        // the next one queued after it sets the event again
+        _ = win.WSAResetEvent(events.wakeup);
+        events.pending.store(false, .seq_cst);
+    }
 
-    // Use short timeout since we don't have wakeup mechanism on Windows yet
-    // TODO: Use Windows event object for proper wakeup
-    var timeout: ws2.timeval = .{ .sec = 0, .usec = 10000 }; // 10ms
+    // Also resets the socket event
+    var network: win.NetworkEvents = undefined;
+    if (win.WSAEnumNetworkEvents(socket, events.socket, &network) != 0) return -1;
+    const fired = network.events;
+    if (fired & (win.FD_WRITE | win.FD_CONNECT) != 0) events.write_blocked = false;
+    if (fired & (win.FD_READ | win.FD_CLOSE) != 0) events.read_pending = true;
+
+    const want_read = !state.read_paused.load(.acquire);
+    // Same rule as POLLHUP: a closed socket we are not reading from is fatal
+    if (fired & win.FD_CLOSE != 0 and !want_read) return -1;
+
+    const writable = state.want_write.load(.acquire) and !events.write_blocked;
+    const readable = want_read and events.read_pending;
+    if (!readable and !writable) {
+        if (!woken and result != win.WSA_WAIT_TIMEOUT) {
+            _ = state.spurious_wakeups.fetchAdd(1, .monotonic);
+        }
+        return 0;
+    }
 
-    const result = ws2.select(0, &read_fds, &write_fds, &except_fds, &timeout);
+    if (writable) {
+        // FD_WRITE is only signalled after a send would have blocked, so
+        // keep writing until one does
+        win.WSASetLastError(0);
+        handleSocketEvents(state, false, true);
+        if (state.want_write.load(.acquire) and win.wouldBlock(win.WSAGetLastError())) {
+            events.write_blocked = true;
+        }
+    }
+    if (readable) {
+        // FD_READ is signalled again after a read leaves data behind
+        events.read_pending = false;
+        handleSocketEvents(state, true, false);
+    }
+    return 0;
+}
 
-    if (result == ws2.SOCKET_ERROR) return -1;
-    if (result == 0) return 0;
+/// Event objects of a Windows poll thread.
+///
+/// Unlike poll, WSAEventSelect reports FD_READ and FD_WRITE once until the
+/// call that consumes them, so the loop remembers input it has not read yet
+/// and whether the last write would have blocked.
+const WindowsEvents = struct {
+    /// Signalled by redis_event_loop_wakeup.
+    wakeup: win.HANDLE,
+    /// Set from the first wakeup until the poll thread resets the event, so
+    /// later wakeups skip the SetEvent call.
+    pending: std.atomic.Value(bool) = std.atomic.Value(bool).init(false),
+    /// Signalled by WSAEventSelect on socket activity.
+    socket: win.HANDLE,
+    /// Whether the socket has been associated with `socket` yet; done by the
+    /// poll thread once the fd is known.
+    selected: bool = false,
+    /// Set when a write left output behind because send would block; FD_WRITE
+    /// (or FD_CONNECT) clears it.
+    write_blocked: bool = false,
+    /// Set by FD_READ or FD_CLOSE until hiredis reads. Starts set in case data
+    /// arrived before WSAEventSelect.
+    read_pending: bool = true,
+
+    fn create() ?WindowsEvents {
+        const wakeup = win.WSACreateEvent() orelse return null;
+        const socket = win.WSACreateEvent() orelse {
+            _ = win.WSACloseEvent(wakeup);
+            return null;
+        };
+        return .{ .wakeup = wakeup, .socket = socket };
+    }
 
-    if (except_fds.fd_count > 0) return -1;
+    fn destroy(self: WindowsEvents) void {
+        _ = win.WSACloseEvent(self.wakeup);
+        _ = win.WSACloseEvent(self.socket);
+    }
+};
 
-    // Handle I/O with lock
-    state.ctx_mutex.lock();
-    defer state.ctx_mutex.unlock();
+/// Winsock event functions; std.os.windows.ws2_32 lacks some of them.
+const win = struct {
+    const windows = std.os.windows;
+    const HANDLE = windows.HANDLE;
+    const BOOL = windows.BOOL;
+    const FALSE = windows.FALSE;
+    const SOCKET = windows.ws2_32.SOCKET;
+
+    const FD_READ: i32 = 0x01;
+    const FD_WRITE: i32 = 0x02;
+    const FD_CONNECT: i32 = 0x10;
+    const FD_CLOSE: i32 = 0x20;
+
+    const WSA_INFINITE: u32 = 0xFFFFFFFF;
+    const WSA_WAIT_EVENT_0: u32 = 0;
+    const WSA_WAIT_TIMEOUT: u32 = 0x102;
+    const WSA_WAIT_FAILED: u32 = 0xFFFFFFFF;
+
+    const WSAEWOULDBLOCK: i32 = 10035;
+    const WSAEINPROGRESS: i32 = 10036;
+    const WSAEALREADY: i32 = 10037;
+
+    /// WSANETWORKEVENTS
+    const NetworkEvents = extern struct {
+        events: i32,
+        error_codes: [10]i32,
+    };
 
-    if (write_fds.fd_count > 0) {
-        c.redisAsyncHandleWrite(ctx);
-    }
-    if (read_fds.fd_count > 0) {
-        c.redisAsyncHandleRead(ctx);
+    /// Whether a send (or, while connecting, the connect check) stopped
+    /// because the socket was not writable.
+    fn wouldBlock(err: i32) bool {
+        return err == WSAEWOULDBLOCK or err == WSAEINPROGRESS or err == WSAEALREADY;
     }
 
-    return 0;
-}
+    extern "ws2_32" fn WSACreateEvent() callconv(.winapi) ?HANDLE;
+    extern "ws2_32" fn WSACloseEvent(event: HANDLE) callconv(.winapi) BOOL;
+    extern "ws2_32" fn WSASetEvent(event: HANDLE) callconv(.winapi) BOOL;
+    extern "ws2_32" fn WSAResetEvent(event: HANDLE) callconv(.winapi) BOOL;
+    extern "ws2_32" fn WSAEventSelect(s: SOCKET, event: HANDLE, network_events: i32) callconv(.winapi) i32;
+    extern "ws2_32" fn WSAEnumNetworkEvents(s: SOCKET, event: HANDLE, out: *NetworkEvents) callconv(.winapi) i32;
+    extern "ws2_32" fn WSAWaitForMultipleEvents(
+        count: u32,
+        events: [*]const HANDLE,
+        wait_all: BOOL,
+        timeout_ms: u32,
+        alertable: BOOL,
+    ) callconv(.winapi) u32;
+    extern "ws2_32" fn WSAGetLastError() callconv(.winapi) i32;
+    extern "ws2_32" fn WSASetLastError(err: i32) callconv(.winapi) void;
+};
 
 /// Check if the context is connected.
 export fn redis_async_is_connected(ctx: ?*c.redisAsyncContext) callconv(.c) bool {
@@ -495,267 +1698,287 @@ const CallbackInfo = struct {
     /// If true, this is a pub/sub callback that should NOT be freed after each message.
     /// It will be freed when the context is destroyed.
     persistent: bool,
+    /// Owning event loop. Non-persistent infos go back to its info_pool.
+    state: ?*EventLoopState = null,
+    /// How the reply is encoded for Dart.
+    shape: ReplyShape = .generic,
+    /// monotonicNs when submitted to hiredis, if instrumented (else 0).
+    submitted_ns: u64 = 0,
+    /// Deadline of a command sent with a timeout (see timerWheel).
+    timer: timer_wheel.Node = .{},
+    /// Set once the deadline passed; Dart has failed the command already.
+    expired: bool = false,
 };
 
-/// Serialize a redisReply to a Dart_CObject.
-/// Returns a newly allocated Dart_CObject that must be freed after posting.
-/// The serialization format is:
-/// - NULL reply: null
-/// - STRING/STATUS/ERROR/VERB: [type, string_bytes]
-/// - INTEGER: [type, int64]
-/// - DOUBLE: [type, double_as_string_bytes]
-/// - BOOL: [type, bool_as_int (0/1)]
-/// - NIL: [type]
-/// - ARRAY/MAP/SET/PUSH: [type, element1, element2, ...]
-fn serializeReply(reply: *c.redisReply, allocator: std.mem.Allocator) ?*c.Dart_CObject {
-    const obj = allocator.create(c.Dart_CObject) catch return null;
-
-    switch (reply.type) {
-        REDIS_REPLY_NIL => {
-            obj.* = .{
-                .type = c.Dart_CObject_kNull,
-                .value = undefined,
-            };
-        },
-        REDIS_REPLY_STRING, REDIS_REPLY_STATUS, REDIS_REPLY_ERROR, REDIS_REPLY_VERB, REDIS_REPLY_BIGNUM, REDIS_REPLY_DOUBLE => {
-            // Copy string data
-            const len = reply.len;
-            const str_copy = allocator.alloc(u8, len) catch {
-                allocator.destroy(obj);
-                return null;
-            };
-            if (reply.str != null and len > 0) {
-                @memcpy(str_copy, reply.str[0..len]);
-            }
+// ============================================================================
+// Flat reply encoding
+//
+// A reply is packed depth-first into one contiguous buffer and posted to Dart
+// as a single Uint8List. All integers are little-endian:
+//
+//   tag: u8                         redis reply type, or one of REPLY_TAG_*
+//   STRING/STATUS/ERROR/DOUBLE/
+//   VERB/BIGNUM:  len: u32, bytes
+//   INTEGER:      value: i64
+//   BOOL:         value: u8 (0/1)
+//   NIL, NONE:    (nothing)
+//   ARRAY/MAP/SET/ATTR/PUSH: count: u32, then `count` encoded elements
+//   EXTERNAL:     type: u8 (string-like reply type), index: u32
+//
+// REPLY_TAG_NONE stands for a missing reply (hiredis passes NULL when the
+// connection goes away) or a missing array element.
+//
+// REPLY_TAG_EXTERNAL replaces a string at least `external_threshold` bytes
+// long. Its bytes are not copied: the string buffer is taken over from the
+// hiredis reply and posted next to the batch as external typed data, which
+// Dart frees through freeExternalString once it is garbage collected. `index`
+// selects it among the externals of the message.
+//
+// A command may carry a ReplyShape hint. If its reply has that shape, it is
+// encoded as one of these instead, which Dart turns into the final collection
+// in one pass without a node per element:
+//
+//   STRINGS: count: u32, offsets: u32[count + 1], bytes
+//   SCORED:  count: u32, scores: f64[count], offsets: u32[count + 1], bytes
+//
+// String i is bytes[offsets[i]..offsets[i + 1]]. In SCORED, string i is the
+// member and scores[i] its score, parsed natively.
+// ============================================================================
 
-            // Create array [type, string_bytes]
-            const values = allocator.alloc(*c.Dart_CObject, 2) catch {
-                allocator.free(str_copy);
-                allocator.destroy(obj);
-                return null;
-            };
+const REPLY_TAG_NONE: u8 = 0;
+const REPLY_TAG_EXTERNAL: u8 = 0xff;
 
-            const type_obj = allocator.create(c.Dart_CObject) catch {
-                allocator.free(values);
-                allocator.free(str_copy);
-                allocator.destroy(obj);
-                return null;
-            };
-            type_obj.* = .{
-                .type = c.Dart_CObject_kInt32,
-                .value = .{ .as_int32 = reply.type },
-            };
+const default_external_threshold: usize = 64 * 1024;
 
-            const str_obj = allocator.create(c.Dart_CObject) catch {
-                allocator.destroy(type_obj);
-                allocator.free(values);
-                allocator.free(str_copy);
-                allocator.destroy(obj);
-                return null;
-            };
-            str_obj.* = .{
-                .type = c.Dart_CObject_kTypedData,
-                .value = .{
-                    .as_typed_data = .{
-                        .type = c.Dart_TypedData_kUint8,
-                        .length = @intCast(len),
-                        .values = str_copy.ptr,
-                    },
-                },
-            };
+/// A string buffer taken over from a hiredis reply (allocated with hi_malloc).
+pub const ExternalString = struct {
+    ptr: [*]u8,
+    len: usize,
+};
 
-            values[0] = type_obj;
-            values[1] = str_obj;
+/// Sizing result for one reply.
+pub const ReplyEncoding = struct {
+    /// Strings at least this long go out of line (0: never).
+    external_threshold: usize,
+    /// Inline bytes `encodeReply` will write.
+    size: usize = 0,
+    /// Strings `encodeReply` will take over.
+    externals: usize = 0,
+
+    fn isExternal(self: *const ReplyEncoding, r: *const c.redisReply) bool {
+        return self.external_threshold > 0 and r.len >= self.external_threshold;
+    }
 
-            obj.* = .{
-                .type = c.Dart_CObject_kArray,
-                .value = .{
-                    .as_array = .{
-                        .length = 2,
-                        .values = @ptrCast(values.ptr),
-                    },
-                },
-            };
+    pub fn measure(self: *ReplyEncoding, reply: ?*const c.redisReply) void {
+        const r = reply orelse {
+            self.size += 1;
+            return;
+        };
+        switch (r.type) {
+            REDIS_REPLY_STRING, REDIS_REPLY_STATUS, REDIS_REPLY_ERROR, REDIS_REPLY_VERB, REDIS_REPLY_BIGNUM, REDIS_REPLY_DOUBLE => {
+                if (self.isExternal(r)) {
+                    self.size += 1 + 1 + 4;
+                    self.externals += 1;
+                } else {
+                    self.size += 1 + 4 + r.len;
+                }
+            },
+            REDIS_REPLY_INTEGER => self.size += 1 + 8,
+            REDIS_REPLY_BOOL => self.size += 1 + 1,
+            REDIS_REPLY_ARRAY, REDIS_REPLY_MAP, REDIS_REPLY_SET, REDIS_REPLY_ATTR, REDIS_REPLY_PUSH => {
+                self.size += 1 + 4;
+                for (0..r.elements) |i| self.measure(r.element[i]);
+            },
+            else => self.size += 1, // NIL and unknown types
+        }
+    }
+};
+
+/// Encode `reply` into `out`, which must hold `enc.size` bytes, moving the
+/// strings that `enc` marks as external into `externals` (which must have
+/// room for `enc.externals` more items). Returns the number of bytes written.
+pub fn encodeReply(
+    reply: ?*c.redisReply,
+    out: []u8,
+    enc: *const ReplyEncoding,
+    externals: *std.ArrayListUnmanaged(ExternalString),
+) usize {
+    const r = reply orelse {
+        out[0] = REPLY_TAG_NONE;
+        return 1;
+    };
+    switch (r.type) {
+        REDIS_REPLY_STRING, REDIS_REPLY_STATUS, REDIS_REPLY_ERROR, REDIS_REPLY_VERB, REDIS_REPLY_BIGNUM, REDIS_REPLY_DOUBLE => {
+            if (enc.isExternal(r)) {
+                out[0] = REPLY_TAG_EXTERNAL;
+                out[1] = @intCast(r.type);
+                std.mem.writeInt(u32, out[2..6], @intCast(externals.items.len), .little);
+                externals.appendAssumeCapacity(.{ .ptr = r.str, .len = r.len });
+                // hiredis frees r.str with the reply; it belongs to Dart now
+                r.str = null;
+                r.len = 0;
+                return 6;
+            }
+            out[0] = @intCast(r.type);
+            std.mem.writeInt(u32, out[1..5], @intCast(r.len), .little);
+            if (r.len > 0) @memcpy(out[5..][0..r.len], r.str[0..r.len]);
+            return 5 + r.len;
         },
         REDIS_REPLY_INTEGER => {
-            // Create array [type, int64]
-            const values = allocator.alloc(*c.Dart_CObject, 2) catch {
-                allocator.destroy(obj);
-                return null;
-            };
-
-            const type_obj = allocator.create(c.Dart_CObject) catch {
-                allocator.free(values);
-                allocator.destroy(obj);
-                return null;
-            };
-            type_obj.* = .{
-                .type = c.Dart_CObject_kInt32,
-                .value = .{ .as_int32 = reply.type },
-            };
-
-            const int_obj = allocator.create(c.Dart_CObject) catch {
-                allocator.destroy(type_obj);
-                allocator.free(values);
-                allocator.destroy(obj);
-                return null;
-            };
-            int_obj.* = .{
-                .type = c.Dart_CObject_kInt64,
-                .value = .{ .as_int64 = reply.integer },
-            };
-
-            values[0] = type_obj;
-            values[1] = int_obj;
-
-            obj.* = .{
-                .type = c.Dart_CObject_kArray,
-                .value = .{
-                    .as_array = .{
-                        .length = 2,
-                        .values = @ptrCast(values.ptr),
-                    },
-                },
-            };
+            out[0] = REDIS_REPLY_INTEGER;
+            std.mem.writeInt(i64, out[1..9], r.integer, .little);
+            return 9;
         },
         REDIS_REPLY_BOOL => {
-            // Create array [type, bool_as_int]
-            const values = allocator.alloc(*c.Dart_CObject, 2) catch {
-                allocator.destroy(obj);
-                return null;
-            };
-
-            const type_obj = allocator.create(c.Dart_CObject) catch {
-                allocator.free(values);
-                allocator.destroy(obj);
-                return null;
-            };
-            type_obj.* = .{
-                .type = c.Dart_CObject_kInt32,
-                .value = .{ .as_int32 = reply.type },
-            };
-
-            const bool_obj = allocator.create(c.Dart_CObject) catch {
-                allocator.destroy(type_obj);
-                allocator.free(values);
-                allocator.destroy(obj);
-                return null;
-            };
-            bool_obj.* = .{
-                .type = c.Dart_CObject_kInt32,
-                .value = .{ .as_int32 = if (reply.integer != 0) @as(i32, 1) else @as(i32, 0) },
-            };
-
-            values[0] = type_obj;
-            values[1] = bool_obj;
-
-            obj.* = .{
-                .type = c.Dart_CObject_kArray,
-                .value = .{
-                    .as_array = .{
-                        .length = 2,
-                        .values = @ptrCast(values.ptr),
-                    },
-                },
-            };
+            out[0] = REDIS_REPLY_BOOL;
+            out[1] = if (r.integer != 0) 1 else 0;
+            return 2;
         },
-        REDIS_REPLY_ARRAY, REDIS_REPLY_MAP, REDIS_REPLY_SET, REDIS_REPLY_PUSH => {
-            const elements = reply.elements;
-            // Create array [type, element1, element2, ...]
-            const values = allocator.alloc(*c.Dart_CObject, elements + 1) catch {
-                allocator.destroy(obj);
-                return null;
-            };
-
-            const type_obj = allocator.create(c.Dart_CObject) catch {
-                allocator.free(values);
-                allocator.destroy(obj);
-                return null;
-            };
-            type_obj.* = .{
-                .type = c.Dart_CObject_kInt32,
-                .value = .{ .as_int32 = reply.type },
-            };
-            values[0] = type_obj;
-
-            // Recursively serialize elements
-            for (0..elements) |i| {
-                const element_reply = reply.element[i];
-                if (element_reply) |er| {
-                    const element_obj = serializeReply(er, allocator);
-                    if (element_obj) |eo| {
-                        values[i + 1] = eo;
-                    } else {
-                        // Allocation failed, clean up
-                        for (0..i + 1) |j| {
-                            freeSerializedReply(values[j], allocator);
-                        }
-                        allocator.free(values);
-                        allocator.destroy(obj);
-                        return null;
-                    }
-                } else {
-                    // Null element
-                    const null_obj = allocator.create(c.Dart_CObject) catch {
-                        for (0..i + 1) |j| {
-                            freeSerializedReply(values[j], allocator);
-                        }
-                        allocator.free(values);
-                        allocator.destroy(obj);
-                        return null;
-                    };
-                    null_obj.* = .{
-                        .type = c.Dart_CObject_kNull,
-                        .value = undefined,
-                    };
-                    values[i + 1] = null_obj;
-                }
-            }
-
-            obj.* = .{
-                .type = c.Dart_CObject_kArray,
-                .value = .{
-                    .as_array = .{
-                        .length = @intCast(elements + 1),
-                        .values = @ptrCast(values.ptr),
-                    },
-                },
-            };
+        REDIS_REPLY_ARRAY, REDIS_REPLY_MAP, REDIS_REPLY_SET, REDIS_REPLY_ATTR, REDIS_REPLY_PUSH => {
+            out[0] = @intCast(r.type);
+            std.mem.writeInt(u32, out[1..5], @intCast(r.elements), .little);
+            var pos: usize = 5;
+            for (0..r.elements) |i| pos += encodeReply(r.element[i], out[pos..], enc, externals);
+            return pos;
         },
         else => {
-            // Unknown type, return null
-            obj.* = .{
-                .type = c.Dart_CObject_kNull,
-                .value = undefined,
-            };
+            out[0] = REDIS_REPLY_NIL;
+            return 1;
         },
     }
+}
+
+/// Decode hints a command carries in CommandBatch.shapes. A reply without the
+/// hinted shape (an error, nil, nested or large values) is encoded generically.
+pub const ReplyShape = enum(u8) {
+    generic = 0,
+    /// An aggregate of strings: a list, a set or a flat map.
+    strings = 1,
+    /// (member, score) pairs, flat in RESP2 or nested in RESP3.
+    scored = 2,
+};
+
+const REPLY_TAG_STRINGS: u8 = 0xfe;
+const REPLY_TAG_SCORED: u8 = 0xfd;
 
-    return obj;
+/// The bytes of a string reply short enough to copy inline, else null (large
+/// strings stay zero-copy on the generic path).
+fn inlineString(reply: ?*const c.redisReply, external_threshold: usize) ?[]const u8 {
+    const r = reply orelse return null;
+    switch (r.type) {
+        REDIS_REPLY_STRING, REDIS_REPLY_STATUS, REDIS_REPLY_VERB, REDIS_REPLY_DOUBLE => {},
+        else => return null,
+    }
+    if (external_threshold > 0 and r.len >= external_threshold) return null;
+    return if (r.len == 0) "" else r.str[0..r.len];
 }
 
-/// Free a serialized reply and all its allocations.
-fn freeSerializedReply(obj: *c.Dart_CObject, allocator: std.mem.Allocator) void {
-    switch (obj.type) {
-        c.Dart_CObject_kArray => {
-            const arr = obj.value.as_array;
-            const values: [*]*c.Dart_CObject = @ptrCast(arr.values);
-            for (0..@intCast(arr.length)) |i| {
-                freeSerializedReply(values[i], allocator);
+/// Where the pairs of a scored reply are.
+const ScoredLayout = struct {
+    count: usize,
+    nested: bool,
+
+    fn of(r: *const c.redisReply) ?ScoredLayout {
+        const first: ?*const c.redisReply = if (r.elements > 0) r.element[0] else null;
+        if (first != null and first.?.type == REDIS_REPLY_ARRAY) {
+            return .{ .count = r.elements, .nested = true };
+        }
+        if (r.elements % 2 != 0) return null;
+        return .{ .count = r.elements / 2, .nested = false };
+    }
+
+    /// The member and score strings of pair `i`.
+    fn pair(self: ScoredLayout, r: *const c.redisReply, i: usize, external_threshold: usize) ?[2][]const u8 {
+        var member: ?*const c.redisReply = undefined;
+        var score: ?*const c.redisReply = undefined;
+        if (self.nested) {
+            const element: ?*const c.redisReply = r.element[i];
+            const p = element orelse return null;
+            if (p.type != REDIS_REPLY_ARRAY or p.elements != 2) return null;
+            member = p.element[0];
+            score = p.element[1];
+        } else {
+            member = r.element[2 * i];
+            score = r.element[2 * i + 1];
+        }
+        return .{
+            inlineString(member, external_threshold) orelse return null,
+            inlineString(score, external_threshold) orelse return null,
+        };
+    }
+};
+
+/// Inline bytes `encodeShaped` will write, or null if `reply` does not have
+/// the shape.
+pub fn measureShaped(reply: ?*const c.redisReply, shape: ReplyShape, external_threshold: usize) ?usize {
+    const r = reply orelse return null;
+    switch (r.type) {
+        REDIS_REPLY_ARRAY, REDIS_REPLY_SET, REDIS_REPLY_MAP => {},
+        else => return null,
+    }
+    switch (shape) {
+        .generic => return null,
+        .strings => {
+            var size: usize = 1 + 4 + 4 * (r.elements + 1);
+            for (0..r.elements) |i| {
+                size += (inlineString(r.element[i], external_threshold) orelse return null).len;
             }
-            const slice = values[0..@intCast(arr.length)];
-            allocator.free(slice);
+            return size;
         },
-        c.Dart_CObject_kTypedData => {
-            const td = obj.value.as_typed_data;
-            if (td.length > 0) {
-                const slice = td.values[0..@intCast(td.length)];
-                allocator.free(slice);
+        .scored => {
+            const layout = ScoredLayout.of(r) orelse return null;
+            var size: usize = 1 + 4 + (8 + 4) * layout.count + 4;
+            for (0..layout.count) |i| {
+                const p = layout.pair(r, i, external_threshold) orelse return null;
+                size += p[0].len;
             }
+            return size;
         },
-        else => {},
     }
-    allocator.destroy(obj);
+}
+
+fn parseScore(text: []const u8) f64 {
+    // parseFloat also takes Redis' inf/-inf/nan spellings
+    return std.fmt.parseFloat(f64, text) catch std.math.nan(f64);
+}
+
+/// Encode `r`, which measureShaped accepted for `shape`, into `out`.
+pub fn encodeShaped(r: *const c.redisReply, shape: ReplyShape, out: []u8) void {
+    const scored = shape == .scored;
+    const layout: ScoredLayout = if (scored) ScoredLayout.of(r).? else .{ .count = r.elements, .nested = false };
+    const count = layout.count;
+
+    out[0] = if (scored) REPLY_TAG_SCORED else REPLY_TAG_STRINGS;
+    std.mem.writeInt(u32, out[1..5], @intCast(count), .little);
+    var score_pos: usize = 5;
+    var table: usize = if (scored) 5 + 8 * count else 5;
+    const base = table + 4 * (count + 1);
+    var pos = base;
+    for (0..count) |i| {
+        var str: []const u8 = undefined;
+        if (scored) {
+            const p = layout.pair(r, i, 0).?;
+            str = p[0];
+            std.mem.writeInt(u64, out[score_pos..][0..8], @bitCast(parseScore(p[1])), .little);
+            score_pos += 8;
+        } else {
+            str = inlineString(r.element[i], 0).?;
+        }
+        std.mem.writeInt(u32, out[table..][0..4], @intCast(pos - base), .little);
+        table += 4;
+        @memcpy(out[pos..][0..str.len], str);
+        pos += str.len;
+    }
+    std.mem.writeInt(u32, out[table..][0..4], @intCast(pos - base), .little);
+}
+
+/// Finalizer for external strings, run by the Dart VM.
+fn freeExternalString(_: ?*anyopaque, peer: ?*anyopaque) callconv(.c) void {
+    c.hi_free(peer);
+}
+
+fn freeExternalStrings(externals: []const ExternalString) void {
+    for (externals) |e| c.hi_free(e.ptr);
 }
 
 /// Native callback invoked by hiredis when a reply arrives.
@@ -768,66 +1991,431 @@ fn nativeReplyCallback(
     const info_ptr = privdata orelse return;
     const info: *CallbackInfo = @ptrCast(@alignCast(info_ptr));
 
+    const state = info.state orelse return;
+    if (info.timer.scheduled()) timerWheel(state).remove(&info.timer);
+
     // Copy values before potentially freeing
     const command_id = info.command_id;
     const dart_port = info.dart_port;
     const persistent = info.persistent;
+    const shape = info.shape;
+    const submitted_ns = info.submitted_ns;
+    const expired = info.expired;
 
-    // Only free non-persistent callbacks (pub/sub callbacks are persistent)
+    // Only recycle non-persistent callbacks (pub/sub callbacks are persistent)
     if (!persistent) {
-        std.heap.c_allocator.destroy(info);
+        state.info_pool.destroy(info);
     }
 
-    const postFn = c.Dart_PostCObject_DL orelse return;
-    const allocator = std.heap.c_allocator;
+    if (submitted_ns != 0) {
+        if (state.instruments) |inst| inst.recordSince(.reply, submitted_ns, instruments.monotonicNs());
+    }
+
+    // Failed when it expired; dropping it keeps the replies after it in order
+    if (expired) return;
+
+    const reply: ?*c.redisReply = if (reply_ptr) |rp| @ptrCast(@alignCast(rp)) else null;
+    if (reply == null and state.dropping_context) {
+        // Subscriptions are renewed by Dart on the new connection
+        if (!persistent) appendCommandRecord(state, dart_port, LOST_COMMAND_ID, command_id);
+        return;
+    }
+    if (state.codec) |cd| cd.decompressReply(reply);
+    if (persistent and state.pubsub_capacity > 0) {
+        appendPubsubReply(state, dart_port, command_id, reply);
+    } else {
+        appendReply(state, dart_port, command_id, reply, shape);
+    }
+}
+
+/// Called by hiredis for RESP3 push frames that are not pub/sub messages.
+/// They go to Dart in the reply stream, in order with the replies around them.
+fn pushCallback(ac: ?*c.redisAsyncContext, reply_ptr: ?*anyopaque) callconv(.c) void {
+    const ctx = ac orelse return;
+    const state: *EventLoopState = @ptrCast(@alignCast(ctx.ev.data orelse return));
+    const reply: ?*c.redisReply = if (reply_ptr) |rp| @ptrCast(@alignCast(rp)) else null;
+    appendReply(state, state.dart_port, PUSH_COMMAND_ID, reply, .generic);
+}
+
+// ============================================================================
+// Reply batches
+//
+// A reply message is a Uint8List of back-to-back records:
+//
+//   command_id: i64 (little-endian), encoded reply (see encodeReply)
+//
+// If any record refers to external strings, the message is instead an array
+// [records, external_0, external_1, ...].
+//
+// While the driving thread handles socket events, records accumulate in
+// EventLoopState.reply_buf and are posted once the read cycle is done (or a
+// batch limit is hit). Replies delivered any other time (e.g. the NULL
+// replies from redisAsyncFree) are posted right away.
+// ============================================================================
+
+const reply_record_header_size = 8;
+
+/// Messages with up to this many externals are built on the stack.
+const max_stack_externals = 16;
 
-    // Create message: [commandId, serializedReply]
-    var command_id_obj: c.Dart_CObject = .{
-        .type = c.Dart_CObject_kInt64,
-        .value = .{ .as_int64 = command_id },
+fn appendReply(
+    state: *EventLoopState,
+    dart_port: c.Dart_Port_DL,
+    command_id: i64,
+    reply: ?*c.redisReply,
+    shape: ReplyShape,
+) void {
+    if (state.reply_count > 0 and state.reply_port != dart_port) flushReplies(state);
+
+    const external_threshold = state.external_threshold.load(.monotonic);
+    if (shape != .generic) {
+        if (measureShaped(reply, shape, external_threshold)) |shaped_size| {
+            const size = reply_record_header_size + shaped_size;
+            if (reserveRecord(state, size)) |out| {
+                std.mem.writeInt(i64, out[0..8], command_id, .little);
+                encodeShaped(reply.?, shape, out[reply_record_header_size..]);
+                commitRecord(state, dart_port, size);
+                return;
+            }
+            // Out of memory: the generic path below reports it
+        }
+    }
+
+    var enc: ReplyEncoding = .{ .external_threshold = external_threshold };
+    enc.measure(reply);
+    if (enc.externals > 0) {
+        state.reply_externals.ensureUnusedCapacity(std.heap.c_allocator, enc.externals) catch {
+            // Can't track them: copy the strings inline instead
+            enc = .{ .external_threshold = 0 };
+            enc.measure(reply);
+        };
+    }
+
+    const size = reply_record_header_size + enc.size;
+    const out = reserveRecord(state, size) orelse {
+        // Out of memory: still complete the command, with a missing reply
+        var record: [reply_record_header_size + 1]u8 = undefined;
+        std.mem.writeInt(i64, record[0..8], command_id, .little);
+        record[8] = REPLY_TAG_NONE;
+        postReplies(state, dart_port, &record, &.{});
+        return;
     };
 
-    var reply_obj: c.Dart_CObject = undefined;
-    var serialized_reply: ?*c.Dart_CObject = null;
+    std.mem.writeInt(i64, out[0..8], command_id, .little);
+    _ = encodeReply(reply, out[reply_record_header_size..], &enc, &state.reply_externals);
+    commitRecord(state, dart_port, size);
+}
 
-    if (reply_ptr) |rp| {
-        const reply: *c.redisReply = @ptrCast(@alignCast(rp));
-        serialized_reply = serializeReply(reply, allocator);
-        if (serialized_reply) |sr| {
-            reply_obj = sr.*;
-        } else {
-            // Allocation failed, send null
-            reply_obj = .{
-                .type = c.Dart_CObject_kNull,
-                .value = undefined,
-            };
+/// Append an already encoded record (see appendReply).
+fn appendRecord(state: *EventLoopState, dart_port: c.Dart_Port_DL, record: []u8) void {
+    if (state.reply_count > 0 and state.reply_port != dart_port) flushReplies(state);
+    const out = reserveRecord(state, record.len) orelse {
+        postReplies(state, dart_port, record, &.{});
+        return;
+    };
+    @memcpy(out, record);
+    commitRecord(state, dart_port, record.len);
+}
+
+/// Make room for a `size`-byte record in the pending batch, flushing it first
+/// if a batch limit would be exceeded. On allocation failure the pending batch
+/// is flushed and null returned.
+fn reserveRecord(state: *EventLoopState, size: usize) ?[]u8 {
+    const max_bytes = state.max_batch_bytes.load(.monotonic);
+    const max_replies = state.max_batch_replies.load(.monotonic);
+    if (state.reply_count > 0 and
+        (state.reply_buf.items.len + size > max_bytes or state.reply_count >= max_replies))
+    {
+        flushReplies(state);
+    }
+
+    state.reply_buf.ensureUnusedCapacity(std.heap.c_allocator, size) catch {
+        flushReplies(state);
+        return null;
+    };
+    return state.reply_buf.unusedCapacitySlice()[0..size];
+}
+
+/// Add the record written into the slice from reserveRecord to the batch.
+fn commitRecord(state: *EventLoopState, dart_port: c.Dart_Port_DL, size: usize) void {
+    state.reply_buf.items.len += size;
+    state.reply_count += 1;
+    state.reply_port = dart_port;
+    if (state.reply_count == 1) {
+        if (state.instruments) |inst| inst.batch_started = instruments.monotonicNs();
+    }
+
+    if (!state.collecting_replies) flushReplies(state);
+}
+
+// ============================================================================
+// Pub/sub flow control
+//
+// With a pubsub_capacity, Dart holds a credit per message it may be sent and
+// returns credits (redis_pubsub_ack) once its listeners have taken messages.
+// Without credits, messages are encoded into individually allocated records
+// (strings always inline) and queued in pubsub_ring until Dart catches up or
+// the overflow policy applies.
+// ============================================================================
+
+/// FIFO of encoded pub/sub records, oldest first.
+const PubsubRing = struct {
+    items: [][]u8 = &.{},
+    head: usize = 0,
+    len: usize = 0,
+
+    fn push(self: *PubsubRing, record: []u8) bool {
+        if (self.len == self.items.len) {
+            const items = std.heap.c_allocator.alloc([]u8, @max(16, self.items.len * 2)) catch return false;
+            for (0..self.len) |i| items[i] = self.items[(self.head + i) % self.items.len];
+            std.heap.c_allocator.free(self.items);
+            self.items = items;
+            self.head = 0;
+        }
+        self.items[(self.head + self.len) % self.items.len] = record;
+        self.len += 1;
+        return true;
+    }
+
+    fn pop(self: *PubsubRing) ?[]u8 {
+        if (self.len == 0) return null;
+        const record = self.items[self.head];
+        self.head = (self.head + 1) % self.items.len;
+        self.len -= 1;
+        return record;
+    }
+
+    fn deinit(self: *PubsubRing) void {
+        while (self.pop()) |record| std.heap.c_allocator.free(record);
+        std.heap.c_allocator.free(self.items);
+        self.* = .{};
+    }
+};
+
+/// Take one credit. Only the driving thread takes credits, Dart only adds.
+fn takePubsubCredit(state: *EventLoopState) bool {
+    if (state.pubsub_credits.load(.seq_cst) == 0) return false;
+    _ = state.pubsub_credits.fetchSub(1, .seq_cst);
+    return true;
+}
+
+/// appendReply for a flow-controlled pub/sub message.
+fn appendPubsubReply(
+    state: *EventLoopState,
+    dart_port: c.Dart_Port_DL,
+    command_id: i64,
+    reply: ?*c.redisReply,
+) void {
+    if (state.pubsub_ring.len == 0 and takePubsubCredit(state)) {
+        appendReply(state, dart_port, command_id, reply, .generic);
+        return;
+    }
+
+    const ring = &state.pubsub_ring;
+    if (ring.len >= state.pubsub_capacity) {
+        switch (state.pubsub_overflow) {
+            .drop_newest => {
+                _ = state.pubsub_dropped.fetchAdd(1, .monotonic);
+                return;
+            },
+            .drop_oldest => {
+                if (ring.pop()) |old| std.heap.c_allocator.free(old);
+                _ = state.pubsub_dropped.fetchAdd(1, .monotonic);
+            },
+            // Already paused; the rest of this read is queued regardless
+            .pause => {},
         }
+    }
+
+    var enc: ReplyEncoding = .{ .external_threshold = 0 };
+    enc.measure(reply);
+    const record = std.heap.c_allocator.alloc(u8, reply_record_header_size + enc.size) catch {
+        _ = state.pubsub_dropped.fetchAdd(1, .monotonic);
+        return;
+    };
+    std.mem.writeInt(i64, record[0..8], command_id, .little);
+    _ = encodeReply(reply, record[reply_record_header_size..], &enc, &state.reply_externals);
+    if (!ring.push(record)) {
+        std.heap.c_allocator.free(record);
+        _ = state.pubsub_dropped.fetchAdd(1, .monotonic);
+        return;
+    }
+    state.pubsub_queued.store(ring.len, .seq_cst);
+
+    if (state.pubsub_overflow == .pause and ring.len >= state.pubsub_capacity and
+        !state.read_paused.load(.monotonic))
+    {
+        state.read_paused.store(true, .release);
+        _ = state.pubsub_read_pauses.fetchAdd(1, .monotonic);
+    }
+
+    // Dart may have acknowledged between the credit check and the queue
+    // update without seeing the queued message
+    deliverQueuedPubsubLocked(state);
+}
+
+/// Post queued pub/sub messages for which Dart has credits. Called from
+/// drainCommandQueue on the driving thread.
+fn deliverQueuedPubsub(state: *EventLoopState) void {
+    state.ctx_mutex.lock();
+    defer state.ctx_mutex.unlock();
+
+    state.collecting_replies = true;
+    defer {
+        state.collecting_replies = false;
+        flushReplies(state);
+    }
+
+    deliverQueuedPubsubLocked(state);
+}
+
+/// deliverQueuedPubsub with ctx_mutex held.
+fn deliverQueuedPubsubLocked(state: *EventLoopState) void {
+    const ring = &state.pubsub_ring;
+    while (ring.len > 0 and takePubsubCredit(state)) {
+        const record = ring.pop().?;
+        appendRecord(state, state.dart_port, record);
+        std.heap.c_allocator.free(record);
+    }
+    state.pubsub_queued.store(ring.len, .seq_cst);
+
+    // Resume reading once the ring is half drained, not on every message
+    if (state.read_paused.load(.monotonic) and ring.len <= state.pubsub_capacity / 2) {
+        state.read_paused.store(false, .release);
+    }
+}
+
+/// Report what happened to a command instead of its reply: a record with
+/// command id `kind` (LOST_COMMAND_ID, EXPIRED_COMMAND_ID) holding its id.
+fn appendCommandRecord(state: *EventLoopState, dart_port: c.Dart_Port_DL, kind: i64, command_id: i64) void {
+    var record: [reply_record_header_size + 1 + 8]u8 = undefined;
+    std.mem.writeInt(i64, record[0..8], kind, .little);
+    record[8] = REDIS_REPLY_INTEGER;
+    std.mem.writeInt(i64, record[9..17], command_id, .little);
+    appendRecord(state, dart_port, &record);
+}
+
+/// Post the pending reply batch, if any.
+fn flushReplies(state: *EventLoopState) void {
+    if (state.reply_count == 0) return;
+    if (state.instruments) |inst| appendTimingRecord(state, inst);
+    postReplies(state, state.reply_port, state.reply_buf.items, state.reply_externals.items);
+    state.reply_count = 0;
+    state.reply_externals.clearRetainingCapacity();
+
+    // Don't keep a buffer that grew past the limit because of one huge reply
+    if (state.reply_buf.capacity > state.max_batch_bytes.load(.monotonic)) {
+        state.reply_buf.clearAndFree(std.heap.c_allocator);
     } else {
-        // Null reply
-        reply_obj = .{
-            .type = c.Dart_CObject_kNull,
-            .value = undefined,
-        };
+        state.reply_buf.clearRetainingCapacity();
     }
+}
 
-    var values: [2]*c.Dart_CObject = .{ &command_id_obj, &reply_obj };
+/// End the pending batch with a TIMING_COMMAND_ID record, so Dart can report
+/// how long the message took to reach it, and record the collection time.
+fn appendTimingRecord(state: *EventLoopState, inst: *instruments.Instruments) void {
+    const now = instruments.monotonicNs();
+    inst.recordSince(.post, inst.batch_started, now);
+    _ = inst.bytes_in.fetchAdd(state.reply_buf.items.len, .monotonic);
+
+    var record: [reply_record_header_size + 1 + 8]u8 = undefined;
+    std.mem.writeInt(i64, record[0..8], TIMING_COMMAND_ID, .little);
+    record[8] = REDIS_REPLY_INTEGER;
+    std.mem.writeInt(i64, record[9..17], @intCast(now), .little);
+    // Without room the message simply goes unmeasured
+    state.reply_buf.appendSlice(std.heap.c_allocator, &record) catch {};
+}
 
-    var array_obj: c.Dart_CObject = .{
-        .type = c.Dart_CObject_kArray,
+/// Post one reply message. Ownership of `externals` passes to the VM, or
+/// back to us if posting fails.
+fn postReplies(
+    state: *EventLoopState,
+    dart_port: c.Dart_Port_DL,
+    bytes: []u8,
+    externals: []const ExternalString,
+) void {
+    const postFn = c.Dart_PostCObject_DL orelse {
+        freeExternalStrings(externals);
+        return;
+    };
+
+    var records: c.Dart_CObject = .{
+        .type = c.Dart_CObject_kTypedData,
         .value = .{
-            .as_array = .{
-                .length = 2,
-                .values = @ptrCast(&values),
+            .as_typed_data = .{
+                .type = c.Dart_TypedData_kUint8,
+                .length = @intCast(bytes.len),
+                .values = bytes.ptr,
             },
         },
     };
 
-    _ = postFn(dart_port, &array_obj);
+    if (externals.len == 0) {
+        // The VM copies the bytes, so the buffer can be reused right after
+        _ = postFn(dart_port, &records);
+        _ = state.reply_posts.fetchAdd(1, .monotonic);
+        return;
+    }
 
-    // Free the serialized reply after posting
-    if (serialized_reply) |sr| {
-        freeSerializedReply(sr, allocator);
+    // [records, external_0, external_1, ...]
+    const count = externals.len + 1;
+    var stack_objs: [max_stack_externals + 1]c.Dart_CObject = undefined;
+    var stack_ptrs: [max_stack_externals + 1]*c.Dart_CObject = undefined;
+    var heap_objs: ?[]c.Dart_CObject = null;
+    var heap_ptrs: ?[]*c.Dart_CObject = null;
+    defer {
+        if (heap_objs) |h| std.heap.c_allocator.free(h);
+        if (heap_ptrs) |h| std.heap.c_allocator.free(h);
+    }
+
+    var objs: []c.Dart_CObject = stack_objs[0..@min(count, stack_objs.len)];
+    var ptrs: []*c.Dart_CObject = stack_ptrs[0..objs.len];
+    if (count > stack_objs.len) {
+        heap_objs = std.heap.c_allocator.alloc(c.Dart_CObject, count) catch null;
+        heap_ptrs = std.heap.c_allocator.alloc(*c.Dart_CObject, count) catch null;
+        if (heap_objs == null or heap_ptrs == null) {
+            // Dart decodes the unresolved externals as missing replies
+            freeExternalStrings(externals);
+            _ = postFn(dart_port, &records);
+            _ = state.reply_posts.fetchAdd(1, .monotonic);
+            return;
+        }
+        objs = heap_objs.?;
+        ptrs = heap_ptrs.?;
     }
+
+    objs[0] = records;
+    ptrs[0] = &objs[0];
+    for (externals, 1..) |e, i| {
+        objs[i] = .{
+            .type = c.Dart_CObject_kExternalTypedData,
+            .value = .{
+                .as_external_typed_data = .{
+                    .type = c.Dart_TypedData_kUint8,
+                    .length = @intCast(e.len),
+                    .data = e.ptr,
+                    .peer = e.ptr,
+                    .callback = freeExternalString,
+                },
+            },
+        };
+        ptrs[i] = &objs[i];
+    }
+
+    var message: c.Dart_CObject = .{
+        .type = c.Dart_CObject_kArray,
+        .value = .{
+            .as_array = .{
+                .length = @intCast(count),
+                .values = @ptrCast(ptrs.ptr),
+            },
+        },
+    };
+    if (!postFn(dart_port, &message)) {
+        // Not enqueued: the externals are still ours
+        freeExternalStrings(externals);
+    }
+    _ = state.reply_posts.fetchAdd(1, .monotonic);
 }
 
 /// Queue a command without waking up the poll thread.
@@ -843,7 +2431,8 @@ export fn redis_async_command_enqueue(
     const s = state orelse return -1;
 
     // Create command node (copies all data)
-    const node = CommandNode.create(dart_port, command_id, argc, argv, argvlen) orelse return -1;
+    const node = CommandNode.create(&s.node_pool, dart_port, command_id, argc, argv, argvlen) orelse return -1;
+    if (s.instruments != null) node.enqueued_ns = instruments.monotonicNs();
 
     // Push to lock-free queue (no mutex needed)
     s.command_queue.push(node);
@@ -851,6 +2440,58 @@ export fn redis_async_command_enqueue(
     return 0;
 }
 
+/// Get an empty batch with room for at least `data_capacity` bytes and
+/// `cmd_capacity` commands, reusing the last submitted batch when possible.
+/// Returns null on allocation failure.
+export fn redis_command_batch_acquire(
+    state: ?*EventLoopState,
+    data_capacity: usize,
+    cmd_capacity: usize,
+) callconv(.c) ?*CommandBatch {
+    const s = state orelse return null;
+    if (s.spare_batch.swap(null, .acq_rel)) |batch| {
+        if (batch.reserve(data_capacity, cmd_capacity)) return batch;
+        batch.destroy();
+        return null;
+    }
+    return CommandBatch.create(data_capacity, cmd_capacity);
+}
+
+/// Grow a batch that Dart is filling. Existing contents are kept.
+/// Returns false on allocation failure (the batch is left unchanged).
+export fn redis_command_batch_reserve(
+    batch: ?*CommandBatch,
+    data_capacity: usize,
+    cmd_capacity: usize,
+) callconv(.c) bool {
+    const b = batch orelse return false;
+    return b.reserve(data_capacity, cmd_capacity);
+}
+
+/// Free a batch that was acquired but never enqueued.
+export fn redis_command_batch_free(batch: ?*CommandBatch) callconv(.c) void {
+    const b = batch orelse return;
+    b.destroy();
+}
+
+/// Queue a batch of RESP-formatted commands without waking up the poll thread.
+/// On success the batch is owned by the event loop; on failure it stays with
+/// the caller. Returns 0 on success, -1 on error.
+export fn redis_async_batch_enqueue(
+    state: ?*EventLoopState,
+    dart_port: c.Dart_Port_DL,
+    batch: ?*CommandBatch,
+) callconv(.c) c_int {
+    const s = state orelse return -1;
+    const b = batch orelse return -1;
+    if (b.count == 0) return -1;
+
+    const node = CommandNode.createForBatch(&s.node_pool, dart_port, b) orelse return -1;
+    if (s.instruments != null) node.enqueued_ns = instruments.monotonicNs();
+    s.command_queue.push(node);
+    return 0;
+}
+
 /// Send an async command by pushing to the lock-free queue and waking up the poll thread.
 /// For pipelining, use redis_async_command_enqueue + redis_event_loop_wakeup instead.
 export fn redis_async_command(
@@ -868,9 +2509,12 @@ export fn redis_async_command(
     return result;
 }
 
-/// Send a pub/sub command (SUBSCRIBE, PSUBSCRIBE, etc.).
-/// The callback for pub/sub commands is persistent and will be called for each message.
-/// The callback info will be freed when the context is destroyed, not after each message.
+/// Send a pub/sub command (SUBSCRIBE, UNSUBSCRIBE, PSUBSCRIBE, PUNSUBSCRIBE).
+/// All pub/sub commands of a connection share one persistent callback, which
+/// hiredis calls for every message and (un)subscribe confirmation; Dart routes
+/// them to listeners by channel. The callback info is created by the first
+/// call and freed with the event loop, so channels can come and go without
+/// leaking one info per SUBSCRIBE.
 export fn redis_async_pubsub_command(
     state: ?*EventLoopState,
     dart_port: c.Dart_Port_DL,
@@ -881,21 +2525,24 @@ export fn redis_async_pubsub_command(
 ) callconv(.c) c_int {
     const s = state orelse return -1;
 
-    // For pub/sub, we need to submit directly to hiredis with a persistent callback
-    // We can't use the queue because we need to mark the callback as persistent
-
-    // Allocate callback info
-    const info = std.heap.c_allocator.create(CallbackInfo) catch return -1;
-    info.* = .{
-        .dart_port = dart_port,
-        .command_id = command_id,
-        .persistent = true, // This callback will be called multiple times
-    };
+    // Pub/sub commands bypass the queue: they need the persistent callback
 
     // Lock context for hiredis call
     s.ctx_mutex.lock();
     defer s.ctx_mutex.unlock();
 
+    const info = s.pubsub_info orelse blk: {
+        const new_info = std.heap.c_allocator.create(CallbackInfo) catch return -1;
+        new_info.* = .{
+            .dart_port = dart_port,
+            .command_id = command_id,
+            .persistent = true, // This callback will be called multiple times
+            .state = s,
+        };
+        s.pubsub_info = new_info;
+        break :blk new_info;
+    };
+
     // Submit directly to hiredis (not through the queue)
     const result = c.redisAsyncCommandArgv(
         s.ctx,
@@ -907,7 +2554,6 @@ export fn redis_async_pubsub_command(
     );
 
     if (result != c.REDIS_OK) {
-        std.heap.c_allocator.destroy(info);
         return -1;
     }
 
@@ -0,0 +1,212 @@
+// Microbenchmarks of the native hot paths, without a Redis server.
+//
+// Run with `zig build bench` (always ReleaseFast). Each benchmark prints one
+// JSON object per line to stderr:
+//
+//   {"benchmark":"...","ops":N,"ns_per_op":X,"ops_per_sec":Y}
+//
+// so runs can be diffed or collected by CI to catch regressions before a
+// release.
+
+const std = @import("std");
+const alloc = @import("alloc.zig");
+const loop = @import("async_loop.zig");
+const pool = @import("pool.zig");
+
+const c = loop.c;
+
+fn report(name: []const u8, ops: usize, elapsed_ns: u64) void {
+    const ns: f64 = @floatFromInt(@max(elapsed_ns, 1));
+    const n: f64 = @floatFromInt(ops);
+    std.debug.print(
+        "{{\"benchmark\":\"{s}\",\"ops\":{d},\"ns_per_op\":{d:.2},\"ops_per_sec\":{d:.0}}}\n",
+        .{ name, ops, ns / n, n * std.time.ns_per_s / ns },
+    );
+}
+
+/// Keep the optimizer from discarding a result.
+fn consume(value: anytype) void {
+    std.mem.doNotOptimizeAway(value);
+}
+
+// ============================================================================
+// Command nodes
+// ============================================================================
+
+/// Copy a SET command with a `value_len`-byte value into a pooled node and
+/// recycle it, as the enqueue and drain paths do.
+fn benchNodeCreate(name: []const u8, value_len: usize, iterations: usize) !void {
+    var node_pool: pool.BlockPool = .{};
+    defer node_pool.deinit();
+
+    const value = try std.heap.c_allocator.alloc(u8, value_len);
+    defer std.heap.c_allocator.free(value);
+    @memset(value, 'x');
+
+    const key = "bench:key";
+    var argv = [_][*c]const u8{ "SET", key, value.ptr };
+    var argvlen = [_]usize{ 3, key.len, value_len };
+
+    var timer = try std.time.Timer.start();
+    for (0..iterations) |i| {
+        const node = loop.CommandNode.create(&node_pool, 0, @intCast(i), 3, &argv, &argvlen) orelse
+            return error.OutOfMemory;
+        consume(node);
+        node.destroy(&node_pool);
+    }
+    report(name, iterations, timer.read());
+}
+
+// ============================================================================
+// Command queue
+// ============================================================================
+
+fn producer(queue: *loop.CommandQueue, nodes: []*loop.CommandNode, start: *std.atomic.Value(bool)) void {
+    while (!start.load(.acquire)) std.atomic.spinLoopHint();
+    for (nodes) |node| queue.push(node);
+}
+
+/// `producers` threads push `per_producer` nodes each while one consumer
+/// drains; measures until the consumer has seen every node.
+fn benchQueue(name: []const u8, producers: usize, per_producer: usize) !void {
+    const allocator = std.heap.c_allocator;
+    var node_pool: pool.BlockPool = .{};
+    defer node_pool.deinit();
+
+    var argv = [_][*c]const u8{"PING"};
+    var argvlen = [_]usize{4};
+
+    // Nodes are created up front so only the queue is measured
+    const total = producers * per_producer;
+    const nodes = try allocator.alloc(*loop.CommandNode, total);
+    defer allocator.free(nodes);
+    for (nodes, 0..) |*node, i| {
+        node.* = loop.CommandNode.create(&node_pool, 0, @intCast(i), 1, &argv, &argvlen) orelse
+            return error.OutOfMemory;
+    }
+    defer for (nodes) |node| node.destroy(&node_pool);
+
+    var queue: loop.CommandQueue = undefined;
+    queue.init();
+    var start = std.atomic.Value(bool).init(false);
+
+    const threads = try allocator.alloc(std.Thread, producers);
+    defer allocator.free(threads);
+    for (threads, 0..) |*thread, p| {
+        const slice = nodes[p * per_producer .. (p + 1) * per_producer];
+        thread.* = try std.Thread.spawn(.{}, producer, .{ &queue, slice, &start });
+    }
+
+    var timer = try std.time.Timer.start();
+    start.store(true, .release);
+    var received: usize = 0;
+    var drains: usize = 0;
+    while (received < total) {
+        var node = queue.drainAll();
+        if (node == null) {
+            std.atomic.spinLoopHint();
+            continue;
+        }
+        drains += 1;
+        while (node) |n| {
+            received += 1;
+            node = n.next.load(.acquire);
+        }
+    }
+    const elapsed = timer.read();
+    for (threads) |thread| thread.join();
+
+    consume(drains);
+    report(name, total, elapsed);
+}
+
+// ============================================================================
+// Reply encoding
+// ============================================================================
+
+/// An array reply of `count` strings of `len` bytes each.
+const ArrayReply = struct {
+    root: c.redisReply,
+    elements: []c.redisReply,
+    pointers: []?*c.redisReply,
+    bytes: []u8,
+
+    fn init(count: usize, len: usize) !ArrayReply {
+        const allocator = std.heap.c_allocator;
+        const elements = try allocator.alloc(c.redisReply, count);
+        const pointers = try allocator.alloc(?*c.redisReply, count);
+        const bytes = try allocator.alloc(u8, @max(count * len, 1));
+        @memset(bytes, 'v');
+        for (elements, pointers, 0..) |*element, *pointer, i| {
+            element.* = std.mem.zeroes(c.redisReply);
+            element.type = c.REDIS_REPLY_STRING;
+            element.str = @ptrCast(bytes.ptr + i * len);
+            element.len = len;
+            pointer.* = element;
+        }
+        var root = std.mem.zeroes(c.redisReply);
+        root.type = c.REDIS_REPLY_ARRAY;
+        root.elements = count;
+        return .{ .root = root, .elements = elements, .pointers = pointers, .bytes = bytes };
+    }
+
+    fn deinit(self: *ArrayReply) void {
+        const allocator = std.heap.c_allocator;
+        allocator.free(self.bytes);
+        allocator.free(self.pointers);
+        allocator.free(self.elements);
+    }
+
+    fn reply(self: *ArrayReply) *c.redisReply {
+        self.root.element = @ptrCast(self.pointers.ptr);
+        return &self.root;
+    }
+};
+
+/// Measure and encode one reply into a reused buffer, as appendReply does.
+fn benchEncode(name: []const u8, count: usize, len: usize, shape: loop.ReplyShape, iterations: usize) !void {
+    const allocator = std.heap.c_allocator;
+    var array = try ArrayReply.init(count, len);
+    defer array.deinit();
+    const reply = array.reply();
+
+    var externals: std.ArrayListUnmanaged(loop.ExternalString) = .{};
+    defer externals.deinit(allocator);
+    var buffer: std.ArrayListUnmanaged(u8) = .{};
+    defer buffer.deinit(allocator);
+
+    var timer = try std.time.Timer.start();
+    for (0..iterations) |_| {
+        if (shape != .generic) {
+            const size = loop.measureShaped(reply, shape, 0) orelse return error.Unshaped;
+            try buffer.resize(allocator, size);
+            loop.encodeShaped(reply, shape, buffer.items);
+        } else {
+            // No externals: the benchmark reply owns its strings
+            var enc: loop.ReplyEncoding = .{ .external_threshold = 0 };
+            enc.measure(reply);
+            try buffer.resize(allocator, enc.size);
+            consume(loop.encodeReply(reply, buffer.items, &enc, &externals));
+        }
+        consume(buffer.items.ptr);
+    }
+    report(name, iterations, timer.read());
+}
+
+pub fn main() !void {
+    // The loader must have run the .init_array entry of async_loop.zig
+    if (alloc.enabled and !alloc.installed()) return error.AllocatorNotInstalled;
+
+    try benchNodeCreate("command_node_create/16B", 16, 2_000_000);
+    try benchNodeCreate("command_node_create/1KiB", 1024, 1_000_000);
+    try benchNodeCreate("command_node_create/64KiB", 64 * 1024, 20_000);
+
+    try benchQueue("command_queue/1_producer", 1, 1_000_000);
+    try benchQueue("command_queue/4_producers", 4, 250_000);
+    try benchQueue("command_queue/8_producers", 8, 125_000);
+
+    try benchEncode("encode_reply/generic/1x16B", 1, 16, .generic, 2_000_000);
+    try benchEncode("encode_reply/generic/1000x16B", 1000, 16, .generic, 10_000);
+    try benchEncode("encode_reply/strings/1000x16B", 1000, 16, .strings, 10_000);
+    try benchEncode("encode_reply/generic/100x1KiB", 100, 1024, .generic, 20_000);
+}
@@ -0,0 +1,248 @@
+// Transparent compression of large values (redis_event_loop_set_compression).
+//
+// On the way out, a command that writes values (SET, MSET, HSET, LPUSH, ...;
+// see value_commands) and has a value argument of at least `threshold` bytes
+// is rewritten before it goes to hiredis, each such value replaced by
+//
+//   magic "\x00LZ4", format version: u8, raw length: u32,
+//   XXH32 of the raw bytes: u32, LZ4 block (lz4.zig)
+//
+// (integers little-endian) unless that is not smaller. On the way in, every
+// string reply starting with the header is decompressed in place, in the
+// buffer hiredis allocated for it, before it is encoded for Dart. It is
+// replaced only if its body decompresses to exactly the length and checksum
+// the header names; anything else, such as values written before
+// compression was turned on or by other clients, passes through as it is.
+//
+// Text never starts with a NUL byte, but binary values can. Whichever
+// command read it, a binary value that happens to be such a frame, which
+// only something imitating this codec writes, is returned decompressed; one
+// that merely starts with the magic costs a failed decompression.
+//
+// The same value always packs to the same bytes, so the elements LREM, LPOS
+// and LINSERT look for in a list are packed too and match the stored ones.
+// Keys, fields, members and scripts are never compressed, so lookups,
+// sorting and scripting see the same bytes as before. Commands that read or
+// modify part of a value (GETRANGE, SETRANGE, APPEND, STRLEN, ...) see the
+// compressed bytes, and so do clients without compression.
+//
+// Both directions run on the thread driving the connection, under
+// ctx_mutex.
+
+const std = @import("std");
+const lz4 = @import("lz4.zig");
+const c = @import("async_loop.zig").c;
+
+const allocator = std.heap.c_allocator;
+
+const magic = "\x00LZ4";
+const version = 1;
+pub const header_size = magic.len + 1 + 4 + 4;
+
+/// Largest value Redis stores; longer raw lengths mark a corrupt header.
+const max_value_len = 512 << 20;
+
+/// Which arguments of a command are values: the one at `first`, and with a
+/// `step` every step-th after it.
+const ValueArgs = struct {
+    name: []const u8,
+    first: u8,
+    step: u8 = 0,
+
+    fn isValue(self: ValueArgs, index: usize) bool {
+        if (index < self.first) return false;
+        if (index == self.first) return true;
+        return self.step > 0 and (index - self.first) % self.step == 0;
+    }
+};
+
+const value_commands = [_]ValueArgs{
+    .{ .name = "SET", .first = 2 },
+    .{ .name = "SETNX", .first = 2 },
+    .{ .name = "SETEX", .first = 3 },
+    .{ .name = "PSETEX", .first = 3 },
+    .{ .name = "GETSET", .first = 2 },
+    .{ .name = "MSET", .first = 2, .step = 2 },
+    .{ .name = "MSETNX", .first = 2, .step = 2 },
+    .{ .name = "HSET", .first = 3, .step = 2 },
+    .{ .name = "HMSET", .first = 3, .step = 2 },
+    .{ .name = "HSETNX", .first = 3 },
+    .{ .name = "LPUSH", .first = 2, .step = 1 },
+    .{ .name = "RPUSH", .first = 2, .step = 1 },
+    .{ .name = "LPUSHX", .first = 2, .step = 1 },
+    .{ .name = "RPUSHX", .first = 2, .step = 1 },
+    .{ .name = "LSET", .first = 3 },
+    .{ .name = "LINSERT", .first = 3, .step = 1 },
+    // Elements to find in a list: compressed alike, so they match the ones
+    // stored compressed
+    .{ .name = "LREM", .first = 3 },
+    .{ .name = "LPOS", .first = 2 },
+};
+
+fn valueArgs(name: []const u8) ?ValueArgs {
+    for (value_commands) |spec| {
+        if (std.ascii.eqlIgnoreCase(spec.name, name)) return spec;
+    }
+    return null;
+}
+
+/// The arguments of a command in RESP, as written by Dart's _RespWriter:
+/// `*<count>\r\n` followed by `$<len>\r\n<bytes>\r\n` for each.
+const Args = struct {
+    data: []const u8,
+    pos: usize,
+    count: usize,
+
+    fn parse(data: []const u8) ?Args {
+        var pos: usize = 0;
+        const count = readLength(data, &pos, '*') orelse return null;
+        return .{ .data = data, .pos = pos, .count = count };
+    }
+
+    fn next(self: *Args) ?[]const u8 {
+        const len = readLength(self.data, &self.pos, '$') orelse return null;
+        if (self.data.len - self.pos < len + 2) return null;
+        const arg = self.data[self.pos..][0..len];
+        self.pos += len + 2;
+        return arg;
+    }
+
+    fn readLength(data: []const u8, pos: *usize, prefix: u8) ?usize {
+        if (pos.* >= data.len or data[pos.*] != prefix) return null;
+        const start = pos.* + 1;
+        const end = std.mem.indexOfScalarPos(u8, data, start, '\r') orelse return null;
+        if (end + 1 >= data.len or data[end + 1] != '\n') return null;
+        pos.* = end + 2;
+        return std.fmt.parseUnsigned(usize, data[start..end], 10) catch null;
+    }
+};
+
+pub const Codec = struct {
+    /// Values shorter than this are sent as they are.
+    threshold: usize,
+    table: lz4.HashTable = undefined,
+    /// The rewritten command being built.
+    command: std.ArrayListUnmanaged(u8) = .{},
+    /// The value being compressed.
+    value: std.ArrayListUnmanaged(u8) = .{},
+    compressed: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    decompressed: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+
+    pub fn create(threshold: usize) ?*Codec {
+        const self = allocator.create(Codec) catch return null;
+        self.* = .{ .threshold = @max(threshold, header_size + 1) };
+        return self;
+    }
+
+    pub fn destroy(self: *Codec) void {
+        self.command.deinit(allocator);
+        self.value.deinit(allocator);
+        allocator.destroy(self);
+    }
+
+    /// The command to hand to hiredis for `command`: itself, or a copy with
+    /// its large values compressed, valid until the next call.
+    pub fn compressCommand(self: *Codec, command: []const u8) []const u8 {
+        if (command.len < self.threshold) return command;
+        return self.rewrite(command) catch command;
+    }
+
+    fn rewrite(self: *Codec, command: []const u8) error{ OutOfMemory, Unchanged }![]const u8 {
+        var args = Args.parse(command) orelse return error.Unchanged;
+        const spec = valueArgs(args.next() orelse return error.Unchanged) orelse return error.Unchanged;
+
+        // Most commands have nothing to compress; find out before copying
+        var found = false;
+        var index: usize = 1;
+        while (index < args.count) : (index += 1) {
+            const arg = args.next() orelse return error.Unchanged;
+            if (spec.isValue(index) and arg.len >= self.threshold) found = true;
+        }
+        if (!found) return error.Unchanged;
+
+        const out = &self.command;
+        out.clearRetainingCapacity();
+        try out.ensureTotalCapacity(allocator, command.len);
+        var prefix: [24]u8 = undefined;
+        out.appendSliceAssumeCapacity(std.fmt.bufPrint(&prefix, "*{d}\r\n", .{args.count}) catch unreachable);
+
+        args = Args.parse(command).?;
+        var compressed: u64 = 0;
+        for (0..args.count) |i| {
+            var arg = args.next().?;
+            if (spec.isValue(i) and arg.len >= self.threshold) {
+                if (try self.pack(arg)) |packed_value| {
+                    arg = packed_value;
+                    compressed += 1;
+                }
+            }
+            try out.appendSlice(allocator, std.fmt.bufPrint(&prefix, "${d}\r\n", .{arg.len}) catch unreachable);
+            try out.appendSlice(allocator, arg);
+            try out.appendSlice(allocator, "\r\n");
+        }
+        if (compressed == 0) return error.Unchanged;
+        _ = self.compressed.fetchAdd(compressed, .monotonic);
+        return out.items;
+    }
+
+    /// `value` with a header and compressed, or null if that is no smaller.
+    fn pack(self: *Codec, value: []const u8) error{OutOfMemory}!?[]const u8 {
+        if (value.len > max_value_len) return null;
+        try self.value.resize(allocator, header_size + lz4.compressBound(value.len));
+        const buf = self.value.items;
+        @memcpy(buf[0..magic.len], magic);
+        buf[magic.len] = version;
+        std.mem.writeInt(u32, buf[magic.len + 1 ..][0..4], @intCast(value.len), .little);
+        std.mem.writeInt(u32, buf[magic.len + 5 ..][0..4], checksum(value), .little);
+        const size = header_size + lz4.compress(value, buf[header_size..], &self.table);
+        if (size >= value.len) return null;
+        return buf[0..size];
+    }
+
+    /// Decompress the compressed strings in `reply` and its elements.
+    pub fn decompressReply(self: *Codec, reply: ?*c.redisReply) void {
+        const r = reply orelse return;
+        switch (r.type) {
+            c.REDIS_REPLY_STRING => self.decompressString(r),
+            c.REDIS_REPLY_ARRAY, c.REDIS_REPLY_MAP, c.REDIS_REPLY_SET, c.REDIS_REPLY_PUSH => {
+                for (0..r.elements) |i| self.decompressReply(r.element[i]);
+            },
+            else => {},
+        }
+    }
+
+    /// Swap the buffer of a compressed string for one holding its raw bytes,
+    /// allocated with hi_malloc like the buffer hiredis frees with the reply.
+    /// A string whose body does not decompress to the length and checksum
+    /// in its header is left as it is.
+    fn decompressString(self: *Codec, reply: *c.redisReply) void {
+        if (reply.len < header_size) return;
+        const data = reply.str[0..reply.len];
+        if (!std.mem.eql(u8, data[0..magic.len], magic) or data[magic.len] != version) return;
+        const raw_len = std.mem.readInt(u32, data[magic.len + 1 ..][0..4], .little);
+        const sum = std.mem.readInt(u32, data[magic.len + 5 ..][0..4], .little);
+        const body = data[header_size..];
+        // Check the length before allocating it: it may be anything
+        if (raw_len > max_value_len or raw_len > lz4.maxDecompressedSize(body.len)) return;
+
+        const raw: [*]u8 = @ptrCast(c.hi_malloc(@as(usize, raw_len) + 1) orelse return);
+        lz4.decompress(body, raw[0..raw_len]) catch {
+            c.hi_free(raw);
+            return;
+        };
+        if (checksum(raw[0..raw_len]) != sum) {
+            c.hi_free(raw);
+            return;
+        }
+        // hiredis strings are NUL-terminated
+        raw[raw_len] = 0;
+        c.hi_free(reply.str);
+        reply.str = raw;
+        reply.len = raw_len;
+        _ = self.decompressed.fetchAdd(1, .monotonic);
+    }
+};
+
+fn checksum(bytes: []const u8) u32 {
+    return std.hash.XxHash32.hash(0, bytes);
+}
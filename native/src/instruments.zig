@@ -0,0 +1,129 @@
+// Optional latency instrumentation of an event loop.
+//
+// A connection created with instrumentation gets one Instruments block; all
+// hooks in async_loop.zig check for it first, so connections without it pay
+// a single null test per drain, submit and reply batch and take no
+// timestamps.
+//
+// Histograms are log-linear like HdrHistogram: values below 16 are counted
+// exactly, larger ones in 16 sub-buckets per power of two (about 6% relative
+// precision). Buckets are atomic counters, so the driving thread and Dart
+// (which records delivery times) update them without locks, and a snapshot
+// never blocks either.
+
+const std = @import("std");
+
+/// Sub-buckets per power of two, as a power of two.
+const sub_bucket_bits = 4;
+const sub_buckets = 1 << sub_bucket_bits;
+
+/// Enough buckets for any u64.
+pub const bucket_count = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+pub const Histogram = struct {
+    buckets: [bucket_count]std.atomic.Value(u64) = .{std.atomic.Value(u64).init(0)} ** bucket_count,
+
+    pub fn bucketIndex(value: u64) usize {
+        if (value < sub_buckets) return @intCast(value);
+        const exponent: usize = 63 - @clz(value);
+        const shift: u6 = @intCast(exponent - sub_bucket_bits);
+        const sub: usize = @intCast((value >> shift) & (sub_buckets - 1));
+        return (exponent - sub_bucket_bits + 1) * sub_buckets + sub;
+    }
+
+    pub fn record(self: *Histogram, value: u64) void {
+        self.recordCount(value, 1);
+    }
+
+    pub fn recordCount(self: *Histogram, value: u64, count: u64) void {
+        _ = self.buckets[bucketIndex(value)].fetchAdd(count, .monotonic);
+    }
+
+    /// Copy up to `out.len` bucket counts; returns how many were copied.
+    pub fn snapshot(self: *const Histogram, out: []u64) usize {
+        const n = @min(out.len, bucket_count);
+        for (0..n) |i| out[i] = self.buckets[i].load(.monotonic);
+        return n;
+    }
+};
+
+/// Histograms, by the index redis_event_loop_get_histogram takes.
+pub const HistogramKind = enum(u8) {
+    /// Nanoseconds a command waited in the command queue before the driving
+    /// thread drained it.
+    queue_wait = 0,
+    /// Nanoseconds from submitting commands to hiredis until its output
+    /// buffer was fully written to the socket.
+    write = 1,
+    /// Nanoseconds from submitting a command until its reply was parsed:
+    /// network round trip plus server time.
+    reply = 2,
+    /// Nanoseconds from the first reply of a batch being parsed until the
+    /// batch was posted to Dart.
+    post = 3,
+    /// Nanoseconds from posting a reply batch until Dart began handling it.
+    delivery = 4,
+    /// Commands submitted per drain of the command queue (a count, not a
+    /// time).
+    batch_size = 5,
+};
+
+pub const histogram_kinds = @typeInfo(HistogramKind).@"enum".fields.len;
+
+pub const Instruments = struct {
+    histograms: [histogram_kinds]Histogram = .{Histogram{}} ** histogram_kinds,
+    /// Command bytes handed to hiredis.
+    bytes_out: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    /// Encoded reply bytes posted to Dart.
+    bytes_in: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    /// Drains that found queued commands.
+    drains: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    /// When hiredis got output that is not fully written yet (0: none).
+    /// Also set from the Dart thread by pub/sub commands.
+    write_pending_since: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    /// When the first reply of the batch being collected was parsed.
+    /// Driving thread only.
+    batch_started: u64 = 0,
+
+    pub fn create() ?*Instruments {
+        const self = std.heap.c_allocator.create(Instruments) catch return null;
+        self.* = .{};
+        return self;
+    }
+
+    pub fn destroy(self: *Instruments) void {
+        std.heap.c_allocator.destroy(self);
+    }
+
+    pub fn histogram(self: *Instruments, kind: HistogramKind) *Histogram {
+        return &self.histograms[@intFromEnum(kind)];
+    }
+
+    /// Record the time since `start` (a monotonicNs value) in `kind`.
+    pub fn recordSince(self: *Instruments, kind: HistogramKind, start: u64, now: u64) void {
+        self.histogram(kind).record(if (now > start) now - start else 0);
+    }
+};
+
+/// Process-wide origin of monotonicNs, written once by init before any
+/// thread that reads it is started.
+var clock_origin: ?std.time.Instant = null;
+var clock_started = std.once(startClock);
+
+fn startClock() void {
+    clock_origin = std.time.Instant.now() catch null;
+}
+
+/// Start the clock shared by all threads (and isolates) of the process.
+/// Isolates may call this concurrently, each before its first connection.
+pub fn init() void {
+    clock_started.call();
+}
+
+/// Nanoseconds on a monotonic clock shared by all threads; never 0 once
+/// init has run, so 0 can mean "no timestamp".
+pub fn monotonicNs() u64 {
+    const origin = clock_origin orelse return 0;
+    const now = std.time.Instant.now() catch return 0;
+    return now.since(origin) + 1;
+}
@@ -0,0 +1,285 @@
+// LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+//
+// A greedy single-pass compressor with a hash table of recent 4-byte
+// sequences, and a decompressor that checks every length and offset against
+// its buffers, so corrupt or hostile input fails instead of reading or
+// writing out of bounds. Output of compress() decodes with any LZ4 block
+// decoder, and decompress() reads any conforming block.
+
+const std = @import("std");
+
+const min_match = 4;
+/// The last 5 bytes of a block are always literals.
+const last_literals = 5;
+/// No match starts within the last 12 bytes of a block.
+const mf_limit = 12;
+const max_offset = 65535;
+
+const hash_log = 13;
+
+/// Positions of recently seen sequences, kept by the caller so that
+/// compress() needs no allocation.
+pub const HashTable = [1 << hash_log]u32;
+
+/// Largest compressed size of `len` input bytes.
+pub fn compressBound(len: usize) usize {
+    return len + len / 255 + 16;
+}
+
+fn read32(bytes: []const u8, pos: usize) u32 {
+    return std.mem.readInt(u32, bytes[pos..][0..4], .little);
+}
+
+fn hash(sequence: u32) usize {
+    return @intCast((sequence *% 2654435761) >> (32 - hash_log));
+}
+
+/// Append an extended length: 255s, then the remainder.
+fn writeLength(dst: []u8, pos: *usize, length: usize) void {
+    var rest = length;
+    while (rest >= 255) : (rest -= 255) {
+        dst[pos.*] = 255;
+        pos.* += 1;
+    }
+    dst[pos.*] = @intCast(rest);
+    pos.* += 1;
+}
+
+/// Append one sequence: `literals`, then a match of `match_len` bytes at
+/// `offset` back, or none for the last sequence (match_len 0).
+fn writeSequence(dst: []u8, pos: *usize, literals: []const u8, offset: usize, match_len: usize) void {
+    const lit_code = @min(literals.len, 15);
+    const match_code = if (match_len > 0) @min(match_len - min_match, 15) else 0;
+    dst[pos.*] = @intCast(lit_code << 4 | match_code);
+    pos.* += 1;
+    if (lit_code == 15) writeLength(dst, pos, literals.len - 15);
+    @memcpy(dst[pos.*..][0..literals.len], literals);
+    pos.* += literals.len;
+    if (match_len == 0) return;
+
+    std.mem.writeInt(u16, dst[pos.*..][0..2], @intCast(offset), .little);
+    pos.* += 2;
+    if (match_code == 15) writeLength(dst, pos, match_len - min_match - 15);
+}
+
+/// Compress `src` into `dst`, which must hold compressBound(src.len) bytes.
+/// Returns the compressed size.
+pub fn compress(src: []const u8, dst: []u8, table: *HashTable) usize {
+    std.debug.assert(dst.len >= compressBound(src.len));
+    var pos: usize = 0;
+    var anchor: usize = 0;
+
+    if (src.len > mf_limit) {
+        @memset(table, 0);
+        const match_limit = src.len - last_literals;
+        var ip: usize = 0;
+        while (ip < src.len - mf_limit) {
+            const sequence = read32(src, ip);
+            const h = hash(sequence);
+            const candidate: usize = table[h];
+            table[h] = @intCast(ip);
+
+            if (candidate >= ip or ip - candidate > max_offset or read32(src, candidate) != sequence) {
+                // Skip faster through data that does not compress
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            var len: usize = min_match;
+            while (ip + len < match_limit and src[candidate + len] == src[ip + len]) len += 1;
+            writeSequence(dst, &pos, src[anchor..ip], ip - candidate, len);
+            ip += len;
+            anchor = ip;
+        }
+    }
+
+    writeSequence(dst, &pos, src[anchor..], 0, 0);
+    return pos;
+}
+
+/// Largest decompressed size of a `len`-byte block. Every byte of a block
+/// adds at most 255 bytes of output, through an extended match length.
+pub fn maxDecompressedSize(len: usize) usize {
+    return len *| 255;
+}
+
+pub const DecompressError = error{Corrupt};
+
+/// Read an extended length starting at `pos.*`.
+fn readLength(src: []const u8, pos: *usize) DecompressError!usize {
+    var length: usize = 0;
+    while (true) {
+        if (pos.* >= src.len) return error.Corrupt;
+        const byte = src[pos.*];
+        pos.* += 1;
+        length += byte;
+        if (byte != 255) return length;
+    }
+}
+
+/// Decompress the block `src` into `dst`, which must be exactly its
+/// decompressed size.
+pub fn decompress(src: []const u8, dst: []u8) DecompressError!void {
+    var ip: usize = 0;
+    var op: usize = 0;
+    while (true) {
+        if (ip >= src.len) return error.Corrupt;
+        const token = src[ip];
+        ip += 1;
+
+        var lit_len: usize = token >> 4;
+        if (lit_len == 15) lit_len += try readLength(src, &ip);
+        if (lit_len > src.len - ip or lit_len > dst.len - op) return error.Corrupt;
+        @memcpy(dst[op..][0..lit_len], src[ip..][0..lit_len]);
+        ip += lit_len;
+        op += lit_len;
+
+        // The last sequence has no match
+        if (ip == src.len) break;
+
+        if (src.len - ip < 2) return error.Corrupt;
+        const offset: usize = std.mem.readInt(u16, src[ip..][0..2], .little);
+        ip += 2;
+        if (offset == 0 or offset > op) return error.Corrupt;
+
+        var match_len: usize = token & 15;
+        if (match_len == 15) match_len += try readLength(src, &ip);
+        match_len += min_match;
+        if (match_len > dst.len - op) return error.Corrupt;
+
+        // A match closer than its length repeats the bytes it produces
+        const from = op - offset;
+        if (offset >= match_len) {
+            @memcpy(dst[op..][0..match_len], dst[from..][0..match_len]);
+        } else {
+            for (0..match_len) |i| dst[op + i] = dst[from + i];
+        }
+        op += match_len;
+    }
+    if (op != dst.len) return error.Corrupt;
+}
+
+// ============================================================================
+// Tests (zig build test)
+// ============================================================================
+
+const testing = std.testing;
+
+fn expectRoundTrip(src: []const u8) !void {
+    var table: HashTable = undefined;
+    const block = try testing.allocator.alloc(u8, compressBound(src.len));
+    defer testing.allocator.free(block);
+    const size = compress(src, block, &table);
+    try testing.expect(size <= compressBound(src.len));
+    try testing.expect(src.len <= maxDecompressedSize(size));
+
+    const out = try testing.allocator.alloc(u8, src.len);
+    defer testing.allocator.free(out);
+    try decompress(block[0..size], out);
+    try testing.expectEqualSlices(u8, src, out);
+}
+
+fn randomBytes(buf: []u8, seed: u64) void {
+    var prng = std.Random.DefaultPrng.init(seed);
+    prng.random().bytes(buf);
+}
+
+test "round trip of short and empty inputs" {
+    try expectRoundTrip("");
+    try expectRoundTrip("a");
+    try expectRoundTrip("abcdefghijkl");
+    try expectRoundTrip("abcdefghijklm");
+}
+
+test "round trip of text" {
+    var buf: [20000]u8 = undefined;
+    var pos: usize = 0;
+    var i: usize = 0;
+    while (pos + 64 < buf.len) : (i += 1) {
+        pos += (std.fmt.bufPrint(buf[pos..], "{{\"id\":{d},\"name\":\"item {d}\"}},", .{ i, i }) catch unreachable).len;
+    }
+    try expectRoundTrip(buf[0..pos]);
+}
+
+test "round trip of incompressible input" {
+    var buf: [70000]u8 = undefined;
+    randomBytes(&buf, 1);
+    try expectRoundTrip(&buf);
+    // Literal runs of every extended length encoding
+    try expectRoundTrip(buf[0..15]);
+    try expectRoundTrip(buf[0 .. 15 + 255]);
+    try expectRoundTrip(buf[0 .. 15 + 255 + 1]);
+}
+
+test "round trip of overlapping matches" {
+    // Runs repeat the bytes a match is still producing (offset < length)
+    var buf: [100000]u8 = undefined;
+    @memset(&buf, 'a');
+    try expectRoundTrip(&buf);
+    for (&buf, 0..) |*byte, i| byte.* = "abc"[i % 3];
+    try expectRoundTrip(&buf);
+    for (&buf, 0..) |*byte, i| byte.* = @intCast(i % 7 + (i / 5000) % 3);
+    try expectRoundTrip(&buf);
+}
+
+test "round trip of matches at the window limit" {
+    // A 70000-byte pattern repeated: matches just within and beyond 64 KiB
+    const buf = try testing.allocator.alloc(u8, 3 * 70000);
+    defer testing.allocator.free(buf);
+    randomBytes(buf[0..70000], 2);
+    @memcpy(buf[70000..140000], buf[0..70000]);
+    @memcpy(buf[140000..], buf[0..70000]);
+    try expectRoundTrip(buf);
+}
+
+test "a run compresses close to the expansion limit" {
+    var table: HashTable = undefined;
+    const src = try testing.allocator.alloc(u8, 1 << 20);
+    defer testing.allocator.free(src);
+    @memset(src, 0);
+    const block = try testing.allocator.alloc(u8, compressBound(src.len));
+    defer testing.allocator.free(block);
+    const size = compress(src, block, &table);
+    try testing.expect(size < src.len / 200);
+    try testing.expect(src.len <= maxDecompressedSize(size));
+}
+
+test "corrupt blocks fail" {
+    var out: [64]u8 = undefined;
+    // Empty block
+    try testing.expectError(error.Corrupt, decompress("", &out));
+    // Literals beyond the end of the block
+    try testing.expectError(error.Corrupt, decompress("\x50abc", &out));
+    // Extended length cut short
+    try testing.expectError(error.Corrupt, decompress("\xf0\xff", &out));
+    // Match with offset 0, and one reaching before the output
+    try testing.expectError(error.Corrupt, decompress("\x10a\x00\x00\x00", &out));
+    try testing.expectError(error.Corrupt, decompress("\x10a\x02\x00\x00", &out));
+    // Offset cut short
+    try testing.expectError(error.Corrupt, decompress("\x10a\x01", &out));
+    // Output longer or shorter than the block produces
+    try testing.expectError(error.Corrupt, decompress("\x10a\x01\x00\x00", out[0..4]));
+    try testing.expectError(error.Corrupt, decompress("\x30abc", out[0..4]));
+    try decompress("\x30abc", out[0..3]);
+}
+
+test "mutated blocks never decode out of bounds" {
+    var src: [4096]u8 = undefined;
+    for (&src, 0..) |*byte, i| byte.* = "redis_ffi "[i % 10] +% @as(u8, @intCast(i / 512));
+    var table: HashTable = undefined;
+    var block: [compressBound(src.len)]u8 = undefined;
+    const size = compress(&src, &block, &table);
+
+    var prng = std.Random.DefaultPrng.init(3);
+    const random = prng.random();
+    var mutated: [block.len]u8 = undefined;
+    var out: [src.len]u8 = undefined;
+    for (0..2000) |_| {
+        @memcpy(mutated[0..size], block[0..size]);
+        for (0..random.intRangeAtMost(usize, 1, 4)) |_| {
+            mutated[random.uintLessThan(usize, size)] = random.int(u8);
+        }
+        const len = random.intRangeAtMost(usize, 0, size);
+        decompress(mutated[0..len], &out) catch continue;
+    }
+}
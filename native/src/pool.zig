@@ -0,0 +1,197 @@
+// Free-list pools for the per-command allocations on the enqueue hot path.
+//
+// Command nodes are allocated on the Dart thread and released on the thread
+// driving the connection; callback infos are allocated on the poll thread and
+// released from the reply callback. Both pools therefore take a mutex, which
+// is uncontended in the common case and far cheaper than a malloc/free pair.
+//
+// Recycled blocks are kept up to a per-pool cap so a burst does not pin its
+// peak memory forever; anything above the cap goes back to the C allocator.
+
+const std = @import("std");
+
+const allocator = std.heap.c_allocator;
+
+/// Counters for one pool, reported through redis_event_loop_get_stats.
+pub const PoolStats = struct {
+    /// Most blocks that were handed out at the same time.
+    high_water: u64,
+    /// Blocks currently sitting on the free lists.
+    cached: u64,
+    /// Allocations that were too large for any size class.
+    oversize: u64,
+};
+
+/// Variable-sized blocks, bucketed into a few power-of-two size classes.
+/// Blocks are 8-byte aligned.
+pub const BlockPool = struct {
+    pub const class_sizes = [_]usize{ 128, 256, 512, 1024, 4096 };
+    const max_cached_per_class = 256;
+
+    const FreeBlock = struct { next: ?*FreeBlock };
+
+    mutex: std.Thread.Mutex = .{},
+    free_lists: [class_sizes.len]?*FreeBlock = .{null} ** class_sizes.len,
+    cached: [class_sizes.len]u32 = .{0} ** class_sizes.len,
+    in_use: u64 = 0,
+    high_water: u64 = 0,
+    oversize: u64 = 0,
+
+    fn classFor(size: usize) ?usize {
+        for (class_sizes, 0..) |class_size, i| {
+            if (size <= class_size) return i;
+        }
+        return null;
+    }
+
+    fn allocWords(size: usize) ?[*]align(8) u8 {
+        const words = allocator.alloc(u64, (size + 7) / 8) catch return null;
+        return @ptrCast(words.ptr);
+    }
+
+    fn freeWords(ptr: [*]align(8) u8, size: usize) void {
+        const words: [*]u64 = @ptrCast(ptr);
+        allocator.free(words[0 .. (size + 7) / 8]);
+    }
+
+    /// Get a block of at least `size` bytes. Release it with `free(ptr, size)`.
+    pub fn alloc(self: *BlockPool, size: usize) ?[*]align(8) u8 {
+        const class = classFor(size);
+
+        self.mutex.lock();
+        self.in_use += 1;
+        self.high_water = @max(self.high_water, self.in_use);
+        if (class) |i| {
+            if (self.free_lists[i]) |block| {
+                self.free_lists[i] = block.next;
+                self.cached[i] -= 1;
+                self.mutex.unlock();
+                return @ptrCast(block);
+            }
+        } else {
+            self.oversize += 1;
+        }
+        self.mutex.unlock();
+
+        const ptr = allocWords(if (class) |i| class_sizes[i] else size) orelse {
+            self.mutex.lock();
+            self.in_use -= 1;
+            self.mutex.unlock();
+            return null;
+        };
+        return ptr;
+    }
+
+    /// Return a block obtained from `alloc`. `size` must be the requested size.
+    pub fn free(self: *BlockPool, ptr: [*]align(8) u8, size: usize) void {
+        const class = classFor(size);
+
+        self.mutex.lock();
+        self.in_use -= 1;
+        if (class) |i| {
+            if (self.cached[i] < max_cached_per_class) {
+                const block: *FreeBlock = @ptrCast(ptr);
+                block.next = self.free_lists[i];
+                self.free_lists[i] = block;
+                self.cached[i] += 1;
+                self.mutex.unlock();
+                return;
+            }
+        }
+        self.mutex.unlock();
+
+        freeWords(ptr, if (class) |i| class_sizes[i] else size);
+    }
+
+    pub fn stats(self: *BlockPool) PoolStats {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        var cached: u64 = 0;
+        for (self.cached) |n| cached += n;
+        return .{ .high_water = self.high_water, .cached = cached, .oversize = self.oversize };
+    }
+
+    /// Free all cached blocks. Blocks still handed out are not tracked.
+    pub fn deinit(self: *BlockPool) void {
+        for (&self.free_lists, class_sizes) |*head, class_size| {
+            while (head.*) |block| {
+                head.* = block.next;
+                freeWords(@ptrCast(block), class_size);
+            }
+        }
+        self.cached = .{0} ** class_sizes.len;
+    }
+};
+
+/// Fixed-size objects of type T.
+pub fn ItemPool(comptime T: type) type {
+    return struct {
+        const Self = @This();
+        const max_cached = 1024;
+
+        const FreeItem = struct { next: ?*FreeItem };
+
+        comptime {
+            std.debug.assert(@sizeOf(T) >= @sizeOf(FreeItem));
+            std.debug.assert(@alignOf(T) >= @alignOf(FreeItem));
+        }
+
+        mutex: std.Thread.Mutex = .{},
+        free_list: ?*FreeItem = null,
+        cached: u64 = 0,
+        in_use: u64 = 0,
+        high_water: u64 = 0,
+
+        /// Get an uninitialized item.
+        pub fn create(self: *Self) ?*T {
+            self.mutex.lock();
+            self.in_use += 1;
+            self.high_water = @max(self.high_water, self.in_use);
+            if (self.free_list) |item| {
+                self.free_list = item.next;
+                self.cached -= 1;
+                self.mutex.unlock();
+                return @ptrCast(@alignCast(item));
+            }
+            self.mutex.unlock();
+
+            return allocator.create(T) catch {
+                self.mutex.lock();
+                self.in_use -= 1;
+                self.mutex.unlock();
+                return null;
+            };
+        }
+
+        pub fn destroy(self: *Self, item: *T) void {
+            self.mutex.lock();
+            self.in_use -= 1;
+            if (self.cached < max_cached) {
+                const free_item: *FreeItem = @ptrCast(item);
+                free_item.next = self.free_list;
+                self.free_list = free_item;
+                self.cached += 1;
+                self.mutex.unlock();
+                return;
+            }
+            self.mutex.unlock();
+
+            allocator.destroy(item);
+        }
+
+        pub fn stats(self: *Self) PoolStats {
+            self.mutex.lock();
+            defer self.mutex.unlock();
+            return .{ .high_water = self.high_water, .cached = self.cached, .oversize = 0 };
+        }
+
+        /// Free all cached items. Items still handed out are not tracked.
+        pub fn deinit(self: *Self) void {
+            while (self.free_list) |item| {
+                self.free_list = item.next;
+                allocator.destroy(@as(*T, @ptrCast(@alignCast(item))));
+            }
+            self.cached = 0;
+        }
+    };
+}
@@ -0,0 +1,521 @@
+// Shared multi-connection reactor.
+//
+// A Reactor owns a small, fixed set of I/O threads. Each thread waits on one
+// epoll (Linux/Android) or kqueue (macOS/iOS) instance plus a Wakeup (see
+// wakeup.zig) and drives every EventLoopState attached to it. A state is
+// pinned to a single I/O thread for its whole life, so hiredis contexts keep
+// being accessed from exactly one native thread.
+//
+// Threading:
+// - attach/detach requests are posted by the Dart thread to an intrusive op
+//   list (guarded by ops_mutex) and applied on the I/O thread.
+// - redis_event_loop_wakeup pushes the state onto a lock-free ready stack,
+//   at most once until the I/O thread has drained it (wake_pending flag).
+// - The deadlines of all hosted commands sent with a timeout share the
+//   thread's timer wheel, which bounds each wait.
+
+const std = @import("std");
+const builtin = @import("builtin");
+const loop = @import("async_loop.zig");
+const Wakeup = @import("wakeup.zig").Wakeup;
+const timer_wheel = @import("timer_wheel.zig");
+const alloc = @import("alloc.zig");
+
+const posix = std.posix;
+const EventLoopState = loop.EventLoopState;
+
+/// Whether a reactor backend exists for the target OS.
+pub const supported = switch (builtin.os.tag) {
+    .linux, .macos, .ios => true,
+    else => false,
+};
+
+const Poller = switch (builtin.os.tag) {
+    .macos, .ios => KqueuePoller,
+    else => EpollPoller,
+};
+
+const max_events = 64;
+
+/// Per-state reactor bookkeeping, embedded in EventLoopState.
+pub const Link = struct {
+    /// Hosting I/O thread. Set on attach and cleared on stop (Dart thread).
+    thread: ?*IoThread = null,
+    /// Whether the I/O thread currently polls this state (I/O thread only).
+    hosted: bool = false,
+    /// Socket fd the state is registered under (I/O thread only).
+    fd: i32 = -1,
+    /// Interest currently registered with the poller (I/O thread only).
+    registered_read: bool = true,
+    registered_write: bool = false,
+    /// Set while the state sits on the ready stack.
+    wake_pending: std.atomic.Value(bool) = std.atomic.Value(bool).init(false),
+    ready_next: ?*EventLoopState = null,
+    /// Pending attach/detach request (guarded by IoThread.ops_mutex).
+    op: Op = .none,
+    op_done: ?*std.Thread.ResetEvent = null,
+    op_next: ?*EventLoopState = null,
+};
+
+const Op = enum { none, attach, detach };
+
+/// A set of I/O threads shared by many connections.
+pub const Reactor = struct {
+    threads: []IoThread,
+
+    pub fn create(num_threads: usize) ?*Reactor {
+        if (!supported) return null;
+
+        const allocator = std.heap.c_allocator;
+        const self = allocator.create(Reactor) catch return null;
+        const threads = allocator.alloc(IoThread, num_threads) catch {
+            allocator.destroy(self);
+            return null;
+        };
+
+        for (threads, 0..) |*t, i| {
+            t.start() catch {
+                for (threads[0..i]) |*started| started.shutdown();
+                allocator.free(threads);
+                allocator.destroy(self);
+                return null;
+            };
+        }
+
+        self.* = .{ .threads = threads };
+        return self;
+    }
+
+    /// Stop all I/O threads and free the reactor. Connections should be
+    /// stopped first; any still hosted are detached and told they are gone.
+    pub fn destroy(self: *Reactor) void {
+        for (self.threads) |*t| t.shutdown();
+        std.heap.c_allocator.free(self.threads);
+        std.heap.c_allocator.destroy(self);
+    }
+
+    /// Pin the state to the least loaded I/O thread.
+    /// Caller holds state.mutex.
+    pub fn attach(self: *Reactor, state: *EventLoopState) bool {
+        var best = &self.threads[0];
+        for (self.threads[1..]) |*t| {
+            if (t.load.load(.monotonic) < best.load.load(.monotonic)) best = t;
+        }
+        _ = best.load.fetchAdd(1, .monotonic);
+        state.reactor_link.thread = best;
+        best.post(state, .attach, null);
+        return true;
+    }
+};
+
+/// One reactor thread and the connections it hosts.
+pub const IoThread = struct {
+    poller: Poller,
+    /// Wakes the thread for ops, ready states and shutdown (coalesced).
+    wakeup: Wakeup,
+    thread: ?std.Thread,
+    stop: std.atomic.Value(bool),
+    /// Number of states pinned to this thread (used for placement).
+    load: std.atomic.Value(usize),
+    /// Lock-free stack of states with queued work (see wake).
+    ready: std.atomic.Value(?*EventLoopState),
+    ops_mutex: std.Thread.Mutex,
+    ops_head: ?*EventLoopState,
+    /// Hosted connections keyed by socket fd (I/O thread only).
+    conns: std.AutoHashMapUnmanaged(posix.fd_t, *EventLoopState),
+    /// Command deadlines of the hosted connections (I/O thread only).
+    timers: timer_wheel.Wheel,
+    /// Connections that timed out with close_on_timeout while the wheel was
+    /// being expired, dropped right after (I/O thread only).
+    timed_out: std.ArrayListUnmanaged(*EventLoopState),
+
+    fn start(self: *IoThread) !void {
+        const wakeup = try Wakeup.init();
+        errdefer wakeup.deinit();
+
+        var poller = try Poller.init();
+        errdefer poller.deinit();
+        try poller.add(wakeup.read_fd, true, false);
+
+        self.* = .{
+            .poller = poller,
+            .wakeup = wakeup,
+            .thread = null,
+            .stop = std.atomic.Value(bool).init(false),
+            .load = std.atomic.Value(usize).init(0),
+            .ready = std.atomic.Value(?*EventLoopState).init(null),
+            .ops_mutex = .{},
+            .ops_head = null,
+            .conns = .{},
+            .timers = .{},
+            .timed_out = .{},
+        };
+        self.thread = try std.Thread.spawn(.{}, run, .{self});
+    }
+
+    fn shutdown(self: *IoThread) void {
+        self.stop.store(true, .release);
+        self.signal();
+        if (self.thread) |t| t.join();
+
+        self.conns.deinit(std.heap.c_allocator);
+        self.timed_out.deinit(std.heap.c_allocator);
+        self.poller.deinit();
+        self.wakeup.deinit();
+    }
+
+    /// Queue the state for a drain on this thread (any thread).
+    pub fn wake(self: *IoThread, state: *EventLoopState) void {
+        const link = &state.reactor_link;
+        // Already on the ready stack; the I/O thread will see the new commands
+        if (link.wake_pending.swap(true, .acq_rel)) return;
+
+        var head = self.ready.load(.acquire);
+        while (true) {
+            link.ready_next = head;
+            head = self.ready.cmpxchgWeak(head, state, .acq_rel, .acquire) orelse break;
+        }
+        self.signal();
+    }
+
+    /// Remove the state from this thread and wait until the I/O thread no
+    /// longer references it. Called from the Dart thread.
+    pub fn detach(self: *IoThread, state: *EventLoopState) void {
+        var done: std.Thread.ResetEvent = .{};
+        self.post(state, .detach, &done);
+        done.wait();
+        _ = self.load.fetchSub(1, .monotonic);
+    }
+
+    fn post(self: *IoThread, state: *EventLoopState, op: Op, done: ?*std.Thread.ResetEvent) void {
+        self.ops_mutex.lock();
+        const link = &state.reactor_link;
+        const queued = link.op != .none;
+        // A detach posted before its attach was applied simply replaces it
+        link.op = op;
+        link.op_done = done;
+        if (!queued) {
+            link.op_next = self.ops_head;
+            self.ops_head = state;
+        }
+        self.ops_mutex.unlock();
+        self.signal();
+    }
+
+    fn signal(self: *IoThread) void {
+        self.wakeup.signal();
+    }
+
+    fn run(self: *IoThread) void {
+        alloc.enterThread();
+        defer alloc.exitThread();
+
+        var events: [max_events]Poller.Event = undefined;
+
+        while (!self.stop.load(.acquire)) {
+            self.processOps();
+            self.processReady();
+
+            const n = self.poller.wait(&events, self.timers.timeoutMs(timer_wheel.nowMs()));
+            for (events[0..n]) |*ev| {
+                const fd = Poller.eventFd(ev);
+                if (fd == self.wakeup.read_fd) {
+                    // Ops and ready states are processed next iteration
+                    self.wakeup.consume();
+                    continue;
+                }
+
+                const state = self.conns.get(fd) orelse continue;
+                _ = state.poll_wakeups.fetchAdd(1, .monotonic);
+
+                if (Poller.isError(ev)) {
+                    self.remove(state, true);
+                    continue;
+                }
+                loop.handleSocketEvents(state, Poller.isReadable(ev), Poller.isWritable(ev));
+                self.afterIo(state);
+            }
+
+            self.expireCommands();
+        }
+
+        // Reactor is going away: apply outstanding requests, then drop
+        // whatever is still hosted.
+        self.processOps();
+        var it = self.conns.valueIterator();
+        while (it.next()) |state_ptr| {
+            const state = state_ptr.*;
+            state.reactor_link.hosted = false;
+            self.timers.removeMatching(state, ownsTimer);
+            loop.notifyDisconnect(state);
+        }
+        self.conns.clearRetainingCapacity();
+    }
+
+    /// Fail the hosted commands whose deadline has passed, then drop the
+    /// connections that are to close on a timeout.
+    fn expireCommands(self: *IoThread) void {
+        self.timers.advance(timer_wheel.nowMs(), self, expired);
+        for (self.timed_out.items) |state| self.afterIo(state);
+        self.timed_out.clearRetainingCapacity();
+    }
+
+    fn expired(self: *IoThread, node: *timer_wheel.Node) void {
+        const state = loop.expireCommand(node) orelse return;
+        // Removing it now would change the wheel while it is expired; without
+        // room, it is dropped after its next I/O instead
+        if (state.timed_out.load(.acquire)) self.timed_out.append(std.heap.c_allocator, state) catch {};
+    }
+
+    fn ownsTimer(state: *EventLoopState, node: *timer_wheel.Node) bool {
+        return loop.timerOwner(node) == state;
+    }
+
+    /// Drain every state on the ready stack.
+    fn processReady(self: *IoThread) void {
+        var node = self.ready.swap(null, .acq_rel);
+        while (node) |state| {
+            const link = &state.reactor_link;
+            // Read next before clearing the flag: a producer may re-push right after
+            node = link.ready_next;
+            link.wake_pending.store(false, .seq_cst);
+
+            if (!link.hosted) continue;
+            loop.drainCommandQueue(state);
+            self.afterIo(state);
+        }
+    }
+
+    /// Apply pending attach/detach requests.
+    fn processOps(self: *IoThread) void {
+        self.ops_mutex.lock();
+        defer self.ops_mutex.unlock();
+
+        var node = self.ops_head orelse return;
+        self.ops_head = null;
+
+        // A state woken before it was detached must leave the ready stack first
+        self.processReady();
+
+        while (true) {
+            const link = &node.reactor_link;
+            const next = link.op_next;
+            const op = link.op;
+            const done = link.op_done;
+            link.op = .none;
+            link.op_done = null;
+            link.op_next = null;
+
+            switch (op) {
+                .attach => self.add(node),
+                .detach => if (link.hosted) self.remove(node, false),
+                .none => {},
+            }
+            if (done) |d| d.set();
+
+            node = next orelse break;
+        }
+    }
+
+    fn add(self: *IoThread, state: *EventLoopState) void {
+        const link = &state.reactor_link;
+        const fd: posix.fd_t = state.ctx.c.fd;
+        const want_read = !state.read_paused.load(.acquire);
+        const want_write = state.want_write.load(.acquire);
+
+        if (fd < 0 or state.stop.load(.acquire)) {
+            loop.notifyDisconnect(state);
+            return;
+        }
+        self.conns.put(std.heap.c_allocator, fd, state) catch {
+            loop.notifyDisconnect(state);
+            return;
+        };
+        self.poller.add(fd, want_read, want_write) catch {
+            _ = self.conns.remove(fd);
+            loop.notifyDisconnect(state);
+            return;
+        };
+
+        link.fd = fd;
+        link.hosted = true;
+        link.registered_read = want_read;
+        link.registered_write = want_write;
+
+        // Submit anything queued before the state was attached
+        loop.drainCommandQueue(state);
+        self.afterIo(state);
+    }
+
+    fn remove(self: *IoThread, state: *EventLoopState, notify: bool) void {
+        const link = &state.reactor_link;
+        if (!link.hosted) return;
+
+        // The fd may already be closed by hiredis; epoll/kqueue drop it then
+        self.poller.remove(link.fd);
+        _ = self.conns.remove(link.fd);
+        link.hosted = false;
+        link.fd = -1;
+        // Its commands may be answered from another thread from now on, e.g.
+        // by redisAsyncFree on the Dart thread
+        self.timers.removeMatching(state, ownsTimer);
+
+        if (notify) loop.notifyDisconnect(state);
+    }
+
+    /// Drop closed connections, otherwise sync the write interest with hiredis
+    /// and the read interest with pub/sub flow control.
+    fn afterIo(self: *IoThread, state: *EventLoopState) void {
+        const link = &state.reactor_link;
+        if (!link.hosted) return;
+
+        if (state.stop.load(.acquire) or loop.connectionClosed(state)) {
+            self.remove(state, true);
+            return;
+        }
+
+        const want_read = !state.read_paused.load(.acquire);
+        const want_write = state.want_write.load(.acquire);
+        if (want_read != link.registered_read or want_write != link.registered_write) {
+            self.poller.modify(link.fd, want_read, want_write) catch {
+                self.remove(state, true);
+                return;
+            };
+            link.registered_read = want_read;
+            link.registered_write = want_write;
+        }
+    }
+};
+
+// ============================================================================
+// Poller backends
+// ============================================================================
+
+const EpollPoller = struct {
+    const linux = std.os.linux;
+    const Event = linux.epoll_event;
+
+    fd: posix.fd_t,
+
+    fn init() !EpollPoller {
+        return .{ .fd = try posix.epoll_create1(linux.EPOLL.CLOEXEC) };
+    }
+
+    fn deinit(self: *EpollPoller) void {
+        posix.close(self.fd);
+    }
+
+    fn interest(read: bool, write: bool) u32 {
+        var events: u32 = 0;
+        if (read) events |= linux.EPOLL.IN;
+        if (write) events |= linux.EPOLL.OUT;
+        return events;
+    }
+
+    fn add(self: *EpollPoller, fd: posix.fd_t, read: bool, write: bool) !void {
+        var ev: Event = .{ .events = interest(read, write), .data = .{ .fd = fd } };
+        try posix.epoll_ctl(self.fd, linux.EPOLL.CTL_ADD, fd, &ev);
+    }
+
+    fn modify(self: *EpollPoller, fd: posix.fd_t, read: bool, write: bool) !void {
+        var ev: Event = .{ .events = interest(read, write), .data = .{ .fd = fd } };
+        try posix.epoll_ctl(self.fd, linux.EPOLL.CTL_MOD, fd, &ev);
+    }
+
+    fn remove(self: *EpollPoller, fd: posix.fd_t) void {
+        posix.epoll_ctl(self.fd, linux.EPOLL.CTL_DEL, fd, null) catch {};
+    }
+
+    fn wait(self: *EpollPoller, events: []Event, timeout_ms: i32) usize {
+        return posix.epoll_wait(self.fd, events, timeout_ms);
+    }
+
+    fn eventFd(ev: *const Event) posix.fd_t {
+        return ev.data.fd;
+    }
+
+    fn isReadable(ev: *const Event) bool {
+        return ev.events & linux.EPOLL.IN != 0;
+    }
+
+    fn isWritable(ev: *const Event) bool {
+        return ev.events & linux.EPOLL.OUT != 0;
+    }
+
+    fn isError(ev: *const Event) bool {
+        return ev.events & (linux.EPOLL.ERR | linux.EPOLL.HUP) != 0;
+    }
+};
+
+const KqueuePoller = struct {
+    const Event = posix.Kevent;
+    const EVFILT = std.c.EVFILT;
+    const EV = std.c.EV;
+
+    fd: posix.fd_t,
+
+    fn init() !KqueuePoller {
+        return .{ .fd = try posix.kqueue() };
+    }
+
+    fn deinit(self: *KqueuePoller) void {
+        posix.close(self.fd);
+    }
+
+    fn change(self: *KqueuePoller, fd: posix.fd_t, filter: i16, flags: u16) !void {
+        const changes = [_]Event{.{
+            .ident = @intCast(fd),
+            .filter = filter,
+            .flags = flags,
+            .fflags = 0,
+            .data = 0,
+            .udata = 0,
+        }};
+        var no_events: [0]Event = .{};
+        _ = try posix.kevent(self.fd, &changes, &no_events, null);
+    }
+
+    fn add(self: *KqueuePoller, fd: posix.fd_t, read: bool, write: bool) !void {
+        try self.change(fd, EVFILT.READ, if (read) EV.ADD | EV.ENABLE else EV.ADD | EV.DISABLE);
+        try self.change(fd, EVFILT.WRITE, if (write) EV.ADD | EV.ENABLE else EV.ADD | EV.DISABLE);
+    }
+
+    fn modify(self: *KqueuePoller, fd: posix.fd_t, read: bool, write: bool) !void {
+        try self.change(fd, EVFILT.READ, if (read) EV.ENABLE else EV.DISABLE);
+        try self.change(fd, EVFILT.WRITE, if (write) EV.ENABLE else EV.DISABLE);
+    }
+
+    fn remove(self: *KqueuePoller, fd: posix.fd_t) void {
+        self.change(fd, EVFILT.READ, EV.DELETE) catch {};
+        self.change(fd, EVFILT.WRITE, EV.DELETE) catch {};
+    }
+
+    fn wait(self: *KqueuePoller, events: []Event, timeout_ms: i32) usize {
+        var ts: posix.timespec = undefined;
+        const timeout: ?*const posix.timespec = if (timeout_ms < 0) null else blk: {
+            ts = .{
+                .sec = @intCast(@divTrunc(timeout_ms, 1000)),
+                .nsec = @intCast(@rem(timeout_ms, 1000) * std.time.ns_per_ms),
+            };
+            break :blk &ts;
+        };
+        return posix.kevent(self.fd, &.{}, events, timeout) catch 0;
+    }
+
+    fn eventFd(ev: *const Event) posix.fd_t {
+        return @intCast(ev.ident);
+    }
+
+    fn isReadable(ev: *const Event) bool {
+        return ev.filter == EVFILT.READ;
+    }
+
+    fn isWritable(ev: *const Event) bool {
+        return ev.filter == EVFILT.WRITE;
+    }
+
+    fn isError(ev: *const Event) bool {
+        // EV_EOF is reported as readable so hiredis sees the close itself
+        return ev.flags & EV.ERROR != 0;
+    }
+};
@@ -0,0 +1,140 @@
+// Automatic reconnect of a connection driven by its own poll thread.
+//
+// When the socket goes away, pollLoop hands the connection to reconnect
+// instead of exiting. The EventLoopState, its command queue and its reply
+// ports stay as they are; only the hiredis context is replaced:
+//
+// 1. With full jitter, wait a random time up to min(max_delay, min_delay *
+//    2^attempt), waking early only to stop.
+// 2. Connect a new context to the same address and swap it in under
+//    ctx_mutex. Freeing the old one runs the callbacks of the commands it
+//    still held with a NULL reply; each is posted to its port as a lost
+//    record (LOST_COMMAND_ID, the command id as an integer), and Dart
+//    decides whether to send it again. Commands still in the queue were
+//    never sent and simply go to the new context.
+// 3. Submit the handshake (commands that set up the session, kept by
+//    redis_event_loop_set_handshake) ahead of everything else.
+//
+// MSG_RECONNECTING goes to every port when the connection is lost and
+// MSG_RECONNECTED from the connect callback once a new one is up. After
+// max_attempts failed attempts in a row, pollLoop gives up and exits as
+// without reconnect.
+//
+// Everything here runs on the connection's poll thread; a reactor's I/O
+// threads never reconnect.
+
+const std = @import("std");
+const loop = @import("async_loop.zig");
+const uring = @import("uring.zig");
+
+const c = loop.c;
+const EventLoopState = loop.EventLoopState;
+const CommandBatch = loop.CommandBatch;
+
+pub const Reconnect = struct {
+    host: [:0]u8,
+    port: c_int,
+    min_delay_ms: u32,
+    max_delay_ms: u32,
+    /// Failed attempts in a row before giving up (0: never give up).
+    max_attempts: u32,
+    /// Attempts since the connection was last up.
+    attempts: u32 = 0,
+    /// Commands submitted first on every new context (under ctx_mutex).
+    handshake: ?*CommandBatch = null,
+    /// Whether the next context gets a new io_uring backend.
+    restore_uring: bool = false,
+    /// Connections re-established so far.
+    reconnects: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    random: std.Random.DefaultPrng,
+
+    pub fn create(host: [*:0]const u8, port: c_int, min_delay_ms: u32, max_delay_ms: u32, max_attempts: u32) ?*Reconnect {
+        const self = std.heap.c_allocator.create(Reconnect) catch return null;
+        const host_copy = std.heap.c_allocator.dupeZ(u8, std.mem.span(host)) catch {
+            std.heap.c_allocator.destroy(self);
+            return null;
+        };
+        self.* = .{
+            .host = host_copy,
+            .port = port,
+            .min_delay_ms = @max(min_delay_ms, 1),
+            .max_delay_ms = @max(max_delay_ms, min_delay_ms),
+            .max_attempts = max_attempts,
+            .random = std.Random.DefaultPrng.init(@as(u64, @truncate(@as(u128, @bitCast(std.time.nanoTimestamp())))) ^ @intFromPtr(self)),
+        };
+        return self;
+    }
+
+    pub fn destroy(self: *Reconnect) void {
+        if (self.handshake) |b| b.destroy();
+        std.heap.c_allocator.free(self.host);
+        std.heap.c_allocator.destroy(self);
+    }
+
+    /// Replace the handshake batch. Called with ctx_mutex held.
+    pub fn setHandshake(self: *Reconnect, batch: ?*CommandBatch) void {
+        if (self.handshake) |old| old.destroy();
+        self.handshake = batch;
+    }
+
+    /// Called from the connect callback once a context is connected.
+    pub fn connected(self: *Reconnect, state: *EventLoopState, was: loop.ConnectionState) void {
+        self.attempts = 0;
+        if (was == .reconnecting) {
+            _ = self.reconnects.fetchAdd(1, .monotonic);
+            loop.notifyPorts(state, loop.MSG_RECONNECTED);
+        }
+    }
+
+    /// Replace the lost context with a new one, after the backoff delay.
+    /// Returns false to give up: stopped, or out of attempts.
+    pub fn reconnect(self: *Reconnect, state: *EventLoopState) bool {
+        if (self.max_attempts > 0 and self.attempts >= self.max_attempts) return false;
+
+        if (state.connection.swap(.reconnecting, .acq_rel) != .reconnecting) {
+            loop.notifyPorts(state, loop.MSG_RECONNECTING);
+        }
+
+        // The ring holds operations on the old socket; start over with a new
+        // one once connected. Its wakeup poll may have completed unseen, so
+        // re-arm: the queue is drained anyway.
+        if (state.uring) |u| {
+            u.destroy();
+            state.uring = null;
+            self.restore_uring = true;
+            loop.rearmWakeup(state);
+        }
+
+        if (!loop.sleepUnlessStopped(state, self.nextDelay())) return false;
+        self.attempts += 1;
+
+        var options = std.mem.zeroes(c.redisOptions);
+        options.type = c.REDIS_CONN_TCP;
+        options.endpoint.tcp.ip = self.host.ptr;
+        options.endpoint.tcp.port = self.port;
+        options.options = c.REDIS_OPT_NOAUTOFREE;
+        // On failure the old context stays until an attempt gets a new one,
+        // and the next iteration of pollLoop tries again
+        const ctx: *c.redisAsyncContext = c.redisAsyncConnectWithOptions(&options) orelse return true;
+        if (ctx.c.err != 0) {
+            // E.g. the name does not resolve
+            c.redisAsyncFree(ctx);
+            return true;
+        }
+
+        loop.replaceContext(state, ctx, self.handshake);
+
+        if (self.restore_uring) {
+            state.uring = uring.Backend.create();
+            self.restore_uring = false;
+        }
+        return true;
+    }
+
+    /// Full jitter: uniform in [0, min(max_delay, min_delay * 2^attempts)].
+    fn nextDelay(self: *Reconnect) u32 {
+        const shift: u5 = @intCast(@min(self.attempts, 20));
+        const ceiling = @min(@as(u64, self.max_delay_ms), @as(u64, self.min_delay_ms) << shift);
+        return @intCast(self.random.random().uintAtMost(u64, ceiling));
+    }
+};
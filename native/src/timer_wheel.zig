@@ -0,0 +1,117 @@
+// Hashed timing wheel for command deadlines.
+//
+// Each command with a timeout embeds a Node (CallbackInfo.timer) that is
+// linked into the slot of the tick its deadline falls in, rounded up, so
+// scheduling and cancelling are O(1) and need no allocation. Deadlines more
+// than one revolution ahead share a slot with nearer ones and are skipped,
+// by comparing the deadline, until their turn comes round.
+//
+// A wheel belongs to the thread that drives its connections: a state's own
+// poll thread has one in its EventLoopState, a reactor I/O thread one for
+// all the states it hosts. Only that thread touches it.
+
+const std = @import("std");
+const instruments = @import("instruments.zig");
+
+/// Resolution of deadlines, in milliseconds.
+pub const tick_ms: u64 = 10;
+
+/// Slots per revolution (2.56 s at 10 ms ticks).
+const slot_count = 256;
+
+/// Milliseconds on the clock deadlines are measured against.
+pub fn nowMs() u64 {
+    return instruments.monotonicNs() / std.time.ns_per_ms;
+}
+
+/// Intrusive list entry of a scheduled deadline.
+pub const Node = struct {
+    prev: ?*Node = null,
+    next: ?*Node = null,
+    /// Absolute deadline in nowMs; 0 while not scheduled.
+    deadline_ms: u64 = 0,
+    slot: u16 = 0,
+
+    pub fn scheduled(self: *const Node) bool {
+        return self.deadline_ms != 0;
+    }
+};
+
+pub const Wheel = struct {
+    slots: [slot_count]?*Node = [_]?*Node{null} ** slot_count,
+    /// Last tick whose slot has been expired.
+    tick: u64 = 0,
+    /// Nodes scheduled.
+    count: usize = 0,
+
+    /// Schedule `node` to expire `timeout_ms` after `now`.
+    pub fn insert(self: *Wheel, node: *Node, now: u64, timeout_ms: u32) void {
+        if (self.count == 0) self.tick = now / tick_ms;
+        const deadline = now + @max(timeout_ms, 1);
+        const due = @max(std.math.divCeil(u64, deadline, tick_ms) catch unreachable, self.tick + 1);
+        const slot: u16 = @intCast(due % slot_count);
+
+        node.* = .{ .next = self.slots[slot], .deadline_ms = deadline, .slot = slot };
+        if (node.next) |n| n.prev = node;
+        self.slots[slot] = node;
+        self.count += 1;
+    }
+
+    /// Cancel `node` if it is scheduled.
+    pub fn remove(self: *Wheel, node: *Node) void {
+        if (!node.scheduled()) return;
+        if (node.prev) |p| p.next = node.next else self.slots[node.slot] = node.next;
+        if (node.next) |n| n.prev = node.prev;
+        node.* = .{};
+        self.count -= 1;
+    }
+
+    /// Unschedule every node and pass it to `expired(ctx, node)`, for each
+    /// slot whose tick has passed by `now`. The callback must not change the
+    /// wheel.
+    pub fn advance(self: *Wheel, now: u64, ctx: anytype, comptime expired: fn (@TypeOf(ctx), *Node) void) void {
+        const now_tick = now / tick_ms;
+        if (self.count == 0) {
+            self.tick = now_tick;
+            return;
+        }
+        const steps = @min(now_tick -| self.tick, slot_count);
+        for (1..steps + 1) |i| {
+            const slot: usize = @intCast((self.tick + i) % slot_count);
+            var node = self.slots[slot];
+            while (node) |n| {
+                node = n.next;
+                if (n.deadline_ms > now) continue; // A later revolution
+                self.remove(n);
+                expired(ctx, n);
+            }
+        }
+        self.tick = now_tick;
+    }
+
+    /// Unschedule every node for which `matches(ctx, node)` holds, e.g. the
+    /// commands of a connection leaving a reactor thread.
+    pub fn removeMatching(self: *Wheel, ctx: anytype, comptime matches: fn (@TypeOf(ctx), *Node) bool) void {
+        if (self.count == 0) return;
+        for (&self.slots) |*head| {
+            var node = head.*;
+            while (node) |n| {
+                node = n.next;
+                if (matches(ctx, n)) self.remove(n);
+            }
+        }
+    }
+
+    /// Milliseconds until the next slot holding a node is due, for the poll
+    /// timeout: -1 if nothing is scheduled, 0 if a slot is due already.
+    pub fn timeoutMs(self: *const Wheel, now: u64) i32 {
+        if (self.count == 0) return -1;
+        for (1..slot_count + 1) |i| {
+            if (self.slots[@intCast((self.tick + i) % slot_count)] != null) {
+                const due = (self.tick + i) * tick_ms;
+                return if (due <= now) 0 else @intCast(@min(due - now, std.math.maxInt(i32)));
+            }
+        }
+        return 0;
+    }
+};
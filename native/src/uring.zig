@@ -0,0 +1,243 @@
+// Optional io_uring backend of the per-connection poll loop (Linux).
+//
+// pollAndHandlePosix costs a poll, a read of the wakeup eventfd and hiredis'
+// own recv/send per iteration. Here the socket receive, the send of pending
+// output and a poll of the wakeup eventfd stay in flight on one ring, and
+// each iteration resubmits whatever completed and waits in a single
+// io_uring_enter. While commands with a timeout are outstanding, a timeout
+// operation bounds the wait for their next deadline.
+//
+// Both descriptors are non-blocking, and on 5.10-era kernels a READ or
+// WRITE (fixed or not) of an O_NONBLOCK file completes with -EAGAIN instead
+// of waiting, which would turn an idle connection into a busy loop. RECV
+// and SEND take their mode from the message flags alone, so the socket uses
+// those and waits in the kernel's internal poll; the eventfd is polled and
+// then read like in the poll backend.
+//
+// Once connected, hiredis still parses replies and runs callbacks but does
+// no socket I/O: received bytes are fed to its reader, and its output buffer
+// is moved into the send buffer. Until the connect has completed, hiredis
+// is driven by a POLLOUT poll as usual.
+//
+// Everything here runs on the connection's poll thread; hiredis state is
+// only touched under ctx_mutex, like in the poll backend.
+
+const std = @import("std");
+const builtin = @import("builtin");
+const loop = @import("async_loop.zig");
+const timer_wheel = @import("timer_wheel.zig");
+
+const linux = std.os.linux;
+const posix = std.posix;
+const c = loop.c;
+const EventLoopState = loop.EventLoopState;
+
+/// Whether the target can have an io_uring backend. Android's seccomp
+/// policy kills apps that call io_uring_setup, so it is never tried there.
+pub const supported = builtin.os.tag == .linux and !builtin.abi.isAndroid();
+
+/// Room for the five operations a connection keeps in flight.
+const ring_entries = 8;
+
+/// Size of the receive and send buffers.
+const buffer_size = 64 * 1024;
+
+/// Longest timeout kept in flight for the next command deadline. A command
+/// sent meanwhile with a shorter timeout expires at most this late.
+const max_timer_ms = 50;
+
+/// user_data of each operation.
+const Op = enum(u64) { wakeup = 1, connect = 2, recv = 3, send = 4, timer = 5 };
+
+pub const Backend = struct {
+    ring: linux.IoUring,
+    /// Receive buffer, then send buffer.
+    buffers: []u8,
+    wake_inflight: bool = false,
+    connect_inflight: bool = false,
+    recv_inflight: bool = false,
+    send_inflight: bool = false,
+    timer_inflight: bool = false,
+    /// Duration of the timer in flight; the kernel reads it on submission.
+    timer_ts: linux.kernel_timespec = .{ .sec = 0, .nsec = 0 },
+    /// Part of the send buffer not written yet.
+    send_start: usize = 0,
+    send_end: usize = 0,
+
+    /// Set up a ring. Returns null when io_uring is unavailable (kernel
+    /// before 5.10, or disabled by sysctl or seccomp).
+    pub fn create() ?*Backend {
+        if (!supported) return null;
+        if (!kernelAtLeast(5, 10)) return null;
+
+        const self = std.heap.c_allocator.create(Backend) catch return null;
+        const buffers = std.heap.page_allocator.alloc(u8, 2 * buffer_size) catch {
+            std.heap.c_allocator.destroy(self);
+            return null;
+        };
+
+        const ring = linux.IoUring.init(ring_entries, 0) catch {
+            std.heap.page_allocator.free(buffers);
+            std.heap.c_allocator.destroy(self);
+            return null;
+        };
+
+        self.* = .{ .ring = ring, .buffers = buffers };
+        return self;
+    }
+
+    /// Close the ring, which cancels operations still in flight, and free
+    /// the buffers. Called once the poll thread has exited.
+    pub fn destroy(self: *Backend) void {
+        self.ring.deinit();
+        std.heap.page_allocator.free(self.buffers);
+        std.heap.c_allocator.destroy(self);
+    }
+
+    fn recvBuffer(self: *Backend) []u8 {
+        return self.buffers[0..buffer_size];
+    }
+
+    /// The part of the send buffer not written yet.
+    fn unsent(self: *Backend) []const u8 {
+        return self.buffers[buffer_size + self.send_start .. buffer_size + self.send_end];
+    }
+
+    /// One iteration of pollLoop: queue the operations not in flight, submit
+    /// them and wait for at least one completion, then handle all that are
+    /// ready. Returns -1 when the loop should exit.
+    pub fn pollAndHandle(self: *Backend, state: *EventLoopState) i32 {
+        const fd = state.ctx.c.fd;
+        if (fd < 0) return -1;
+
+        if (!self.wake_inflight) {
+            _ = self.ring.poll_add(@intFromEnum(Op.wakeup), state.wakeup.read_fd, linux.POLL.IN) catch return -1;
+            self.wake_inflight = true;
+        }
+
+        if (state.ctx.c.flags & c.REDIS_CONNECTED == 0) {
+            // hiredis completes the connect on the first write event
+            if (!self.connect_inflight) {
+                _ = self.ring.poll_add(@intFromEnum(Op.connect), fd, linux.POLL.OUT) catch return -1;
+                self.connect_inflight = true;
+            }
+        } else {
+            if (!self.recv_inflight and !state.read_paused.load(.acquire)) {
+                _ = self.ring.recv(@intFromEnum(Op.recv), fd, .{ .buffer = self.recvBuffer() }, 0) catch return -1;
+                self.recv_inflight = true;
+            }
+            if (!self.send_inflight and self.takeOutput(state)) {
+                _ = self.ring.send(@intFromEnum(Op.send), fd, self.unsent(), linux.MSG.NOSIGNAL) catch return -1;
+                self.send_inflight = true;
+            }
+        }
+
+        if (!self.timer_inflight) {
+            // Wakes us for the next command deadline
+            const wait_ms = state.timers.timeoutMs(timer_wheel.nowMs());
+            if (wait_ms >= 0) {
+                const ms: u32 = @min(@as(u32, @intCast(wait_ms)), max_timer_ms);
+                self.timer_ts = .{ .sec = 0, .nsec = @as(i64, ms) * std.time.ns_per_ms };
+                _ = self.ring.timeout(@intFromEnum(Op.timer), &self.timer_ts, 0, 0) catch return -1;
+                self.timer_inflight = true;
+            }
+        }
+
+        _ = self.ring.submit_and_wait(1) catch |err| switch (err) {
+            error.SignalInterrupt => return 0,
+            else => return -1,
+        };
+        _ = state.poll_wakeups.fetchAdd(1, .monotonic);
+
+        var cqes: [ring_entries]linux.io_uring_cqe = undefined;
+        const count = self.ring.copy_cqes(&cqes, 0) catch return -1;
+        if (count == 0) {
+            _ = state.spurious_wakeups.fetchAdd(1, .monotonic);
+            return 0;
+        }
+
+        for (cqes[0..count]) |cqe| {
+            const op = std.meta.intToEnum(Op, cqe.user_data) catch continue;
+            switch (op) {
+                .wakeup => {
+                    self.wake_inflight = false;
+                    switch (cqe.err()) {
+                        // Commands queued from here on signal again
+                        .SUCCESS => state.wakeup.consume(),
+                        .INTR => {},
+                        else => return -1,
+                    }
+                },
+                .connect => {
+                    self.connect_inflight = false;
+                    loop.handleSocketEvents(state, false, true);
+                },
+                .recv => {
+                    self.recv_inflight = false;
+                    if (cqe.res > 0) {
+                        loop.handleReceived(state, self.buffers[0..@intCast(cqe.res)]);
+                    } else switch (cqe.err()) {
+                        .AGAIN, .INTR => {},
+                        // EOF or a socket error: hiredis reads it again itself
+                        // and disconnects
+                        else => loop.handleSocketEvents(state, true, false),
+                    }
+                },
+                // Due deadlines are expired by pollLoop after this returns
+                .timer => self.timer_inflight = false,
+                .send => {
+                    self.send_inflight = false;
+                    if (cqe.res > 0) {
+                        // A short write resubmits the rest next iteration
+                        self.send_start += @intCast(cqe.res);
+                        if (self.send_start == self.send_end) {
+                            self.send_start = 0;
+                            self.send_end = 0;
+                        }
+                    } else switch (cqe.err()) {
+                        .SUCCESS, .AGAIN, .INTR => {},
+                        else => return -1,
+                    }
+                },
+            }
+        }
+        return 0;
+    }
+
+    /// Move the next chunk of hiredis' output buffer into the send buffer,
+    /// unless part of the last chunk is still unwritten. Returns false if
+    /// there is nothing to send.
+    fn takeOutput(self: *Backend, state: *EventLoopState) bool {
+        if (self.send_start < self.send_end) return true;
+
+        state.ctx_mutex.lock();
+        defer state.ctx_mutex.unlock();
+
+        const obuf = state.ctx.c.obuf;
+        const pending: usize = if (obuf == null) 0 else c.sdslen(obuf);
+        if (pending == 0) {
+            // Everything hiredis produced has been written
+            if (state.want_write.load(.acquire)) loop.outputFlushed(state);
+            return false;
+        }
+
+        const n = @min(pending, buffer_size);
+        @memcpy(self.buffers[buffer_size..][0..n], obuf[0..n]);
+        _ = c.sdsrange(obuf, @intCast(n), -1);
+        self.send_start = 0;
+        self.send_end = n;
+        return true;
+    }
+};
+
+/// RECV and SEND date from 5.6, and the internal poll that waits for a
+/// socket instead of a kernel worker blocking per operation from 5.7; 5.10
+/// is the first long-term release with both.
+fn kernelAtLeast(major: u32, minor: u32) bool {
+    const uts = posix.uname();
+    const release = std.mem.sliceTo(&uts.release, 0);
+    var parts = std.mem.tokenizeAny(u8, release, ".-");
+    const have_major = std.fmt.parseInt(u32, parts.next() orelse return false, 10) catch return false;
+    const have_minor = std.fmt.parseInt(u32, parts.next() orelse return false, 10) catch return false;
+    return have_major > major or (have_major == major and have_minor >= minor);
+}
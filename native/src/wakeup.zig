@@ -0,0 +1,76 @@
+// Coalescing wakeup of a poll thread (POSIX): one eventfd on Linux and
+// Android, a non-blocking pipe elsewhere.
+//
+// Producers set `pending` before writing, so only the first signal after the
+// poll thread consumed the previous one makes a system call; a burst of
+// enqueues from several isolates costs one write per drain, not one per
+// microtask batch. The poll thread clears the flag once it has read the
+// descriptor and before it drains its queue, so work queued after the clear
+// signals again. All flag operations are seq_cst, pairing with the queue
+// operations like the reactor's wake_pending flag.
+
+const std = @import("std");
+const builtin = @import("builtin");
+
+const posix = std.posix;
+const use_eventfd = builtin.os.tag == .linux;
+
+pub const Wakeup = struct {
+    /// Descriptor the poll thread waits on for readability.
+    read_fd: posix.fd_t,
+    /// Descriptor signal writes to; the same eventfd on Linux.
+    write_fd: posix.fd_t,
+    /// Set from the first signal until the poll thread consumes it.
+    pending: std.atomic.Value(bool) = std.atomic.Value(bool).init(false),
+
+    pub fn init() !Wakeup {
+        if (use_eventfd) {
+            const linux = std.os.linux;
+            const fd = try posix.eventfd(0, linux.EFD.CLOEXEC | linux.EFD.NONBLOCK);
+            return .{ .read_fd = fd, .write_fd = fd };
+        }
+        const fds = try posix.pipe2(.{ .NONBLOCK = true, .CLOEXEC = true });
+        return .{ .read_fd = fds[0], .write_fd = fds[1] };
+    }
+
+    pub fn deinit(self: Wakeup) void {
+        posix.close(self.read_fd);
+        if (self.write_fd != self.read_fd) posix.close(self.write_fd);
+    }
+
+    /// Wake the poll thread unless a wakeup is already pending (any thread).
+    pub fn signal(self: *Wakeup) void {
+        if (self.pending.swap(true, .seq_cst)) return;
+        if (use_eventfd) {
+            const one: u64 = 1;
+            _ = posix.write(self.write_fd, std.mem.asBytes(&one)) catch {};
+        } else {
+            const buf = [_]u8{1};
+            // A full pipe already guarantees a pending wakeup
+            _ = posix.write(self.write_fd, &buf) catch {};
+        }
+    }
+
+    /// Read the descriptor empty and re-arm signal. Called by the poll thread
+    /// when read_fd is readable, before draining.
+    pub fn consume(self: *Wakeup) void {
+        if (use_eventfd) {
+            // Reading an eventfd resets its counter
+            var value: u64 = 0;
+            _ = posix.read(self.read_fd, std.mem.asBytes(&value)) catch {};
+        } else {
+            var buf: [64]u8 = undefined;
+            while (true) {
+                const n = posix.read(self.read_fd, &buf) catch break;
+                if (n < buf.len) break;
+            }
+        }
+        self.rearm();
+    }
+
+    /// Re-arm signal after the descriptor was read some other way (the
+    /// io_uring backend reads it through the ring).
+    pub fn rearm(self: *Wakeup) void {
+        self.pending.store(false, .seq_cst);
+    }
+};
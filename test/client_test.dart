@@ -1,6 +1,9 @@
 @Tags(['redis'])
 library;
 
+import 'dart:convert';
+import 'dart:typed_data';
+
 import 'package:redis_ffi/redis_ffi.dart';
 import 'package:test/test.dart';
 
@@ -26,6 +29,65 @@ void main() {
       expect(await client.ping('hello'), equals('hello'));
     });
 
+    test('sendCommand is binary-safe', () async {
+      final blob = Uint8List.fromList([0, 255, 13, 10, 0xc3, 0x28]);
+      expect(
+        await client.sendCommand(['SET', 'raw_key', blob]),
+        equals('OK'),
+      );
+      expect(await client.sendCommand(['GET', 'raw_key']), equals(blob));
+      expect(await client.sendCommand(['STRLEN', 'raw_key']), equals(6));
+      expect(await client.sendCommand(['GET', 'raw_missing']), isNull);
+      expect(
+        await client.sendCommand(['MGET', 'raw_key', 'raw_missing']),
+        equals([blob, null]),
+      );
+      await client.sendCommand(['DEL', 'raw_key']);
+    });
+
+    test('sendCommand decodes nested replies', () async {
+      final reply = await client.sendCommand([
+        'EVAL',
+        "return {1, {'a', {2, 'b'}}, {}, 'c'}",
+        '0',
+      ]);
+      expect(
+        reply,
+        equals([
+          1,
+          [
+            utf8.encode('a'),
+            [2, utf8.encode('b')],
+          ],
+          <Object?>[],
+          utf8.encode('c'),
+        ]),
+      );
+    });
+
+    test('sendCommand surfaces error replies', () async {
+      await expectLater(
+        client.sendCommand(['NOT_A_COMMAND']),
+        throwsA(isA<RedisException>()),
+      );
+    });
+
+    test('a command hiredis rejects fails without shifting replies', () async {
+      // hiredis refuses UNSUBSCRIBE on a connection that is not subscribed,
+      // while the commands sent with it are still waiting for their replies
+      final before = [for (var i = 0; i < 10; i++) client.ping('before $i')];
+      final rejected = client.sendCommand(['UNSUBSCRIBE']);
+      final after = client.ping('after');
+
+      await expectLater(rejected, throwsA(isA<RedisException>()));
+      expect(
+        await Future.wait(before),
+        equals([for (var i = 0; i < 10; i++) 'before $i']),
+      );
+      expect(await after, equals('after'));
+      expect(await client.ping(), equals('PONG'));
+    });
+
     test('concurrent commands are automatically pipelined', () async {
       // Clean up first
       await client.del(['pipe1', 'pipe2']);
@@ -57,5 +119,126 @@ void main() {
 
       await client.del(['seq_key']);
     });
+
+    test('idle connection does not spin the poll thread', () async {
+      await client.ping();
+      final before = client.stats();
+      await Future<void>.delayed(const Duration(milliseconds: 200));
+      final after = client.stats();
+
+      expect(after.pollWakeups - before.pollWakeups, lessThan(5));
+      expect(after.spuriousWakeups, equals(before.spuriousWakeups));
+    });
+
+    test('pipelined replies share port messages', () async {
+      final before = client.stats();
+      await Future.wait([
+        for (var i = 0; i < 1000; i++) client.ping(),
+      ]);
+      final after = client.stats();
+
+      expect(after.replyMessages - before.replyMessages, lessThan(1000));
+    });
+
+    test('reply batch limits are honoured', () async {
+      final limited = await RedisClient.connect(
+        'localhost',
+        6379,
+        maxReplyBatchSize: 1,
+      );
+      try {
+        final before = limited.stats();
+        final replies = await Future.wait([
+          for (var i = 0; i < 100; i++) limited.ping('m$i'),
+        ]);
+        final after = limited.stats();
+
+        expect(replies, [for (var i = 0; i < 100; i++) 'm$i']);
+        expect(after.replyMessages - before.replyMessages, equals(100));
+      } finally {
+        await limited.close();
+      }
+    });
+
+    test('command storage is recycled between batches', () async {
+      for (var round = 0; round < 3; round++) {
+        await Future.wait([
+          for (var i = 0; i < 50; i++) client.set('pool:$i', 'v$i'),
+        ]);
+      }
+      await client.del(List.generate(50, (i) => 'pool:$i'));
+
+      final stats = client.stats();
+      expect(stats.commandPoolHighWater, inInclusiveRange(1, 50));
+      expect(stats.commandPoolCached, greaterThan(0));
+      expect(stats.callbackPoolHighWater, greaterThan(0));
+      expect(stats.callbackPoolCached, greaterThan(0));
+    });
+
+    test('reports no latency histograms unless instrumented', () async {
+      await client.ping();
+      expect(client.stats().latency, isNull);
+    });
+
+    test('instrumented connection reports latency histograms', () async {
+      final instrumented = await RedisClient.connect(
+        'localhost',
+        6379,
+        instrument: true,
+      );
+      try {
+        await Future.wait([
+          for (var i = 0; i < 100; i++) instrumented.ping(),
+        ]);
+        final latency = instrumented.stats().latency!;
+
+        expect(latency.reply.count, greaterThanOrEqualTo(100));
+        expect(latency.queueWait.count, equals(latency.reply.count));
+        expect(latency.batchSize.count, equals(latency.drains));
+        expect(latency.delivery.count, greaterThan(0));
+        expect(latency.post.count, equals(latency.delivery.count));
+        expect(latency.write.count, greaterThan(0));
+        expect(latency.reply.valueAtPercentile(50), greaterThan(0));
+        expect(
+          latency.reply.valueAtPercentile(99),
+          greaterThanOrEqualTo(latency.reply.valueAtPercentile(50)),
+        );
+        expect(latency.bytesOut, greaterThan(0));
+        expect(latency.bytesIn, greaterThan(0));
+      } finally {
+        await instrumented.close();
+      }
+    });
+
+    test('ioUring connection round-trips small and large values', () async {
+      final uring = await RedisClient.connect(
+        'localhost',
+        6379,
+        ioUring: true,
+      );
+      try {
+        final large = 'x' * (256 * 1024);
+        await uring.set('test:uring:large', large);
+        final results = await Future.wait([
+          for (var i = 0; i < 1000; i++) uring.incr('test:uring:counter'),
+        ]);
+        expect(results.last, equals(1000));
+        expect(await uring.get('test:uring:large'), equals(large));
+
+        final before = uring.stats();
+        expect(before.ioUring, equals(canCreateIoUring()));
+        expect(before.pollWakeups, greaterThan(0));
+
+        // Nothing in flight may complete while the connection is idle
+        await Future<void>.delayed(const Duration(milliseconds: 200));
+        final after = uring.stats();
+        expect(after.pollWakeups - before.pollWakeups, lessThan(5));
+        expect(after.spuriousWakeups, equals(before.spuriousWakeups));
+
+        await uring.del(['test:uring:large', 'test:uring:counter']);
+      } finally {
+        await uring.close();
+      }
+    });
   });
 }
@@ -0,0 +1,366 @@
+library;
+
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:redis_ffi/redis_ffi.dart';
+import 'package:test/test.dart';
+
+/// A status reply.
+class _Status {
+  final String text;
+  const _Status(this.text);
+}
+
+/// An error reply.
+class _Error {
+  final String text;
+  const _Error(this.text);
+}
+
+/// Returned by [_FakeNode.intercept] to let the node answer itself.
+const _unhandled = Object();
+
+String _encode(Object? reply) => switch (reply) {
+  null => '\$-1\r\n',
+  int() => ':$reply\r\n',
+  _Status(:final text) => '+$text\r\n',
+  _Error(:final text) => '-$text\r\n',
+  String() => '\$${utf8.encode(reply).length}\r\n$reply\r\n',
+  List() => '*${reply.length}\r\n${reply.map(_encode).join()}',
+  _ => throw ArgumentError.value(reply, 'reply'),
+};
+
+/// The first command in [bytes] and the number of bytes it takes, or null
+/// if it is incomplete.
+(List<String>, int)? _parseCommand(List<int> bytes) {
+  int? lineEnd(int from) {
+    for (var i = from; i + 1 < bytes.length; i++) {
+      if (bytes[i] == 13 && bytes[i + 1] == 10) return i;
+    }
+    return null;
+  }
+
+  var end = lineEnd(0);
+  if (end == null) return null;
+  final count = int.parse(ascii.decode(bytes.sublist(1, end)));
+  var pos = end + 2;
+  final args = <String>[];
+  for (var i = 0; i < count; i++) {
+    end = lineEnd(pos);
+    if (end == null) return null;
+    final length = int.parse(ascii.decode(bytes.sublist(pos + 1, end)));
+    pos = end + 2;
+    if (bytes.length < pos + length + 2) return null;
+    args.add(utf8.decode(bytes.sublist(pos, pos + length)));
+    pos += length + 2;
+  }
+  return (args, pos);
+}
+
+/// Two fake primaries splitting the slots, speaking just enough RESP for
+/// the routing of [RedisClusterClient]: `CLUSTER SLOTS`, `ASKING` and a few
+/// key commands on an in-memory store.
+class _FakeCluster {
+  /// The node serving each slot, as `CLUSTER SLOTS` reports it.
+  final owners = <_FakeNode>[];
+
+  /// The node each slot is being migrated to, if any.
+  final migrating = <int, _FakeNode>{};
+
+  late final _FakeNode a;
+  late final _FakeNode b;
+
+  static Future<_FakeCluster> start() async {
+    final cluster = _FakeCluster();
+    cluster.a = await _FakeNode.start(cluster);
+    cluster.b = await _FakeNode.start(cluster);
+    cluster.owners.addAll([
+      for (var slot = 0; slot < 16384; slot++)
+        slot < 8192 ? cluster.a : cluster.b,
+    ]);
+    return cluster;
+  }
+
+  Future<void> close() async {
+    await a.close();
+    await b.close();
+  }
+
+  /// The `CLUSTER SLOTS` reply: one range per run of slots on a node.
+  List<Object?> slotsReply() {
+    final ranges = <Object?>[];
+    var start = 0;
+    for (var slot = 1; slot <= owners.length; slot++) {
+      if (slot < owners.length && owners[slot] == owners[start]) continue;
+      final node = owners[start];
+      ranges.add([
+        start,
+        slot - 1,
+        ['127.0.0.1', node.port, 'node${node.port}'],
+      ]);
+      start = slot;
+    }
+    return ranges;
+  }
+
+  /// A key in a slot [node] serves.
+  String keyOn(_FakeNode node, String prefix) {
+    for (var i = 0; ; i++) {
+      final key = '$prefix$i';
+      if (owners[RedisClusterClient.keySlot(key)] == node) return key;
+    }
+  }
+}
+
+class _FakeNode {
+  final _FakeCluster _cluster;
+  final ServerSocket _server;
+  final _sockets = <Socket>[];
+
+  final data = <String, String>{};
+
+  /// Every command received, in order.
+  final received = <List<String>>[];
+
+  /// Answers a command before the node does, unless it returns
+  /// [_unhandled].
+  Object? Function(List<String> command) intercept = (_) => _unhandled;
+
+  _FakeNode._(this._cluster, this._server) {
+    _server.listen(_serve);
+  }
+
+  static Future<_FakeNode> start(_FakeCluster cluster) async {
+    final server = await ServerSocket.bind(InternetAddress.loopbackIPv4, 0);
+    return _FakeNode._(cluster, server);
+  }
+
+  int get port => _server.port;
+  String get address => '127.0.0.1:$port';
+
+  Future<void> close() async {
+    await _server.close();
+    for (final socket in _sockets) {
+      socket.destroy();
+    }
+  }
+
+  void _serve(Socket socket) {
+    _sockets.add(socket);
+    final pending = <int>[];
+    var asking = false;
+    socket.listen((bytes) {
+      pending.addAll(bytes);
+      while (true) {
+        final parsed = _parseCommand(pending);
+        if (parsed == null) break;
+        final (command, length) = parsed;
+        pending.removeRange(0, length);
+        received.add(command);
+
+        final wasAsking = asking;
+        asking = command[0] == 'ASKING';
+        var reply = intercept(command);
+        if (identical(reply, _unhandled)) reply = _answer(command, wasAsking);
+        socket.add(utf8.encode(_encode(reply)));
+      }
+    }, onError: (_) {});
+  }
+
+  Object? _answer(List<String> command, bool asking) {
+    final args = command.sublist(1);
+    switch (command[0]) {
+      case 'CLUSTER':
+        return _cluster.slotsReply();
+      case 'ASKING':
+        return const _Status('OK');
+      case 'DBSIZE':
+        return data.length;
+      case 'KEYS':
+        return data.keys.toList();
+      case 'FLUSHDB':
+        data.clear();
+        return const _Status('OK');
+    }
+
+    if (args.isEmpty) return _Error('ERR unknown command ${command[0]}');
+
+    // Key commands are answered for the slots this node serves
+    final slot = RedisClusterClient.keySlot(args.first);
+    final target = _cluster.migrating[slot];
+    if (_cluster.owners[slot] != this) {
+      if (!(asking && target == this)) {
+        return _Error('MOVED $slot ${_cluster.owners[slot].address}');
+      }
+    } else if (target != null && !data.containsKey(args.first)) {
+      return _Error('ASK $slot ${target.address}');
+    }
+
+    switch (command[0]) {
+      case 'GET':
+        return data[args[0]];
+      case 'SET':
+        data[args[0]] = args[1];
+        return const _Status('OK');
+      case 'MGET':
+        return [for (final key in args) data[key]];
+      case 'MSET':
+        for (var i = 0; i < args.length; i += 2) {
+          data[args[i]] = args[i + 1];
+        }
+        return const _Status('OK');
+      case 'DEL':
+        return args.where((key) => data.remove(key) != null).length;
+    }
+    return _Error('ERR unknown command ${command[0]}');
+  }
+
+  /// The commands named [name] received.
+  List<List<String>> commands(String name) => [
+    for (final command in received)
+      if (command[0] == name) command,
+  ];
+}
+
+void main() {
+  group('RedisClusterClient', () {
+    late _FakeCluster nodes;
+    late RedisClusterClient cluster;
+
+    setUp(() async {
+      nodes = await _FakeCluster.start();
+      cluster = await RedisClusterClient.connect([
+        ('127.0.0.1', nodes.a.port),
+      ]);
+    });
+
+    tearDown(() async {
+      await cluster.close();
+      await nodes.close();
+    });
+
+    test('routes commands to the node serving their slot', () async {
+      final onA = nodes.keyOn(nodes.a, 'route:');
+      final onB = nodes.keyOn(nodes.b, 'route:');
+      await cluster.set(onA, 'a');
+      await cluster.set(onB, 'b');
+      expect(nodes.a.data, equals({onA: 'a'}));
+      expect(nodes.b.data, equals({onB: 'b'}));
+    });
+
+    test('follows MOVED and updates the slot map', () async {
+      final key = nodes.keyOn(nodes.a, 'moved:');
+      nodes.owners[RedisClusterClient.keySlot(key)] = nodes.b;
+      nodes.b.data[key] = 'moved';
+
+      expect(await cluster.get(key), equals('moved'));
+      expect(await cluster.get(key), equals('moved'));
+      expect(nodes.a.commands('GET'), hasLength(1));
+      expect(nodes.b.commands('GET'), hasLength(2));
+    });
+
+    test('follows ASK with ASKING, without updating the slot map', () async {
+      final key = nodes.keyOn(nodes.a, 'ask:');
+      nodes.migrating[RedisClusterClient.keySlot(key)] = nodes.b;
+      nodes.b.data[key] = 'asked';
+
+      expect(await cluster.get(key), equals('asked'));
+      expect(await cluster.get(key), equals('asked'));
+      expect(nodes.a.commands('GET'), hasLength(2));
+
+      // ASKING directly precedes every redirected command
+      final received = nodes.b.received;
+      expect(received, hasLength(4));
+      for (var i = 0; i < received.length; i += 2) {
+        expect(received[i], equals(['ASKING']));
+        expect(received[i + 1], equals(['GET', key]));
+      }
+    });
+
+    test('retries after TRYAGAIN', () async {
+      final key = nodes.keyOn(nodes.a, 'tryagain:');
+      nodes.a.data[key] = 'value';
+      var refused = false;
+      nodes.a.intercept = (command) {
+        if (command[0] != 'GET' || refused) return _unhandled;
+        refused = true;
+        return const _Error('TRYAGAIN Multiple keys request during rehashing');
+      };
+
+      expect(await cluster.get(key), equals('value'));
+      expect(nodes.a.commands('GET'), hasLength(2));
+    });
+
+    test('gives up after too many redirects', () async {
+      final key = nodes.keyOn(nodes.a, 'loop:');
+      final slot = RedisClusterClient.keySlot(key);
+      nodes.a.intercept = (command) => command[0] == 'GET'
+          ? _Error('ASK $slot ${nodes.b.address}')
+          : _unhandled;
+      nodes.b.intercept = (command) => command[0] == 'GET'
+          ? _Error('ASK $slot ${nodes.a.address}')
+          : _unhandled;
+
+      await expectLater(cluster.get(key), throwsA(isA<RedisException>()));
+    });
+
+    test('splits MGET, MSET and DEL by slot and merges the replies', () async {
+      final onA = [for (var i = 0; i < 3; i++) nodes.keyOn(nodes.a, 'a$i:')];
+      final onB = [for (var i = 0; i < 3; i++) nodes.keyOn(nodes.b, 'b$i:')];
+      final keys = [for (var i = 0; i < 3; i++) ...[onA[i], onB[i]]];
+      await cluster.mset({for (final key in keys) key: 'v:$key'});
+      expect(nodes.a.commands('MSET'), hasLength(1));
+      expect(nodes.b.commands('MSET'), hasLength(1));
+      expect(nodes.a.data.keys, unorderedEquals(onA));
+      expect(nodes.b.data.keys, unorderedEquals(onB));
+
+      expect(
+        await cluster.mget([...keys, 'missing']),
+        equals([for (final key in keys) 'v:$key', null]),
+      );
+      expect(await cluster.del([...keys, 'missing']), equals(keys.length));
+      expect(nodes.a.data, isEmpty);
+      expect(nodes.b.data, isEmpty);
+    });
+
+    test('sends keyspace-wide commands to every primary', () async {
+      final onA = nodes.keyOn(nodes.a, 'all:');
+      final onB = nodes.keyOn(nodes.b, 'all:');
+      nodes.a.data[onA] = '1';
+      nodes.b.data[onB] = '2';
+
+      expect(await cluster.sendCommand(['DBSIZE']), equals(2));
+      expect(await cluster.keys('*'), unorderedEquals([onA, onB]));
+      expect(await cluster.sendCommand(['FLUSHDB']), equals('OK'));
+      expect(nodes.a.data, isEmpty);
+      expect(nodes.b.data, isEmpty);
+    });
+
+    test('rejects commands that concern a single node', () async {
+      await expectLater(
+        cluster.sendCommand(['INFO']),
+        throwsA(isA<UnsupportedError>()),
+      );
+      await expectLater(cluster.scan('0'), throwsA(isA<UnsupportedError>()));
+    });
+
+    test('loads the slot map past a seed that cannot be reached', () async {
+      final unused = await ServerSocket.bind(InternetAddress.loopbackIPv4, 0);
+      final port = unused.port;
+      await unused.close();
+
+      final other = await RedisClusterClient.connect([
+        ('127.0.0.1', port),
+        ('127.0.0.1', nodes.a.port),
+      ]);
+      try {
+        final key = nodes.keyOn(nodes.b, 'seed:');
+        await other.set(key, 'value');
+        expect(nodes.b.data[key], equals('value'));
+      } finally {
+        await other.close();
+      }
+    });
+  });
+}
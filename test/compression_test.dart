@@ -0,0 +1,143 @@
+@Tags(['redis'])
+library;
+
+import 'dart:convert';
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:redis_ffi/redis_ffi.dart';
+import 'package:test/test.dart';
+
+import 'test_helper.dart';
+
+/// About 20 KB of JSON that compresses well.
+final _json = jsonEncode([
+  for (var i = 0; i < 200; i++)
+    {'id': i, 'name': 'item $i', 'tags': ['cache', 'json'], 'active': true},
+]);
+
+const _keys = ['codec:a', 'codec:b', 'codec:hash', 'codec:list'];
+
+void main() {
+  group('compression', () {
+    late RedisClient admin;
+    late RedisClient client;
+
+    setUp(() async {
+      admin = await createTestClient();
+      client = await RedisClient.connect(
+        'localhost',
+        6379,
+        compressionThreshold: 1024,
+      );
+      await admin.del(_keys);
+    });
+
+    tearDown(() async {
+      await admin.del(_keys);
+      await client.close();
+      await admin.close();
+    });
+
+    test('large values are stored compressed and read back', () async {
+      await client.set('codec:a', _json);
+      expect(await client.get('codec:a'), equals(_json));
+
+      // Without compression the stored bytes show the header and version
+      final stored = await admin.getBytes('codec:a');
+      expect(stored!.sublist(0, 5), equals([0, 0x4c, 0x5a, 0x34, 1]));
+      expect(stored.length, lessThan(_json.length ~/ 2));
+
+      final stats = client.stats();
+      expect(stats.valuesCompressed, equals(1));
+      expect(stats.valuesDecompressed, equals(1));
+    });
+
+    test('small and uncompressed values pass through', () async {
+      await client.set('codec:a', 'small');
+      await admin.set('codec:b', _json);
+      expect(await admin.get('codec:a'), equals('small'));
+      expect(await client.get('codec:b'), equals(_json));
+      expect(client.stats().valuesCompressed, equals(0));
+    });
+
+    test('values in multi-value commands and replies', () async {
+      await client.mset({'codec:a': _json, 'codec:b': 'small'});
+      expect(await client.mget(['codec:a', 'codec:b']), [_json, 'small']);
+
+      await client.hsetAll('codec:hash', {'f1': _json, 'f2': _json});
+      expect(await client.hgetall('codec:hash'), {'f1': _json, 'f2': _json});
+      expect(await admin.hkeys('codec:hash'), unorderedEquals(['f1', 'f2']));
+
+      await client.rpush('codec:list', [_json, 'small', _json]);
+      final list = await client.lrange('codec:list', 0, -1);
+      expect(list, equals([_json, 'small', _json]));
+    });
+
+    test('list elements are found by their value', () async {
+      final other = _json.replaceAll('item', 'part');
+      await client.rpush('codec:list', [_json, 'small', other, _json]);
+
+      expect(await client.lpos('codec:list', other), equals(2));
+      expect(
+        await client.linsert('codec:list', other, _json, before: true),
+        equals(5),
+      );
+      expect(await client.lrem('codec:list', 0, _json), equals(3));
+      expect(await client.lrange('codec:list', 0, -1), ['small', other]);
+    });
+
+    test('runs and repeated patterns round-trip', () async {
+      // Matches that overlap the bytes they produce
+      final run = 'a' * 100000;
+      final pattern = 'abc' * 30000;
+      await client.mset({'codec:a': run, 'codec:b': pattern});
+      expect(await client.mget(['codec:a', 'codec:b']), [run, pattern]);
+      expect((await admin.getBytes('codec:a'))!.length, lessThan(1000));
+    });
+
+    test('incompressible values are stored as they are', () async {
+      final random = Random(1);
+      final bytes = Uint8List.fromList([
+        for (var i = 0; i < 4096; i++) random.nextInt(256),
+      ]);
+      await client.sendCommand(['SET', 'codec:a', bytes]);
+      expect(await admin.getBytes('codec:a'), equals(bytes));
+      expect(await client.sendCommand(['GET', 'codec:a']), equals(bytes));
+      expect(client.stats().valuesCompressed, equals(0));
+    });
+
+    test('corrupt frames are returned as stored', () async {
+      await client.set('codec:a', _json);
+      final frame = (await admin.getBytes('codec:a'))!;
+
+      // A wrong checksum, and a length the body cannot produce
+      final badChecksum = Uint8List.fromList(frame)..[9] ^= 0xff;
+      final badLength = Uint8List.fromList(frame);
+      ByteData.sublistView(badLength).setUint32(5, 512 << 20, Endian.little);
+      await admin.sendCommand(['SET', 'codec:a', badChecksum]);
+      await admin.sendCommand(['SET', 'codec:b', badLength]);
+
+      expect(await client.getBytes('codec:a'), equals(badChecksum));
+      expect(await client.getBytes('codec:b'), equals(badLength));
+      expect(client.stats().valuesDecompressed, equals(0));
+    });
+
+    test('keys are never compressed', () async {
+      final key = 'codec:a${'k' * 2000}';
+      try {
+        await client.set(key, 'value');
+        expect(await admin.get(key), equals('value'));
+      } finally {
+        await admin.del([key]);
+      }
+    });
+
+    test('rejects a threshold below 1', () async {
+      await expectLater(
+        RedisClient.connect('localhost', 6379, compressionThreshold: 0),
+        throwsArgumentError,
+      );
+    });
+  });
+}
@@ -0,0 +1,112 @@
+@Tags(['redis'])
+library;
+
+import 'dart:isolate';
+
+import 'package:redis_ffi/redis_ffi.dart';
+import 'package:test/test.dart';
+
+import 'test_helper.dart';
+
+/// Attaches to [handle] in a new isolate and runs INCR [count] times there,
+/// returning the last value.
+Future<int> _incrInWorker(RedisConnectionHandle handle, int count) {
+  return Isolate.run(() async {
+    final client = handle.attach();
+    try {
+      var last = 0;
+      final futures = [
+        for (var i = 0; i < count; i++) client.incr('handle:counter'),
+      ];
+      for (final value in await Future.wait(futures)) {
+        if (value > last) last = value;
+      }
+      return last;
+    } finally {
+      await client.close();
+    }
+  });
+}
+
+/// Attaches to [handle] in a new isolate, signals [ready] and keeps the
+/// client until a message arrives on the port it sends back.
+Future<void> _attachAndWait(RedisConnectionHandle handle, SendPort ready) {
+  return Isolate.run(() async {
+    final client = handle.attach();
+    final done = ReceivePort();
+    ready.send(done.sendPort);
+    await done.first;
+    try {
+      await client.set('handle:worker', 'still-open');
+    } finally {
+      await client.close();
+    }
+  });
+}
+
+void main() {
+  group('RedisConnectionHandle', () {
+    late RedisClient client;
+
+    setUp(() async {
+      client = await createTestClient();
+      await client.del(['handle:counter', 'handle:worker']);
+    });
+
+    tearDown(() async {
+      await client.close();
+    });
+
+    test('workers share the connection', () async {
+      final results = await Future.wait([
+        for (var i = 0; i < 4; i++) _incrInWorker(client.handle(), 250),
+        for (var i = 0; i < 250; i++) client.incr('handle:counter'),
+      ]);
+      expect(results, hasLength(254));
+      expect(await client.get('handle:counter'), equals('1250'));
+    });
+
+    test('a handle attaches once', () async {
+      final handle = client.handle();
+      final shared = handle.attach();
+      expect(handle.attach, throwsStateError);
+      expect(await shared.ping(), equals('PONG'));
+      await shared.close();
+      expect(await client.ping(), equals('PONG'));
+    });
+
+    test('a released handle cannot attach', () async {
+      final handle = client.handle()..release();
+      expect(handle.attach, throwsStateError);
+      handle.release();
+    });
+
+    test('the connection outlives the owner while attached', () async {
+      final ready = ReceivePort();
+      final worker = _attachAndWait(client.handle(), ready.sendPort);
+      final done = await ready.first as SendPort;
+
+      await client.close();
+      done.send(null);
+      await worker;
+
+      client = await createTestClient();
+      expect(await client.get('handle:worker'), equals('still-open'));
+    });
+
+    test('clients on a reactor cannot be shared', () async {
+      final reactor = RedisReactor(threads: 1);
+      try {
+        final hosted = await RedisClient.connect(
+          'localhost',
+          6379,
+          reactor: reactor,
+        );
+        expect(hosted.handle, throwsStateError);
+        await hosted.close();
+      } finally {
+        await reactor.close();
+      }
+    });
+  });
+}
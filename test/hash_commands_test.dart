@@ -1,6 +1,8 @@
 @Tags(['redis'])
 library;
 
+import 'dart:typed_data';
+
 import 'package:redis_ffi/redis_ffi.dart';
 import 'package:test/test.dart';
 
@@ -39,6 +41,31 @@ void main() {
       await client.del(['hash2']);
     });
 
+    test('hsetBytes, hgetBytes and hgetallBytes', () async {
+      final a = Uint8List.fromList([0, 1, 2, 0xff]);
+      final b = Uint8List.fromList([0xc3, 0x28]);
+      expect(await client.hsetBytes('hash_bytes', 'a', a), equals(1));
+      expect(await client.hsetBytes('hash_bytes', 'b', b), equals(1));
+
+      expect(await client.hgetBytes('hash_bytes', 'b'), equals(b));
+      expect(
+        await client.hgetallBytes('hash_bytes'),
+        equals({'a': a, 'b': b}),
+      );
+
+      await client.del(['hash_bytes']);
+    });
+
+    test('hgetall with many fields', () async {
+      final fields = {for (var i = 0; i < 10000; i++) 'field$i': 'value$i'};
+      await client.hsetAll('hash_big', fields);
+
+      final all = await client.hgetall('hash_big');
+      expect(all, equals(fields));
+
+      await client.del(['hash_big']);
+    });
+
     test('hmget', () async {
       await client.hsetAll('hash3', {'a': '1', 'b': '2', 'c': '3'});
 
@@ -139,5 +166,18 @@ void main() {
 
       await client.del(['hash11']);
     });
+
+    test('hscanStream', () async {
+      final fields = {for (var i = 0; i < 300; i++) 'field$i': 'value$i'};
+      await client.hsetAll('hash12', fields);
+
+      final scanned = <String, String>{};
+      await for (final (field, value) in client.hscanStream('hash12')) {
+        scanned[field] = value;
+      }
+      expect(scanned, equals(fields));
+
+      await client.del(['hash12']);
+    });
   });
 }
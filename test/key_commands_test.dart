@@ -162,6 +162,31 @@ void main() {
       await client.del(allKeys);
     });
 
+    test('scanStream yields every matching key', () async {
+      final keys = [for (var i = 0; i < 500; i++) 'scan_stream_$i'];
+      await client.mset({for (final key in keys) key: 'value'});
+
+      final scanned = <String>{};
+      await for (final key in client.scanStream(
+        match: 'scan_stream_*',
+        count: 50,
+        prefetch: 3,
+      )) {
+        scanned.add(key);
+        // A slow listener lets pages queue up behind it
+        await Future<void>.delayed(Duration.zero);
+      }
+      expect(scanned, equals(keys.toSet()));
+
+      // Cancelling stops the iteration early
+      expect(
+        await client.scanStream(match: 'scan_stream_*').take(10).length,
+        equals(10),
+      );
+
+      await client.del(keys);
+    });
+
     test('touch updates last access time', () async {
       await client.set('touch1', 'value1');
       await client.set('touch2', 'value2');
@@ -75,6 +75,20 @@ void main() {
       await client.del(['list5']);
     });
 
+    test('lrange with empty, UTF-8 and large elements', () async {
+      // 64 KiB and up is sent zero-copy, outside the string table
+      final large = 'x' * (64 * 1024);
+      await client.rpush('list5b', ['', 'ünï', large, 'z']);
+
+      expect(
+        await client.lrange('list5b', 0, -1),
+        equals(['', 'ünï', large, 'z']),
+      );
+      expect(await client.lrange('list5b', 5, 10), isEmpty);
+
+      await client.del(['list5b']);
+    });
+
     test('lindex', () async {
       await client.rpush('list6', ['a', 'b', 'c']);
 
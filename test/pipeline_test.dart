@@ -0,0 +1,136 @@
+@Tags(['redis'])
+library;
+
+import 'package:redis_ffi/redis_ffi.dart';
+import 'package:test/test.dart';
+
+import 'test_helper.dart';
+
+void main() {
+  group('pipeline', () {
+    late RedisClient client;
+
+    setUp(() async {
+      client = await createTestClient();
+    });
+
+    tearDown(() async {
+      await client.close();
+    });
+
+    test('sends queued commands on execute', () async {
+      final pipeline = client.pipeline();
+      final set = pipeline.set('pipeline:a', '1');
+      final incr = pipeline.incr('pipeline:a');
+      final get = pipeline.get('pipeline:a');
+      final members = pipeline.lrange('pipeline:missing', 0, -1);
+      expect(pipeline.length, equals(4));
+
+      // Nothing is sent before execute
+      expect(await client.get('pipeline:a'), isNull);
+
+      final results = await pipeline.execute();
+      expect(results, hasLength(4));
+      expect(results[1], equals(2));
+      expect(await set, equals('OK'));
+      expect(await incr, equals(2));
+      expect(await get, equals('2'));
+      expect(await members, isEmpty);
+
+      expect(() => pipeline.execute(), throwsStateError);
+      await client.del(['pipeline:a']);
+    });
+
+    test('reports error replies per command', () async {
+      await client.set('pipeline:text', 'abc');
+      final pipeline = client.pipeline();
+      final failing = pipeline.incr('pipeline:text');
+      final ok = pipeline.get('pipeline:text');
+
+      final results = await pipeline.execute();
+      expect(results[0], isA<RedisException>());
+      await expectLater(failing, throwsA(isA<RedisException>()));
+      expect(await ok, equals('abc'));
+
+      await client.del(['pipeline:text']);
+    });
+  });
+
+  group('transaction', () {
+    late RedisClient client;
+    late RedisClient other;
+
+    setUp(() async {
+      client = await createTestClient();
+      other = await createTestClient();
+    });
+
+    tearDown(() async {
+      await client.close();
+      await other.close();
+    });
+
+    test('runs commands atomically', () async {
+      final transaction = client.transaction();
+      final incr = transaction.incr('tx:counter');
+      transaction.expire('tx:counter', 60);
+      final get = transaction.get('tx:counter');
+
+      final results = await transaction.execute();
+      expect(results, hasLength(3));
+      expect(results![0], equals(1));
+      expect(await incr, equals(1));
+      expect(await get, equals('1'));
+
+      await client.del(['tx:counter']);
+    });
+
+    test('is discarded when a watched key changes', () async {
+      await client.set('tx:balance', '100');
+      await client.watch(['tx:balance']);
+      final balance = int.parse((await client.get('tx:balance'))!);
+
+      await other.set('tx:balance', '50');
+
+      final transaction = client.transaction();
+      final set = transaction.set('tx:balance', '${balance - 10}');
+      expect(await transaction.execute(), isNull);
+      expect(await set, isNull);
+      expect(await client.get('tx:balance'), equals('50'));
+
+      await client.del(['tx:balance']);
+    });
+
+    test('a discarded cascade raises no uncaught errors', () async {
+      await client.del(['tx:balance', 'tx:log']);
+      await client.set('tx:balance', '100');
+
+      // The example of RedisTransaction, with the balance changed meanwhile
+      await client.watch(['tx:balance']);
+      final balance = int.parse(await client.get('tx:balance') ?? '0');
+      await other.set('tx:balance', '50');
+      final transaction = client.transaction()
+        ..set('tx:balance', '${balance - 10}')
+        ..rpush('tx:log', ['-10']);
+      expect(await transaction.execute(), isNull);
+
+      // Let unhandled errors of the cascade's futures surface
+      await Future<void>.delayed(Duration.zero);
+      expect(await client.get('tx:balance'), equals('50'));
+      expect(await client.exists('tx:log'), isFalse);
+
+      await client.del(['tx:balance']);
+    });
+
+    test('fails as a whole when a command cannot be queued', () async {
+      final transaction = client.transaction();
+      final bad = transaction.sendCommand(['NOT_A_COMMAND']);
+      final set = transaction.set('tx:never', '1');
+
+      await expectLater(transaction.execute(), throwsA(isA<RedisException>()));
+      expect(await bad, isNull);
+      expect(await set, isNull);
+      expect(await client.exists('tx:never'), isFalse);
+    });
+  });
+}
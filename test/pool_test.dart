@@ -0,0 +1,71 @@
+@Tags(['redis'])
+library;
+
+import 'package:redis_ffi/redis_ffi.dart';
+import 'package:test/test.dart';
+
+void main() {
+  group('RedisPool', () {
+    late RedisPool pool;
+
+    setUp(() async {
+      pool = await RedisPool.connect('localhost', 6379, size: 3);
+    });
+
+    tearDown(() async {
+      await pool.close();
+    });
+
+    test('runs commands across the pool', () async {
+      expect(pool.size, equals(3));
+
+      for (var round = 0; round < 10; round++) {
+        await Future.wait([
+          for (var i = 0; i < 10; i++) pool.set('pool:key:$round:$i', '$i'),
+        ]);
+      }
+      for (var round = 0; round < 10; round++) {
+        final values = await Future.wait([
+          for (var i = 0; i < 10; i++) pool.get('pool:key:$round:$i'),
+        ]);
+        expect(values, equals([for (var i = 0; i < 10; i++) '$i']));
+      }
+
+      await pool.del([
+        for (var round = 0; round < 10; round++)
+          for (var i = 0; i < 10; i++) 'pool:key:$round:$i',
+      ]);
+    });
+
+    test('spreads concurrent batches over connections', () async {
+      final futures = <Future<Object?>>[];
+      for (var batch = 0; batch < 6; batch++) {
+        futures.add(pool.ping());
+        // End the microtask batch without waiting for its reply
+        await Future<void>.value();
+      }
+      await Future.wait(futures);
+
+      final used = pool.stats().where((s) => s.replyMessages > 0);
+      expect(used.length, greaterThan(1));
+    });
+
+    test('withConnection keeps connection state', () async {
+      final result = await pool.withConnection((client) async {
+        await client.sendCommand(['WATCH', 'pool:watched']);
+        await client.sendCommand(['MULTI']);
+        await client.sendCommand(['SET', 'pool:watched', 'done']);
+        return client.sendCommand(['EXEC']);
+      });
+      expect(result, isA<List<Object?>>());
+      expect(await pool.get('pool:watched'), equals('done'));
+      await pool.del(['pool:watched']);
+    });
+
+    test('throws after close', () async {
+      await pool.close();
+      expect(pool.isClosed, isTrue);
+      expect(() => pool.ping(), throwsStateError);
+    });
+  });
+}
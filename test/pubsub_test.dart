@@ -1,6 +1,8 @@
 @Tags(['redis', 'pubsub'])
 library;
 
+import 'dart:async';
+
 import 'package:redis_ffi/redis_ffi.dart';
 import 'package:test/test.dart';
 
@@ -67,6 +69,141 @@ void main() {
       expect(messages.length, greaterThanOrEqualTo(1));
     });
 
+    test('streams share one subscriber connection', () async {
+      final first = <RedisPubSubMessage>[];
+      final second = <RedisPubSubMessage>[];
+      final other = <RedisPubSubMessage>[];
+
+      final sub1 = subscriber
+          .subscribe(channels: ['shared-channel'])
+          .listen(first.add);
+      final sub2 = subscriber
+          .subscribe(channels: ['shared-channel'])
+          .listen(second.add);
+      final sub3 = subscriber
+          .subscribe(channels: ['other-channel'])
+          .listen(other.add);
+      await Future<void>.delayed(const Duration(milliseconds: 100));
+
+      final numsub = await publisher.sendCommand([
+        'PUBSUB',
+        'NUMSUB',
+        'shared-channel',
+        'other-channel',
+      ]);
+      expect(numsub, equals(['shared-channel', 1, 'other-channel', 1]));
+
+      await publisher.publish('shared-channel', 'both');
+      await publisher.publish('other-channel', 'other');
+      await Future<void>.delayed(const Duration(milliseconds: 100));
+
+      bool isMessage(RedisPubSubMessage m) =>
+          m.type == RedisPubSubMessageType.message;
+      expect(first.where(isMessage).map((m) => m.message), equals(['both']));
+      expect(second.where(isMessage).map((m) => m.message), equals(['both']));
+      expect(other.where(isMessage).map((m) => m.message), equals(['other']));
+      expect(
+        second.where((m) => m.type == RedisPubSubMessageType.subscribe),
+        hasLength(1),
+      );
+
+      // The channel stays subscribed while it has a listener
+      await sub1.cancel();
+      await Future<void>.delayed(const Duration(milliseconds: 50));
+      await publisher.publish('shared-channel', 'second only');
+      await Future<void>.delayed(const Duration(milliseconds: 100));
+      expect(first.where(isMessage), hasLength(1));
+      expect(second.where(isMessage), hasLength(2));
+
+      await sub2.cancel();
+      await Future<void>.delayed(const Duration(milliseconds: 100));
+      final afterCancel = await publisher.sendCommand([
+        'PUBSUB',
+        'NUMSUB',
+        'shared-channel',
+      ]);
+      expect(afterCancel, equals(['shared-channel', 0]));
+
+      await sub3.cancel();
+    });
+
+    test('client close ends subscription streams', () async {
+      final done = Completer<void>();
+      subscriber
+          .subscribe(channels: ['closing-channel'])
+          .listen((_) {}, onDone: done.complete);
+      await Future<void>.delayed(const Duration(milliseconds: 50));
+
+      await subscriber.close();
+      await done.future.timeout(const Duration(seconds: 1));
+    });
+
+    group('with a subscription buffer', () {
+      Future<void> publishBurst(String channel, int count) async {
+        await Future.wait([
+          for (var i = 0; i < count; i++) publisher.publish(channel, '$i'),
+        ]);
+      }
+
+      test('drops the oldest messages for a paused listener', () async {
+        final client = await RedisClient.connect(
+          'localhost',
+          6379,
+          subscriptionBufferSize: 10,
+        );
+        final received = <String?>[];
+        final subscription = client
+            .subscribe(channels: ['buffer-oldest'])
+            .where((m) => m.type == RedisPubSubMessageType.message)
+            .listen((m) => received.add(m.message));
+        await Future<void>.delayed(const Duration(milliseconds: 100));
+
+        subscription.pause();
+        await publishBurst('buffer-oldest', 100);
+        await Future<void>.delayed(const Duration(milliseconds: 100));
+
+        final stats = client.subscriptionStats();
+        expect(stats.dropped, greaterThan(0));
+        expect(stats.queued, lessThanOrEqualTo(10));
+
+        subscription.resume();
+        await Future<void>.delayed(const Duration(milliseconds: 100));
+        expect(received.length, lessThan(100));
+        expect(received.last, equals('99'));
+
+        await subscription.cancel();
+        await client.close();
+      });
+
+      test('pauses reading instead of dropping', () async {
+        final client = await RedisClient.connect(
+          'localhost',
+          6379,
+          subscriptionBufferSize: 10,
+          subscriptionOverflow: RedisPubSubOverflow.pause,
+        );
+        final received = <String?>[];
+        final subscription = client
+            .subscribe(channels: ['buffer-pause'])
+            .where((m) => m.type == RedisPubSubMessageType.message)
+            .listen((m) => received.add(m.message));
+        await Future<void>.delayed(const Duration(milliseconds: 100));
+
+        subscription.pause();
+        await publishBurst('buffer-pause', 100);
+        await Future<void>.delayed(const Duration(milliseconds: 100));
+        expect(client.subscriptionStats().readPauses, greaterThan(0));
+
+        subscription.resume();
+        await Future<void>.delayed(const Duration(milliseconds: 200));
+        expect(received, equals([for (var i = 0; i < 100; i++) '$i']));
+        expect(client.subscriptionStats().dropped, equals(0));
+
+        await subscription.cancel();
+        await client.close();
+      });
+    });
+
     test('close stops the client', () async {
       final subscription = subscriber
           .subscribe(channels: ['close-test'])
@@ -0,0 +1,91 @@
+@Tags(['redis'])
+library;
+
+import 'package:redis_ffi/redis_ffi.dart';
+import 'package:test/test.dart';
+
+void main() {
+  group('RedisReactor', () {
+    late RedisReactor reactor;
+
+    setUp(() {
+      reactor = RedisReactor(threads: 2);
+    });
+
+    tearDown(() async {
+      await reactor.close();
+    });
+
+    test('hosts many clients on a few threads', () async {
+      final clients = [
+        for (var i = 0; i < 16; i++)
+          await RedisClient.connect('localhost', 6379, reactor: reactor),
+      ];
+
+      final results = await Future.wait([
+        for (var i = 0; i < clients.length; i++)
+          clients[i]
+              .set('reactor:key:$i', 'value-$i')
+              .then((_) => clients[i].get('reactor:key:$i')),
+      ]);
+      for (var i = 0; i < clients.length; i++) {
+        expect(results[i], equals('value-$i'));
+      }
+
+      await clients.first.del(
+        List.generate(clients.length, (i) => 'reactor:key:$i'),
+      );
+      for (final client in clients) {
+        await client.close();
+      }
+    });
+
+    test('subscriptions run on the reactor', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        reactor: reactor,
+      );
+      final messages = <RedisPubSubMessage>[];
+      final subscription = client
+          .subscribe(channels: ['reactor-channel'])
+          .listen(messages.add);
+
+      await Future<void>.delayed(const Duration(milliseconds: 100));
+      await client.publish('reactor-channel', 'hello');
+      await Future<void>.delayed(const Duration(milliseconds: 100));
+
+      expect(
+        messages.where((m) => m.type == RedisPubSubMessageType.message),
+        [
+          isA<RedisPubSubMessage>().having(
+            (m) => m.message,
+            'message',
+            'hello',
+          ),
+        ],
+      );
+
+      await subscription.cancel();
+      await client.close();
+    });
+
+    test('close() closes hosted clients', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        reactor: reactor,
+      );
+      expect(await client.ping(), equals('PONG'));
+
+      await reactor.close();
+
+      expect(reactor.isClosed, isTrue);
+      expect(() => client.ping(), throwsStateError);
+      expect(
+        () => RedisClient.connect('localhost', 6379, reactor: reactor),
+        throwsStateError,
+      );
+    });
+  });
+}
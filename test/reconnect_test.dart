@@ -0,0 +1,188 @@
+@Tags(['redis'])
+library;
+
+import 'dart:async';
+import 'dart:convert';
+
+import 'package:redis_ffi/redis_ffi.dart';
+import 'package:test/test.dart';
+
+import 'test_helper.dart';
+
+const _fast = RedisReconnectOptions(
+  initialDelay: Duration(milliseconds: 10),
+  maxDelay: Duration(milliseconds: 100),
+);
+
+/// Waits until [client] has reconnected [count] times.
+Future<void> _reconnected(RedisClient client, int count) async {
+  final deadline = DateTime.now().add(const Duration(seconds: 10));
+  while (client.stats().reconnects < count ||
+      client.connectionState != RedisConnectionState.connected) {
+    if (DateTime.now().isAfter(deadline)) {
+      fail('Not reconnected: ${client.connectionState}');
+    }
+    await Future<void>.delayed(const Duration(milliseconds: 10));
+  }
+}
+
+void main() {
+  group('reconnect', () {
+    late RedisClient admin;
+
+    setUp(() async {
+      admin = await createTestClient();
+      await admin.del(['reconnect:list', 'reconnect:key']);
+    });
+
+    tearDown(() async {
+      await admin.del(['reconnect:list', 'reconnect:key']);
+      await admin.close();
+    });
+
+    Future<void> kill(RedisClient client) async {
+      final id = await client.sendCommand(['CLIENT', 'ID']);
+      await admin.sendCommand(['CLIENT', 'KILL', 'ID', '$id']);
+    }
+
+    test('commands go through after the connection is killed', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        reconnect: _fast,
+      );
+      try {
+        expect(await client.ping(), equals('PONG'));
+        expect(client.connectionState, RedisConnectionState.connected);
+
+        await kill(client);
+        await _reconnected(client, 1);
+        expect(await client.ping(), equals('PONG'));
+      } finally {
+        await client.close();
+      }
+      expect(client.connectionState, RedisConnectionState.disconnected);
+    });
+
+    test('the session is set up again', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        reconnect: _fast,
+      );
+      try {
+        await client.sendCommand(['SELECT', '1']);
+        await client.sendCommand(['CLIENT', 'SETNAME', 'reconnect-test']);
+        await client.set('reconnect:key', 'db1');
+
+        await kill(client);
+        await _reconnected(client, 1);
+        expect(await client.get('reconnect:key'), equals('db1'));
+        final name = await client.sendCommand(['CLIENT', 'GETNAME']);
+        expect(utf8.decode(name! as List<int>), equals('reconnect-test'));
+        await client.del(['reconnect:key']);
+      } finally {
+        await client.close();
+      }
+      expect(await admin.get('reconnect:key'), isNull);
+    });
+
+    test('in-flight writes fail by default', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        reconnect: _fast,
+      );
+      try {
+        final id = await client.sendCommand(['CLIENT', 'ID']);
+        final blocked = client.sendCommand(['BLPOP', 'reconnect:list', '0']);
+        await Future<void>.delayed(const Duration(milliseconds: 50));
+        await admin.sendCommand(['CLIENT', 'KILL', 'ID', '$id']);
+
+        await expectLater(blocked, throwsA(isA<RedisException>()));
+        await _reconnected(client, 1);
+      } finally {
+        await client.close();
+      }
+    });
+
+    test('RedisReplayPolicy.always sends them again', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        reconnect: const RedisReconnectOptions(
+          initialDelay: Duration(milliseconds: 10),
+          replay: RedisReplayPolicy.always,
+        ),
+      );
+      try {
+        final id = await client.sendCommand(['CLIENT', 'ID']);
+        final blocked = client.sendCommand(['BLPOP', 'reconnect:list', '0']);
+        await Future<void>.delayed(const Duration(milliseconds: 50));
+        await admin.sendCommand(['CLIENT', 'KILL', 'ID', '$id']);
+
+        await _reconnected(client, 1);
+        // Wait for the replayed BLPOP to block again
+        await Future<void>.delayed(const Duration(milliseconds: 50));
+        await admin.rpush('reconnect:list', ['value']);
+        expect(await blocked, hasLength(2));
+      } finally {
+        await client.close();
+      }
+    });
+
+    test('subscriptions are renewed', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        reconnect: _fast,
+      );
+      final messages = StreamController<String?>();
+      final subscription = client
+          .subscribe(channels: ['reconnect:channel'])
+          .listen((message) {
+            if (message.type == RedisPubSubMessageType.message) {
+              messages.add(message.message);
+            }
+          });
+      try {
+        final received = StreamIterator(messages.stream);
+        while (await admin.publish('reconnect:channel', 'first') == 0) {
+          await Future<void>.delayed(const Duration(milliseconds: 10));
+        }
+        expect(await received.moveNext(), isTrue);
+        expect(received.current, equals('first'));
+
+        await admin.sendCommand(['CLIENT', 'KILL', 'TYPE', 'pubsub']);
+        final deadline = DateTime.now().add(const Duration(seconds: 10));
+        while (await admin.publish('reconnect:channel', 'second') == 0) {
+          if (DateTime.now().isAfter(deadline)) fail('Not resubscribed');
+          await Future<void>.delayed(const Duration(milliseconds: 10));
+        }
+        expect(await received.moveNext(), isTrue);
+        expect(received.current, equals('second'));
+      } finally {
+        await subscription.cancel();
+        await messages.close();
+        await client.close();
+      }
+    });
+
+    test('requires a client without a reactor', () async {
+      final reactor = RedisReactor(threads: 1);
+      try {
+        await expectLater(
+          RedisClient.connect(
+            'localhost',
+            6379,
+            reactor: reactor,
+            reconnect: _fast,
+          ),
+          throwsArgumentError,
+        );
+      } finally {
+        await reactor.close();
+      }
+    });
+  });
+}
@@ -0,0 +1,167 @@
+@Tags(['redis'])
+library;
+
+import 'package:redis_ffi/redis_ffi.dart';
+import 'package:test/test.dart';
+
+import 'test_helper.dart';
+
+void main() {
+  group('RESP3', () {
+    late RedisClient client;
+
+    setUp(() async {
+      client = await RedisClient.connect('localhost', 6379, protocol: 3);
+    });
+
+    tearDown(() async {
+      await client.close();
+    });
+
+    test('decodes maps, doubles and typed commands', () async {
+      await client.hsetAll('resp3:hash', {'a': '1', 'b': '2'});
+      await client.zadd('resp3:zset', {'x': 1.5, 'y': 2});
+
+      final map = await client.sendCommand(['HGETALL', 'resp3:hash']);
+      expect(map, isA<Map<Object?, Object?>>());
+      expect((map as Map).keys, unorderedEquals(['a', 'b']));
+      expect(await client.hgetall('resp3:hash'), equals({'a': '1', 'b': '2'}));
+
+      expect(
+        await client.sendCommand(['ZSCORE', 'resp3:zset', 'x']),
+        equals(1.5),
+      );
+      expect(
+        await client.zrangeWithScores('resp3:zset', 0, -1),
+        equals([('x', 1.5), ('y', 2.0)]),
+      );
+      expect(await client.zpopmin('resp3:zset', count: 2), hasLength(2));
+
+      await client.del(['resp3:hash', 'resp3:zset']);
+    });
+
+    test('rejects a cache without RESP3', () {
+      expect(
+        () => RedisClient.connect(
+          'localhost',
+          6379,
+          cache: const RedisCacheOptions(),
+        ),
+        throwsArgumentError,
+      );
+    });
+  });
+
+  group('client-side cache', () {
+    late RedisClient writer;
+
+    setUp(() async {
+      writer = await createTestClient();
+    });
+
+    tearDown(() async {
+      await writer.del(['cache:a', 'cache:h', 'other:b']);
+      await writer.close();
+    });
+
+    for (final mode in RedisTrackingMode.values) {
+      test('serves repeated reads locally (${mode.name})', () async {
+        final client = await RedisClient.connect(
+          'localhost',
+          6379,
+          protocol: 3,
+          cache: RedisCacheOptions(mode: mode, prefixes: ['cache:']),
+        );
+        await writer.set('cache:a', 'one');
+        await writer.hset('cache:h', 'f', 'x');
+
+        expect(await client.get('cache:a'), equals('one'));
+        expect(await client.get('cache:a'), equals('one'));
+        expect(await client.hget('cache:h', 'f'), equals('x'));
+        expect(await client.hget('cache:h', 'f'), equals('x'));
+        var stats = client.cacheStats()!;
+        expect(stats.hits, equals(2));
+        expect(stats.size, equals(2));
+
+        // Another client's write arrives as an invalidation
+        await writer.set('cache:a', 'two');
+        await Future<void>.delayed(const Duration(milliseconds: 50));
+        expect(await client.get('cache:a'), equals('two'));
+        stats = client.cacheStats()!;
+        expect(stats.invalidations, greaterThanOrEqualTo(1));
+
+        await client.close();
+      });
+    }
+
+    test('sees its own writes and skips other prefixes', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        protocol: 3,
+        cache: const RedisCacheOptions(prefixes: ['cache:']),
+      );
+
+      await client.set('cache:a', 'one');
+      expect(await client.get('cache:a'), equals('one'));
+      await client.set('cache:a', 'two');
+      expect(await client.get('cache:a'), equals('two'));
+
+      await client.set('other:b', 'x');
+      await client.get('other:b');
+      await client.get('other:b');
+      expect(client.cacheStats()!.size, equals(1));
+
+      await client.close();
+    });
+
+    test('invalidates the keys of a write, not its values', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        protocol: 3,
+        cache: const RedisCacheOptions(prefixes: ['cache:']),
+      );
+      await client.set('cache:a', 'one');
+      await client.get('cache:a');
+
+      // A value naming the cached key leaves it cached
+      await client.set('cache:h', 'cache:a');
+      await client.rpush('other:b', ['cache:a']);
+      final hits = client.cacheStats()!.hits;
+      expect(await client.get('cache:a'), equals('one'));
+      expect(client.cacheStats()!.hits, equals(hits + 1));
+
+      // So does a read that is not cached
+      await client.strlen('cache:a');
+      await client.ttl('cache:a');
+      await client.sendCommand(['EXISTS', 'cache:a']);
+      expect(await client.get('cache:a'), equals('one'));
+      expect(client.cacheStats()!.hits, equals(hits + 2));
+
+      // Every key of a multi-key write is dropped
+      await client.mset({'cache:h': 'x', 'cache:a': 'two'});
+      expect(await client.get('cache:a'), equals('two'));
+      await client.del(['cache:h', 'cache:a']);
+      expect(await client.get('cache:a'), isNull);
+
+      await client.close();
+    });
+
+    test('evicts the least recently used keys', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        protocol: 3,
+        cache: const RedisCacheOptions(maxEntries: 2),
+      );
+      for (final key in ['cache:1', 'cache:2', 'cache:3']) {
+        await client.get(key);
+      }
+      final stats = client.cacheStats()!;
+      expect(stats.size, equals(2));
+      expect(stats.evictions, equals(1));
+      await client.close();
+    });
+  });
+}
@@ -0,0 +1,90 @@
+@Tags(['redis'])
+library;
+
+import 'package:redis_ffi/redis_ffi.dart';
+import 'package:test/test.dart';
+
+import 'test_helper.dart';
+
+void main() {
+  group('scripting', () {
+    late RedisClient client;
+
+    setUp(() async {
+      client = await createTestClient();
+      await client.sendCommand(['SCRIPT', 'FLUSH']);
+    });
+
+    tearDown(() async {
+      await client.close();
+    });
+
+    test('eval passes keys and arguments', () async {
+      final result = await client.eval(
+        'return {KEYS[1], ARGV[1], tonumber(ARGV[2]) + 1}',
+        keys: ['script:key'],
+        args: ['value', 41],
+      );
+      expect(result, hasLength(3));
+      expect((result! as List)[2], equals(42));
+    });
+
+    test('RedisScript sha1 matches SCRIPT LOAD', () async {
+      final script = RedisScript('return 1');
+      expect(await client.scriptLoad(script.source), equals(script.sha1));
+      expect(await client.scriptExists([script.sha1, '0' * 40]), [true, false]);
+    });
+
+    test('evalScript loads a missing script once for a burst', () async {
+      final script = RedisScript("return redis.call('INCR', KEYS[1])");
+      expect(await client.scriptExists([script.sha1]), [false]);
+
+      final results = await Future.wait([
+        for (var i = 0; i < 20; i++)
+          client.evalScript(script, keys: ['script:counter']),
+      ]);
+      expect(results.toSet(), hasLength(20));
+      expect(await client.get('script:counter'), equals('20'));
+      expect(await client.scriptExists([script.sha1]), [true]);
+
+      // Reloaded after the cache is flushed
+      await client.sendCommand(['SCRIPT', 'FLUSH']);
+      expect(
+        await client.evalScript(script, keys: ['script:counter']),
+        equals(21),
+      );
+
+      await client.del(['script:counter']);
+    });
+
+    test('evalScript rethrows other errors', () async {
+      final script = RedisScript("return redis.error_reply('boom')");
+      await expectLater(
+        client.evalScript(script),
+        throwsA(isA<RedisException>()),
+      );
+    });
+
+    test('loads scripts ahead of a pipeline', () async {
+      final script = RedisScript('return ARGV[1]');
+      final pipeline = client.pipeline();
+      final first = pipeline.evalScript(script, args: ['a']);
+      final second = pipeline.evalScript(script, args: ['b']);
+      await pipeline.execute();
+      expect(await first, isNotNull);
+      expect(await second, isNotNull);
+      expect(await client.scriptExists([script.sha1]), [true]);
+    });
+
+    test('loads scripts ahead of a transaction', () async {
+      final script = RedisScript("return redis.call('INCR', KEYS[1])");
+      final transaction = client.transaction();
+      final incr = transaction.evalScript(script, keys: ['script:tx']);
+      final results = await transaction.execute();
+      expect(results, equals([1]));
+      expect(await incr, equals(1));
+
+      await client.del(['script:tx']);
+    });
+  });
+}
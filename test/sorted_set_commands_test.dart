@@ -117,6 +117,30 @@ void main() {
       await client.del(['zset8']);
     });
 
+    test('zrangeWithScores with infinite scores and UTF-8 members', () async {
+      await client.zadd('zset8b', {
+        'ünï': double.negativeInfinity,
+        '': 0.25,
+        'top': double.infinity,
+      });
+
+      final result = await client.zrangeWithScores('zset8b', 0, -1);
+      expect(
+        result,
+        equals([
+          ('ünï', double.negativeInfinity),
+          ('', 0.25),
+          ('top', double.infinity),
+        ]),
+      );
+      expect(
+        await client.zpopmax('zset8b', count: 2),
+        equals([('top', double.infinity), ('', 0.25)]),
+      );
+
+      await client.del(['zset8b']);
+    });
+
     test('zrangebyscore and zrevrangebyscore', () async {
       await client.zadd('zset9', {'a': 1.0, 'b': 2.0, 'c': 3.0, 'd': 4.0});
 
@@ -0,0 +1,189 @@
+@Tags(['redis'])
+library;
+
+import 'dart:convert';
+
+import 'package:redis_ffi/redis_ffi.dart';
+import 'package:test/test.dart';
+
+import 'test_helper.dart';
+
+void main() {
+  group('stream commands', () {
+    late RedisClient client;
+
+    setUp(() async {
+      client = await createTestClient();
+    });
+
+    tearDown(() async {
+      await client.del(['stream:basic']);
+      await client.close();
+    });
+
+    test('xadd, xlen and xdel', () async {
+      final id = await client.xadd('stream:basic', {'a': '1', 'b': '2'});
+      expect(id, contains('-'));
+      await client.xadd('stream:basic', {'a': '3'}, maxLen: 10);
+      expect(await client.xlen('stream:basic'), equals(2));
+      expect(await client.xdel('stream:basic', [id]), equals(1));
+      expect(await client.xlen('stream:basic'), equals(1));
+    });
+  });
+
+  group('RedisStreamConsumer', () {
+    late RedisClient client;
+
+    setUp(() async {
+      client = await createTestClient();
+      await client.del(['stream:jobs']);
+    });
+
+    tearDown(() async {
+      await client.del(['stream:jobs']);
+      await client.close();
+    });
+
+    Future<int> pending() async {
+      final summary = await client.sendCommand([
+        'XPENDING',
+        'stream:jobs',
+        'workers',
+      ]);
+      return (summary! as List)[0] as int;
+    }
+
+    test('delivers new entries and batches acks', () async {
+      final consumer = await client.streamConsumer(
+        'stream:jobs',
+        'workers',
+        'w1',
+        block: const Duration(milliseconds: 100),
+      );
+      final entries = <RedisStreamEntry>[];
+      final subscription = consumer.entries.listen(entries.add);
+      for (var i = 0; i < 3; i++) {
+        await client.xadd('stream:jobs', {'job': '$i'});
+      }
+      while (entries.length < 3) {
+        await Future<void>.delayed(const Duration(milliseconds: 10));
+      }
+
+      expect([for (final e in entries) e.fields['job']], ['0', '1', '2']);
+      expect(entries.first.stream, equals('stream:jobs'));
+      expect(await pending(), equals(3));
+
+      // One XACK for all three
+      await Future.wait([for (final e in entries) consumer.ack(e.id)]);
+      expect(await pending(), equals(0));
+
+      await subscription.cancel();
+      expect(() => consumer.ack('0-1'), throwsStateError);
+    });
+
+    test('reads on a connection with the options of its client', () async {
+      final resp3 = await RedisClient.connect('localhost', 6379, protocol: 3);
+      final consumer = await resp3.streamConsumer(
+        'stream:jobs',
+        'workers',
+        'w1',
+        block: const Duration(milliseconds: 100),
+      );
+      final entries = <RedisStreamEntry>[];
+      final subscription = consumer.entries.listen(entries.add);
+      try {
+        // The consumer's connection is the one reading the stream
+        String? reader;
+        while (reader == null) {
+          await Future<void>.delayed(const Duration(milliseconds: 10));
+          final clients = await client.sendCommand(['CLIENT', 'LIST']);
+          reader = utf8
+              .decode(clients! as List<int>)
+              .split('\n')
+              .where((line) => line.contains('cmd=xreadgroup'))
+              .firstOrNull;
+        }
+        expect(reader, contains('resp=3'));
+
+        // XREADGROUP replies with a map under RESP3
+        final id = await client.xadd('stream:jobs', {'job': 'resp3'});
+        while (entries.isEmpty) {
+          await Future<void>.delayed(const Duration(milliseconds: 10));
+        }
+        expect(entries.single.id, equals(id));
+        expect(entries.single.fields, equals({'job': 'resp3'}));
+
+        // So does the read of the unacknowledged history
+        final again = await resp3.streamConsumer(
+          'stream:jobs',
+          'workers',
+          'w1',
+          block: const Duration(milliseconds: 100),
+        );
+        final redelivered = await again.entries.first;
+        expect(redelivered.id, equals(id));
+      } finally {
+        await subscription.cancel();
+        await resp3.close();
+      }
+    });
+
+    test('does not block the client while waiting', () async {
+      final consumer = await client.streamConsumer(
+        'stream:jobs',
+        'workers',
+        'w1',
+        block: const Duration(seconds: 2),
+      );
+      final subscription = consumer.entries.listen((_) {});
+      await Future<void>.delayed(const Duration(milliseconds: 50));
+
+      final stopwatch = Stopwatch()..start();
+      expect(await client.ping(), equals('PONG'));
+      expect(stopwatch.elapsed, lessThan(const Duration(seconds: 1)));
+
+      await subscription.cancel();
+      expect(consumer.isClosed, isTrue);
+    });
+
+    test('redelivers unacknowledged entries first', () async {
+      final first = await client.streamConsumer('stream:jobs', 'workers', 'w1');
+      await client.xadd('stream:jobs', {'job': 'a'});
+      final entry = await first.entries.first;
+      expect(entry.fields, equals({'job': 'a'}));
+
+      final second = await client.streamConsumer(
+        'stream:jobs',
+        'workers',
+        'w1',
+      );
+      final redelivered = await second.entries.first;
+      expect(redelivered.id, equals(entry.id));
+      await client.xack('stream:jobs', 'workers', [entry.id]);
+    });
+
+    test('claims entries idle at other consumers', () async {
+      final crashed = await client.streamConsumer(
+        'stream:jobs',
+        'workers',
+        'crashed',
+      );
+      await client.xadd('stream:jobs', {'job': 'lost'});
+      final lost = await crashed.entries.first;
+
+      final rescuer = await client.streamConsumer(
+        'stream:jobs',
+        'workers',
+        'rescuer',
+        block: const Duration(milliseconds: 100),
+        claimMinIdle: const Duration(milliseconds: 10),
+        claimInterval: const Duration(milliseconds: 20),
+      );
+      final claimed = await rescuer.entries.first.timeout(
+        const Duration(seconds: 5),
+      );
+      expect(claimed.id, equals(lost.id));
+      expect(claimed.fields, equals({'job': 'lost'}));
+    });
+  });
+}
@@ -1,6 +1,8 @@
 @Tags(['redis'])
 library;
 
+import 'dart:typed_data';
+
 import 'package:redis_ffi/redis_ffi.dart';
 import 'package:test/test.dart';
 
@@ -24,6 +26,54 @@ void main() {
       await client.del(['test_key']);
     });
 
+    test('non-ASCII values are sent as UTF-8', () async {
+      await client.set('utf8_key', 'héllo wörld ✓');
+      expect(await client.get('utf8_key'), equals('héllo wörld ✓'));
+      expect(await client.strlen('utf8_key'), equals(17));
+      await client.del(['utf8_key']);
+    });
+
+    test('large pipelined batches grow the command buffer', () async {
+      final value = 'x' * 10000;
+      await Future.wait([
+        for (var i = 0; i < 200; i++) client.set('big_batch:$i', value),
+      ]);
+      expect(await client.get('big_batch:199'), equals(value));
+      await client.del(List.generate(200, (i) => 'big_batch:$i'));
+    });
+
+    test('large values round-trip above the external threshold', () async {
+      final large = 'abcdefgh' * (1 << 17); // 1 MiB
+      await client.set('large_value', large);
+      final results = await Future.wait([
+        client.get('large_value'),
+        client.get('large_value'),
+        client.strlen('large_value'),
+      ]);
+      expect(results, [large, large, large.length]);
+
+      final copying = await RedisClient.connect(
+        'localhost',
+        6379,
+        externalValueThreshold: 0,
+      );
+      try {
+        expect(await copying.get('large_value'), equals(large));
+      } finally {
+        await copying.close();
+      }
+      await client.del(['large_value']);
+    });
+
+    test('setBytes and getBytes keep raw bytes', () async {
+      final value = Uint8List.fromList(List.generate(256, (i) => i));
+      expect(await client.setBytes('bytes_key', value), isTrue);
+      expect(await client.getBytes('bytes_key'), equals(value));
+      expect(await client.setBytes('bytes_key', value, nx: true), isFalse);
+      expect(await client.getBytes('bytes_missing'), isNull);
+      await client.del(['bytes_key']);
+    });
+
     test('get returns null for non-existent key', () async {
       expect(await client.get('non_existent_key_12345'), isNull);
     });
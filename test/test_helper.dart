@@ -1,6 +1,46 @@
+import 'dart:ffi';
+import 'dart:io';
+
+import 'package:ffi/ffi.dart';
 import 'package:redis_ffi/redis_ffi.dart';
 
 /// Creates a RedisClient connected to localhost:6379 for testing.
 Future<RedisClient> createTestClient() async {
   return RedisClient.connect('localhost', 6379);
 }
+
+/// Whether the `ioUring` option can take effect here: Linux 5.10 or later,
+/// with io_uring_setup allowed by sysctl and seccomp.
+bool canCreateIoUring() {
+  if (!Platform.isLinux) return false;
+  final release = RegExp(
+    r'(\d+)\.(\d+)',
+  ).firstMatch(Platform.operatingSystemVersion);
+  if (release == null) return false;
+  final major = int.parse(release[1]!);
+  final minor = int.parse(release[2]!);
+  if (major < 5 || (major == 5 && minor < 10)) return false;
+
+  final libc = DynamicLibrary.process();
+  final syscall = libc
+      .lookupFunction<
+        Long Function(Long, VarArgs<(Long, Pointer<Uint8>)>),
+        int Function(int, int, Pointer<Uint8>)
+      >('syscall');
+  final close = libc.lookupFunction<Int Function(Int), int Function(int)>(
+    'close',
+  );
+
+  // io_uring_setup has the same number on every architecture
+  const ioUringSetup = 425;
+  // struct io_uring_params, zeroed
+  final params = calloc<Uint8>(120);
+  try {
+    final fd = syscall(ioUringSetup, 8, params);
+    if (fd < 0) return false;
+    close(fd);
+    return true;
+  } finally {
+    calloc.free(params);
+  }
+}
@@ -0,0 +1,130 @@
+@Tags(['redis'])
+library;
+
+import 'package:redis_ffi/redis_ffi.dart';
+import 'package:test/test.dart';
+
+import 'test_helper.dart';
+
+const _short = Duration(milliseconds: 100);
+
+void main() {
+  group('command timeouts', () {
+    late RedisClient admin;
+
+    setUp(() async {
+      admin = await createTestClient();
+      await admin.del(['timeout:list', 'timeout:key']);
+    });
+
+    tearDown(() async {
+      await admin.del(['timeout:list', 'timeout:key']);
+      await admin.close();
+    });
+
+    /// Pushes onto the list once a client is blocked on it.
+    Future<void> unblock() async {
+      final deadline = DateTime.now().add(const Duration(seconds: 5));
+      while (true) {
+        final clients = await admin.sendCommand(['INFO', 'clients']);
+        final info = String.fromCharCodes(clients! as List<int>);
+        if (!info.contains('blocked_clients:0')) break;
+        if (DateTime.now().isAfter(deadline)) fail('Nothing blocked');
+        await Future<void>.delayed(const Duration(milliseconds: 10));
+      }
+      await admin.rpush('timeout:list', ['value']);
+    }
+
+    for (final hosted in [false, true]) {
+      group(hosted ? 'on a reactor' : 'on a poll thread', () {
+        RedisReactor? reactor;
+        late RedisClient client;
+
+        setUp(() async {
+          reactor = hosted ? RedisReactor(threads: 1) : null;
+          client = await RedisClient.connect(
+            'localhost',
+            6379,
+            reactor: reactor,
+            commandTimeout: _short,
+          );
+        });
+
+        tearDown(() async {
+          await client.close();
+          await reactor?.close();
+        });
+
+        test('a late command fails without shifting replies', () async {
+          final blocked = client
+              .withTimeout(_short)
+              .sendCommand(['BLPOP', 'timeout:list', '0']);
+          await expectLater(blocked, throwsA(isA<RedisTimeoutException>()));
+
+          // The BLPOP still holds the connection; its reply is dropped
+          final next = client.withTimeout(null).ping();
+          await unblock();
+          expect(await next, equals('PONG'));
+          expect(await admin.llen('timeout:list'), equals(0));
+          expect(client.stats().timeouts, equals(1));
+        });
+
+        test('blocking commands are exempt from commandTimeout', () async {
+          final blocked = client.sendCommand(['BLPOP', 'timeout:list', '0']);
+          // Queued behind the BLPOP, so it times out
+          final read = client.get('timeout:key');
+          await expectLater(read, throwsA(isA<RedisTimeoutException>()));
+
+          await unblock();
+          expect(await blocked, hasLength(2));
+          expect(await client.ping(), equals('PONG'));
+        });
+      });
+    }
+
+    test('withTimeout(null) sends without a timeout', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        commandTimeout: _short,
+      );
+      try {
+        final blocked = client.sendCommand(['BLPOP', 'timeout:list', '0']);
+        final read = client.withTimeout(null).get('timeout:key');
+        await Future<void>.delayed(_short * 2);
+        await unblock();
+        expect(await blocked, hasLength(2));
+        expect(await read, isNull);
+      } finally {
+        await client.close();
+      }
+    });
+
+    test('closeOnTimeout drops the connection', () async {
+      final client = await RedisClient.connect(
+        'localhost',
+        6379,
+        closeOnTimeout: true,
+      );
+      try {
+        final blocked = client
+            .withTimeout(_short)
+            .sendCommand(['BLPOP', 'timeout:list', '0']);
+        final next = client.ping();
+        await expectLater(blocked, throwsA(isA<RedisTimeoutException>()));
+        await expectLater(next, throwsA(isA<RedisException>()));
+        expect(client.connectionState, RedisConnectionState.disconnected);
+      } finally {
+        await client.close();
+      }
+    });
+
+    test('rejects a timeout that is not positive', () async {
+      await expectLater(
+        RedisClient.connect('localhost', 6379, commandTimeout: Duration.zero),
+        throwsArgumentError,
+      );
+      expect(() => admin.withTimeout(Duration.zero), throwsArgumentError);
+    });
+  });
+}
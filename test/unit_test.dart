@@ -1,5 +1,7 @@
 library;
 
+import 'dart:convert';
+
 import 'package:redis_ffi/redis_ffi.dart';
 import 'package:test/test.dart';
 
@@ -25,10 +27,105 @@ void main() {
     });
   });
 
+  group('RedisClusterClient.keySlot', () {
+    test('matches CLUSTER KEYSLOT', () {
+      expect(RedisClusterClient.keySlot('123456789'), equals(12739));
+      expect(RedisClusterClient.keySlot('foo'), equals(12182));
+      expect(RedisClusterClient.keySlot('bar'), equals(5061));
+      expect(RedisClusterClient.keySlot(''), equals(0));
+    });
+
+    test('hashes only the hash tag', () {
+      expect(
+        RedisClusterClient.keySlot('{user1000}.following'),
+        equals(RedisClusterClient.keySlot('user1000')),
+      );
+      expect(
+        RedisClusterClient.keySlot('{user1000}.followers'),
+        equals(RedisClusterClient.keySlot('{user1000}.following')),
+      );
+    });
+
+    test('ignores an empty hash tag', () {
+      expect(RedisClusterClient.keySlot('foo{}{bar}'), equals(8363));
+      expect(
+        RedisClusterClient.keySlot('foo{{bar}}zap'),
+        equals(RedisClusterClient.keySlot('{bar')),
+      );
+    });
+
+    test('hashes strings as UTF-8', () {
+      expect(
+        RedisClusterClient.keySlot('ключ'),
+        equals(RedisClusterClient.keySlot(utf8.encode('ключ'))),
+      );
+    });
+  });
+
+  group('RedisScript', () {
+    test('computes the SHA1 digest of its source', () {
+      expect(
+        RedisScript('').sha1,
+        equals('da39a3ee5e6b4b0d3255bfef95601890afd80709'),
+      );
+      expect(
+        RedisScript('abc').sha1,
+        equals('a9993e364706816aba3e25717850c26c9cd0d89d'),
+      );
+      // 56 bytes: the length no longer fits in the first block
+      expect(
+        RedisScript(
+          'abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq',
+        ).sha1,
+        equals('84983e441c3bd26ebaae4aa1f95129e5e54670f1'),
+      );
+    });
+  });
+
+  group('RedisHistogram', () {
+    test('counts small values exactly', () {
+      final histogram = RedisHistogram.fromBuckets([0, 2, 0, 1, 1]);
+      expect(histogram.count, equals(4));
+      expect(histogram.min, equals(1));
+      expect(histogram.max, equals(4));
+      expect(histogram.valueAtPercentile(50), equals(1));
+      expect(histogram.valueAtPercentile(75), equals(3));
+      expect(histogram.valueAtPercentile(100), equals(4));
+      expect(histogram.mean, closeTo(2.25, 1e-9));
+    });
+
+    test('buckets larger values log-linearly', () {
+      // Bucket 16 holds 16, bucket 32 holds 32..33, bucket 48 holds 64..67
+      final counts = List.filled(49, 0)
+        ..[16] = 1
+        ..[32] = 1
+        ..[48] = 1;
+      final histogram = RedisHistogram.fromBuckets(counts);
+      expect(histogram.min, equals(16));
+      expect(histogram.valueAtPercentile(50), equals(33));
+      expect(histogram.max, equals(67));
+    });
+
+    test('is empty without values', () {
+      final histogram = RedisHistogram.fromBuckets(const []);
+      expect(histogram.count, equals(0));
+      expect(histogram.valueAtPercentile(99), equals(0));
+      expect(histogram.mean, equals(0));
+    });
+  });
+
   group('RedisException', () {
     test('toString includes message', () {
       final exception = RedisException('test error');
       expect(exception.toString(), contains('test error'));
     });
   });
+
+  group('RedisTimeoutException', () {
+    test('is a RedisException', () {
+      final exception = RedisTimeoutException('Command timed out');
+      expect(exception, isA<RedisException>());
+      expect(exception.toString(), startsWith('RedisTimeoutException'));
+    });
+  });
 }